@@ -0,0 +1,299 @@
+#include "ArchiveCodec.hpp"
+#include "../Utils/CivilTime.hpp"
+
+#include <array>
+#include <limits>
+#include <stdexcept>
+
+namespace archive_codec {
+
+namespace {
+/**
+ * @brief Powers of ten as quads, exact up to 10^48.
+ */
+const std::array<quad, 39> &quadPowersOfTen() {
+  static const std::array<quad, 39> powers = [] {
+    std::array<quad, 39> result;
+    result[0] = 1;
+    for (std::size_t i = 1; i < result.size(); ++i) {
+      result[i] = result[i - 1] * 10;
+    }
+    return result;
+  }();
+  return powers;
+}
+
+/**
+ * @brief Powers of ten as wide integers.
+ */
+constexpr std::array<wide_uint, 39> widePowersOfTen = [] {
+  std::array<wide_uint, 39> result{};
+  result[0] = 1;
+  for (std::size_t i = 1; i < result.size(); ++i) {
+    result[i] = result[i - 1] * 10;
+  }
+  return result;
+}();
+
+/**
+ * @brief Appends a number zero padded to a width.
+ */
+void putDigits(std::string &out, wide_uint value, std::size_t width) {
+  char digits[40];
+  std::size_t count = 0;
+  do {
+    digits[count++] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  while (count < width) {
+    digits[count++] = '0';
+  }
+  while (count > 0) {
+    out += digits[--count];
+  }
+}
+} // namespace
+
+void putString(std::string &out, std::string_view value) {
+  if (value.size() > std::numeric_limits<std::uint16_t>::max()) {
+    throw std::length_error("String too long to encode");
+  }
+  put(out, static_cast<std::uint16_t>(value.size()));
+  out.append(value);
+}
+
+std::string getString(std::string_view data, std::size_t &position) {
+  auto size = get<std::uint16_t>(data, position);
+  if (size > data.size() - position) {
+    throw std::runtime_error("Encoded data is truncated");
+  }
+  std::string value(data.substr(position, size));
+  position += size;
+  return value;
+}
+
+void putVarint(std::string &out, wide_uint value) {
+  while (value >= 0x80) {
+    out += static_cast<char>((value & 0x7F) | 0x80);
+    value >>= 7;
+  }
+  out += static_cast<char>(value);
+}
+
+wide_uint getVarint(std::string_view data, std::size_t &position) {
+  wide_uint value = 0;
+  for (int shift = 0; shift < 128; shift += 7) {
+    if (position >= data.size()) {
+      throw std::runtime_error("Archive block is truncated");
+    }
+    auto byte = static_cast<std::uint8_t>(data[position++]);
+    value |= static_cast<wide_uint>(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      return value;
+    }
+  }
+  throw std::runtime_error("Archive block has an invalid varint");
+}
+
+void encodeIntegers(std::span<const wide_int> values, int order,
+                    std::string &out) {
+  wide_int previous = 0;
+  wide_int previous_delta = 0;
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    // Wrapping arithmetic, decoding wraps back the same way
+    wide_int delta = static_cast<wide_int>(static_cast<wide_uint>(values[i]) -
+                                           static_cast<wide_uint>(previous));
+    if (order == 2 && i > 0) {
+      putVarint(out, zigzag(static_cast<wide_int>(
+                         static_cast<wide_uint>(delta) -
+                         static_cast<wide_uint>(previous_delta))));
+    } else {
+      putVarint(out, zigzag(delta));
+    }
+    previous = values[i];
+    previous_delta = i > 0 ? delta : 0;
+  }
+}
+
+void decodeIntegers(std::string_view data, int order,
+                    std::span<wide_int> values) {
+  std::size_t position = 0;
+  wide_uint previous = 0;
+  wide_uint previous_delta = 0;
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    auto delta = static_cast<wide_uint>(unzigzag(getVarint(data, position)));
+    if (order == 2 && i > 0) {
+      delta += previous_delta;
+    }
+    previous += delta;
+    previous_delta = i > 0 ? delta : 0;
+    values[i] = static_cast<wide_int>(previous);
+  }
+}
+
+void encodeTimes(std::span<const time_ticks> times, std::string &out) {
+  time_ticks previous_delta = 0;
+  for (std::size_t i = 1; i < times.size(); ++i) {
+    time_ticks delta = times[i] - times[i - 1];
+    putVarint(out, zigzag(static_cast<wide_int>(delta) - previous_delta));
+    previous_delta = delta;
+  }
+}
+
+void decodeTimes(std::string_view data, time_ticks first,
+                 std::span<time_ticks> times) {
+  if (times.empty()) {
+    return;
+  }
+  std::size_t position = 0;
+  time_ticks delta = 0;
+  times[0] = first;
+  for (std::size_t i = 1; i < times.size(); ++i) {
+    delta += static_cast<time_ticks>(unzigzag(getVarint(data, position)));
+    times[i] = times[i - 1] + delta;
+  }
+}
+
+bool parseDecimal(std::string_view text, wide_int &mantissa,
+                  DecimalLayout &layout) {
+  bool negative = !text.empty() && text.front() == '-';
+  if (negative) {
+    text.remove_prefix(1);
+  }
+
+  std::size_t point = text.find('.');
+  std::string_view integer = text.substr(0, point);
+  std::string_view fraction = point == std::string_view::npos
+                                  ? std::string_view()
+                                  : text.substr(point + 1);
+  if (integer.empty() || integer.size() + fraction.size() > 38 ||
+      (point != std::string_view::npos && fraction.empty())) {
+    return false;
+  }
+
+  wide_uint value = 0;
+  for (std::string_view digits : {integer, fraction}) {
+    for (char c : digits) {
+      if (c < '0' || c > '9') {
+        return false;
+      }
+      value = value * 10 + static_cast<unsigned>(c - '0');
+    }
+  }
+
+  mantissa = negative ? -static_cast<wide_int>(value)
+                      : static_cast<wide_int>(value);
+  layout.scale = static_cast<std::uint8_t>(fraction.size());
+  layout.width = integer.size() > 1 && integer.front() == '0'
+                     ? static_cast<std::uint8_t>(integer.size())
+                     : 0;
+  return true;
+}
+
+void formatDecimal(wide_int mantissa, DecimalLayout layout, std::string &out) {
+  wide_uint magnitude = mantissa < 0 ? -static_cast<wide_uint>(mantissa)
+                                     : static_cast<wide_uint>(mantissa);
+  if (mantissa < 0) {
+    out += '-';
+  }
+  const wide_uint unit = widePowersOfTen[layout.scale];
+  putDigits(out, magnitude / unit, layout.width);
+  if (layout.scale > 0) {
+    out += '.';
+    putDigits(out, magnitude % unit, layout.scale);
+  }
+}
+
+quad decimalValue(wide_int mantissa, int scale) {
+  // Below 2^113 the mantissa is exact in a quad, as is any power of ten up to
+  // 10^48, so the one rounding is that of the division. Longer mantissas
+  // would be rounded twice, parse their text as a reader of the file would.
+  constexpr wide_uint exact = wide_uint(1) << 113;
+  wide_uint magnitude = mantissa < 0 ? -static_cast<wide_uint>(mantissa)
+                                     : static_cast<wide_uint>(mantissa);
+  if (magnitude >= exact) {
+    std::string text;
+    formatDecimal(mantissa, DecimalLayout{static_cast<std::uint8_t>(scale), 0},
+                  text);
+    return quad(text);
+  }
+  quad value(mantissa);
+  return scale == 0 ? value : value / quadPowersOfTen()[scale];
+}
+
+TimeTextLayout detectTimeText(CsvTimeFormat format, std::uint8_t part,
+                              std::string_view text) {
+  TimeTextLayout layout;
+  layout.part = part;
+
+  // Seconds end after "YYYY-MM-DD HH:MM:SS" or "HHMMSS"
+  std::size_t seconds_end = 0;
+  if (format == CsvTimeFormat::oneColStandard) {
+    seconds_end = 19;
+    if (text.size() > 10) {
+      layout.separator = text[10];
+    }
+  } else if (part == 1) {
+    seconds_end = 6;
+  }
+  if (seconds_end > 0 && text.size() > seconds_end + 1) {
+    layout.fractionDigits =
+        static_cast<std::uint8_t>(text.size() - seconds_end - 1);
+  }
+  return layout;
+}
+
+void formatTimeText(CsvTimeFormat format, TimeTextLayout layout,
+                    time_ticks ticks, std::string &out) {
+  const time_ticks per_second = time_delt::ticks_per_second();
+  const time_ticks per_day = per_second * 86400;
+  time_ticks days = floorDiv(ticks, per_day);
+  time_ticks of_day = ticks - days * per_day;
+  time_ticks seconds = of_day / per_second;
+  time_ticks fraction = of_day % per_second;
+
+  const CivilDate date = civilFromDays(days);
+
+  auto put_fraction = [&] {
+    if (layout.fractionDigits == 0) {
+      return;
+    }
+    // Scale the ticks to the digits written, digits past the tick resolution
+    // are zero
+    int tick_digits = time_delt::num_fractional_digits();
+    wide_uint digits = fraction;
+    if (layout.fractionDigits > tick_digits) {
+      digits *= widePowersOfTen[layout.fractionDigits - tick_digits];
+    } else {
+      digits /= widePowersOfTen[tick_digits - layout.fractionDigits];
+    }
+    out += '.';
+    putDigits(out, digits, layout.fractionDigits);
+  };
+
+  if (format == CsvTimeFormat::oneColStandard) {
+    putDigits(out, static_cast<wide_uint>(date.year), 4);
+    out += '-';
+    putDigits(out, date.month, 2);
+    out += '-';
+    putDigits(out, date.day, 2);
+    out += layout.separator;
+    putDigits(out, seconds / 3600, 2);
+    out += ':';
+    putDigits(out, seconds / 60 % 60, 2);
+    out += ':';
+    putDigits(out, seconds % 60, 2);
+    put_fraction();
+  } else if (layout.part == 0) {
+    putDigits(out, static_cast<wide_uint>(date.year % 100), 2);
+    putDigits(out, date.month, 2);
+    putDigits(out, date.day, 2);
+  } else {
+    putDigits(out, seconds / 3600, 2);
+    putDigits(out, seconds / 60 % 60, 2);
+    putDigits(out, seconds % 60, 2);
+    put_fraction();
+  }
+}
+
+} // namespace archive_codec
@@ -0,0 +1,245 @@
+#ifndef __ARCHIVECODEC_H__
+#define __ARCHIVECODEC_H__
+
+#include "TimeParse.hpp"
+#include <boost/multiprecision/cpp_bin_float.hpp>
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+using quad = boost::multiprecision::cpp_bin_float_quad;
+
+/*
+ * Encodings of the columns of a TimeArchive block.
+ *
+ * Fixed size numbers are written in their native little endian layout, the
+ * helpers here are shared by every file the library saves. Integers in
+ * blocks are written as LEB128 varints, signed ones zigzag encoded first so
+ * small magnitudes of either sign stay short. Times are stored as the delta
+ * of deltas of their ticks, which is zero for rows logged at a steady rate.
+ *
+ * Values are kept as the text they were logged as. Fixed point numbers, the
+ * common case, become an integer mantissa with a per block scale and are
+ * stored as deltas, or deltas of deltas for columns that ramp like phases and
+ * counters. Their quad value is the mantissa divided by a power of ten, which
+ * rounds exactly as parsing the text does. Anything else is stored as text.
+ */
+static_assert(std::endian::native == std::endian::little,
+              "Saved files are little endian");
+
+namespace archive_codec {
+
+/**
+ * @brief Appends a fixed size integer or double.
+ * @param out The buffer to append to.
+ * @param value The value.
+ */
+template <typename T> void put(std::string &out, T value) {
+  static_assert(std::is_arithmetic_v<T>);
+  out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+/**
+ * @brief Reads a fixed size integer or double.
+ * @param data The encoded bytes.
+ * @param position Offset of the value, moved past it.
+ * @return The value.
+ * @throws std::runtime_error if the value runs past the end of data.
+ */
+template <typename T> T get(std::string_view data, std::size_t &position) {
+  static_assert(std::is_arithmetic_v<T>);
+  if (position > data.size() || sizeof(T) > data.size() - position) {
+    throw std::runtime_error("Encoded data is truncated");
+  }
+  T value;
+  std::memcpy(&value, data.data() + position, sizeof(T));
+  position += sizeof(T);
+  return value;
+}
+
+/**
+ * @brief Appends a string with a uint16 length prefix.
+ * @param out The buffer to append to.
+ * @param value The string.
+ * @throws std::length_error if the string is longer than a uint16 counts.
+ */
+void putString(std::string &out, std::string_view value);
+
+/**
+ * @brief Reads a string written by putString.
+ * @param data The encoded bytes.
+ * @param position Offset of the string, moved past it.
+ * @return The string.
+ * @throws std::runtime_error if the string runs past the end of data.
+ */
+std::string getString(std::string_view data, std::size_t &position);
+
+/**
+ * @brief Wide enough for the mantissa of any 38 digit decimal.
+ */
+using wide_int = __int128;
+
+/**
+ * @brief Unsigned counterpart of wide_int.
+ */
+using wide_uint = unsigned __int128;
+
+/**
+ * @brief Appends an unsigned varint.
+ * @param out The buffer to append to.
+ * @param value The value.
+ */
+void putVarint(std::string &out, wide_uint value);
+
+/**
+ * @brief Reads an unsigned varint.
+ * @param data The encoded bytes.
+ * @param position Offset of the varint, moved past it.
+ * @return The value.
+ * @throws std::runtime_error if the varint runs past the end of data.
+ */
+wide_uint getVarint(std::string_view data, std::size_t &position);
+
+/**
+ * @brief Maps a signed value to an unsigned one, small magnitudes first.
+ */
+constexpr wide_uint zigzag(wide_int value) {
+  return (static_cast<wide_uint>(value) << 1) ^
+         static_cast<wide_uint>(value >> 127);
+}
+
+/**
+ * @brief Inverse of zigzag.
+ */
+constexpr wide_int unzigzag(wide_uint value) {
+  return static_cast<wide_int>(value >> 1) ^ -static_cast<wide_int>(value & 1);
+}
+
+/**
+ * @brief Encodes integers as deltas of the given order after the first.
+ * @param values The integers.
+ * @param order 1 for deltas, 2 for deltas of deltas.
+ * @param out The buffer to append to.
+ */
+void encodeIntegers(std::span<const wide_int> values, int order,
+                    std::string &out);
+
+/**
+ * @brief Decodes integers written by encodeIntegers.
+ * @param data The encoded bytes.
+ * @param order The order they were encoded with.
+ * @param values Receives the integers, sized to their count.
+ * @throws std::runtime_error if data is too short.
+ */
+void decodeIntegers(std::string_view data, int order,
+                    std::span<wide_int> values);
+
+/**
+ * @brief Encodes times as deltas of deltas, the first time is not written.
+ * @param times The times of a block.
+ * @param out The buffer to append to.
+ */
+void encodeTimes(std::span<const time_ticks> times, std::string &out);
+
+/**
+ * @brief Decodes times written by encodeTimes.
+ * @param data The encoded bytes.
+ * @param first The first time of the block.
+ * @param times Receives the times, sized to their count.
+ * @throws std::runtime_error if data is too short.
+ */
+void decodeTimes(std::string_view data, time_ticks first,
+                 std::span<time_ticks> times);
+
+/**
+ * @brief Layout of fixed point text, shared by every value of a block.
+ */
+struct DecimalLayout {
+  /**
+   * @brief Digits after the decimal point, zero for no point.
+   */
+  std::uint8_t scale = 0;
+
+  /**
+   * @brief Integer digits the text is zero padded to, zero for no padding.
+   */
+  std::uint8_t width = 0;
+};
+
+/**
+ * @brief Parses fixed point text into a mantissa.
+ * @param text The text, an optional '-', digits and an optional fraction.
+ * @param mantissa Receives the value times ten to the scale.
+ * @param layout Receives the scale and padding of the text.
+ * @return false if the text is not fixed point or has more than 38 digits.
+ */
+bool parseDecimal(std::string_view text, wide_int &mantissa,
+                  DecimalLayout &layout);
+
+/**
+ * @brief Formats a mantissa back into fixed point text.
+ * @param mantissa The value times ten to the scale.
+ * @param layout The scale and padding.
+ * @param out The buffer to append to.
+ */
+void formatDecimal(wide_int mantissa, DecimalLayout layout, std::string &out);
+
+/**
+ * @brief Gets the value of a mantissa.
+ * @return The mantissa divided by ten to the scale, rounded as parsing its
+ * text into a quad is.
+ */
+quad decimalValue(wide_int mantissa, int scale);
+
+/**
+ * @brief Layout of the text of a time column, shared by a block.
+ */
+struct TimeTextLayout {
+  /**
+   * @brief Which of the format's time columns, as in TimeParser::columns.
+   */
+  std::uint8_t part = 0;
+
+  /**
+   * @brief Digits after the decimal point of the seconds, zero for none.
+   */
+  std::uint8_t fractionDigits = 0;
+
+  /**
+   * @brief Character between the date and the time, where there is one.
+   */
+  char separator = ' ';
+};
+
+/**
+ * @brief Finds the layout of the text of a time column.
+ * @param format The time format of the files.
+ * @param part Which of the format's time columns the text is.
+ * @param text The text of the column in one row.
+ * @return The layout, which formatTimeText may or may not reproduce the text
+ * with.
+ */
+TimeTextLayout detectTimeText(CsvTimeFormat format, std::uint8_t part,
+                              std::string_view text);
+
+/**
+ * @brief Formats a time column from the time of its row.
+ * @param format The time format of the files.
+ * @param layout The layout of the column.
+ * @param ticks The time of the row.
+ * @param out The buffer to append to.
+ */
+void formatTimeText(CsvTimeFormat format, TimeTextLayout layout,
+                    time_ticks ticks, std::string &out);
+
+} // namespace archive_codec
+
+#endif // __ARCHIVECODEC_H__
@@ -0,0 +1,83 @@
+#include "AtomicFile.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+/**
+ * @brief Makes an error message ending with the description of errno.
+ */
+std::runtime_error fileError(const std::string &message) {
+  return std::runtime_error(message + ": " + std::strerror(errno));
+}
+} // namespace
+
+AtomicFile::AtomicFile(std::string path) : path_(std::move(path)) {
+  // The pid and a counter keep the name unique among processes and among
+  // writers in this one, O_EXCL catches a stale file left by a crash
+  static std::atomic<unsigned long> counter = 0;
+  for (int attempt = 0; attempt < 100 && fd_ < 0; ++attempt) {
+    tempPath_ = path_ + "." + std::to_string(::getpid()) + "." +
+                std::to_string(counter++) + ".tmp";
+    fd_ = ::open(tempPath_.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+                 0666);
+    if (fd_ < 0 && errno != EEXIST) {
+      break;
+    }
+  }
+  if (fd_ < 0) {
+    throw fileError("Failed to create " + path_);
+  }
+}
+
+AtomicFile::~AtomicFile() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+  if (!committed_) {
+    ::unlink(tempPath_.c_str());
+  }
+}
+
+void AtomicFile::write(std::string_view bytes) {
+  if (fd_ < 0) {
+    throw std::logic_error("Write to a closed file " + path_);
+  }
+  while (!bytes.empty()) {
+    ssize_t count = ::write(fd_, bytes.data(), bytes.size());
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw fileError("Failed to write " + path_);
+    }
+    bytes.remove_prefix(std::size_t(count));
+  }
+}
+
+void AtomicFile::commit() {
+  if (fd_ < 0) {
+    throw std::logic_error("Commit of a closed file " + path_);
+  }
+
+  // Flush before the rename so a crash cannot leave an empty file in place
+  bool flushed = ::fsync(fd_) == 0;
+  int error = errno;
+  bool closed = ::close(fd_) == 0;
+  fd_ = -1;
+  if (!flushed || !closed) {
+    errno = flushed ? errno : error;
+    throw fileError("Failed to write " + path_);
+  }
+  if (std::rename(tempPath_.c_str(), path_.c_str()) != 0) {
+    throw fileError("Failed to replace " + path_);
+  }
+  committed_ = true;
+}
@@ -0,0 +1,73 @@
+#ifndef __ATOMICFILE_H__
+#define __ATOMICFILE_H__
+
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Replaces a file as a whole.
+ *
+ * The contents are written to a temporary file with a name unique to this
+ * writer, in the same directory, and commit() renames it over the path. A
+ * reader sees either the old file or the complete new one, and writers racing
+ * on the same path each rename a whole file of their own. The temporary file
+ * is removed if the writer is destroyed without committing.
+ */
+struct AtomicFile {
+private:
+  /**
+   * @brief Final path of the file.
+   */
+  std::string path_;
+
+  /**
+   * @brief Path of the temporary file being written.
+   */
+  std::string tempPath_;
+
+  /**
+   * @brief Descriptor of the temporary file, -1 once closed.
+   */
+  int fd_ = -1;
+
+  /**
+   * @brief Whether commit() has renamed the file into place.
+   */
+  bool committed_ = false;
+
+public:
+  /**
+   * @brief Creates the temporary file.
+   * @param path Final path of the file.
+   * @throws std::runtime_error if the file cannot be created.
+   */
+  explicit AtomicFile(std::string path);
+
+  /**
+   * @brief Removes the temporary file unless it was committed.
+   */
+  ~AtomicFile();
+
+  AtomicFile(const AtomicFile &) = delete;
+  AtomicFile &operator=(const AtomicFile &) = delete;
+
+  /**
+   * @brief Appends bytes to the file.
+   * @throws std::runtime_error if the write fails.
+   */
+  void write(std::string_view bytes);
+
+  /**
+   * @brief Flushes the file and renames it over the final path.
+   * @throws std::runtime_error if the flush or rename fails, the temporary
+   * file is removed and the final path left as it was.
+   */
+  void commit();
+
+  /**
+   * @brief Final path of the file.
+   */
+  const std::string &path() const { return path_; }
+};
+
+#endif // __ATOMICFILE_H__
@@ -0,0 +1,313 @@
+#include "BatchRead.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define TIMEKEEPING_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace {
+
+/**
+ * @brief Completes a request with pread, continuing after any bytes already
+ * read.
+ */
+void preadRemaining(int fd, ReadRequest &request) {
+  while (request.bytesRead < request.length) {
+    ssize_t count = ::pread(fd, request.buffer + request.bytesRead,
+                            request.length - request.bytesRead,
+                            request.offset + request.bytesRead);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error("Failed to read from file: " +
+                               std::string(std::strerror(errno)));
+    }
+    if (count == 0) {
+      // End of file
+      return;
+    }
+    request.bytesRead += count;
+  }
+}
+
+#ifdef TIMEKEEPING_IO_URING
+
+/**
+ * @brief A minimal io_uring instance driven through the raw system calls.
+ *
+ * Only supports what readRanges needs: submitting a batch of reads and
+ * waiting for all of them.
+ */
+struct IoRing {
+  int ringFd = -1;
+  unsigned entries = 0;
+
+  void *sqRing = MAP_FAILED;
+  std::size_t sqRingSize = 0;
+  void *cqRing = MAP_FAILED;
+  std::size_t cqRingSize = 0;
+  io_uring_sqe *sqes = static_cast<io_uring_sqe *>(MAP_FAILED);
+  std::size_t sqesSize = 0;
+
+  unsigned *sqTail = nullptr;
+  unsigned *sqMask = nullptr;
+  unsigned *sqArray = nullptr;
+  unsigned *cqHead = nullptr;
+  unsigned *cqTail = nullptr;
+  unsigned *cqMask = nullptr;
+  io_uring_cqe *cqes = nullptr;
+
+  IoRing() = default;
+  IoRing(const IoRing &) = delete;
+  IoRing &operator=(const IoRing &) = delete;
+
+  ~IoRing() { close(); }
+
+  /**
+   * @brief Unmaps the queues and closes the ring, leaving this thread to
+   * read with pread.
+   */
+  void close() {
+    if (sqes != MAP_FAILED) {
+      ::munmap(sqes, sqesSize);
+    }
+    if (cqRing != MAP_FAILED && cqRing != sqRing) {
+      ::munmap(cqRing, cqRingSize);
+    }
+    if (sqRing != MAP_FAILED) {
+      ::munmap(sqRing, sqRingSize);
+    }
+    if (ringFd >= 0) {
+      ::close(ringFd);
+    }
+    sqes = static_cast<io_uring_sqe *>(MAP_FAILED);
+    cqRing = sqRing = MAP_FAILED;
+    ringFd = -1;
+    entries = 0;
+  }
+
+  /**
+   * @brief Creates the ring and maps its queues.
+   * @return false if the kernel does not provide io_uring.
+   */
+  bool init(unsigned requestedEntries) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    ringFd = static_cast<int>(
+        ::syscall(__NR_io_uring_setup, requestedEntries, &params));
+    if (ringFd < 0) {
+      return false;
+    }
+    entries = params.sq_entries;
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+      sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+    }
+
+    sqRing = ::mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED) {
+      return false;
+    }
+    cqRing = single_mmap
+                 ? sqRing
+                 : ::mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+    if (cqRing == MAP_FAILED) {
+      return false;
+    }
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    sqes = static_cast<io_uring_sqe *>(
+        ::mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES));
+    if (sqes == MAP_FAILED) {
+      return false;
+    }
+
+    char *sq = static_cast<char *>(sqRing);
+    sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sqMask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+
+    char *cq = static_cast<char *>(cqRing);
+    cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cqMask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+    return true;
+  }
+
+  /**
+   * @brief Submits up to `entries` reads and waits for all of them.
+   * @return false if the kernel refused the submission or does not support
+   * the read operation. Requests that were not completed are left for pread.
+   * @throws std::runtime_error if waiting for the reads fails.
+   */
+  bool read(int fd, std::span<ReadRequest> batch) {
+    unsigned tail = std::atomic_ref<unsigned>(*sqTail).load(
+        std::memory_order_relaxed);
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+      unsigned index = tail & *sqMask;
+      io_uring_sqe &sqe = sqes[index];
+      std::memset(&sqe, 0, sizeof(sqe));
+      sqe.opcode = IORING_OP_READ;
+      sqe.fd = fd;
+      sqe.off = batch[i].offset;
+      sqe.addr = reinterpret_cast<std::uint64_t>(batch[i].buffer);
+      sqe.len = static_cast<unsigned>(batch[i].length);
+      sqe.user_data = i;
+      sqArray[index] = index;
+      ++tail;
+    }
+    std::atomic_ref<unsigned>(*sqTail).store(tail, std::memory_order_release);
+
+    unsigned submitted = 0;
+    while (submitted < batch.size()) {
+      int ret = static_cast<int>(
+          ::syscall(__NR_io_uring_enter, ringFd, batch.size() - submitted,
+                    batch.size() - submitted, IORING_ENTER_GETEVENTS,
+                    nullptr, 0));
+      if (ret < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        // Roll back the entries the kernel did not consume, and wait for the
+        // ones it did so their completions cannot reach a later batch
+        std::atomic_ref<unsigned>(*sqTail).store(
+            tail - static_cast<unsigned>(batch.size() - submitted),
+            std::memory_order_release);
+        collect(batch, submitted);
+        return false;
+      }
+      submitted += ret;
+    }
+
+    return collect(batch, batch.size());
+  }
+
+  /**
+   * @brief Waits for the completions of a batch's submitted reads.
+   * @param batch The batch, indexed by each read's user data.
+   * @param expected The number of reads submitted.
+   * @return false if the kernel does not support the read operation.
+   * @throws std::runtime_error if waiting fails. The ring is closed first, as
+   * reads still in flight would otherwise complete into a later batch.
+   */
+  bool collect(std::span<ReadRequest> batch, std::size_t expected) {
+    bool supported = true;
+    std::size_t completed = 0;
+    while (completed < expected) {
+      unsigned head = std::atomic_ref<unsigned>(*cqHead).load(
+          std::memory_order_relaxed);
+      unsigned ready = std::atomic_ref<unsigned>(*cqTail).load(
+          std::memory_order_acquire);
+      if (head == ready) {
+        int ret = static_cast<int>(::syscall(
+            __NR_io_uring_enter, ringFd, 0, 1, IORING_ENTER_GETEVENTS,
+            nullptr, 0));
+        if (ret < 0 && errno != EINTR) {
+          int error = errno;
+          close();
+          throw std::runtime_error("io_uring wait failed: " +
+                                   std::string(std::strerror(error)));
+        }
+        continue;
+      }
+      for (; head != ready; ++head, ++completed) {
+        const io_uring_cqe &cqe = cqes[head & *cqMask];
+        ReadRequest &request = batch[cqe.user_data];
+        // Failed or short reads are finished with pread by the caller
+        request.bytesRead = cqe.res > 0 ? cqe.res : 0;
+        if (cqe.res == -EINVAL || cqe.res == -EOPNOTSUPP) {
+          // Kernels before 5.6 have io_uring but no plain read operation
+          supported = false;
+        }
+      }
+      std::atomic_ref<unsigned>(*cqHead).store(head,
+                                               std::memory_order_release);
+    }
+    return supported;
+  }
+};
+
+/**
+ * @brief Whether io_uring has been found to be unusable, so later batches go
+ * straight to pread.
+ */
+std::atomic<bool> ioUringDisabled = false;
+
+/**
+ * @brief Gets this thread's ring, creating it on first use.
+ * @return The ring, or nullptr if io_uring is unavailable.
+ */
+IoRing *threadRing() {
+  if (ioUringDisabled.load(std::memory_order_relaxed)) {
+    return nullptr;
+  }
+  thread_local IoRing ring;
+  thread_local bool initialised = false;
+  if (!initialised) {
+    initialised = true;
+    if (!ring.init(64)) {
+      ioUringDisabled.store(true, std::memory_order_relaxed);
+      return nullptr;
+    }
+  }
+  return ring.ringFd >= 0 && ring.entries > 0 ? &ring : nullptr;
+}
+
+#endif // TIMEKEEPING_IO_URING
+
+} // namespace
+
+void readRanges(int fd, std::span<ReadRequest> requests) {
+  for (auto &request : requests) {
+    request.bytesRead = 0;
+  }
+
+#ifdef TIMEKEEPING_IO_URING
+  // A single read gains nothing from the ring
+  if (requests.size() > 1) {
+    if (IoRing *ring = threadRing()) {
+      for (std::size_t first = 0; first < requests.size();
+           first += ring->entries) {
+        std::size_t count =
+            std::min<std::size_t>(ring->entries, requests.size() - first);
+        if (!ring->read(fd, requests.subspan(first, count))) {
+          ioUringDisabled.store(true, std::memory_order_relaxed);
+          break;
+        }
+      }
+    }
+  }
+#endif
+
+  // Finish anything not read in full, or everything without io_uring
+  for (auto &request : requests) {
+    preadRemaining(fd, request);
+  }
+}
+
+bool ioUringAvailable() {
+#ifdef TIMEKEEPING_IO_URING
+  return threadRing() != nullptr;
+#else
+  return false;
+#endif
+}
@@ -0,0 +1,54 @@
+#ifndef __BATCHREAD_H__
+#define __BATCHREAD_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+/**
+ * @brief One positional read of a batch.
+ */
+struct ReadRequest {
+  /**
+   * @brief Position in the file to read from.
+   */
+  std::int64_t offset = 0;
+
+  /**
+   * @brief Number of bytes to read.
+   */
+  std::size_t length = 0;
+
+  /**
+   * @brief Destination of the read, at least length bytes.
+   */
+  char *buffer = nullptr;
+
+  /**
+   * @brief Number of bytes read, less than length only at the end of file.
+   */
+  std::size_t bytesRead = 0;
+};
+
+/**
+ * @brief Reads many ranges of a file without touching its file position.
+ *
+ * On Linux the reads are submitted together through io_uring, using the raw
+ * system calls so no library is needed, and complete in whatever order the
+ * storage returns them. Where io_uring is unavailable, or refused by the
+ * kernel, each range is read with pread instead. Either way every request is
+ * complete when the call returns.
+ *
+ * @param fd A file descriptor open for reading.
+ * @param requests The ranges to read.
+ * @throws std::runtime_error if a read fails.
+ */
+void readRanges(int fd, std::span<ReadRequest> requests);
+
+/**
+ * @brief Checks whether readRanges can use io_uring on this system.
+ * @return true if an io_uring instance could be created.
+ */
+bool ioUringAvailable();
+
+#endif // __BATCHREAD_H__
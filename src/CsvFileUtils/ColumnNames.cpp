@@ -0,0 +1,54 @@
+#include "ColumnNames.hpp"
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+namespace {
+/**
+ * @brief The live lists, by their names.
+ */
+struct Registry {
+  std::mutex mutex;
+  std::map<std::vector<std::string>, std::weak_ptr<const ColumnNames>> lists;
+};
+
+Registry &registry() {
+  static Registry instance;
+  return instance;
+}
+} // namespace
+
+std::shared_ptr<const ColumnNames>
+ColumnNames::intern(const std::vector<std::string> &names) {
+  if (names.empty()) {
+    return empty();
+  }
+
+  Registry &shared = registry();
+  std::lock_guard<std::mutex> lock(shared.mutex);
+  auto it = shared.lists.find(names);
+  if (it != shared.lists.end()) {
+    if (auto list = it->second.lock()) {
+      return list;
+    }
+  }
+
+  // Drop the lists no longer held by anyone before adding another
+  std::erase_if(shared.lists,
+                [](const auto &entry) { return entry.second.expired(); });
+
+  std::shared_ptr<const ColumnNames> list(new ColumnNames(names));
+  shared.lists[names] = list;
+  return list;
+}
+
+const std::shared_ptr<const ColumnNames> &ColumnNames::empty() {
+  static const std::shared_ptr<const ColumnNames> list(new ColumnNames({}));
+  return list;
+}
+
+long ColumnNames::index(std::string_view name) const {
+  auto it = std::find(names_.begin(), names_.end(), name);
+  return it == names_.end() ? -1 : it - names_.begin();
+}
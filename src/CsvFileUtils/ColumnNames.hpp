@@ -0,0 +1,65 @@
+#ifndef __COLUMNNAMES_H__
+#define __COLUMNNAMES_H__
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief An immutable list of column names, interned so every file and group
+ * with the same columns shares one copy.
+ *
+ * Lists are only created by intern(), which hands out the live list equal to
+ * the names if there is one, so two interned lists are equal exactly when
+ * they are the same object. Lists are immutable and may be shared between
+ * threads.
+ */
+struct ColumnNames {
+private:
+  /**
+   * @brief The names, in file order.
+   */
+  std::vector<std::string> names_;
+
+  /**
+   * @brief Construct a list of names, for intern().
+   */
+  explicit ColumnNames(std::vector<std::string> names)
+      : names_(std::move(names)) {}
+
+public:
+  /**
+   * @brief Gets the shared list of the given names.
+   * @param names The column names, in file order.
+   * @return The list, shared with every other holder of the same names.
+   */
+  static std::shared_ptr<const ColumnNames>
+  intern(const std::vector<std::string> &names);
+
+  /**
+   * @brief Gets the shared empty list.
+   */
+  static const std::shared_ptr<const ColumnNames> &empty();
+
+  /**
+   * @brief Gets the names.
+   * @return The column names, in file order.
+   */
+  const std::vector<std::string> &names() const { return names_; }
+
+  /**
+   * @brief Gets the number of columns.
+   */
+  std::size_t size() const { return names_.size(); }
+
+  /**
+   * @brief Finds the position of a column.
+   * @param name The column name.
+   * @return The position of the column in file order, or -1 if missing.
+   */
+  long index(std::string_view name) const;
+};
+
+#endif // __COLUMNNAMES_H__
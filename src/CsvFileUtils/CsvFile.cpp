@@ -3,7 +3,6 @@
 #include "LineMapFile.hpp"
 
 #include <boost/algorithm/string.hpp>
-#include <boost/tokenizer.hpp>
 
 #include <fstream>
 #include <sstream>
@@ -11,19 +10,22 @@
 
 #include <iostream>
 
-CsvFile::CsvFile(CsvFileMetadata metadata, bool overwriteCache) {
+CsvFile::CsvFile(CsvFileMetadata metadata, bool overwriteCache,
+                 bool complete) {
   metadata_ = std::move(metadata);
+  tokenizer_ = Tokenizer(metadata_.delimiter(), metadata_.multiDelimiter());
 
   // Open the CSV file for reading
   dataFile_.open(metadata_.dataFilePath(), std::ios::in);
   if (!dataFile_.is_open()) {
     throw std::runtime_error("Failed to open input file");
   }
+  dataFd_ = CsvFileView::openData(metadata_.dataFilePath());
 
   // Initialize the line map file
   lineMap_.setFilePath(metadata_.cacheFilePath());
 
-  update(overwriteCache);
+  update(overwriteCache, complete);
 }
 
 CsvFile::CsvFile(const std::string jsonFilePath, bool overwriteCache) {
@@ -39,12 +41,7 @@ CsvFile::~CsvFile() {
   }
 }
 
-bool CsvFile::update(bool overwriteCache) {
-  boost::escaped_list_separator<char> separator("\\", metadata_.delimiter(),
-                                                "\"");
-  boost::tokenizer<boost::escaped_list_separator<char>> tokenizer(
-      std::string(""), separator);
-
+bool CsvFile::update(bool overwriteCache, bool complete) {
   std::streampos pos;
   std::string line;
 
@@ -60,6 +57,9 @@ bool CsvFile::update(bool overwriteCache) {
 
   bool file_updated = false;
 
+  // Clear the EOF and fail flags left by the previous scan
+  dataFile_.clear();
+
   if (!lineMap_.empty()) {
     // Go to the start of the last line read
     dataFile_.seekg(lineMap_.back(), std::ios::beg);
@@ -81,6 +81,12 @@ bool CsvFile::update(bool overwriteCache) {
     pos = dataFile_.tellg();
     std::getline(dataFile_, line);
 
+    // A line cut off by the end of the file may be half written, read it
+    // again once the writer has finished it
+    if (!complete && dataFile_.eof() && !line.empty()) {
+      break;
+    }
+
     // trim whitespace from the line
     boost::algorithm::trim(line);
 
@@ -90,17 +96,14 @@ bool CsvFile::update(bool overwriteCache) {
       continue;
     }
 
-    // Tokenize the line using the specified delimiter
-    tokenizer =
-        boost::tokenizer<boost::escaped_list_separator<char>>(line, separator);
-
     // Handle the header line if specified
     if (header_line) {
       // If header is specified, read the first line as column names
       if (metadata_.colNames().empty()) {
-        for (const auto &token : tokenizer) {
-          metadata_.appendColName(token);
-        }
+        std::vector<std::string_view> fields;
+        tokenizer_.split(line, fields);
+        metadata_.setColNames(
+            std::vector<std::string>(fields.begin(), fields.end()));
       }
 
       // Update the header line flag
@@ -120,6 +123,9 @@ bool CsvFile::update(bool overwriteCache) {
     file_updated = true;
   }
 
+  // Publish the new positions to readers
+  view_ = CsvFileView(dataFd_, lineMap_.view(), tokenizer_);
+
   metadata_.setSize(lineMap_.size()); // Update the total lines count
 
   // Write the metadata to the JSON file
@@ -128,62 +134,36 @@ bool CsvFile::update(bool overwriteCache) {
   return file_updated;
 }
 
-std::string CsvFile::getRawLine(long row) {
-  // check if the row index is valid
-  if (row < 0 || row >= lineMap_.size()) {
-    throw std::out_of_range("Row index out of range");
-  }
-
-  // Clear any EOF or error flags
-  dataFile_.clear();
-  // move input file stream to the start of the specified row
-
-  dataFile_.seekg(lineMap_[row], std::ios::beg);
-
-  // Read the line from the file
-  std::string line;
-  std::getline(dataFile_, line);
-
-  if (dataFile_.fail()) {
-    throw std::runtime_error("Failed to read line from file");
-  }
-
-  return line;
+std::string CsvFile::getRawLine(long row) const {
+  return view_.getRawLine(row);
 }
 
-std::map<std::string, std::string> CsvFile::getRow(long row) {
-  std::map<std::string, std::string> rowData;
-
-  // get the line from the specified row
-  std::string line = getRawLine(row);
+std::map<std::string, std::string> CsvFile::getRow(long row) const {
+  return view_.getRow(row, metadata_.colNames());
+}
 
-  // Set up the tokenizer with the specified delimiter
-  boost::escaped_list_separator<char> separator("\\", metadata_.delimiter(),
-                                                "\"");
-  boost::tokenizer<boost::escaped_list_separator<char>> tokenizer(line,
-                                                                  separator);
+ArenaRow CsvFile::getRow(long row, RowArena &arena) const {
+  return view_.getRow(row, *metadata_.columns(), arena);
+}
 
-  auto col_it = metadata_.colNames().begin();
-  for (const auto &token : tokenizer) {
-    std::string trimmed_token =
-        boost::algorithm::trim_copy(token); // Trim whitespace from the token
+void CsvFile::getFields(long row, const Projection &projection,
+                        std::vector<std::string_view> &values) const {
+  view_.getFields(row, projection, values);
+}
 
-    // If multi_delimiter is enabled and the token is empty, skip it
-    if (metadata_.multiDelimiter() & trimmed_token.empty()) {
-      continue;
-    }
+void CsvFile::splitFields(std::string_view line, const Projection &projection,
+                          std::vector<std::string_view> &values) const {
+  view_.splitFields(line, projection, values);
+}
 
-    // Add the token to the row data map
-    if (col_it != metadata_.colNames().end()) {
-      rowData[*col_it] = trimmed_token;
-      ++col_it;
-    }
-  }
-  return rowData;
+std::vector<std::string> CsvFile::readRows(std::span<const long> rows) const {
+  return view_.readRows(rows);
 }
 
 CsvFile::CsvFile(const CsvFile &other)
-    : metadata_(other.metadata_), lineMap_(other.lineMap_) {
+    : metadata_(other.metadata_), dataFd_(other.dataFd_),
+      lineMap_(other.lineMap_), tokenizer_(other.tokenizer_),
+      view_(other.view_) {
 
   // Open the data file from the other CsvFile object
   dataFile_.open(other.metadata_.dataFilePath());
@@ -201,7 +181,10 @@ CsvFile &CsvFile::operator=(const CsvFile &other) {
     }
 
     metadata_ = other.metadata_;
+    dataFd_ = other.dataFd_;
     lineMap_ = other.lineMap_;
+    tokenizer_ = other.tokenizer_;
+    view_ = other.view_;
   }
 
   return *this;
@@ -210,13 +193,18 @@ CsvFile &CsvFile::operator=(const CsvFile &other) {
 CsvFile::CsvFile(CsvFile &&other)
     : metadata_(std::move(other.metadata_)),
       dataFile_(std::move(other.dataFile_)),
-      lineMap_(std::move(other.lineMap_)) {}
+      dataFd_(std::move(other.dataFd_)), lineMap_(std::move(other.lineMap_)),
+      tokenizer_(std::move(other.tokenizer_)),
+      view_(std::move(other.view_)) {}
 
 CsvFile &CsvFile::operator=(CsvFile &&other) {
   if (this != &other) {
     dataFile_ = std::move(other.dataFile_); // Move the file stream
     metadata_ = std::move(other.metadata_);
+    dataFd_ = std::move(other.dataFd_);
     lineMap_ = std::move(other.lineMap_);
+    tokenizer_ = std::move(other.tokenizer_);
+    view_ = std::move(other.view_);
 
     // Ensure the moved object is in a valid state
     other.dataFile_.close();
@@ -2,11 +2,17 @@
 #define __CSVFILE_H__
 
 #include "CsvFileMetadata.hpp"
+#include "CsvFileView.hpp"
 #include "LineMapFile.hpp"
+#include "Projection.hpp"
+#include "RowArena.hpp"
+#include "Tokenizer.hpp"
 
 #include <fstream>
 #include <ios>
 #include <map>
+#include <memory>
+#include <span>
 
 /**
  * @brief Random access to a dataset in a single CSV file.
@@ -15,6 +21,11 @@
  * memory. This is useful for large datasets where loading the entire file is
  * impractical. The class provides methods to read specific rows and columns
  * from the CSV file.
+ *
+ * Reads are positional and go through an immutable CsvFileView, so any
+ * number of threads can read from the same file at once without locking.
+ * update() replaces the view and must not run at the same time as reads, use
+ * view() to keep reading a fixed set of rows while the file is updated.
  */
 struct CsvFile {
 
@@ -29,19 +40,39 @@ private:
    */
   std::ifstream dataFile_;
 
+  /**
+   * @brief Descriptor of the data file for positional reads, shared with the
+   * views.
+   */
+  std::shared_ptr<const int> dataFd_;
+
   /**
    * @brief Map of line numbers to their positions in the file, relative to the
    * first line.
    */
   LineMapFile lineMap_;
 
+  /**
+   * @brief Splits lines into fields using the delimiter configuration.
+   */
+  Tokenizer tokenizer_;
+
+  /**
+   * @brief Read access to the rows indexed so far, used by every read so
+   * reads never touch a shared stream position.
+   */
+  CsvFileView view_;
+
 public:
   /**
    * @brief Constructor to initialize the CSV data file with the given metadata.
    * @param metadata The metadata specifying the CSV data file.
    * @param overwriteCache If true, ignores the cache file if it exists.
+   * @param complete If false, the file may still be being written, see
+   * update().
    */
-  CsvFile(CsvFileMetadata metadata, bool overwriteCache = false);
+  CsvFile(CsvFileMetadata metadata, bool overwriteCache = false,
+          bool complete = true);
 
   /**
    * @brief Constructor to initialize reading metadata from the specified json
@@ -60,10 +91,12 @@ public:
   /**
    * @brief Update the line map based on any new lines added to the file.
    * @param overwriteCache If true, deletes the cached line map and rebuilds.
+   * @param complete If false, the file may still be being written and a last
+   * line without a newline is left for a later update instead of indexed.
    * @return true if the file was updated, false otherwise.
    * lines on a MacBook Pro M4 Max
    */
-  bool update(bool overwriteCache = false);
+  bool update(bool overwriteCache = false, bool complete = true);
 
   /**
    * @brief Reads a specific row from the CSV file.
@@ -73,7 +106,7 @@ public:
    * @throws std::runtime_error if there is an error reading the line from the
    * file
    */
-  std::string getRawLine(long row);
+  std::string getRawLine(long row) const;
 
   /**
    * @brief Reads a specific row from the CSV file and returns it as a map of
@@ -85,7 +118,59 @@ public:
    * @throws std::runtime_error if there is an error reading the line from the
    * file
    */
-  std::map<std::string, std::string> getRow(long row);
+  std::map<std::string, std::string> getRow(long row) const;
+
+  /**
+   * @brief Reads a specific row into an arena, as named fields.
+   * @param row The row number to read (0-based index).
+   * @param arena The arena the row is made in.
+   * @return The row, valid until the arena is reset.
+   * @throws std::out_of_range if the row index is out of range.
+   * @throws std::runtime_error if there is an error reading the line.
+   */
+  ArenaRow getRow(long row, RowArena &arena) const;
+
+  /**
+   * @brief Reads only the projected columns of a specific row.
+   * @details Splitting stops after the last projected field and nothing is
+   * copied, the values are views into a buffer owned by the calling thread.
+   * @param row The row number to read (0-based index).
+   * @param projection The columns to read, built from this file's column
+   * names.
+   * @param values Receives one value per projected column, in projection
+   * order. The views stay valid until the next read on the same thread.
+   * @throws std::out_of_range if the row index is out of range.
+   * @throws std::runtime_error if there is an error reading the line from the
+   * file, or the row is missing a projected column.
+   */
+  void getFields(long row, const Projection &projection,
+                 std::vector<std::string_view> &values) const;
+
+  /**
+   * @brief Reads many rows from the CSV file in one batch.
+   * @details Requests are sorted by position and nearby rows are coalesced
+   * into single reads, which are then submitted together (see readRanges).
+   * Does not move the position of the data file stream.
+   * @param rows The row numbers to read (0-based index), in any order and
+   * possibly repeated.
+   * @return The raw data of each requested row, in request order.
+   * @throws std::out_of_range if a row index is out of range.
+   * @throws std::runtime_error if there is an error reading the file.
+   */
+  std::vector<std::string> readRows(std::span<const long> rows) const;
+
+  /**
+   * @brief Splits a raw line of this file into the projected columns.
+   * @param line A raw line, for example from readRows.
+   * @param projection The columns to read, built from this file's column
+   * names.
+   * @param values Receives one value per projected column, in projection
+   * order. The views stay valid until the line changes or the next split on
+   * the same thread.
+   * @throws std::runtime_error if the line is missing a projected column.
+   */
+  void splitFields(std::string_view line, const Projection &projection,
+                   std::vector<std::string_view> &values) const;
 
   // Compatability with vector of CsvDataFile objects
 
@@ -153,6 +238,12 @@ public:
    * @return The CsvFileMetadata object containing metadata information.
    */
   const CsvFileMetadata &metadata() const { return metadata_; }
+
+  /**
+   * @brief Gets read access to the rows indexed by the last update.
+   * @return The view, unaffected by later updates.
+   */
+  const CsvFileView &view() const { return view_; }
 };
 
 #endif // __CSVFILE_H__
\ No newline at end of file
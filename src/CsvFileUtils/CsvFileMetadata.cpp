@@ -14,7 +14,8 @@ CsvFileMetadata::CsvFileMetadata(std::string dataFilePath,
                                  long total_lines, std::size_t cache_size)
     : dataFilePath_(dataFilePath), cacheFilePath_(cacheFilePath),
       jsonFilePath_(jsonFilePath), comment_(comment), delimiter_(delimiter),
-      multiDelimiter_(multi_delimiter), header_(header), colNames_(col_names),
+      multiDelimiter_(multi_delimiter), header_(header),
+      columns_(ColumnNames::intern(col_names)),
       size_(total_lines), cache_size_(cache_size) {
   // Default for cacheFilePath if not provided
   if (cacheFilePath_.empty()) {
@@ -66,7 +67,7 @@ void CsvFileMetadata::writeToJsonFile() {
   obj["multi_delimiter"] = multiDelimiter_;
 
   obj["header"] = header_;
-  obj["col_names"] = boost::json::value_from(colNames_);
+  obj["col_names"] = boost::json::value_from(colNames());
 
   obj["total_lines"] = size_;
   obj["cache_size"] = cache_size_;
@@ -89,7 +90,7 @@ std::string CsvFileMetadata::toString() const {
       << "Header Processed: " << (header_ ? "true" : "false") << "\n"
       << "Column Names: ";
 
-  for (const auto &col : colNames_) {
+  for (const auto &col : colNames()) {
     oss << col << ", ";
   }
 
@@ -1,7 +1,10 @@
 #ifndef __CSVFILEMETADATA_H__
 #define __CSVFILEMETADATA_H__
 
+#include "ColumnNames.hpp"
+
 #include <cstddef>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -48,9 +51,10 @@ private:
   bool header_;
 
   /**
-   * @brief Column names in the CSV file.
+   * @brief Column names in the CSV file, shared with the other files of the
+   * same columns.
    */
-  std::vector<std::string> colNames_;
+  std::shared_ptr<const ColumnNames> columns_ = ColumnNames::empty();
 
   /**
    * @brief Total number of lines in the CSV file.
@@ -173,7 +177,17 @@ public:
    * @brief Gets the column names in the CSV file.
    * @return A vector of column names.
    */
-  const std::vector<std::string> &colNames() const { return colNames_; }
+  const std::vector<std::string> &colNames() const {
+    return columns_->names();
+  }
+
+  /**
+   * @brief Gets the shared list of column names in the CSV file.
+   * @return The interned column names.
+   */
+  const std::shared_ptr<const ColumnNames> &columns() const {
+    return columns_;
+  }
 
   /**
    * @brief Gets the total number of lines in the CSV file.
@@ -237,15 +251,18 @@ public:
    * @brief Sets the column names in the CSV file.
    * @param colNames A vector of column names to set.
    */
-  // void setColNames(const std::vector<std::string>& colNames) { colNames_ =
-  // colNames; }
+  void setColNames(const std::vector<std::string> &colNames) {
+    columns_ = ColumnNames::intern(colNames);
+  }
 
   /**
    * @brief Append the given column name to the list of column names.
    * @param colName The column name to append.
    */
   void appendColName(const std::string &colName) {
-    colNames_.push_back(colName);
+    std::vector<std::string> names = columns_->names();
+    names.push_back(colName);
+    columns_ = ColumnNames::intern(names);
   }
 
   /**
@@ -0,0 +1,245 @@
+#include "CsvFileView.hpp"
+#include "BatchRead.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+/**
+ * @brief Per thread storage for the line behind the views from getFields.
+ */
+thread_local std::string lineBuffer;
+
+/**
+ * @brief Per thread storage for all fields of the line being split.
+ */
+thread_local std::vector<std::string_view> fieldBuffer;
+} // namespace
+
+std::shared_ptr<const int>
+CsvFileView::openData(const std::string &dataFilePath) {
+  int fd = ::open(dataFilePath.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw std::runtime_error("Failed to open input file");
+  }
+  return std::shared_ptr<const int>(new int(fd), [](const int *fd) {
+    ::close(*fd);
+    delete fd;
+  });
+}
+
+void CsvFileView::readLine(long row, std::string &line) const {
+  // check if the row index is valid
+  if (row < 0 || row >= static_cast<long>(lines_.size())) {
+    throw std::out_of_range("Row index out of range");
+  }
+
+  // The next row's start bounds the line, except for comment lines in
+  // between, so it is a good first guess at the length
+  std::streamoff begin = lines_[row];
+  size_t length = row + 1 < static_cast<long>(lines_.size())
+                      ? lines_[row + 1] - begin
+                      : 256;
+
+  // Positional reads leave no shared state behind, so threads can read at once
+  size_t filled = 0;
+  while (true) {
+    line.resize(std::max(length, filled + 1));
+    ssize_t count =
+        ::pread(*dataFd_, line.data() + filled, line.size() - filled,
+                begin + filled);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error("Failed to read line from file: " +
+                               std::string(std::strerror(errno)));
+    }
+
+    const char *newline = static_cast<const char *>(
+        std::memchr(line.data() + filled, '\n', count));
+    if (newline) {
+      line.resize(newline - line.data());
+      return;
+    }
+
+    filled += count;
+    if (count == 0) {
+      // End of file, the last line has no terminator
+      if (filled == 0) {
+        throw std::runtime_error("Failed to read line from file");
+      }
+      line.resize(filled);
+      return;
+    }
+    length = 2 * line.size();
+  }
+}
+
+std::string CsvFileView::getRawLine(long row) const {
+  std::string line;
+  readLine(row, line);
+  return line;
+}
+
+std::map<std::string, std::string>
+CsvFileView::getRow(long row, const std::vector<std::string> &colNames) const {
+  std::map<std::string, std::string> rowData;
+
+  // get the line from the specified row
+  std::string line = getRawLine(row);
+
+  // Split the line into trimmed fields, no more than there are columns
+  tokenizer_.split(line, fieldBuffer, colNames.size());
+
+  for (size_t i = 0; i < fieldBuffer.size(); ++i) {
+    rowData[colNames[i]] = std::string(fieldBuffer[i]);
+  }
+  return rowData;
+}
+
+ArenaRow CsvFileView::getRow(long row, const ColumnNames &columns,
+                            RowArena &arena) const {
+  readLine(row, lineBuffer);
+  return arena.row(columns, lineBuffer, tokenizer_);
+}
+
+void CsvFileView::getFields(long row, const Projection &projection,
+                        std::vector<std::string_view> &values) const {
+  readLine(row, lineBuffer);
+  splitFields(lineBuffer, projection, values);
+}
+
+void CsvFileView::splitFields(std::string_view line, const Projection &projection,
+                          std::vector<std::string_view> &values) const {
+  // Only split as far as the last projected column
+  tokenizer_.split(line, fieldBuffer, projection.fieldCount());
+  if (fieldBuffer.size() < projection.fieldCount()) {
+    throw std::runtime_error("Row is missing a projected column: " +
+                             std::string(line));
+  }
+
+  values.clear();
+  for (size_t position : projection.positions()) {
+    values.push_back(fieldBuffer[position]);
+  }
+}
+
+std::vector<std::string> CsvFileView::readRows(std::span<const long> rows) const {
+  const long row_count = lines_.size();
+  for (long row : rows) {
+    if (row < 0 || row >= row_count) {
+      throw std::out_of_range("Row index out of range");
+    }
+  }
+
+  // Visit the requests in file order
+  std::vector<size_t> order(rows.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(),
+            [&rows](size_t a, size_t b) { return rows[a] < rows[b]; });
+
+  struct stat file_stat;
+  if (::fstat(*dataFd_, &file_stat) != 0) {
+    throw std::runtime_error("Failed to stat data file");
+  }
+
+  // A row runs from its start to the start of the next row, so comment
+  // lines in between are read and discarded
+  std::vector<std::streamoff> begins(rows.size());
+  std::vector<std::streamoff> ends(rows.size());
+  for (size_t i : order) {
+    begins[i] = lines_[rows[i]];
+    ends[i] = rows[i] + 1 < row_count ? lines_[rows[i] + 1]
+                                      : std::streamoff(file_stat.st_size);
+  }
+
+  // Coalesce rows that are close together into single reads
+  constexpr std::streamoff coalesce_gap = 4096;
+  std::vector<ReadRequest> requests;
+  std::vector<size_t> request_of(rows.size());
+  for (size_t i : order) {
+    if (requests.empty() ||
+        begins[i] > requests.back().offset +
+                        std::streamoff(requests.back().length) +
+                        coalesce_gap) {
+      requests.push_back({begins[i], 0, nullptr, 0});
+    }
+    ReadRequest &request = requests.back();
+    request.length = std::max<size_t>(request.length, ends[i] - request.offset);
+    request_of[i] = requests.size() - 1;
+  }
+
+  std::vector<std::string> buffers(requests.size());
+  for (size_t r = 0; r < requests.size(); ++r) {
+    buffers[r].resize(requests[r].length);
+    requests[r].buffer = buffers[r].data();
+  }
+
+  readRanges(*dataFd_, requests);
+
+  // Cut each row out of its read, up to the end of its line
+  std::vector<std::string> lines(rows.size());
+  for (size_t i = 0; i < rows.size(); ++i) {
+    const ReadRequest &request = requests[request_of[i]];
+    size_t begin = begins[i] - request.offset;
+    size_t end = ends[i] - request.offset;
+    if (end > request.bytesRead) {
+      throw std::runtime_error("Failed to read line from file");
+    }
+
+    std::string_view text(request.buffer + begin, end - begin);
+    lines[i] = std::string(text.substr(0, text.find('\n')));
+  }
+  return lines;
+}
+
+void CsvFileView::readBlock(long first, long last, std::vector<char> &data,
+                            std::vector<std::string_view> &lines) const {
+  const long row_count = lines_.size();
+  if (first < 0 || first > last || last > row_count) {
+    throw std::out_of_range("Row index out of range");
+  }
+  lines.clear();
+  if (first == last) {
+    data.clear();
+    return;
+  }
+
+  // The block ends at the start of the row after it, or at the end of the
+  // file, which may hold part of a row not yet indexed
+  const std::streamoff begin = lines_[first];
+  std::streamoff end;
+  if (last < row_count) {
+    end = lines_[last];
+  } else {
+    struct stat file_stat;
+    if (::fstat(*dataFd_, &file_stat) != 0) {
+      throw std::runtime_error("Failed to stat data file");
+    }
+    end = file_stat.st_size;
+  }
+
+  data.resize(end - begin);
+  ReadRequest request{begin, data.size(), data.data(), 0};
+  readRanges(*dataFd_, std::span<ReadRequest>(&request, 1));
+  if (request.bytesRead < data.size()) {
+    throw std::runtime_error("Failed to read rows from file");
+  }
+
+  // Cut each row out of the block, up to the end of its line
+  for (long row = first; row < last; ++row) {
+    const size_t row_begin = lines_[row] - begin;
+    const size_t row_end =
+        row + 1 < last ? size_t(lines_[row + 1] - begin) : data.size();
+    std::string_view text(data.data() + row_begin, row_end - row_begin);
+    lines.push_back(text.substr(0, text.find('\n')));
+  }
+}
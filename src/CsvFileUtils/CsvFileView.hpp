@@ -0,0 +1,176 @@
+#ifndef __CSVFILEVIEW_H__
+#define __CSVFILEVIEW_H__
+
+#include "LineMapView.hpp"
+#include "Projection.hpp"
+#include "RowArena.hpp"
+#include "Tokenizer.hpp"
+
+#include <map>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Immutable read access to the rows of a CSV file indexed so far.
+ *
+ * Holds everything needed to read rows: the open data file, a view of the
+ * line map and the delimiter configuration. Reads are positional and leave
+ * no state behind, so a view can be shared by any number of threads. Views
+ * are cheap to copy and keep reading the same rows after the file they came
+ * from is updated.
+ */
+struct CsvFileView {
+private:
+  /**
+   * @brief Descriptor of the data file, closed with the last copy.
+   */
+  std::shared_ptr<const int> dataFd_;
+
+  /**
+   * @brief Positions of the rows in the data file.
+   */
+  LineMapView lines_;
+
+  /**
+   * @brief Splits lines into fields using the delimiter configuration.
+   */
+  Tokenizer tokenizer_;
+
+public:
+  /**
+   * @brief Default constructor for a view with no rows.
+   */
+  CsvFileView() = default;
+
+  /**
+   * @brief Construct a view of the given rows of a data file.
+   * @param dataFd The open data file, from openData.
+   * @param lines Positions of the rows in the data file.
+   * @param tokenizer Splits lines using the file's delimiter configuration.
+   */
+  CsvFileView(std::shared_ptr<const int> dataFd, LineMapView lines,
+              Tokenizer tokenizer)
+      : dataFd_(std::move(dataFd)), lines_(std::move(lines)),
+        tokenizer_(std::move(tokenizer)) {}
+
+  /**
+   * @brief Opens a data file for positional reads.
+   * @param dataFilePath The path to the data file.
+   * @return The descriptor, closed when the last reference is released.
+   * @throws std::runtime_error if the file cannot be opened.
+   */
+  static std::shared_ptr<const int> openData(const std::string &dataFilePath);
+
+  /**
+   * @brief Gets the number of rows in the view.
+   * @return The number of rows.
+   */
+  long size() const { return static_cast<long>(lines_.size()); }
+
+  /**
+   * @brief Gets the tokenizer for the file's delimiter configuration.
+   * @return The tokenizer.
+   */
+  const Tokenizer &tokenizer() const { return tokenizer_; }
+
+  /**
+   * @brief Reads a specific row into a string.
+   * @param row The row number to read (0-based index).
+   * @param line Receives the raw data of the row, reusing its storage.
+   * @throws std::out_of_range if the row index is out of range.
+   * @throws std::runtime_error if there is an error reading the line.
+   */
+  void readLine(long row, std::string &line) const;
+
+  /**
+   * @brief Reads a specific row.
+   * @param row The row number to read (0-based index).
+   * @return A string containing the raw data of the specified row.
+   * @throws std::out_of_range if the row index is out of range.
+   * @throws std::runtime_error if there is an error reading the line.
+   */
+  std::string getRawLine(long row) const;
+
+  /**
+   * @brief Reads a specific row as a map of column names to values.
+   * @param row The row number to read (0-based index).
+   * @param colNames The column names of the file, in file order.
+   * @return A map where keys are column names and values are the corresponding
+   * data for that row.
+   * @throws std::out_of_range if the row index is out of range.
+   * @throws std::runtime_error if there is an error reading the line.
+   */
+  std::map<std::string, std::string>
+  getRow(long row, const std::vector<std::string> &colNames) const;
+
+  /**
+   * @brief Reads a specific row into an arena, as named fields.
+   * @param row The row number to read (0-based index).
+   * @param columns The column names of the file, in file order.
+   * @param arena The arena the row is made in.
+   * @return The row, valid until the arena is reset.
+   * @throws std::out_of_range if the row index is out of range.
+   * @throws std::runtime_error if there is an error reading the line.
+   */
+  ArenaRow getRow(long row, const ColumnNames &columns,
+                  RowArena &arena) const;
+
+  /**
+   * @brief Reads only the projected columns of a specific row.
+   * @param row The row number to read (0-based index).
+   * @param projection The columns to read, built from the file's column
+   * names.
+   * @param values Receives one value per projected column, in projection
+   * order. The views are into a buffer owned by the calling thread and stay
+   * valid until the next read on the same thread.
+   * @throws std::out_of_range if the row index is out of range.
+   * @throws std::runtime_error if there is an error reading the line, or the
+   * row is missing a projected column.
+   */
+  void getFields(long row, const Projection &projection,
+                 std::vector<std::string_view> &values) const;
+
+  /**
+   * @brief Splits a raw line of the file into the projected columns.
+   * @param line A raw line, for example from readRows.
+   * @param projection The columns to read, built from the file's column
+   * names.
+   * @param values Receives one value per projected column, in projection
+   * order. The views stay valid until the line changes or the next split on
+   * the same thread.
+   * @throws std::runtime_error if the line is missing a projected column.
+   */
+  void splitFields(std::string_view line, const Projection &projection,
+                   std::vector<std::string_view> &values) const;
+
+  /**
+   * @brief Reads many rows in one batch.
+   * @details Requests are sorted by position and nearby rows are coalesced
+   * into single reads, which are then submitted together (see readRanges).
+   * @param rows The row numbers to read (0-based index), in any order and
+   * possibly repeated.
+   * @return The raw data of each requested row, in request order.
+   * @throws std::out_of_range if a row index is out of range.
+   * @throws std::runtime_error if there is an error reading the file.
+   */
+  std::vector<std::string> readRows(std::span<const long> rows) const;
+
+  /**
+   * @brief Reads a run of consecutive rows with a single read.
+   * @details The bytes from the first row to the end of the last are read
+   * into data, and each row is cut out of them up to the end of its line.
+   * @param first The first row to read (0-based index).
+   * @param last One past the last row to read.
+   * @param data Receives the bytes read, reusing its storage.
+   * @param lines Receives one view into data per row, in row order.
+   * @throws std::out_of_range if the rows are out of range.
+   * @throws std::runtime_error if there is an error reading the file.
+   */
+  void readBlock(long first, long last, std::vector<char> &data,
+                 std::vector<std::string_view> &lines) const;
+};
+
+#endif // __CSVFILEVIEW_H__
@@ -11,7 +11,6 @@ CsvGroup::CsvGroup(CsvGroupMetadata metadata, bool ignoreCache) {
 
   this->metadata_ = metadata;
   this->files_ = std::vector<CsvFile>();
-  this->startingLineNumbers_ = std::vector<long>();
 
   update(ignoreCache);
 }
@@ -63,15 +62,7 @@ bool CsvGroup::update(bool ignoreCache) {
     if (it != files_.end()) {
       file_updated |= it->update();
     } else {
-      // If the file is not in the list, create a new CsvFile object
-      CsvFileMetadata metadata(
-          dataPath, "", "", metadata_.comment(), metadata_.delimiter(),
-          metadata_.multiDelimiter(), metadata_.header(), metadata_.colNames(),
-          -1 // Total lines will be determined later
-      );
-      CsvFile csv_file(metadata, ignoreCache);
-      files_.push_back(csv_file);
-
+      addFile(dataPath, ignoreCache);
       file_updated = true; // Mark that the file list was updated
     }
   }
@@ -79,6 +70,53 @@ bool CsvGroup::update(bool ignoreCache) {
   // Sort the files vector based on the file path
   std::sort(files_.begin(), files_.end());
 
+  return publish(file_updated);
+}
+
+bool CsvGroup::update(const CsvGroupChanges &changes) {
+  if (changes.rescan) {
+    return update();
+  }
+
+  bool file_updated = false;
+  bool file_added = false;
+
+  // Only the named files are read, the rest of the tree is not touched
+  for (size_t i = 0; i < changes.paths.size(); ++i) {
+    const std::string &dataPath = changes.paths[i];
+    auto it = std::find_if(files_.begin(), files_.end(),
+                           [&dataPath](const CsvFile &file) {
+                             return file.metadata().dataFilePath() == dataPath;
+                           });
+
+    if (it != files_.end()) {
+      file_updated |= it->update(false, changes.complete[i]);
+    } else if (std::filesystem::is_regular_file(dataPath)) {
+      addFile(dataPath, false, changes.complete[i]);
+      file_added = true;
+    }
+  }
+
+  if (file_added) {
+    // Sorting copies the files, which reopens them, so only sort when needed
+    std::sort(files_.begin(), files_.end());
+  } else if (!file_updated) {
+    return false;
+  }
+  return publish(true);
+}
+
+void CsvGroup::addFile(const std::string &dataPath, bool ignoreCache,
+                       bool complete) {
+  CsvFileMetadata metadata(
+      dataPath, "", "", metadata_.comment(), metadata_.delimiter(),
+      metadata_.multiDelimiter(), metadata_.header(), metadata_.colNames(),
+      -1 // Total lines will be determined later
+  );
+  files_.push_back(CsvFile(metadata, ignoreCache, complete));
+}
+
+bool CsvGroup::publish(bool file_updated) {
   // If col_names is empty, use the first file's column names
   if (metadata_.colNames().empty() && !files_.empty()) {
     metadata_.setColNames(files_[0].metadata().colNames());
@@ -86,9 +124,9 @@ bool CsvGroup::update(bool ignoreCache) {
 
   // Ensure all files have the same column names
   if (!files_.empty()) {
-    // Ensure all files have the same column names
+    // Interned names are equal only when they are the same list
     for (const auto &file : files_) {
-      if (file.metadata().colNames() != metadata_.colNames()) {
+      if (file.metadata().columns() != metadata_.columns()) {
         throw std::runtime_error("All files must have the same column names");
       }
     }
@@ -101,17 +139,20 @@ bool CsvGroup::update(bool ignoreCache) {
   }
   metadata_.setDataPaths(file_path_list);
 
-  // Compile list of starting line numbers
-  startingLineNumbers_.clear();
-  long lines = 0;
-  for (int i = 0; i < files_.size(); i++) {
-    const auto &file = files_[i];
-    startingLineNumbers_.push_back(lines);
-    lines += file.metadata().size(); // Get the size from the file metadata
+  // Build the new version from the files' views, which also counts the rows
+  std::vector<CsvFileView> views;
+  for (const auto &file : files_) {
+    views.push_back(file.view());
   }
+  current_ = CsvGroupSnapshot(metadata_, std::move(views));
 
   // Update total lines count
-  metadata_.setSize(lines);
+  metadata_.setSize(current_.size());
+
+  // Readers that took the previous version keep it until they let go
+  if (file_updated || !published_.load()) {
+    published_.store(std::make_shared<const CsvGroupSnapshot>(current_));
+  }
 
   if (file_updated) {
     // Write the updated metadata to the JSON file
@@ -121,36 +162,37 @@ bool CsvGroup::update(bool ignoreCache) {
   return file_updated; // Return true if the file list was updated
 }
 
-std::pair<long, long> CsvGroup::getFileIndexAndRow(long row) const {
-  if (row < 0 || row >= metadata_.size()) {
-    throw std::out_of_range("Row index out of range");
-  }
+CsvGroupSnapshot CsvGroup::snapshot() const {
+  std::shared_ptr<const CsvGroupSnapshot> latest = published_.load();
+  return latest ? *latest : CsvGroupSnapshot();
+}
 
-  // Find the file index for the given row
-  long file_index = 0;
-  while (file_index < startingLineNumbers_.size() - 1 &&
-         row >= startingLineNumbers_[file_index + 1]) {
-    file_index++;
-  }
+std::pair<long, long> CsvGroup::getFileIndexAndRow(long row) const {
+  return current_.getFileIndexAndRow(row);
+}
 
-  return {file_index, row - startingLineNumbers_[file_index]};
+std::string CsvGroup::getRawLine(long row) const {
+  return current_.getRawLine(row);
 }
 
-std::string CsvGroup::getRawLine(long row) {
-  // Get the file index and row number within that file
-  auto [file_index, row_in_file] = getFileIndexAndRow(row);
+std::map<std::string, std::string> CsvGroup::getRow(long row) const {
+  return current_.getRow(row);
+}
 
-  // Read the specified row from the determined file
-  return files_[file_index].getRawLine(row_in_file);
+void CsvGroup::getFields(long row, const Projection &projection,
+                         std::vector<std::string_view> &values) const {
+  current_.getFields(row, projection, values);
 }
 
-std::map<std::string, std::string> CsvGroup::getRow(long row) {
-  // Get the file index and row number within that file
-  auto [file_index, row_in_file] = getFileIndexAndRow(row);
+std::vector<std::string>
+CsvGroup::readRows(std::span<const long> rows) const {
+  return current_.readRows(rows);
+}
 
-  // Read the specified row from the determined file
-  CsvFile file = files_[file_index];
-  return files_[file_index].getRow(row_in_file);
+void CsvGroup::splitFields(std::string_view line,
+                           const Projection &projection,
+                           std::vector<std::string_view> &values) const {
+  current_.splitFields(line, projection, values);
 }
 
 std::string CsvGroup::toString() const {
@@ -1,9 +1,21 @@
 #ifndef __CSVFILEGROUP_H__
 #define __CSVFILEGROUP_H__
 
+#include "../Utils/Published.hpp"
 #include "CsvFile.hpp"
 #include "CsvGroupMetadata.hpp"
+#include "CsvGroupSnapshot.hpp"
+#include "CsvGroupWatcher.hpp"
+#include "RowSchema.hpp"
 
+/**
+ * @brief Random access to a dataset split across several CSV files.
+ *
+ * Reads are const and safe to make from any number of threads at once, as
+ * long as update() is not running at the same time. To keep reading while
+ * the group is updated, take a snapshot(): each update publishes a new
+ * version, and snapshots already taken keep reading the version they pinned.
+ */
 struct CsvGroup {
 
 private:
@@ -18,9 +30,36 @@ private:
   std::vector<CsvFile> files_;
 
   /**
-   * @brief List of starting line numbers for each file in the group.
+   * @brief The rows indexed by the last update, read by this group's own
+   * read methods.
    */
-  std::vector<long> startingLineNumbers_;
+  CsvGroupSnapshot current_;
+
+  /**
+   * @brief The latest version, handed out by snapshot() without blocking
+   * update().
+   */
+  Published<CsvGroupSnapshot> published_;
+
+  /**
+   * @brief Opens a data file and adds it to the group.
+   * @param dataPath Path to the data file.
+   * @param ignoreCache Whether to ignore cached data.
+   * @param complete If false, the file may still be being written.
+   */
+  void addFile(const std::string &dataPath, bool ignoreCache,
+               bool complete = true);
+
+  /**
+   * @brief Checks the files, rebuilds the rows and publishes them to
+   * snapshot().
+   * @details The files must already be sorted by path.
+   * @param file_updated Whether any file gained rows or the list of files
+   * changed.
+   * @return file_updated.
+   * @throws std::runtime_error if the files have different column names.
+   */
+  bool publish(bool file_updated);
 
 public:
   /**
@@ -49,6 +88,26 @@ public:
    */
   bool update(bool ignoreCache = false);
 
+  /**
+   * @brief Updates only the files reported by a CsvGroupWatcher, adding any
+   * that are new, without rescanning the directory tree.
+   * @details Lines cut off at the end of a file that is still being written
+   * are left for a later update. Falls back to update() if the watcher lost
+   * events.
+   * @param changes The changed files, from CsvGroupWatcher::poll.
+   * @return true if the group was updated, false otherwise.
+   * @throws std::runtime_error if a new file has different column names.
+   */
+  bool update(const CsvGroupChanges &changes);
+
+  /**
+   * @brief Takes an immutable view of the group as of the last update.
+   * @details Safe to call from any thread, including while update() runs on
+   * another, which publishes the new version with a single pointer swap.
+   * @return A snapshot pinned to the current row count.
+   */
+  CsvGroupSnapshot snapshot() const;
+
   /**
    * @brief Get the file index and row number for a specific row in the group.
    * @param row The row number to get (0-based index).
@@ -66,7 +125,7 @@ public:
    * @throws std::runtime_error if there is an error reading the line from the
    * file
    */
-  std::string getRawLine(long row);
+  std::string getRawLine(long row) const;
 
   /**
    * @brief Reads a specific row from the group of CSV files and returns it as a
@@ -78,7 +137,81 @@ public:
    * @throws std::runtime_error if there is an error reading the line from the
    * file
    */
-  std::map<std::string, std::string> getRow(long row);
+  std::map<std::string, std::string> getRow(long row) const;
+
+  /**
+   * @brief Reads a specific row into an arena, as named fields.
+   * @param row The row number to read (0-based index).
+   * @param arena The arena the row is made in.
+   * @return The row, valid until the arena is reset or the group is updated.
+   * @throws std::out_of_range if the row index is out of range.
+   * @throws std::runtime_error if there is an error reading the line from the
+   * file
+   */
+  ArenaRow getRow(long row, RowArena &arena) const {
+    return current_.getRow(row, arena);
+  }
+
+  /**
+   * @brief Resolves column names to a projection of this group's columns.
+   * @param columns The columns to read, in the order they are wanted.
+   * @return A projection for use with getFields.
+   * @throws std::runtime_error if a column is not in the group.
+   */
+  Projection project(const std::vector<std::string> &columns) const {
+    return current_.project(columns);
+  }
+
+  /**
+   * @brief Reads only the projected columns of a specific row.
+   * @param row The row number to read (0-based index).
+   * @param projection The columns to read, from project().
+   * @param values Receives one value per projected column, in projection
+   * order. The views stay valid until the next read on the same thread.
+   * @throws std::out_of_range if the row index is out of range.
+   * @throws std::runtime_error if there is an error reading the line from the
+   * file, or the row is missing a projected column.
+   */
+  void getFields(long row, const Projection &projection,
+                 std::vector<std::string_view> &values) const;
+
+  /**
+   * @brief Reads many rows from the group in one batch.
+   * @details Rows are split by file and each file's rows are read with
+   * CsvFile::readRows, coalescing nearby rows.
+   * @param rows The row numbers to read (0-based index), in any order.
+   * @return The raw data of each requested row, in request order.
+   * @throws std::out_of_range if a row index is out of range.
+   * @throws std::runtime_error if there is an error reading a file.
+   */
+  std::vector<std::string> readRows(std::span<const long> rows) const;
+
+  /**
+   * @brief Splits a raw line of the group into the projected columns.
+   * @param line A raw line, for example from readRows.
+   * @param projection The columns to read, from project().
+   * @param values Receives one value per projected column, in projection
+   * order. The views stay valid until the line changes or the next read on
+   * the same thread.
+   * @throws std::runtime_error if the line is missing a projected column.
+   */
+  void splitFields(std::string_view line, const Projection &projection,
+                   std::vector<std::string_view> &values) const;
+
+  /**
+   * @brief Reads a specific row from the group of CSV files into the row
+   * struct of a schema.
+   * @param row The row number to read (0-based index).
+   * @param decoder A decoder created from this group's metadata.
+   * @return The decoded row.
+   * @throws std::out_of_range if the row index is out of range.
+   * @throws std::runtime_error if the row cannot be read or decoded.
+   */
+  template <typename Schema>
+  typename Schema::row_type getRow(long row,
+                                   RowDecoder<Schema> &decoder) const {
+    return current_.getRow(row, decoder);
+  }
 
   /**
    * @brief Overloaded operator to access a specific row by index.
@@ -109,23 +242,15 @@ public:
   // Getters for metadata and files
   /**
    * @brief Get the metadata of the CSV group.
-   * @return The metadata of the CSV group.
+   * @return The metadata of the CSV group, valid until the next update.
    */
-  const CsvGroupMetadata metadata() const { return metadata_; }
+  const CsvGroupMetadata &metadata() const { return metadata_; }
 
   /**
    * @brief Get the list of CSV files in the group.
    * @return A vector containing the CSV files in the group.
    */
   // const std::vector<CsvFile> &files() const { return files_; }
-
-  /**
-   * @brief Get the starting line numbers for each file in the group.
-   * @return A vector containing the starting line numbers for each file.
-   */
-  // const std::vector<long> &startingLineNumbers() const {
-  //   return startingLineNumbers_;
-  // }
 };
 
 #endif // __CSVFILEGROUP_H__
\ No newline at end of file
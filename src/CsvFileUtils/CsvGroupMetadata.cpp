@@ -23,7 +23,7 @@ CsvGroupMetadata::CsvGroupMetadata(
     delimiter_(delimiter),
     multiDelimiter_(multiDelimiter),
     header_(header),
-    colNames_(colNames),
+    columns_(ColumnNames::intern(colNames)),
     size_(size) 
 {
     // Default for jsonFilePath if not provided
@@ -78,7 +78,7 @@ void CsvGroupMetadata::writeToJsonFile() {
     obj["multi_delimiter"] = multiDelimiter_;
 
     obj["header"] = header_;
-    obj["colNames"] = boost::json::value_from(colNames_);
+    obj["colNames"] = boost::json::value_from(colNames());
 
     obj["total_lines"] = size_;
 
@@ -104,7 +104,7 @@ std::string CsvGroupMetadata::toString() const {
         << "Multi Delimiter: " << (multiDelimiter_ ? "true" : "false") << "\n"
         << "Header: " << (header_ ? "true" : "false") << "\n"
         << "Column Names: ";
-    for (const auto& colName : colNames_) {
+    for (const auto& colName : colNames()) {
         oss << colName << " ";
     }
     oss << "\nTotal Lines: " << size_;
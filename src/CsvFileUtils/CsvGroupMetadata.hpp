@@ -1,7 +1,9 @@
 #ifndef __CSVFILEGROUPMETADATA_H__
 #define __CSVFILEGROUPMETADATA_H__
 
+#include "ColumnNames.hpp"
 #include "CsvFileMetadata.hpp"
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -53,9 +55,9 @@ private:
   bool header_;
 
   /**
-   * @brief Column names in the CSV files.
+   * @brief Column names in the CSV files, shared with the files.
    */
-  std::vector<std::string> colNames_;
+  std::shared_ptr<const ColumnNames> columns_ = ColumnNames::empty();
 
   /**
    * @brief Total number of lines across all CSV files in the group.
@@ -141,6 +143,12 @@ public:
    */
   const std::string dataTemplate() const { return dataTemplate_; }
 
+  /**
+   * @brief Gets the paths of the CSV files matched by the data template.
+   * @return A vector of data file paths, in group order.
+   */
+  const std::vector<std::string> &dataPaths() const { return dataPaths_; }
+
   /**
    * @brief Gets the list of metadata for each CSV file in the group.
    * @return A vector of CsvFileMetadata objects.
@@ -182,7 +190,17 @@ public:
    * @brief Gets the column names in the CSV files.
    * @return A vector of column names.
    */
-  const std::vector<std::string> &colNames() const { return colNames_; }
+  const std::vector<std::string> &colNames() const {
+    return columns_->names();
+  }
+
+  /**
+   * @brief Gets the shared list of column names in the CSV files.
+   * @return The interned column names, the same object as each file's.
+   */
+  const std::shared_ptr<const ColumnNames> &columns() const {
+    return columns_;
+  }
 
   /**
    * @brief Gets the total number of lines across all CSV files in the group.
@@ -249,7 +267,7 @@ public:
    * @param colNames A vector of column names to set.
    */
   void setColNames(const std::vector<std::string> &colNames) {
-    colNames_ = colNames;
+    columns_ = ColumnNames::intern(colNames);
   }
 
   /**
@@ -0,0 +1,152 @@
+#include "CsvGroupSnapshot.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+CsvGroupSnapshot::CsvGroupSnapshot()
+    : version_(std::make_shared<const Version>()) {}
+
+CsvGroupSnapshot::CsvGroupSnapshot(CsvGroupMetadata metadata,
+                                   std::vector<CsvFileView> files) {
+  auto version = std::make_shared<Version>();
+
+  // Compile list of starting line numbers
+  long lines = 0;
+  for (const auto &file : files) {
+    version->startingLineNumbers.push_back(lines);
+    lines += file.size();
+  }
+
+  // Pin the size to the rows the views can read
+  metadata.setSize(lines);
+  version->metadata = std::move(metadata);
+  version->files = std::move(files);
+  version_ = std::move(version);
+}
+
+std::pair<long, long> CsvGroupSnapshot::getFileIndexAndRow(long row) const {
+  if (row < 0 || row >= size()) {
+    throw std::out_of_range("Row index out of range");
+  }
+
+  // Find the file index for the given row
+  const auto &starting_line_numbers = version_->startingLineNumbers;
+  long file_index = 0;
+  while (file_index < std::ssize(starting_line_numbers) - 1 &&
+         row >= starting_line_numbers[file_index + 1]) {
+    file_index++;
+  }
+
+  return {file_index, row - starting_line_numbers[file_index]};
+}
+
+std::pair<long, long> CsvGroupSnapshot::fileRows(long file) const {
+  if (file < 0 || file >= fileCount()) {
+    throw std::out_of_range("File index out of range");
+  }
+  long first = version_->startingLineNumbers[file];
+  return {first, first + long(version_->files[file].size())};
+}
+
+std::string CsvGroupSnapshot::getRawLine(long row) const {
+  // Get the file index and row number within that file
+  auto [file_index, row_in_file] = getFileIndexAndRow(row);
+
+  // Read the specified row from the determined file
+  return version_->files[file_index].getRawLine(row_in_file);
+}
+
+void CsvGroupSnapshot::readLine(long row, std::string &line) const {
+  auto [file_index, row_in_file] = getFileIndexAndRow(row);
+  version_->files[file_index].readLine(row_in_file, line);
+}
+
+std::map<std::string, std::string> CsvGroupSnapshot::getRow(long row) const {
+  // Get the file index and row number within that file
+  auto [file_index, row_in_file] = getFileIndexAndRow(row);
+
+  // Read the specified row from the determined file
+  return version_->files[file_index].getRow(row_in_file,
+                                            metadata().colNames());
+}
+
+ArenaRow CsvGroupSnapshot::getRow(long row, RowArena &arena) const {
+  auto [file_index, row_in_file] = getFileIndexAndRow(row);
+  return version_->files[file_index].getRow(
+      row_in_file, *metadata().columns(), arena);
+}
+
+void CsvGroupSnapshot::getFields(long row, const Projection &projection,
+                                 std::vector<std::string_view> &values) const {
+  // Get the file index and row number within that file
+  auto [file_index, row_in_file] = getFileIndexAndRow(row);
+
+  // Read the specified fields from the determined file
+  version_->files[file_index].getFields(row_in_file, projection, values);
+}
+
+std::vector<std::string>
+CsvGroupSnapshot::readRows(std::span<const long> rows) const {
+  const auto &files = version_->files;
+
+  // Split the requests by file
+  std::vector<std::vector<long>> file_rows(files.size());
+  std::vector<std::vector<size_t>> file_requests(files.size());
+  for (size_t i = 0; i < rows.size(); ++i) {
+    auto [file_index, row_in_file] = getFileIndexAndRow(rows[i]);
+    file_rows[file_index].push_back(row_in_file);
+    file_requests[file_index].push_back(i);
+  }
+
+  std::vector<std::string> lines(rows.size());
+  for (size_t f = 0; f < files.size(); ++f) {
+    if (file_rows[f].empty()) {
+      continue;
+    }
+    std::vector<std::string> file_lines = files[f].readRows(file_rows[f]);
+    for (size_t j = 0; j < file_lines.size(); ++j) {
+      lines[file_requests[f][j]] = std::move(file_lines[j]);
+    }
+  }
+  return lines;
+}
+
+long CsvGroupSnapshot::readBlock(long first, long last,
+                                 std::vector<char> &data,
+                                 std::vector<std::string_view> &lines) const {
+  if (last <= first || last > size()) {
+    throw std::out_of_range("Row index out of range");
+  }
+  auto [file_index, row_in_file] = getFileIndexAndRow(first);
+  const long file_start = version_->startingLineNumbers[file_index];
+  const CsvFileView &file = version_->files[file_index];
+  const long file_last = std::min<long>(last - file_start, file.size());
+  file.readBlock(row_in_file, file_last, data, lines);
+  return file_start + file_last;
+}
+
+void CsvGroupSnapshot::splitFields(
+    std::string_view line, const Projection &projection,
+    std::vector<std::string_view> &values) const {
+  if (version_->files.empty()) {
+    throw std::runtime_error("Cannot split fields of an empty group");
+  }
+  // All files share the delimiter configuration
+  version_->files.front().splitFields(line, projection, values);
+}
+
+CsvGroupCursor CsvGroupSnapshot::cursor(long row) const {
+  return CsvGroupCursor(*this, row);
+}
+
+bool CsvGroupCursor::next() {
+  if (atEnd()) {
+    return false;
+  }
+
+  auto [file_index, row_in_file] = snapshot_.getFileIndexAndRow(row_);
+  snapshot_.version_->files[file_index].readLine(row_in_file, line_);
+  ++row_;
+  return true;
+}
@@ -0,0 +1,331 @@
+#ifndef __CSVGROUPSNAPSHOT_H__
+#define __CSVGROUPSNAPSHOT_H__
+
+#include "CsvFileView.hpp"
+#include "CsvGroupMetadata.hpp"
+#include "RowArena.hpp"
+#include "RowSchema.hpp"
+
+#include <map>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+struct CsvGroupCursor;
+
+/**
+ * @brief Immutable view of a group of CSV files, pinned to a row count.
+ *
+ * Taken from CsvGroup::snapshot(), a snapshot keeps reading the same rows
+ * while the group is updated, and is a single shared pointer so copies are
+ * cheap. All reads are const and safe from any number of threads. Workers
+ * that want their own position and buffers create a cursor from it.
+ */
+struct CsvGroupSnapshot {
+private:
+  /**
+   * @brief Everything a snapshot reads from, never modified once built.
+   */
+  struct Version {
+    CsvGroupMetadata metadata;
+    std::vector<CsvFileView> files;
+    std::vector<long> startingLineNumbers;
+  };
+
+  /**
+   * @brief The version of the group this snapshot reads.
+   */
+  std::shared_ptr<const Version> version_;
+
+  friend struct CsvGroupCursor;
+
+public:
+  /**
+   * @brief Default constructor for a snapshot with no rows.
+   */
+  CsvGroupSnapshot();
+
+  /**
+   * @brief Construct a snapshot of the given files.
+   * @param metadata Metadata of the group, its size is set to the total rows
+   * of the files.
+   * @param files Views of the files in the group, in group order.
+   */
+  CsvGroupSnapshot(CsvGroupMetadata metadata, std::vector<CsvFileView> files);
+
+  /**
+   * @brief Gets the number of rows in the snapshot.
+   * @return The number of rows, fixed when the snapshot was taken.
+   */
+  long size() const { return version_->metadata.size(); }
+
+  /**
+   * @brief Checks if the snapshot has no rows.
+   * @return True if the snapshot is empty.
+   */
+  bool empty() const { return size() == 0; }
+
+  /**
+   * @brief Gets the metadata of the group when the snapshot was taken.
+   * @return The metadata of the group.
+   */
+  const CsvGroupMetadata &metadata() const { return version_->metadata; }
+
+  /**
+   * @brief Get the file index and row number for a specific row in the group.
+   * @param row The row number to get (0-based index).
+   * @return A pair containing the file index and the row number within that
+   * file.
+   * @throws std::out_of_range if the row index is out of range.
+   */
+  std::pair<long, long> getFileIndexAndRow(long row) const;
+
+  /**
+   * @brief Gets the number of files in the snapshot.
+   * @return The number of files, in the order of metadata().dataPaths().
+   */
+  long fileCount() const { return version_->files.size(); }
+
+  /**
+   * @brief Gets the rows of one file of the group.
+   * @param file The file index, as in metadata().dataPaths().
+   * @return The first row of the file and one past its last row.
+   * @throws std::out_of_range if the file index is out of range.
+   */
+  std::pair<long, long> fileRows(long file) const;
+
+  /**
+   * @brief Reads a specific row.
+   * @param row The row number to read (0-based index).
+   * @return A string containing the raw data of the specified row.
+   * @throws std::out_of_range if the row index is out of range.
+   * @throws std::runtime_error if there is an error reading the line from the
+   * file
+   */
+  std::string getRawLine(long row) const;
+
+  /**
+   * @brief Reads a specific row into a string.
+   * @param row The row number to read (0-based index).
+   * @param line Receives the raw data of the row, reusing its storage.
+   * @throws std::out_of_range if the row index is out of range.
+   * @throws std::runtime_error if there is an error reading the line from the
+   * file
+   */
+  void readLine(long row, std::string &line) const;
+
+  /**
+   * @brief Reads a specific row as a map of column names to values.
+   * @param row The row number to read (0-based index).
+   * @return A map where keys are column names and values are the corresponding
+   * data for that row.
+   * @throws std::out_of_range if the row index is out of range.
+   * @throws std::runtime_error if there is an error reading the line from the
+   * file
+   */
+  std::map<std::string, std::string> getRow(long row) const;
+
+  /**
+   * @brief Reads a specific row into an arena, as named fields.
+   * @details Map-style access without the map, for tools that need rows by
+   * column name.
+   * @param row The row number to read (0-based index).
+   * @param arena The arena the row is made in.
+   * @return The row, valid until the arena is reset and while the snapshot
+   * is held.
+   * @throws std::out_of_range if the row index is out of range.
+   * @throws std::runtime_error if there is an error reading the line from the
+   * file
+   */
+  ArenaRow getRow(long row, RowArena &arena) const;
+
+  /**
+   * @brief Resolves column names to a projection of the group's columns.
+   * @param columns The columns to read, in the order they are wanted.
+   * @return A projection for use with getFields.
+   * @throws std::runtime_error if a column is not in the group.
+   */
+  Projection project(const std::vector<std::string> &columns) const {
+    return Projection(metadata().colNames(), columns);
+  }
+
+  /**
+   * @brief Reads only the projected columns of a specific row.
+   * @param row The row number to read (0-based index).
+   * @param projection The columns to read, from project().
+   * @param values Receives one value per projected column, in projection
+   * order. The views stay valid until the next read on the same thread.
+   * @throws std::out_of_range if the row index is out of range.
+   * @throws std::runtime_error if there is an error reading the line from the
+   * file, or the row is missing a projected column.
+   */
+  void getFields(long row, const Projection &projection,
+                 std::vector<std::string_view> &values) const;
+
+  /**
+   * @brief Reads many rows in one batch.
+   * @details Rows are split by file and each file's rows are read with
+   * CsvFileView::readRows, coalescing nearby rows.
+   * @param rows The row numbers to read (0-based index), in any order.
+   * @return The raw data of each requested row, in request order.
+   * @throws std::out_of_range if a row index is out of range.
+   * @throws std::runtime_error if there is an error reading a file.
+   */
+  std::vector<std::string> readRows(std::span<const long> rows) const;
+
+  /**
+   * @brief Reads a run of consecutive rows from one file with a single read.
+   * @details The run stops at the end of the first row's file, so reading
+   * from the returned row on crosses into the next file.
+   * @param first The first row to read (0-based index).
+   * @param last One past the last row wanted.
+   * @param data Receives the bytes read, reusing its storage.
+   * @param lines Receives one view into data per row read, in row order.
+   * @return One past the last row read.
+   * @throws std::out_of_range if the rows are out of range.
+   * @throws std::runtime_error if there is an error reading the file.
+   */
+  long readBlock(long first, long last, std::vector<char> &data,
+                 std::vector<std::string_view> &lines) const;
+
+  /**
+   * @brief Splits a raw line of the group into the projected columns.
+   * @param line A raw line, for example from readRows.
+   * @param projection The columns to read, from project().
+   * @param values Receives one value per projected column, in projection
+   * order. The views stay valid until the line changes or the next read on
+   * the same thread.
+   * @throws std::runtime_error if the line is missing a projected column.
+   */
+  void splitFields(std::string_view line, const Projection &projection,
+                   std::vector<std::string_view> &values) const;
+
+  /**
+   * @brief Reads a specific row into the row struct of a schema.
+   * @param row The row number to read (0-based index).
+   * @param decoder A decoder created from the group's metadata, one per
+   * thread.
+   * @return The decoded row.
+   * @throws std::out_of_range if the row index is out of range.
+   * @throws std::runtime_error if the row cannot be read or decoded.
+   */
+  template <typename Schema>
+  typename Schema::row_type getRow(long row,
+                                   RowDecoder<Schema> &decoder) const {
+    // Read into a buffer kept by the thread, so repeated reads reuse it
+    thread_local std::string line;
+    readLine(row, line);
+    return decoder(line);
+  }
+
+  /**
+   * @brief Creates a cursor over the rows of the snapshot.
+   * @param row The first row the cursor reads.
+   * @return A cursor for use by a single thread.
+   */
+  CsvGroupCursor cursor(long row = 0) const;
+};
+
+/**
+ * @brief A position in a group snapshot, with its own read buffer.
+ *
+ * Cursors are for a single thread and are created from a shared snapshot, one
+ * per worker. Reading moves through the rows in order, into a buffer owned by
+ * the cursor, so several cursors can be used side by side on one thread.
+ *
+ * Example:
+ * @code
+ * CsvGroupCursor cursor = group.snapshot().cursor(first);
+ * while (cursor.row() < last && cursor.next()) {
+ *   process(cursor.line());
+ * }
+ * @endcode
+ */
+struct CsvGroupCursor {
+private:
+  /**
+   * @brief The snapshot being read.
+   */
+  CsvGroupSnapshot snapshot_;
+
+  /**
+   * @brief The next row to read.
+   */
+  long row_ = 0;
+
+  /**
+   * @brief The row read by the last call to next().
+   */
+  std::string line_;
+
+public:
+  /**
+   * @brief Default constructor for a cursor over no rows.
+   */
+  CsvGroupCursor() = default;
+
+  /**
+   * @brief Construct a cursor over a snapshot.
+   * @param snapshot The snapshot to read.
+   * @param row The first row to read.
+   */
+  explicit CsvGroupCursor(CsvGroupSnapshot snapshot, long row = 0)
+      : snapshot_(std::move(snapshot)), row_(row) {}
+
+  /**
+   * @brief Gets the snapshot the cursor reads.
+   * @return The snapshot.
+   */
+  const CsvGroupSnapshot &snapshot() const { return snapshot_; }
+
+  /**
+   * @brief Gets the next row to be read.
+   * @return The row number (0-based index).
+   */
+  long row() const { return row_; }
+
+  /**
+   * @brief Checks if every row of the snapshot has been read.
+   * @return True if there are no more rows.
+   */
+  bool atEnd() const { return row_ >= snapshot_.size(); }
+
+  /**
+   * @brief Moves the cursor to a row.
+   * @param row The next row to read.
+   */
+  void seek(long row) { row_ = row; }
+
+  /**
+   * @brief Reads the row at the cursor and moves to the next one.
+   * @return false if there are no more rows.
+   * @throws std::out_of_range if the cursor is before the first row.
+   * @throws std::runtime_error if there is an error reading the line.
+   */
+  bool next();
+
+  /**
+   * @brief Gets the row read by the last call to next().
+   * @return A view of the raw line, valid until the cursor reads again.
+   */
+  std::string_view line() const { return line_; }
+
+  /**
+   * @brief Splits the row read by the last call to next() into the projected
+   * columns.
+   * @param projection The columns to read, from the snapshot's project().
+   * @param values Receives one value per projected column, in projection
+   * order. The views stay valid until the cursor reads again or the next
+   * split on the same thread.
+   * @throws std::runtime_error if the line is missing a projected column.
+   */
+  void fields(const Projection &projection,
+              std::vector<std::string_view> &values) const {
+    snapshot_.splitFields(line_, projection, values);
+  }
+};
+
+#endif // __CSVGROUPSNAPSHOT_H__
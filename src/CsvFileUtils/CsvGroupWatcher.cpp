@@ -0,0 +1,202 @@
+#include "CsvGroupWatcher.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace {
+/**
+ * @brief Events watched on every directory of the tree.
+ */
+constexpr std::uint32_t watchMask = IN_CREATE | IN_MODIFY | IN_CLOSE_WRITE |
+                                    IN_MOVED_TO | IN_MOVED_FROM |
+                                    IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+} // namespace
+
+CsvGroupWatcher::CsvGroupWatcher(const CsvGroupMetadata &metadata,
+                                 std::chrono::milliseconds debounce,
+                                 std::chrono::milliseconds maxDelay)
+    : parentPath_(metadata.parentPath()), template_(metadata.dataTemplate()),
+      debounce_(debounce), maxDelay_(maxDelay) {
+  fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd_ < 0) {
+    throw std::runtime_error(std::string("Could not start inotify: ") +
+                             std::strerror(errno));
+  }
+
+  watchTree(parentPath_, false);
+  if (directories_.empty()) {
+    int error = errno;
+    ::close(fd_);
+    throw std::runtime_error("Could not watch " + parentPath_ + ": " +
+                             std::strerror(error));
+  }
+
+  // The group's own first update indexes the files already there
+  pending_.clear();
+}
+
+CsvGroupWatcher::~CsvGroupWatcher() { ::close(fd_); }
+
+void CsvGroupWatcher::watchTree(const std::string &path, bool complete) {
+  int wd = inotify_add_watch(fd_, path.c_str(), watchMask);
+  if (wd < 0) {
+    // The directory went away again before it could be watched
+    return;
+  }
+  directories_[wd] = path;
+
+  // Files may have been written before the watch was in place
+  std::error_code error;
+  for (std::filesystem::directory_iterator it(path, error), end;
+       !error && it != end; it.increment(error)) {
+    if (it->is_directory(error)) {
+      watchTree(it->path().string(), complete);
+    } else if (it->is_regular_file(error)) {
+      recordFile(it->path().string(), complete);
+    }
+  }
+}
+
+void CsvGroupWatcher::recordFile(const std::string &path, bool complete) {
+  std::string file_subpath =
+      std::filesystem::path(path).lexically_relative(parentPath_).string();
+  if (!std::regex_match(file_subpath, template_)) {
+    return;
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  if (pending_.empty() && !rescan_) {
+    firstEvent_ = now;
+  }
+  lastEvent_ = now;
+
+  // The latest event tells whether the file is still being written
+  pending_[path] = complete;
+}
+
+void CsvGroupWatcher::readEvents() {
+  // Aligned for the inotify_event structs read into it
+  alignas(inotify_event) char buffer[64 * 1024];
+
+  while (true) {
+    ssize_t length = ::read(fd_, buffer, sizeof(buffer));
+    if (length < 0 && errno == EINTR) {
+      continue;
+    }
+    if (length < 0 && errno == EAGAIN) {
+      return;
+    }
+    if (length <= 0) {
+      throw std::runtime_error(std::string("Could not read inotify events: ") +
+                               std::strerror(errno));
+    }
+
+    for (char *next = buffer; next < buffer + length;) {
+      const auto *event = reinterpret_cast<const inotify_event *>(next);
+      next += sizeof(inotify_event) + event->len;
+
+      if (event->mask & IN_Q_OVERFLOW) {
+        // Events were dropped, only a full rescan finds what they were
+        auto now = std::chrono::steady_clock::now();
+        if (pending_.empty() && !rescan_) {
+          firstEvent_ = now;
+        }
+        lastEvent_ = now;
+        rescan_ = true;
+        continue;
+      }
+
+      auto directory = directories_.find(event->wd);
+      if (directory == directories_.end()) {
+        continue;
+      }
+      if (event->mask & IN_IGNORED) {
+        // The directory was deleted or its watch removed
+        directories_.erase(directory);
+        continue;
+      }
+      if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+        if (directory->second == parentPath_) {
+          throw std::runtime_error("The watched directory " + parentPath_ +
+                                   " was removed");
+        }
+        continue;
+      }
+      if (event->len == 0) {
+        continue;
+      }
+
+      std::string path =
+          (std::filesystem::path(directory->second) / event->name).string();
+      if (event->mask & IN_ISDIR) {
+        if (event->mask & IN_MOVED_FROM) {
+          // The tree now lives elsewhere, stop watching it under its old
+          // name
+          std::string prefix = path + "/";
+          for (auto it = directories_.begin(); it != directories_.end();) {
+            if (it->second == path || it->second.starts_with(prefix)) {
+              inotify_rm_watch(fd_, it->first);
+              it = directories_.erase(it);
+            } else {
+              ++it;
+            }
+          }
+        } else if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+          // A directory moved in arrives with its files already written
+          watchTree(path, event->mask & IN_MOVED_TO);
+        }
+        continue;
+      }
+
+      if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+        recordFile(path, true);
+      } else if (event->mask & (IN_CREATE | IN_MODIFY)) {
+        recordFile(path, false);
+      }
+    }
+  }
+}
+
+CsvGroupChanges CsvGroupWatcher::poll(std::chrono::milliseconds timeout) {
+  using clock = std::chrono::steady_clock;
+  auto deadline = clock::now() + timeout;
+
+  while (true) {
+    readEvents();
+
+    auto now = clock::now();
+    bool waiting = !pending_.empty() || rescan_;
+    auto settled = std::min(lastEvent_ + debounce_, firstEvent_ + maxDelay_);
+    if (waiting && now >= settled) {
+      CsvGroupChanges changes;
+      for (const auto &[path, complete] : pending_) {
+        changes.paths.push_back(path);
+        changes.complete.push_back(complete);
+      }
+      changes.rescan = rescan_;
+      pending_.clear();
+      rescan_ = false;
+      return changes;
+    }
+    if (now >= deadline) {
+      return CsvGroupChanges();
+    }
+
+    // Sleep until events arrive, the pending changes settle or the timeout
+    auto wake = waiting ? std::min(deadline, settled) : deadline;
+    auto wait =
+        std::chrono::ceil<std::chrono::milliseconds>(wake - now).count();
+    pollfd events{fd_, POLLIN, 0};
+    if (::poll(&events, 1, static_cast<int>(wait)) < 0 && errno != EINTR) {
+      throw std::runtime_error(std::string("Could not wait for inotify: ") +
+                               std::strerror(errno));
+    }
+  }
+}
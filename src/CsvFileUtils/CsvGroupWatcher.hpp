@@ -0,0 +1,173 @@
+#ifndef __CSVGROUPWATCHER_H__
+#define __CSVGROUPWATCHER_H__
+
+#include "CsvGroupMetadata.hpp"
+
+#include <chrono>
+#include <map>
+#include <regex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Data files of a group that changed since the last CsvGroupWatcher
+ * poll, for CsvGroup::update.
+ */
+struct CsvGroupChanges {
+  /**
+   * @brief Paths of data files that were created, written or moved in, in
+   * path order.
+   */
+  std::vector<std::string> paths;
+
+  /**
+   * @brief For each path, whether its writer has finished with it, so a last
+   * line without a newline is complete rather than half written.
+   */
+  std::vector<bool> complete;
+
+  /**
+   * @brief Set when events were lost and the whole tree must be rescanned.
+   */
+  bool rescan = false;
+
+  /**
+   * @brief Checks whether there is anything to update.
+   * @return true if no file changed and no rescan is needed.
+   */
+  bool empty() const { return paths.empty() && !rescan; }
+};
+
+/**
+ * @brief Watches the directory tree of a group with inotify and reports which
+ * data files changed, so updates only touch those files.
+ *
+ * Every directory under the parent path is watched, since a template may
+ * match files at any depth, and watches are added as directories appear.
+ * Events are collected until the tree has been quiet for the debounce
+ * interval, so a burst of writes to a file becomes a single update, and are
+ * released after maxDelay at the latest for files that are written
+ * continuously.
+ *
+ * Not thread-safe, poll from one thread.
+ */
+struct CsvGroupWatcher {
+private:
+  /**
+   * @brief The inotify instance.
+   */
+  int fd_ = -1;
+
+  /**
+   * @brief Path of the parent directory of the group.
+   */
+  std::string parentPath_;
+
+  /**
+   * @brief Matches data file paths relative to the parent directory.
+   */
+  std::regex template_;
+
+  /**
+   * @brief Watched directories by watch descriptor.
+   */
+  std::map<int, std::string> directories_;
+
+  /**
+   * @brief Changed data files, and whether their writer has finished.
+   */
+  std::map<std::string, bool> pending_;
+
+  /**
+   * @brief Set when events were lost.
+   */
+  bool rescan_ = false;
+
+  /**
+   * @brief Quiet time after the last event before changes are released.
+   */
+  std::chrono::milliseconds debounce_;
+
+  /**
+   * @brief Longest time changes are held back while events keep arriving.
+   */
+  std::chrono::milliseconds maxDelay_;
+
+  /**
+   * @brief Time of the first event not yet released.
+   */
+  std::chrono::steady_clock::time_point firstEvent_;
+
+  /**
+   * @brief Time of the latest event.
+   */
+  std::chrono::steady_clock::time_point lastEvent_;
+
+  /**
+   * @brief Watches a directory and every directory below it, and records the
+   * data files already in them.
+   * @param path The directory.
+   * @param complete Whether files found in it are finished, as when a whole
+   * directory is moved into the tree.
+   */
+  void watchTree(const std::string &path, bool complete);
+
+  /**
+   * @brief Records a change to a file if it is a data file of the group.
+   * @param path The file's path.
+   * @param complete Whether the writer has finished with the file.
+   */
+  void recordFile(const std::string &path, bool complete);
+
+  /**
+   * @brief Reads all queued inotify events without blocking.
+   * @throws std::runtime_error if the events cannot be read.
+   */
+  void readEvents();
+
+public:
+  /**
+   * @brief Starts watching the directory tree of a group.
+   * @details Create the watcher before the group's first update, so files
+   * written in between are reported rather than missed.
+   * @param metadata The group's parent path and data template.
+   * @param debounce Quiet time after the last event before changes are
+   * released.
+   * @param maxDelay Longest time changes are held back while events keep
+   * arriving.
+   * @throws std::runtime_error if inotify is unavailable or the parent path
+   * cannot be watched.
+   */
+  CsvGroupWatcher(const CsvGroupMetadata &metadata,
+                  std::chrono::milliseconds debounce =
+                      std::chrono::milliseconds(200),
+                  std::chrono::milliseconds maxDelay =
+                      std::chrono::milliseconds(2000));
+
+  CsvGroupWatcher(const CsvGroupWatcher &) = delete;
+  CsvGroupWatcher &operator=(const CsvGroupWatcher &) = delete;
+
+  /**
+   * @brief Stops watching.
+   */
+  ~CsvGroupWatcher();
+
+  /**
+   * @brief Gets the inotify descriptor, readable when events are queued, for
+   * waiting on several watchers with poll or epoll.
+   * @return The file descriptor.
+   */
+  int fd() const { return fd_; }
+
+  /**
+   * @brief Waits for events and takes the changes once they have settled.
+   * @param timeout Longest time to wait for events, zero to only read those
+   * already queued.
+   * @return The changes, empty if none have settled yet.
+   * @throws std::runtime_error if the events cannot be read.
+   */
+  CsvGroupChanges poll(std::chrono::milliseconds timeout =
+                           std::chrono::milliseconds(0));
+};
+
+#endif // __CSVGROUPWATCHER_H__
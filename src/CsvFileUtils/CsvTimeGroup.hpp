@@ -2,114 +2,296 @@
 #define __CSVTIMEGROUP_H__
 
 #include "CsvGroup.hpp"
-#include <boost/date_time/posix_time/time_parsers.hpp>
-#include <boost/multiprecision/cpp_bin_float.hpp>
-
-using date_time = boost::posix_time::ptime;
-using time_delt = boost::posix_time::time_duration;
-
-using quad = boost::multiprecision::cpp_bin_float_quad;
+#include "CsvTimeSnapshot.hpp"
+#include "SharedDataset.hpp"
+#include "TimeParse.hpp"
+#include "TimeSegments.hpp"
+#include "ZoneMap.hpp"
 
 #include <map>
-#include <tuple>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <vector>
 
 /**
- * @brief Formats for parsing time strings into date_time objects.
+ * @brief Time lookups on a group of CSV files.
+ *
+ * Lookups go through a CsvTimeCursor on the rows indexed by the last
+ * update(). For lookups from several threads, hand each worker a cursor from
+ * snapshot(), which can also be taken while update() runs.
  */
-enum TimeFormat {
+struct CsvTimeGroup {
+private:
   /**
-   * @brief "YYYY-MM-DD HH:MM:SS.fffffffff"
+   * @brief The group of CSV files containing time data.
    */
-  standard,
+  CsvGroup csvGroup_;
 
   /**
-   * @brief "YYYYMMDDTHHMMSS.fffffffff"
+   * @brief The format of the time data in the CSV files.
    */
-  iso,
+  CsvTimeFormat timeFormat_;
 
   /**
-   * @brief "YYYY-MM-DDTHH:MM:SS.fffffffff"
+   * @brief Lookups on the rows indexed by the last update.
    */
-  isoExtended
-};
+  CsvTimeCursor cursor_;
 
-/**
- * @brief Parses a time string into a boost::posix_time::ptime object.
- * @param format: The format of the time string
- * @param time_str: The time string to parse
- * @return: A boost::posix_time::ptime object representing the parsed time
- */
-date_time parseTime(TimeFormat format, const std::string &time_str);
+  /**
+   * @brief Columns to decode into a shared dataset, if enabled.
+   */
+  std::optional<std::vector<std::string>> sharedColumns_;
 
-/**
- * @brief Represents the format of time data in the CSV files.
- */
-enum class CsvTimeFormat {
   /**
-   * @brief Time Data stored in a single column, "Time", in standard format.
+   * @brief Shared dataset of the rows indexed by the last update, if enabled.
    */
-  oneColStandard,
+  std::shared_ptr<const SharedDataset> shared_;
 
   /**
-   * @brief Time Data stored in two columns, "Day" and "Time", with
-   * "Day" as "YYMMDD" and "Time" as "HHMMSS.fffffffff".
+   * @brief Columns to keep zone map statistics of, if enabled.
    */
-  twoColShort,
-};
+  std::optional<std::vector<std::string>> zoneColumns_;
 
-struct CsvTimeGroup {
-private:
   /**
-   * @brief The group of CSV files containing time data.
+   * @brief Zone map of the rows indexed by the last update, if enabled.
    */
-  CsvGroup csvGroup_;
+  std::shared_ptr<const ZoneMap> zones_;
 
   /**
-   * @brief The format of the time data in the CSV files.
+   * @brief Whether time lookups use uniform segments.
    */
-  CsvTimeFormat timeFormat_;
+  bool useSegments_ = false;
+
+  /**
+   * @brief Uniform segments of the rows indexed by the last update, if
+   * enabled.
+   */
+  std::shared_ptr<const TimeSegments> segments_;
 
   /**
-   * @brief A cache for time values to avoid repeated parsing.
-   * Maps from index in the CSV file to the corresponding date_time.
+   * @brief Attaches the cursor to the shared dataset for its rows, if enabled.
+   * @details A dataset this process published for fewer rows is removed once
+   * replaced, as its fingerprint no longer matches the files.
    */
-  std::map<size_t, date_time> timeCache_;
+  void attachShared() {
+    if (sharedColumns_) {
+      // Decode exactly the rows the cursor reads, reusing the rows decoded
+      // before the update
+      CsvTimeSnapshot rows(cursor_.group(), timeFormat_);
+      std::shared_ptr<const SharedDataset> previous = std::move(shared_);
+      shared_ = SharedDataset::attachOrBuild(rows, *sharedColumns_, previous);
+      cursor_.attachShared(shared_);
+
+      if (previous && previous->owner() &&
+          (!shared_ || shared_->name() != previous->name())) {
+        SharedDataset::remove(previous->name());
+      }
+    }
+  }
 
   /**
-   * @brief A cache for extrapolation parameters, on the low side.
-   * @details Maps from column name to a tuple of (reference_time, constant,
-   * slope).
+   * @brief Extends the zone map to the rows of the cursor, if enabled.
+   * @param ignoreCache If true, summarizes every row again.
    */
-  std::map<std::string, std::tuple<date_time, quad, quad>>
-      extrapolationCacheLow_;
+  void updateZones(bool ignoreCache = false) {
+    if (zoneColumns_) {
+      CsvTimeSnapshot rows(cursor_.group(), timeFormat_);
+      zones_ = ZoneMap::build(rows, *zoneColumns_, zones_, ignoreCache);
+    }
+  }
 
   /**
-   * @brief A cache for extrapolation parameters, on the high side.
-   * @details Maps from column name to a tuple of (reference_time, constant,
-   * slope).
+   * @brief Extends the uniform segments to the rows of the cursor and
+   * attaches them, if enabled.
    */
-  std::map<std::string, std::tuple<date_time, quad, quad>>
-      extrapolationCacheHigh_;
+  void updateSegments() {
+    if (useSegments_) {
+      CsvTimeSnapshot rows(cursor_.group(), timeFormat_);
+      segments_ = TimeSegments::build(rows, segments_);
+      cursor_.attachSegments(segments_);
+    }
+  }
 
 public:
   CsvTimeGroup(CsvGroupMetadata metadata, CsvTimeFormat timeFormat,
                bool ignoreCache = false)
-      : csvGroup_(metadata, ignoreCache), timeFormat_(timeFormat) {}
+      : csvGroup_(metadata, ignoreCache), timeFormat_(timeFormat),
+        cursor_(snapshot().cursor()) {}
 
-  date_time timeOfRow(size_t index);
+  /**
+   * @brief Indexes rows added to the files since the last update.
+   * @details Publishes a new version for snapshot(), snapshots already taken
+   * keep the rows they were pinned to.
+   * @param ignoreCache If true, rebuilds the cached line maps.
+   * @return true if the group was updated, false otherwise.
+   */
+  bool update(bool ignoreCache = false) {
+    bool updated = csvGroup_.update(ignoreCache);
+    if (updated) {
+      // Cached lookups and extrapolations are stale once rows are added
+      cursor_ = snapshot().cursor();
+      attachShared();
+      updateSegments();
+      updateZones(ignoreCache);
+    }
+    return updated;
+  }
 
-  date_time startTime() { return timeOfRow(0); }
+  /**
+   * @brief Indexes rows added to the files reported by a CsvGroupWatcher,
+   * without rescanning the directory tree.
+   * @details Publishes a new version for snapshot(), as update() does.
+   * @param changes The changed files, from CsvGroupWatcher::poll.
+   * @return true if the group was updated, false otherwise.
+   */
+  bool update(const CsvGroupChanges &changes) {
+    bool updated = csvGroup_.update(changes);
+    if (updated) {
+      cursor_ = snapshot().cursor();
+      attachShared();
+      updateSegments();
+      updateZones();
+    }
+    return updated;
+  }
 
-  date_time endTime() { return timeOfRow(csvGroup_.metadata().size() - 1); }
+  /**
+   * @brief Reads times and the given columns from a dataset shared between
+   * processes, decoding and publishing it if no other process has.
+   * @details Falls back to parsing rows if shared memory is unavailable. The
+   * dataset is replaced on each update that adds rows, copying the rows
+   * already decoded, and a replaced dataset this process published is
+   * removed.
+   * @param columns The value columns to decode, for colAtTime.
+   * @throws std::runtime_error if a column is missing or a value is invalid.
+   */
+  void useSharedDataset(std::vector<std::string> columns) {
+    sharedColumns_ = std::move(columns);
+    attachShared();
+  }
 
-  std::pair<size_t, size_t> bounds(date_time time);
+  /**
+   * @brief Finds rows by time arithmetically within runs of rows logged at a
+   * fixed rate, searching only the irregular rows between them.
+   * @details The runs are detected from the row times now, and extended on
+   * each update that adds rows. Lookups give the same rows as without.
+   */
+  void useTimeSegments() {
+    useSegments_ = true;
+    updateSegments();
+  }
+
+  /**
+   * @brief Gets the uniform segments of the rows indexed by the last update,
+   * for attaching to cursors of snapshot().
+   * @details The segments are immutable and may be handed to other threads.
+   * @return The segments, or nullptr if useTimeSegments() was not called.
+   */
+  std::shared_ptr<const TimeSegments> timeSegments() const {
+    return segments_;
+  }
+
+  /**
+   * @brief Keeps per block statistics of the given columns, for skipping
+   * blocks in query().
+   * @details Statistics are saved next to each data file and extended on each
+   * update that adds rows, so only new rows are parsed.
+   * @param columns The numeric columns to keep statistics of.
+   * @throws std::runtime_error if a column is missing or the statistics cannot
+   * be saved.
+   */
+  void useZoneMaps(std::vector<std::string> columns) {
+    zoneColumns_ = std::move(columns);
+    zones_ = nullptr;
+    updateZones();
+  }
+
+  /**
+   * @brief Gets the zone map of the rows indexed by the last update.
+   * @details The map is immutable and may be handed to other threads.
+   * @return The zone map, or nullptr if useZoneMaps() was not called.
+   */
+  std::shared_ptr<const ZoneMap> zones() const { return zones_; }
+
+  /**
+   * @brief Finds the rows in a time range that meet every predicate,
+   * scanning only the blocks whose statistics allow a match.
+   * @param start The earliest time of a matching row.
+   * @param end The latest time of a matching row.
+   * @param predicates Conditions every matching row meets, on columns passed
+   * to useZoneMaps().
+   * @param threads Worker threads scanning blocks, 0 for one per core.
+   * @return Runs of consecutive matching rows, as the first row and one past
+   * the last, in row order.
+   * @throws std::runtime_error if zone maps are not enabled or a predicate's
+   * column has no statistics.
+   */
+  std::vector<std::pair<long, long>>
+  query(date_time start, date_time end,
+        const std::vector<ZonePredicate> &predicates, long threads = 0) const {
+    if (!zones_) {
+      throw std::runtime_error("Zone maps are not enabled for this group");
+    }
+    return zones_->query(start, end, predicates, threads);
+  }
+
+  /**
+   * @brief Takes an immutable view of the group as of the last update.
+   * @details Safe to call from any thread, including while update() runs.
+   * @return A snapshot pinned to the current row count.
+   */
+  CsvTimeSnapshot snapshot() const {
+    return CsvTimeSnapshot(csvGroup_.snapshot(), timeFormat_);
+  }
+
+  date_time timeOfRow(size_t index) { return cursor_.timeOfRow(index); }
+
+  /**
+   * @brief Gets the times of a range of rows in one pass.
+   * @details Intended for building time indices, parses all rows with the
+   * batch parser for the group's time format.
+   * @param first The index of the first row.
+   * @param last One past the index of the last row.
+   * @return The time of each row as ticks since 1970-01-01.
+   */
+  std::vector<time_ticks> timesOfRows(size_t first, size_t last) {
+    return cursor_.timesOfRows(first, last);
+  }
+
+  date_time startTime() { return cursor_.startTime(); }
 
-  size_t closestIndex(date_time time);
+  date_time endTime() { return cursor_.endTime(); }
+
+  std::pair<size_t, size_t> bounds(date_time time) {
+    return cursor_.bounds(time);
+  }
 
-  quad colAtTime(date_time time, const std::string &colName);
+  size_t closestIndex(date_time time) { return cursor_.closestIndex(time); }
+
+  quad colAtTime(date_time time, const std::string &colName) {
+    return cursor_.colAtTime(time, colName);
+  }
 
   std::map<std::string, std::string> operator[](size_t index) {
     return csvGroup_[index];
   }
+
+  /**
+   * @brief Reads a row into the row struct of a schema.
+   * @param index The row number to read (0-based index).
+   * @param decoder A decoder created from this group's metadata.
+   * @return The decoded row.
+   */
+  template <typename Schema>
+  typename Schema::row_type row(size_t index, RowDecoder<Schema> &decoder) {
+    return csvGroup_.getRow(index, decoder);
+  }
+
+  /**
+   * @brief Get the metadata of the underlying CSV group.
+   * @return The metadata of the CSV group, valid until the next update.
+   */
+  const CsvGroupMetadata &metadata() const { return csvGroup_.metadata(); }
 };
-#endif // __CSVTIMEGROUP_H__
\ No newline at end of file
+#endif // __CSVTIMEGROUP_H__
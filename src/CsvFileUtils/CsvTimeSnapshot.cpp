@@ -0,0 +1,349 @@
+#include "CsvTimeSnapshot.hpp"
+#include "SharedDataset.hpp"
+#include "TimeSegments.hpp"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/math/statistics/linear_regression.hpp>
+#include <cstddef>
+#include <numeric>
+#include <string>
+
+CsvTimeCursor CsvTimeSnapshot::cursor() const {
+  return CsvTimeCursor(group_, timeFormat_);
+}
+
+void CsvTimeCursor::attachShared(std::shared_ptr<const SharedDataset> shared) {
+  if (shared && shared->size() != group_.size()) {
+    throw std::invalid_argument(
+        "Shared dataset does not match the rows of the cursor");
+  }
+  shared_ = std::move(shared);
+}
+
+void CsvTimeCursor::attachSegments(
+    std::shared_ptr<const TimeSegments> segments) {
+  if (segments && segments->size() != group_.size()) {
+    throw std::invalid_argument(
+        "Time segments do not match the rows of the cursor");
+  }
+  segments_ = std::move(segments);
+}
+
+const Projection &CsvTimeCursor::timeProjection() {
+  if (timeProjection_.empty()) {
+    timeProjection_ = group_.project(timeColumns(timeFormat_));
+  }
+  return timeProjection_;
+}
+
+const Projection &CsvTimeCursor::valueProjection(const std::string &colName) {
+  auto it = valueProjections_.find(colName);
+  if (it == valueProjections_.end()) {
+    it = valueProjections_.emplace(colName, group_.project({colName}))
+             .first;
+  }
+  return it->second;
+}
+
+quad CsvTimeCursor::parseValue(std::string_view field,
+                               const std::string &colName) {
+  quad value;
+  if (!parseField(field, value)) {
+    throw std::runtime_error("Invalid value in column " + colName + ": " +
+                             std::string(field));
+  }
+  return value;
+}
+
+quad CsvTimeCursor::valueOfRow(size_t index, const std::string &colName) {
+  long column = shared_ ? shared_->columnIndex(colName) : -1;
+  if (column >= 0) {
+    if (index >= size_t(shared_->size())) {
+      throw std::out_of_range("Row index out of range");
+    }
+    return shared_->value(column, index);
+  }
+
+  group_.getFields(index, valueProjection(colName), fields_);
+  return parseValue(fields_[0], colName);
+}
+
+time_ticks
+CsvTimeCursor::parseTimeFields(const std::vector<std::string_view> &fields) {
+  switch (timeFormat_) {
+  case CsvTimeFormat::oneColStandard:
+    return parseTimeTicks<CsvTimeFormat::oneColStandard>(
+        std::span<const std::string_view, 1>(fields.data(), 1));
+  case CsvTimeFormat::twoColShort:
+    return parseTimeTicks<CsvTimeFormat::twoColShort>(
+        std::span<const std::string_view, 2>(fields.data(), 2));
+
+  default:
+    throw std::invalid_argument("Unsupported CSV time format: " +
+                                std::to_string(static_cast<int>(timeFormat_)));
+  }
+}
+
+void CsvTimeCursor::readPoints(std::span<const long> rows,
+                               const std::string &colName,
+                               std::vector<date_time> &times,
+                               std::vector<quad> &values) {
+  times.clear();
+  values.clear();
+
+  // Decoded points are read straight from shared memory
+  long column = shared_ ? shared_->columnIndex(colName) : -1;
+  if (column >= 0) {
+    for (long row : rows) {
+      times.push_back(fromTicks(shared_->times()[row]));
+      values.push_back(shared_->value(column, row));
+    }
+    return;
+  }
+
+  std::vector<std::string> lines = group_.readRows(rows);
+
+  for (const auto &line : lines) {
+    group_.splitFields(line, timeProjection(), fields_);
+    times.push_back(fromTicks(parseTimeFields(fields_)));
+    group_.splitFields(line, valueProjection(colName), fields_);
+    values.push_back(parseValue(fields_[0], colName));
+  }
+}
+
+void CsvTimeCursor::readPoint(long row, const std::string &colName,
+                              date_time &time, quad &value) {
+  long column = shared_ ? shared_->columnIndex(colName) : -1;
+  if (column >= 0) {
+    time = fromTicks(shared_->times()[row]);
+    value = shared_->value(column, row);
+    return;
+  }
+
+  group_.readLine(row, line_);
+  group_.splitFields(line_, timeProjection(), fields_);
+  time = fromTicks(parseTimeFields(fields_));
+  group_.splitFields(line_, valueProjection(colName), fields_);
+  value = parseValue(fields_[0], colName);
+}
+
+void CsvTimeCursor::readRange(size_t first, size_t last,
+                              const std::string &colName,
+                              std::vector<date_time> &times,
+                              std::vector<quad> &values) {
+  std::vector<long> rows(last > first ? last - first : 0);
+  std::iota(rows.begin(), rows.end(), static_cast<long>(first));
+  readPoints(rows, colName, times, values);
+}
+
+template <CsvTimeFormat Format>
+time_ticks CsvTimeCursor::parseRowTime(size_t index) {
+  constexpr std::size_t width = TimeParser<Format>::columns.size();
+
+  group_.getFields(index, timeProjection(), fields_);
+  return parseTimeTicks<Format>(
+      std::span<const std::string_view, width>(fields_.data(), width));
+}
+
+template <CsvTimeFormat Format>
+std::vector<time_ticks> CsvTimeCursor::parseRowTimes(size_t first,
+                                                     size_t last) {
+  constexpr std::size_t width = TimeParser<Format>::columns.size();
+
+  // Copy the time fields out, as each read reuses the line buffer
+  std::vector<std::string> storage;
+  storage.reserve((last - first) * width);
+  for (size_t index = first; index < last; ++index) {
+    group_.getFields(index, timeProjection(), fields_);
+    for (const auto &field : fields_) {
+      storage.emplace_back(field);
+    }
+  }
+  std::vector<std::string_view> fields(storage.begin(), storage.end());
+
+  std::vector<time_ticks> ticks(last - first);
+  parseTimeBatch<Format>(fields, ticks);
+  return ticks;
+}
+
+date_time CsvTimeCursor::timeOfRow(size_t index) {
+  // Check if the index is already cached
+  if (timeCache_.find(index) != timeCache_.end()) {
+    return timeCache_[index];
+  }
+
+  // Decoded times are read straight from shared memory
+  if (shared_) {
+    if (index >= size_t(shared_->size())) {
+      throw std::out_of_range("Row index out of range");
+    }
+    return fromTicks(shared_->times()[index]);
+  }
+
+  // If not cached, parse the time from the CSV row
+  date_time time;
+
+  switch (timeFormat_) {
+  case CsvTimeFormat::oneColStandard:
+    return fromTicks(parseRowTime<CsvTimeFormat::oneColStandard>(index));
+  case CsvTimeFormat::twoColShort:
+    return fromTicks(parseRowTime<CsvTimeFormat::twoColShort>(index));
+
+  default:
+    throw std::invalid_argument("Unsupported CSV time format: " +
+                                std::to_string(static_cast<int>(timeFormat_)));
+  }
+
+  // Cache the parsed time
+  timeCache_[index] = time;
+  return time;
+}
+
+std::vector<time_ticks> CsvTimeCursor::timesOfRows(size_t first,
+                                                   size_t last) {
+  if (shared_) {
+    if (first > last || last > size_t(shared_->size())) {
+      throw std::out_of_range("Row index out of range");
+    }
+    auto times = shared_->times().subspan(first, last - first);
+    return std::vector<time_ticks>(times.begin(), times.end());
+  }
+
+  switch (timeFormat_) {
+  case CsvTimeFormat::oneColStandard:
+    return parseRowTimes<CsvTimeFormat::oneColStandard>(first, last);
+  case CsvTimeFormat::twoColShort:
+    return parseRowTimes<CsvTimeFormat::twoColShort>(first, last);
+
+  default:
+    throw std::invalid_argument("Unsupported CSV time format: " +
+                                std::to_string(static_cast<int>(timeFormat_)));
+  }
+}
+
+std::pair<size_t, size_t> CsvTimeCursor::bounds(date_time time) {
+  long start_index = 0;
+  long end_index = group_.size() - 1;
+
+  date_time start_time = timeOfRow(start_index);
+  date_time end_time = timeOfRow(end_index);
+
+  if (time < start_time) {
+    return {-1, start_index};
+  }
+  if (time > end_time) {
+    return {end_index, -1};
+  }
+
+  // Start from the rows the uniform segments put around the time, once
+  // their times confirm it
+  if (segments_) {
+    auto [first, last] = segments_->window(toTicks(time));
+    if (first < last && (first == 0 || timeOfRow(first) < time) &&
+        timeOfRow(last) >= time) {
+      start_index = first;
+      end_index = last;
+    }
+  }
+
+  while (end_index - start_index > 1) {
+    long middle_index = (start_index + end_index) / 2;
+    date_time middle_time = timeOfRow(middle_index);
+
+    if (middle_time < time) {
+      start_index = middle_index;
+      start_time = middle_time;
+    } else {
+      end_index = middle_index;
+      end_time = middle_time;
+    }
+  }
+  return {start_index, end_index};
+}
+
+size_t CsvTimeCursor::closestIndex(date_time time) {
+  auto [start_index, end_index] = bounds(time);
+  if (start_index == -1) {
+    return end_index;
+  }
+  if (end_index == -1) {
+    return start_index;
+  }
+
+  date_time start_time = timeOfRow(start_index);
+  date_time end_time = timeOfRow(end_index);
+
+  return (time - start_time < end_time - time) ? start_index : end_index;
+}
+
+quad CsvTimeCursor::colAtTime(date_time time, const std::string &colName) {
+  // Handle extrapolation for times outside the range of the CSV data
+  if (time < startTime()) {
+    // Generate extrapolation parameters if not already cached
+    if (!extrapolationCacheLow_.contains(colName)) {
+      date_time ref_time = startTime();
+
+      // Read the fit points in one batch
+      std::vector<long> rows(10);
+      std::iota(rows.begin(), rows.end(), 0);
+      std::vector<date_time> row_times;
+      std::vector<quad> values;
+      readPoints(rows, colName, row_times, values);
+
+      std::vector<quad> times;
+      for (const auto &row_time : row_times) {
+        times.push_back((row_time - ref_time).total_microseconds());
+      }
+
+      // Perform linear regression to estimate the value at the given time
+      auto [constant, slope] =
+          boost::math::statistics::simple_ordinary_least_squares(times, values);
+      extrapolationCacheLow_[colName] = {ref_time, constant, slope};
+    }
+    // Use the cached extrapolation parameters to calculate the value
+    auto &[ref_time, constant, slope] = extrapolationCacheLow_[colName];
+    return constant + slope * (time - ref_time).total_microseconds();
+  } else if (time > endTime()) {
+    // Generate extrapolation parameters for the high side if not already cached
+    if (!extrapolationCacheHigh_.contains(colName)) {
+      date_time ref_time = endTime();
+
+      // Read the fit points in one batch
+      std::vector<long> rows(10);
+      std::iota(rows.begin(), rows.end(), group_.size() - 10);
+      std::vector<date_time> row_times;
+      std::vector<quad> values;
+      readPoints(rows, colName, row_times, values);
+
+      std::vector<quad> times;
+      for (const auto &row_time : row_times) {
+        times.push_back((row_time - ref_time).total_microseconds());
+      }
+
+      // Perform linear regression to estimate the value at the given time
+      auto [constant, slope] =
+          boost::math::statistics::simple_ordinary_least_squares(times, values);
+      extrapolationCacheHigh_[colName] = {ref_time, constant, slope};
+    }
+    // Use the cached extrapolation parameters to calculate the value
+    auto &[ref_time, constant, slope] = extrapolationCacheHigh_[colName];
+    return constant + slope * (time - ref_time).total_microseconds();
+  }
+
+  // If the time is within the range of the CSV data, find the two rows that
+  // enclose the time
+  auto [start_index, end_index] = bounds(time);
+
+  // Read the enclosing rows into the cursor's buffers, so a lookup inside
+  // the rows allocates nothing
+  date_time start_time, end_time;
+  quad start_value, end_value;
+  readPoint(start_index, colName, start_time, start_value);
+  readPoint(end_index, colName, end_time, end_value);
+
+  // Interpolate the value at the given time
+
+  return start_value + (end_value - start_value) *
+                           (time - start_time).total_microseconds() /
+                           (end_time - start_time).total_microseconds();
+}
\ No newline at end of file
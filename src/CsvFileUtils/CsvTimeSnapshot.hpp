@@ -0,0 +1,305 @@
+#ifndef __CSVTIMESNAPSHOT_H__
+#define __CSVTIMESNAPSHOT_H__
+
+#include "CsvGroupSnapshot.hpp"
+#include "TimeParse.hpp"
+#include <boost/multiprecision/cpp_bin_float.hpp>
+
+using quad = boost::multiprecision::cpp_bin_float_quad;
+
+#include <map>
+#include <memory>
+#include <span>
+#include <string>
+#include <tuple>
+#include <vector>
+
+struct CsvTimeCursor;
+struct SharedDataset;
+struct TimeSegments;
+
+/**
+ * @brief Immutable view of a group of CSV time data, pinned to a row count.
+ *
+ * Taken from CsvTimeGroup::snapshot(), copies are cheap and can be handed to
+ * any number of workers. Time lookups keep caches, so each worker creates its
+ * own cursor from the snapshot rather than sharing one.
+ */
+struct CsvTimeSnapshot {
+private:
+  /**
+   * @brief The rows of the group.
+   */
+  CsvGroupSnapshot group_;
+
+  /**
+   * @brief The format of the time data in the CSV files.
+   */
+  CsvTimeFormat timeFormat_ = CsvTimeFormat::oneColStandard;
+
+public:
+  /**
+   * @brief Default constructor for a snapshot with no rows.
+   */
+  CsvTimeSnapshot() = default;
+
+  /**
+   * @brief Construct a snapshot of time data.
+   * @param group The rows of the group.
+   * @param timeFormat The format of the time data in the CSV files.
+   */
+  CsvTimeSnapshot(CsvGroupSnapshot group, CsvTimeFormat timeFormat)
+      : group_(std::move(group)), timeFormat_(timeFormat) {}
+
+  /**
+   * @brief Gets the number of rows in the snapshot.
+   * @return The number of rows, fixed when the snapshot was taken.
+   */
+  long size() const { return group_.size(); }
+
+  /**
+   * @brief Gets the rows of the group.
+   * @return The group snapshot.
+   */
+  const CsvGroupSnapshot &group() const { return group_; }
+
+  /**
+   * @brief Gets the format of the time data.
+   * @return The time format.
+   */
+  CsvTimeFormat timeFormat() const { return timeFormat_; }
+
+  /**
+   * @brief Creates a cursor for time lookups on the snapshot.
+   * @return A cursor for use by a single thread.
+   */
+  CsvTimeCursor cursor() const;
+};
+
+/**
+ * @brief Time lookups on a snapshot of CSV time data, for a single thread.
+ *
+ * Holds the caches and read buffers of the lookups, so it must not be shared
+ * between threads. Create one per worker from a shared CsvTimeSnapshot.
+ */
+struct CsvTimeCursor {
+private:
+  /**
+   * @brief The rows being read.
+   */
+  CsvGroupSnapshot group_;
+
+  /**
+   * @brief The format of the time data in the CSV files.
+   */
+  CsvTimeFormat timeFormat_ = CsvTimeFormat::oneColStandard;
+
+  /**
+   * @brief A cache for time values to avoid repeated parsing.
+   * Maps from index in the CSV file to the corresponding date_time.
+   */
+  std::map<size_t, date_time> timeCache_;
+
+  /**
+   * @brief A cache for extrapolation parameters, on the low side.
+   * @details Maps from column name to a tuple of (reference_time, constant,
+   * slope).
+   */
+  std::map<std::string, std::tuple<date_time, quad, quad>>
+      extrapolationCacheLow_;
+
+  /**
+   * @brief A cache for extrapolation parameters, on the high side.
+   * @details Maps from column name to a tuple of (reference_time, constant,
+   * slope).
+   */
+  std::map<std::string, std::tuple<date_time, quad, quad>>
+      extrapolationCacheHigh_;
+
+  /**
+   * @brief Projection of the time columns, built on first use.
+   */
+  Projection timeProjection_;
+
+  /**
+   * @brief Projections of single value columns, built on first use.
+   * @details Maps from column name to its projection.
+   */
+  std::map<std::string, Projection> valueProjections_;
+
+  /**
+   * @brief Reused storage for the fields of the current read.
+   */
+  std::vector<std::string_view> fields_;
+
+  /**
+   * @brief Reused storage for the line of the current read.
+   */
+  std::string line_;
+
+  /**
+   * @brief Decoded times and columns shared with other processes, used in
+   * place of parsing when attached.
+   */
+  std::shared_ptr<const SharedDataset> shared_;
+
+  /**
+   * @brief Uniform segments of the rows, narrowing time searches when
+   * attached.
+   */
+  std::shared_ptr<const TimeSegments> segments_;
+
+  /**
+   * @brief Gets the projection of the time columns.
+   */
+  const Projection &timeProjection();
+
+  /**
+   * @brief Gets the projection of a single value column.
+   */
+  const Projection &valueProjection(const std::string &colName);
+
+  /**
+   * @brief Parses a value field.
+   * @throws std::runtime_error if the value is not a number.
+   */
+  static quad parseValue(std::string_view field, const std::string &colName);
+
+  /**
+   * @brief Reads and parses a single column of a row.
+   * @param index The row number to read (0-based index).
+   * @param colName The column to read.
+   * @return The value of the column.
+   * @throws std::runtime_error if the value is not a number.
+   */
+  quad valueOfRow(size_t index, const std::string &colName);
+
+  /**
+   * @brief Reads the times and values of several rows in one batch.
+   * @param rows The row numbers to read.
+   * @param colName The value column to read.
+   * @param times Receives the time of each row.
+   * @param values Receives the value of each row.
+   */
+  void readPoints(std::span<const long> rows, const std::string &colName,
+                  std::vector<date_time> &times, std::vector<quad> &values);
+
+  /**
+   * @brief Reads the time and value of one row, reusing the cursor's
+   * buffers so nothing is allocated once they have grown.
+   * @param row The row number to read.
+   * @param colName The value column to read.
+   * @param time Receives the time of the row.
+   * @param value Receives the value of the row.
+   */
+  void readPoint(long row, const std::string &colName, date_time &time,
+                 quad &value);
+
+  /**
+   * @brief Parses the time fields of a row, from the time projection.
+   */
+  time_ticks parseTimeFields(const std::vector<std::string_view> &fields);
+
+  /**
+   * @brief Parses the time of a row with the parser for a given format.
+   */
+  template <CsvTimeFormat Format> time_ticks parseRowTime(size_t index);
+
+  /**
+   * @brief Parses the times of a range of rows with the batch parser for a
+   * given format.
+   */
+  template <CsvTimeFormat Format>
+  std::vector<time_ticks> parseRowTimes(size_t first, size_t last);
+
+public:
+  /**
+   * @brief Default constructor for a cursor over no rows.
+   */
+  CsvTimeCursor() = default;
+
+  /**
+   * @brief Construct a cursor over the rows of a group snapshot.
+   * @param group The rows to read.
+   * @param timeFormat The format of the time data in the CSV files.
+   */
+  CsvTimeCursor(CsvGroupSnapshot group, CsvTimeFormat timeFormat)
+      : group_(std::move(group)), timeFormat_(timeFormat) {}
+
+  /**
+   * @brief Gets the rows the cursor reads.
+   * @return The group snapshot.
+   */
+  const CsvGroupSnapshot &group() const { return group_; }
+
+  /**
+   * @brief Reads times, and the values of the columns it holds, from a
+   * shared dataset instead of parsing rows.
+   * @param shared A dataset decoded from the same rows, or nullptr to go back
+   * to parsing.
+   * @throws std::invalid_argument if the dataset has a different row count.
+   */
+  void attachShared(std::shared_ptr<const SharedDataset> shared);
+
+  /**
+   * @brief Finds the rows around a time from the uniform segments of the
+   * rows, searching only where they are irregular.
+   * @param segments Segments detected in the same rows, or nullptr to go back
+   * to searching every row.
+   * @throws std::invalid_argument if the segments cover a different row
+   * count.
+   */
+  void attachSegments(std::shared_ptr<const TimeSegments> segments);
+
+  date_time timeOfRow(size_t index);
+
+  /**
+   * @brief Gets the times of a range of rows in one pass.
+   * @details Intended for building time indices, parses all rows with the
+   * batch parser for the group's time format.
+   * @param first The index of the first row.
+   * @param last One past the index of the last row.
+   * @return The time of each row as ticks since 1970-01-01.
+   */
+  std::vector<time_ticks> timesOfRows(size_t first, size_t last);
+
+  /**
+   * @brief Reads the times and values of a range of rows in one batch.
+   * @param first The index of the first row.
+   * @param last One past the index of the last row.
+   * @param colName The value column to read.
+   * @param times Receives the time of each row.
+   * @param values Receives the value of each row.
+   * @throws std::runtime_error if a value is not a number.
+   */
+  void readRange(size_t first, size_t last, const std::string &colName,
+                 std::vector<date_time> &times, std::vector<quad> &values);
+
+  date_time startTime() { return timeOfRow(0); }
+
+  date_time endTime() { return timeOfRow(group_.size() - 1); }
+
+  std::pair<size_t, size_t> bounds(date_time time);
+
+  size_t closestIndex(date_time time);
+
+  quad colAtTime(date_time time, const std::string &colName);
+
+  std::map<std::string, std::string> operator[](size_t index) const {
+    return group_.getRow(index);
+  }
+
+  /**
+   * @brief Reads a row into the row struct of a schema.
+   * @param index The row number to read (0-based index).
+   * @param decoder A decoder created from the group's metadata.
+   * @return The decoded row.
+   */
+  template <typename Schema>
+  typename Schema::row_type row(size_t index,
+                                RowDecoder<Schema> &decoder) const {
+    return group_.getRow(index, decoder);
+  }
+};
+
+#endif // __CSVTIMESNAPSHOT_H__
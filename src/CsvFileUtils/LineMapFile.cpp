@@ -1,5 +1,6 @@
 #include "LineMapFile.hpp"
 
+#include <filesystem>
 #include <iostream>
 #include <sstream>
 
@@ -33,6 +34,9 @@ bool LineMapFile::isEqualSpaced(int segments) {
   }
 
   size_t lineCount = size();
+  if (lineCount < 2) {
+    return false; // Not enough lines to measure a spacing
+  }
 
   std::streamoff firstPosition = getLinePosition(0);
   std::streamoff secondPosition = getLinePosition(1);
@@ -128,17 +132,48 @@ void LineMapFile::push_back(std::streamoff position) {
                        sizeof(std::streamoff));
 }
 
+void LineMapFile::flush() {
+  if (lineMapWriter_.is_open()) {
+    lineMapWriter_.flush();
+  }
+}
+
+LineMapView LineMapFile::view() {
+  flush();
+  return LineMapView(filePath_, size());
+}
+
 void LineMapFile::clear() {
   if (lineMapWriter_.is_open()) {
     lineMapWriter_.close();
   }
-  lineMapWriter_.open(filePath_, std::ios::binary | std::ios::trunc);
+  if (lineMapReader_.is_open()) {
+    lineMapReader_.close();
+  }
+
+  // Unlink rather than truncate, views still map the old file and would fault
+  // on a truncated one
+  std::error_code error;
+  std::filesystem::remove(filePath_, error);
+  if (error) {
+    throw std::runtime_error("Failed to remove line map file while clearing: " +
+                             error.message());
+  }
+
+  lineMapWriter_.open(filePath_, std::ios::binary | std::ios::app);
   if (!lineMapWriter_.is_open()) {
     throw std::runtime_error(
         "Failed to open line map file for writing while clearing");
   }
+  lineMapReader_.open(filePath_, std::ios::binary);
+  if (!lineMapReader_.is_open()) {
+    throw std::runtime_error(
+        "Failed to open line map file for reading while clearing");
+  }
+
   // Clear the cache
   lineMapCache_.clear();
+  equalSpaced_ = false;
 }
 
 std::string LineMapFile::toString() const {
@@ -172,6 +207,7 @@ void LineMapFile::setFilePath(const std::string &filePath) {
     }
   }
   lineMapCache_.clear();
+  equalSpaced_ = false;
   equalSpaced_ = isEqualSpaced(100);
 }
 
@@ -1,6 +1,8 @@
 #ifndef __LINEMAPFILE_H__
 #define __LINEMAPFILE_H__
 
+#include "LineMapView.hpp"
+
 #include <fstream>
 #include <map>
 #include <string>
@@ -31,17 +33,17 @@ private:
   /**
    * @brief Indicates whether the line map is evenly spaced.
    */
-  bool equalSpaced_;
+  bool equalSpaced_ = false;
 
   /**
    * @brief The first line location in the line map.
    */
-  std::streamoff firstLineLoc_;
+  std::streamoff firstLineLoc_ = 0;
 
   /**
    * @brief The spacing between line locations in the line map.
    */
-  std::streamoff spacing_;
+  std::streamoff spacing_ = 0;
 
   /**
    * @brief Cache for line positions to avoid repeated file access.
@@ -119,8 +121,25 @@ public:
    */
   void push_back(std::streamoff position);
 
+  /**
+   * @brief Flushes appended positions to the file so they can be read back.
+   */
+  void flush();
+
+  /**
+   * @brief Creates a read only view of the lines written so far.
+   * @details Flushes appended positions first. The view is unaffected by
+   * later appends and by clear(), which replaces the file instead of
+   * truncating it.
+   * @return A view of every line currently in the file.
+   * @throws std::runtime_error if the file cannot be mapped.
+   */
+  LineMapView view();
+
   /**
    * @brief Clears the line map file, removing all entries.
+   * @details The file is replaced by a new empty one, so existing views keep
+   * the old positions.
    */
   void clear();
 
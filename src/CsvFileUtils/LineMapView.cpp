@@ -0,0 +1,45 @@
+#include "LineMapView.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+LineMapView::LineMapView(const std::string &filePath, std::size_t size)
+    : size_(size) {
+  if (size_ == 0) {
+    return;
+  }
+
+  int fd = ::open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw std::runtime_error("Failed to open line map file for mapping: " +
+                             filePath);
+  }
+
+  std::size_t length = size_ * sizeof(std::streamoff);
+  void *mapping = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+  int map_error = errno;
+  // The mapping keeps the file alive on its own
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    throw std::runtime_error("Failed to map line map file " + filePath + ": " +
+                             std::strerror(map_error));
+  }
+
+  positions_ = std::shared_ptr<const std::streamoff>(
+      static_cast<const std::streamoff *>(mapping),
+      [length](const std::streamoff *data) {
+        ::munmap(const_cast<std::streamoff *>(data), length);
+      });
+}
+
+std::streamoff LineMapView::at(std::size_t lineNumber) const {
+  if (lineNumber >= size_) {
+    throw std::out_of_range("Line number is out of range");
+  }
+  return (*this)[lineNumber];
+}
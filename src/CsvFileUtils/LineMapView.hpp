@@ -0,0 +1,74 @@
+#ifndef __LINEMAPVIEW_H__
+#define __LINEMAPVIEW_H__
+
+#include <cstddef>
+#include <ios>
+#include <memory>
+#include <string>
+
+/**
+ * @brief Read only view of the first lines of a line map file.
+ *
+ * Maps the line map file into memory and fixes the number of lines when
+ * created, so it never changes afterwards. Any number of threads can look up
+ * positions at once without locks. Views are cheap to copy and share the
+ * mapping, which stays valid after the file is appended to or replaced.
+ */
+struct LineMapView {
+private:
+  /**
+   * @brief The mapped positions, unmapped when the last copy is destroyed.
+   */
+  std::shared_ptr<const std::streamoff> positions_;
+
+  /**
+   * @brief Number of lines in the view.
+   */
+  std::size_t size_ = 0;
+
+public:
+  /**
+   * @brief Default constructor for an empty view.
+   */
+  LineMapView() = default;
+
+  /**
+   * @brief Construct a view of the first lines of a line map file.
+   * @param filePath The path to the line map file.
+   * @param size The number of lines to include, all of which must already be
+   * written to the file.
+   * @throws std::runtime_error if the file cannot be mapped.
+   */
+  LineMapView(const std::string &filePath, std::size_t size);
+
+  /**
+   * @brief Gets the number of lines in the view.
+   * @return The number of lines.
+   */
+  std::size_t size() const { return size_; }
+
+  /**
+   * @brief Checks if the view has no lines.
+   * @return True if the view is empty.
+   */
+  bool empty() const { return size_ == 0; }
+
+  /**
+   * @brief Gets the position of a line.
+   * @param lineNumber The line number (0-based index).
+   * @return The position of the line in the data file.
+   * @throws std::out_of_range if the line number is out of range.
+   */
+  std::streamoff at(std::size_t lineNumber) const;
+
+  /**
+   * @brief Gets the position of a line without range checking.
+   * @param lineNumber The line number (0-based index), less than size().
+   * @return The position of the line in the data file.
+   */
+  std::streamoff operator[](std::size_t lineNumber) const {
+    return positions_.get()[lineNumber];
+  }
+};
+
+#endif // __LINEMAPVIEW_H__
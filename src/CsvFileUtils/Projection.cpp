@@ -0,0 +1,18 @@
+#include "Projection.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+Projection::Projection(const std::vector<std::string> &colNames,
+                       const std::vector<std::string> &columns) {
+  positions_.reserve(columns.size());
+  for (const auto &column : columns) {
+    auto it = std::find(colNames.begin(), colNames.end(), column);
+    if (it == colNames.end()) {
+      throw std::runtime_error("Column '" + column +
+                               "' not found in the file column names");
+    }
+    positions_.push_back(it - colNames.begin());
+    fieldCount_ = std::max(fieldCount_, positions_.back() + 1);
+  }
+}
@@ -0,0 +1,68 @@
+#ifndef __PROJECTION_H__
+#define __PROJECTION_H__
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A subset of the columns of a CSV file, resolved to field positions.
+ *
+ * Built once from the column names, then used to read only the requested
+ * fields of each row. Splitting stops after the last requested field, so the
+ * cost of a read depends on the columns asked for rather than the width of
+ * the file.
+ */
+struct Projection {
+private:
+  /**
+   * @brief Field position of each requested column, in request order.
+   */
+  std::vector<std::size_t> positions_;
+
+  /**
+   * @brief Number of fields to split to reach every requested column.
+   */
+  std::size_t fieldCount_ = 0;
+
+public:
+  /**
+   * @brief Default constructor for an empty projection.
+   */
+  Projection() = default;
+
+  /**
+   * @brief Construct a projection of the given columns.
+   * @param colNames The column names of the file, in file order.
+   * @param columns The columns to read, in the order they are wanted.
+   * @throws std::runtime_error if a requested column is not in colNames.
+   */
+  Projection(const std::vector<std::string> &colNames,
+             const std::vector<std::string> &columns);
+
+  /**
+   * @brief Gets the field position of each requested column.
+   * @return The positions, in request order.
+   */
+  const std::vector<std::size_t> &positions() const { return positions_; }
+
+  /**
+   * @brief Gets the number of fields to split to reach every column.
+   * @return One past the largest position.
+   */
+  std::size_t fieldCount() const { return fieldCount_; }
+
+  /**
+   * @brief Gets the number of requested columns.
+   * @return The number of columns.
+   */
+  std::size_t size() const { return positions_.size(); }
+
+  /**
+   * @brief Checks if the projection has no columns.
+   * @return true if no columns were requested.
+   */
+  bool empty() const { return positions_.empty(); }
+};
+
+#endif // __PROJECTION_H__
@@ -0,0 +1,297 @@
+#include "Resample.hpp"
+#include "AtomicFile.hpp"
+#include "../Utils/Fingerprint.hpp"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace bip = boost::interprocess;
+
+namespace {
+/**
+ * @brief Identifies a cached resampled column.
+ */
+constexpr std::uint64_t gridMagic = 0x0044495247504b54; // "TKPGRID"
+constexpr std::uint32_t gridVersion = 1;
+
+/**
+ * @brief Grid points resampled per batch of rows.
+ */
+constexpr long chunkPoints = 65536;
+
+/**
+ * @brief The most rows read per point of a batch, before the batch is split.
+ */
+constexpr long rowsPerPoint = 16;
+
+/**
+ * @brief The fixed header at the start of a cached array.
+ */
+struct GridHeader {
+  std::uint64_t magic;
+  std::uint32_t version;
+  std::uint32_t method;
+  /**
+   * @brief Fingerprint of the group, column, grid and method.
+   */
+  std::uint64_t key;
+  std::int64_t start;
+  std::int64_t step;
+  /**
+   * @brief The rows the points were computed from, and the times of the
+   * first and last of them, to tell whether the rows were appended to.
+   */
+  std::int64_t sourceRows;
+  std::int64_t firstTime;
+  std::int64_t lastTime;
+  std::int64_t points;
+};
+
+constexpr std::size_t valuesOffset = 128;
+static_assert(sizeof(GridHeader) <= valuesOffset);
+
+std::uint64_t gridKey(const CsvTimeSnapshot &snapshot,
+                      const std::string &column, time_ticks start,
+                      time_ticks step, ResampleMethod method) {
+  const CsvGroupMetadata &metadata = snapshot.group().metadata();
+  Fingerprint fingerprint;
+  fingerprint.add(metadata.parentPath());
+  fingerprint.add(metadata.dataTemplate());
+  fingerprint.add(metadata.delimiter());
+  fingerprint.addValue(metadata.multiDelimiter());
+  fingerprint.addValue(snapshot.timeFormat());
+  fingerprint.add(column);
+  fingerprint.addValue(start);
+  fingerprint.addValue(step);
+  fingerprint.addValue(method);
+  fingerprint.addValue(gridVersion);
+  return fingerprint.hash;
+}
+} // namespace
+
+struct ResampledColumn::Contents {
+  /**
+   * @brief The mapped array.
+   */
+  bip::mapped_region region;
+};
+
+std::string ResampledColumn::cachePath(const CsvTimeSnapshot &snapshot,
+                                       const std::string &column,
+                                       date_time start, time_delt step,
+                                       ResampleMethod method,
+                                       const std::string &cacheDirectory) {
+  char name[40];
+  std::snprintf(name, sizeof(name), ".resample.%016llx.grid",
+                static_cast<unsigned long long>(gridKey(
+                    snapshot, column, toTicks(start), step.ticks(), method)));
+  std::string directory = cacheDirectory.empty()
+                              ? snapshot.group().metadata().parentPath()
+                              : cacheDirectory;
+  return directory + "/" + name;
+}
+
+ResampledColumn ResampledColumn::build(const CsvTimeSnapshot &snapshot,
+                                       std::string column, date_time start,
+                                       time_delt step, date_time end,
+                                       ResampleMethod method,
+                                       const std::string &cacheDirectory) {
+  if (step.ticks() <= 0) {
+    throw std::invalid_argument("Resampling step must be positive");
+  }
+  const long rows = snapshot.size();
+  if (rows < 2) {
+    throw std::runtime_error("Cannot resample a group of fewer than two rows");
+  }
+
+  ResampledColumn result;
+  result.cursor_ = snapshot.cursor();
+  result.column_ = std::move(column);
+  result.method_ = method;
+  result.start_ = toTicks(start);
+  result.step_ = step.ticks();
+
+  const time_ticks first_time = toTicks(result.cursor_.startTime());
+  const time_ticks last_time = toTicks(result.cursor_.endTime());
+  const time_ticks last_point = std::min(toTicks(end), last_time);
+  const long needed = last_point >= result.start_
+                          ? (last_point - result.start_) / result.step_ + 1
+                          : 0;
+
+  GridHeader header{gridMagic,
+                    gridVersion,
+                    static_cast<std::uint32_t>(method),
+                    gridKey(snapshot, result.column_, result.start_,
+                            result.step_, method),
+                    result.start_,
+                    result.step_,
+                    rows,
+                    first_time,
+                    last_time,
+                    needed};
+  const std::string path = cachePath(snapshot, result.column_, start, step,
+                                     method, cacheDirectory);
+
+  // Reuse the cached points, unless the rows they came from changed
+  long reused = 0;
+  std::vector<PackedQuad> values;
+  std::ifstream cached(path, std::ios::binary);
+  GridHeader saved{};
+  if (cached.read(reinterpret_cast<char *>(&saved), sizeof(saved)) &&
+      saved.magic == gridMagic && saved.version == gridVersion &&
+      saved.key == header.key && saved.method == header.method &&
+      saved.start == header.start && saved.step == header.step &&
+      saved.sourceRows >= 2 && saved.sourceRows <= rows &&
+      saved.firstTime == first_time &&
+      toTicks(result.cursor_.timeOfRow(saved.sourceRows - 1)) ==
+          saved.lastTime) {
+    reused = saved.points;
+    if (saved.sourceRows < rows) {
+      // Appended rows can only change the points at or after the old last row
+      reused = std::min<long>(
+          reused, saved.lastTime > result.start_
+                      ? (saved.lastTime - result.start_ - 1) / result.step_ + 1
+                      : 0);
+    }
+  }
+
+  if (needed > reused) {
+    values.resize(needed);
+    if (reused > 0 &&
+        !cached.seekg(valuesOffset)
+             .read(reinterpret_cast<char *>(values.data()),
+                   reused * sizeof(PackedQuad))) {
+      reused = 0;
+    }
+    result.resample(reused, needed, values);
+    result.resampled_ = needed - reused;
+
+    char padding[valuesOffset] = {};
+    std::memcpy(padding, &header, sizeof(header));
+    AtomicFile file(path);
+    file.write(std::string_view(padding, sizeof(padding)));
+    file.write(std::string_view(reinterpret_cast<const char *>(values.data()),
+                                values.size() * sizeof(PackedQuad)));
+    file.commit();
+    reused = needed;
+  }
+  cached.close();
+
+  if (reused > 0) {
+    auto contents = std::make_shared<Contents>();
+    try {
+      bip::file_mapping mapping(path.c_str(), bip::read_only);
+      contents->region = bip::mapped_region(mapping, bip::read_only);
+    } catch (const bip::interprocess_exception &e) {
+      throw std::runtime_error("Failed to map resampled column " + path +
+                               ": " + e.what());
+    }
+    if (contents->region.get_size() <
+        valuesOffset + reused * sizeof(PackedQuad)) {
+      throw std::runtime_error("Resampled column " + path + " is truncated");
+    }
+    result.values_ = reinterpret_cast<const PackedQuad *>(
+        static_cast<const char *>(contents->region.get_address()) +
+        valuesOffset);
+    result.contents_ = std::move(contents);
+  }
+  result.size_ = reused;
+  return result;
+}
+
+void ResampledColumn::resample(long first, long last,
+                               std::vector<PackedQuad> &values) {
+  const date_time first_time = cursor_.startTime();
+
+  // Points before the first row are extrapolated
+  long point = first;
+  for (; point < last && timeOf(point) < first_time; ++point) {
+    values[point] = packQuad(compute(timeOf(point)));
+  }
+
+  std::vector<date_time> times;
+  std::vector<quad> row_values;
+  while (point < last) {
+    // Read the rows enclosing a batch of points, splitting the batch where
+    // the rows are much denser than the grid
+    long batch_end = std::min(last, point + chunkPoints);
+    long first_row = static_cast<long>(cursor_.bounds(timeOf(point)).first);
+    long last_row = 0;
+    while (true) {
+      last_row =
+          static_cast<long>(cursor_.bounds(timeOf(batch_end - 1)).second);
+      if (batch_end - point == 1 ||
+          last_row - first_row <= rowsPerPoint * (batch_end - point)) {
+        break;
+      }
+      batch_end = point + (batch_end - point) / 2;
+    }
+    cursor_.readRange(first_row, last_row + 1, column_, times, row_values);
+
+    // Walk the rows with the points, pairing each with the rows bounds()
+    // would, the first at or after it and the one before
+    long end_row = std::max(first_row + 1, 1L);
+    for (; point < batch_end; ++point) {
+      const date_time time = timeOf(point);
+      while (times[end_row - first_row] < time) {
+        ++end_row;
+      }
+      const long s = end_row - 1 - first_row;
+      const long e = end_row - first_row;
+
+      quad value;
+      switch (method_) {
+      case ResampleMethod::linear:
+        value = row_values[s] + (row_values[e] - row_values[s]) *
+                                    (time - times[s]).total_microseconds() /
+                                    (times[e] - times[s]).total_microseconds();
+        break;
+      case ResampleMethod::previous:
+        value = times[e] == time ? row_values[e] : row_values[s];
+        break;
+      case ResampleMethod::nearest:
+        value = time - times[s] < times[e] - time ? row_values[s]
+                                                  : row_values[e];
+        break;
+      }
+      values[point] = packQuad(value);
+    }
+  }
+}
+
+quad ResampledColumn::compute(date_time time) {
+  if (method_ == ResampleMethod::linear) {
+    return cursor_.colAtTime(time, column_);
+  }
+
+  // Outside the rows both methods take the first or last row
+  auto [start_index, end_index] = cursor_.bounds(time);
+  std::vector<date_time> times;
+  std::vector<quad> values;
+  if (start_index == static_cast<size_t>(-1) ||
+      end_index == static_cast<size_t>(-1)) {
+    size_t row = start_index == static_cast<size_t>(-1) ? end_index
+                                                        : start_index;
+    cursor_.readRange(row, row + 1, column_, times, values);
+    return values[0];
+  }
+
+  cursor_.readRange(start_index, end_index + 1, column_, times, values);
+  if (method_ == ResampleMethod::previous) {
+    return times[1] == time ? values[1] : values[0];
+  }
+  return time - times[0] < times[1] - time ? values[0] : values[1];
+}
+
+quad ResampledColumn::at(long index) const {
+  if (index < 0 || index >= size_) {
+    throw std::out_of_range("Resampled point out of range");
+  }
+  return unpackQuad(values_[index]);
+}
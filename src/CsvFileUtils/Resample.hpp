@@ -0,0 +1,211 @@
+#ifndef __RESAMPLE_H__
+#define __RESAMPLE_H__
+
+#include "CsvTimeSnapshot.hpp"
+#include "SharedDataset.hpp"
+#include "TimeParse.hpp"
+
+#include <memory>
+#include <string>
+
+/**
+ * @brief How a resampled point is taken from the rows around it.
+ */
+enum class ResampleMethod {
+  /**
+   * @brief Interpolated between the enclosing rows, and extrapolated by a fit
+   * to the first or last ten rows, exactly as CsvTimeCursor::colAtTime.
+   */
+  linear,
+
+  /**
+   * @brief The value of the row at the point, or else of the last row before
+   * it.
+   */
+  previous,
+
+  /**
+   * @brief The value of the row closest to the point, as
+   * CsvTimeCursor::closestIndex.
+   */
+  nearest
+};
+
+/**
+ * @brief One column of a time group resampled onto a uniform time grid, and
+ * cached on disk.
+ *
+ * The points of the grid are start() + i * step(), up to the last row of the
+ * group. They are computed once per group, column, grid and method and saved
+ * as a binary array of exact quads, which later runs map and read by index,
+ * (t - start()) / step(), without searching the rows. When rows are appended
+ * to the group only the points from the previous last row on are resampled.
+ *
+ * Lookups off the grid or past the last row are computed from the rows, so
+ * valueAt() always gives what the method gives on the rows. Like a cursor a
+ * resampled column is for a single thread, copies share the mapped array.
+ */
+struct ResampledColumn {
+private:
+  /**
+   * @brief The mapped array.
+   */
+  struct Contents;
+
+  /**
+   * @brief Lookups on the rows, for points not on the grid.
+   */
+  CsvTimeCursor cursor_;
+
+  /**
+   * @brief The resampled column.
+   */
+  std::string column_;
+
+  /**
+   * @brief How points are taken from the rows.
+   */
+  ResampleMethod method_ = ResampleMethod::linear;
+
+  /**
+   * @brief Time of the first point, as ticks since 1970-01-01.
+   */
+  time_ticks start_ = 0;
+
+  /**
+   * @brief Ticks between points.
+   */
+  time_ticks step_ = 1;
+
+  /**
+   * @brief The mapped array, shared by copies.
+   */
+  std::shared_ptr<const Contents> contents_;
+
+  /**
+   * @brief The points in the mapping.
+   */
+  const PackedQuad *values_ = nullptr;
+
+  /**
+   * @brief Number of points.
+   */
+  long size_ = 0;
+
+  /**
+   * @brief Number of points computed when the column was built.
+   */
+  long resampled_ = 0;
+
+  /**
+   * @brief Computes the points of a range of the grid from the rows.
+   * @param first The first point.
+   * @param last One past the last point, at or before the last row.
+   * @param values Receives the packed points.
+   */
+  void resample(long first, long last, std::vector<PackedQuad> &values);
+
+  /**
+   * @brief Computes one point from the rows, the way resample() does.
+   */
+  quad compute(date_time time);
+
+public:
+  /**
+   * @brief Default constructor for a column with no points.
+   */
+  ResampledColumn() = default;
+
+  /**
+   * @brief Resamples a column onto a grid, reusing the cached points.
+   * @param snapshot The rows to resample.
+   * @param column The value column to resample.
+   * @param start The time of the first point.
+   * @param step The time between points.
+   * @param end The latest point needed, points past the last row are never
+   * cached.
+   * @param method How points are taken from the rows.
+   * @param cacheDirectory Where the array is cached, the group's parent
+   * directory if empty.
+   * @return The resampled column.
+   * @throws std::invalid_argument if step is not positive.
+   * @throws std::runtime_error if the group has fewer than two rows, a value
+   * is not a number, or the cache cannot be written.
+   */
+  static ResampledColumn build(const CsvTimeSnapshot &snapshot,
+                               std::string column, date_time start,
+                               time_delt step, date_time end,
+                               ResampleMethod method = ResampleMethod::linear,
+                               const std::string &cacheDirectory = "");
+
+  /**
+   * @brief Gets the path a resampled column is cached at.
+   * @details Named after a fingerprint of the group's location and format,
+   * the column, the grid and the method.
+   * @param snapshot The rows to resample.
+   * @param column The value column to resample.
+   * @param start The time of the first point.
+   * @param step The time between points.
+   * @param method How points are taken from the rows.
+   * @param cacheDirectory Where the array is cached, the group's parent
+   * directory if empty.
+   * @return The path of the cached array.
+   */
+  static std::string cachePath(const CsvTimeSnapshot &snapshot,
+                               const std::string &column, date_time start,
+                               time_delt step, ResampleMethod method,
+                               const std::string &cacheDirectory = "");
+
+  /**
+   * @brief Gets the time of the first point.
+   */
+  date_time start() const { return fromTicks(start_); }
+
+  /**
+   * @brief Gets the time between points.
+   */
+  time_delt step() const { return time_delt(0, 0, 0, step_); }
+
+  /**
+   * @brief Gets the number of cached points.
+   */
+  long size() const { return size_; }
+
+  /**
+   * @brief Gets the number of points computed by build(), the others were
+   * read from the cache.
+   */
+  long resampled() const { return resampled_; }
+
+  /**
+   * @brief Gets the time of a point.
+   */
+  date_time timeOf(long index) const {
+    return fromTicks(start_ + index * step_);
+  }
+
+  /**
+   * @brief Gets a cached point.
+   * @param index The point, 0 for start().
+   * @return The value of the column at timeOf(index).
+   * @throws std::out_of_range if the point is not cached.
+   */
+  quad at(long index) const;
+
+  /**
+   * @brief Gets the value of the column at a time.
+   * @details Read by index when the time is a cached point, else computed
+   * from the rows.
+   * @param time The time to look up.
+   * @return The value of the column.
+   */
+  quad valueAt(date_time time) {
+    time_ticks offset = toTicks(time) - start_;
+    if (offset >= 0 && offset % step_ == 0 && offset / step_ < size_) {
+      return unpackQuad(values_[offset / step_]);
+    }
+    return compute(time);
+  }
+};
+
+#endif // __RESAMPLE_H__
@@ -0,0 +1,77 @@
+#include "RowArena.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+bool ArenaRow::contains(std::string_view name) const {
+  if (!columns_) {
+    return false;
+  }
+  long index = columns_->index(name);
+  return index >= 0 && static_cast<std::size_t>(index) < size_;
+}
+
+std::string_view ArenaRow::value(std::size_t index) const {
+  if (index >= size_) {
+    throw std::out_of_range("Field index out of range");
+  }
+  return values_[index];
+}
+
+std::string_view ArenaRow::operator[](std::string_view name) const {
+  long index = columns_ ? columns_->index(name) : -1;
+  if (index < 0 || static_cast<std::size_t>(index) >= size_) {
+    throw std::out_of_range("Row has no column " + std::string(name));
+  }
+  return values_[index];
+}
+
+std::map<std::string, std::string> ArenaRow::toMap() const {
+  std::map<std::string, std::string> row;
+  for (std::size_t i = 0; i < size_; ++i) {
+    row[columns_->names()[i]] = std::string(values_[i]);
+  }
+  return row;
+}
+
+RowArena::RowArena(std::size_t bytes) : buffer_(bytes) {
+  resource_.emplace(buffer_.data(), buffer_.size());
+}
+
+void *RowArena::allocate(std::size_t bytes, std::size_t alignment) {
+  used_ += bytes + alignment - 1;
+  return resource_->allocate(bytes, alignment);
+}
+
+ArenaRow RowArena::row(const ColumnNames &columns, std::string_view line,
+                       const Tokenizer &tokenizer) {
+  // Split no further than there are columns, as CsvFileView::getRow does
+  tokenizer.split(line, fields_, columns.size());
+
+  // Copy the fields, as they may be views into the line or the tokenizer's
+  // storage
+  std::size_t text_size = 0;
+  for (const auto &field : fields_) {
+    text_size += field.size();
+  }
+  char *text = static_cast<char *>(allocate(text_size, 1));
+  auto *values = static_cast<std::string_view *>(
+      allocate(fields_.size() * sizeof(std::string_view),
+               alignof(std::string_view)));
+  for (std::size_t i = 0; i < fields_.size(); ++i) {
+    std::memcpy(text, fields_[i].data(), fields_[i].size());
+    values[i] = std::string_view(text, fields_[i].size());
+    text += fields_[i].size();
+  }
+  return ArenaRow(&columns, values, fields_.size());
+}
+
+void RowArena::reset() {
+  // A batch that spilled to the heap gets a buffer it fits in next time
+  if (used_ > buffer_.size()) {
+    resource_.reset();
+    buffer_ = std::vector<std::byte>(2 * used_);
+  }
+  resource_.emplace(buffer_.data(), buffer_.size());
+  used_ = 0;
+}
@@ -0,0 +1,179 @@
+#ifndef __ROWARENA_H__
+#define __ROWARENA_H__
+
+#include "ColumnNames.hpp"
+#include "Tokenizer.hpp"
+
+#include <cstddef>
+#include <map>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief A row of named fields, held in a RowArena.
+ *
+ * The map-style view of a row, without the map: fields are looked up by
+ * column name through the group's shared ColumnNames, and their text is in
+ * the arena the row was made in. A row is valid until its arena is reset,
+ * and while the column names it was made with are held.
+ */
+struct ArenaRow {
+private:
+  /**
+   * @brief Names of the fields, by position.
+   */
+  const ColumnNames *columns_ = nullptr;
+
+  /**
+   * @brief The fields, in the arena.
+   */
+  const std::string_view *values_ = nullptr;
+
+  /**
+   * @brief Number of fields, which may be fewer than the columns.
+   */
+  std::size_t size_ = 0;
+
+public:
+  /**
+   * @brief Default constructor for a row of no fields.
+   */
+  ArenaRow() = default;
+
+  /**
+   * @brief Construct a row from fields held in an arena.
+   * @param columns Names of the fields, by position.
+   * @param values The fields.
+   * @param size Number of fields.
+   */
+  ArenaRow(const ColumnNames *columns, const std::string_view *values,
+           std::size_t size)
+      : columns_(columns), values_(values), size_(size) {}
+
+  /**
+   * @brief Gets the number of fields in the row.
+   */
+  std::size_t size() const { return size_; }
+
+  /**
+   * @brief Checks whether the row has a column.
+   * @param name The column name.
+   * @return True if the row has a field for the column.
+   */
+  bool contains(std::string_view name) const;
+
+  /**
+   * @brief Gets a field by position.
+   * @param index The position of the field, in file order.
+   * @return The text of the field.
+   * @throws std::out_of_range if the row has no such field.
+   */
+  std::string_view value(std::size_t index) const;
+
+  /**
+   * @brief Gets a field by column name.
+   * @param name The column name.
+   * @return The text of the field.
+   * @throws std::out_of_range if the row has no field for the column.
+   */
+  std::string_view operator[](std::string_view name) const;
+
+  /**
+   * @brief Copies the row into a map of column names to values, as returned
+   * by the getRow overloads without an arena.
+   * @return The map of the row.
+   */
+  std::map<std::string, std::string> toMap() const;
+};
+
+/**
+ * @brief Monotonic storage for rows made in batches.
+ *
+ * Making a row copies its fields into the arena with bump allocations, and
+ * reset() frees every row at once. The arena grows its buffer to the largest
+ * batch it has seen, so once warm a batch allocates nothing from the heap.
+ * An arena is for a single thread.
+ *
+ * Example:
+ * @code
+ * RowArena arena;
+ * for (long first = 0; first < group.size(); first += 1024) {
+ *   arena.reset();
+ *   for (long row = first; row < std::min(first + 1024, group.size());
+ *        ++row) {
+ *     ArenaRow fields = group.getRow(row, arena);
+ *     print(fields["Time"]);
+ *   }
+ * }
+ * @endcode
+ */
+struct RowArena {
+private:
+  /**
+   * @brief The buffer rows are made in first.
+   */
+  std::vector<std::byte> buffer_;
+
+  /**
+   * @brief Bump allocator over the buffer, spilling to the heap when it is
+   * full.
+   */
+  std::optional<std::pmr::monotonic_buffer_resource> resource_;
+
+  /**
+   * @brief Bytes handed out since the last reset.
+   */
+  std::size_t used_ = 0;
+
+  /**
+   * @brief Reused storage for the fields of the line being split.
+   */
+  std::vector<std::string_view> fields_;
+
+  /**
+   * @brief Takes storage from the arena.
+   */
+  void *allocate(std::size_t bytes, std::size_t alignment);
+
+public:
+  /**
+   * @brief Construct an arena.
+   * @param bytes The initial size of the buffer.
+   */
+  explicit RowArena(std::size_t bytes = 64 * 1024);
+
+  RowArena(const RowArena &) = delete;
+  RowArena &operator=(const RowArena &) = delete;
+
+  /**
+   * @brief Makes a row from a raw line.
+   * @param columns Names of the fields, by position.
+   * @param line A raw line, which may be reused once the row is made.
+   * @param tokenizer Splits the line into fields.
+   * @return The row, valid until reset().
+   * @throws std::runtime_error if the line has an invalid escape sequence.
+   */
+  ArenaRow row(const ColumnNames &columns, std::string_view line,
+               const Tokenizer &tokenizer);
+
+  /**
+   * @brief Frees every row made since the last reset, growing the buffer if
+   * they did not fit in it.
+   */
+  void reset();
+
+  /**
+   * @brief Gets the bytes handed out since the last reset.
+   */
+  std::size_t used() const { return used_; }
+
+  /**
+   * @brief Gets the size of the buffer.
+   */
+  std::size_t capacity() const { return buffer_.size(); }
+};
+
+#endif // __ROWARENA_H__
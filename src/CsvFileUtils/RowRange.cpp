@@ -0,0 +1,105 @@
+#include "RowRange.hpp"
+
+#include <algorithm>
+
+RowBlockReader::RowBlockReader(CsvGroupSnapshot group, long first, long last,
+                               long blockRows, bool readahead)
+    : group_(std::move(group)), next_(first), last_(last),
+      blockRows_(blockRows) {
+  if (first < 0 || first > last || last > group_.size()) {
+    throw std::out_of_range("Row range out of range");
+  }
+  if (blockRows <= 0) {
+    throw std::invalid_argument("Row blocks need at least one row");
+  }
+  if (readahead) {
+    thread_ = std::jthread([this](std::stop_token stop) { readAhead(stop); });
+  } else {
+    done_ = true;
+  }
+}
+
+void RowBlockReader::readAhead(std::stop_token stop) {
+  try {
+    long row = next_;
+    while (row < last_ && !stop.stop_requested()) {
+      RowBlock block;
+      block.firstRow = row;
+      row = group_.readBlock(row, std::min(last_, row + blockRows_),
+                             block.data, block.lines);
+
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (!queueSpace_.wait(lock, stop,
+                            [this] { return queue_.size() < depth; })) {
+        break;
+      }
+      queue_.push_back(std::move(block));
+      lock.unlock();
+      queueReady_.notify_one();
+    }
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    error_ = std::current_exception();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_ = true;
+  }
+  queueReady_.notify_one();
+}
+
+bool RowBlockReader::next(RowBlock &block) {
+  if (!thread_.joinable()) {
+    // Read in place, reusing the block's storage
+    if (next_ >= last_) {
+      return false;
+    }
+    block.firstRow = next_;
+    next_ = group_.readBlock(next_, std::min(last_, next_ + blockRows_),
+                             block.data, block.lines);
+    return true;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  queueReady_.wait(lock, [this] { return !queue_.empty() || done_; });
+  if (queue_.empty()) {
+    if (error_) {
+      std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+    return false;
+  }
+  block = std::move(queue_.front());
+  queue_.pop_front();
+  lock.unlock();
+  queueSpace_.notify_one();
+  return true;
+}
+
+std::pair<long, long> rowsBetween(const CsvTimeSnapshot &rows, date_time start,
+                                  date_time end) {
+  const long size = rows.size();
+  if (size == 0 || end < start) {
+    return {0, 0};
+  }
+  CsvTimeCursor cursor = rows.cursor();
+
+  // bounds() gives the first row after the first at or after a time
+  auto first_at_or_after = [&](date_time time) {
+    auto [start_index, end_index] = cursor.bounds(time);
+    if (start_index == static_cast<size_t>(-1)) {
+      return 0L;
+    }
+    if (end_index == static_cast<size_t>(-1)) {
+      return size;
+    }
+    return cursor.timeOfRow(0) >= time ? 0L : static_cast<long>(end_index);
+  };
+
+  const long first = first_at_or_after(start);
+  long last = first_at_or_after(end);
+  while (last < size && cursor.timeOfRow(last) == end) {
+    ++last;
+  }
+  return {first, std::max(first, last)};
+}
@@ -0,0 +1,425 @@
+#ifndef __ROWRANGE_H__
+#define __ROWRANGE_H__
+
+#include "CsvGroupSnapshot.hpp"
+#include "CsvTimeSnapshot.hpp"
+#include "RowSchema.hpp"
+#include "TimeParse.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief A run of consecutive rows of a group, read from one file.
+ */
+struct RowBlock {
+  /**
+   * @brief The first row of the block in the group.
+   */
+  long firstRow = 0;
+
+  /**
+   * @brief The bytes read.
+   */
+  std::vector<char> data;
+
+  /**
+   * @brief Each row of the block, a view into data.
+   */
+  std::vector<std::string_view> lines;
+};
+
+/**
+ * @brief Reads a run of rows of a group as blocks, in order.
+ *
+ * Each block is one read of up to blockRows rows of a single file, so a run
+ * crossing files gives a short block at the end of each file. With readahead
+ * the blocks are read by a background thread, which stays up to depth blocks
+ * ahead of the reader, so reading overlaps with whatever is done with the
+ * rows. Errors reading are raised by next() once the blocks before them have
+ * been taken.
+ *
+ * A block reader is for a single thread, apart from its own readahead thread.
+ */
+struct RowBlockReader {
+private:
+  /**
+   * @brief The rows to read.
+   */
+  CsvGroupSnapshot group_;
+
+  /**
+   * @brief The next row to read, without readahead.
+   */
+  long next_ = 0;
+
+  /**
+   * @brief One past the last row to read.
+   */
+  long last_ = 0;
+
+  /**
+   * @brief Most rows per block.
+   */
+  long blockRows_ = 8192;
+
+  /**
+   * @brief Guards the queue, error and done flag.
+   */
+  std::mutex mutex_;
+
+  /**
+   * @brief Signalled when a block is queued or reading ends.
+   */
+  std::condition_variable queueReady_;
+
+  /**
+   * @brief Signalled when a block is taken from a full queue.
+   */
+  std::condition_variable_any queueSpace_;
+
+  /**
+   * @brief Blocks read ahead, in row order.
+   */
+  std::deque<RowBlock> queue_;
+
+  /**
+   * @brief The error that ended reading ahead, if any.
+   */
+  std::exception_ptr error_;
+
+  /**
+   * @brief Whether the readahead thread has finished.
+   */
+  bool done_ = false;
+
+  /**
+   * @brief The readahead thread, last so it is stopped before the rest of the
+   * reader is destroyed.
+   */
+  std::jthread thread_;
+
+  /**
+   * @brief Reads the blocks ahead of the reader, until the last row or a
+   * stop is requested.
+   */
+  void readAhead(std::stop_token stop);
+
+public:
+  /**
+   * @brief Most blocks read ahead of the reader.
+   */
+  static constexpr std::size_t depth = 2;
+
+  /**
+   * @brief Construct a reader of a run of rows.
+   * @param group The rows to read.
+   * @param first The first row to read.
+   * @param last One past the last row to read.
+   * @param blockRows Most rows per block.
+   * @param readahead If true, blocks are read by a background thread.
+   * @throws std::out_of_range if the rows are out of range.
+   * @throws std::invalid_argument if blockRows is not positive.
+   */
+  RowBlockReader(CsvGroupSnapshot group, long first, long last,
+                 long blockRows = 8192, bool readahead = true);
+
+  RowBlockReader(const RowBlockReader &) = delete;
+  RowBlockReader &operator=(const RowBlockReader &) = delete;
+
+  /**
+   * @brief Gets the next block.
+   * @param block Receives the block, reusing its storage without readahead.
+   * @return false once every row has been read.
+   * @throws std::runtime_error if the rows cannot be read.
+   */
+  bool next(RowBlock &block);
+};
+
+/**
+ * @brief Finds the rows of a time group within a time interval.
+ * @param rows The rows to search, in time order.
+ * @param start The earliest time wanted.
+ * @param end The latest time wanted.
+ * @return The first row at or after start and one past the last row at or
+ * before end.
+ */
+std::pair<long, long> rowsBetween(const CsvTimeSnapshot &rows, date_time start,
+                                  date_time end);
+
+/**
+ * @brief A row of a RowRange.
+ * @tparam Schema The RowSchema the row is decoded into.
+ */
+template <typename Schema> struct RowView {
+  /**
+   * @brief The row in the group.
+   */
+  long row = 0;
+
+  /**
+   * @brief The raw line, valid until the range moves to the next block.
+   */
+  std::string_view line;
+
+  /**
+   * @brief The decoded row.
+   */
+  const typename Schema::row_type *value = nullptr;
+
+  /**
+   * @brief Accesses the decoded row.
+   */
+  const typename Schema::row_type *operator->() const { return value; }
+};
+
+/**
+ * @brief The rows of a group read in order, decoded into a schema's row
+ * struct, as an input range.
+ *
+ * Rows are read in large blocks by a RowBlockReader, crossing from file to
+ * file, instead of one read per row, and by default a background thread
+ * reads the next blocks while the current one is used. The range is single
+ * pass: begin() starts reading from the first row again, invalidating any
+ * iterator from before.
+ *
+ * Example:
+ * @code
+ * for (const RowView<PhaseFreqSchema> &row :
+ *      RowRange<PhaseFreqSchema>(phase_freq.snapshot())) {
+ *   use(row.row, row->Si_Phase);
+ * }
+ * @endcode
+ *
+ * A range is for a single thread and must outlive its iterators.
+ *
+ * @tparam Schema The RowSchema the rows are decoded into.
+ */
+template <typename Schema> struct RowRange {
+private:
+  /**
+   * @brief The rows to read.
+   */
+  CsvGroupSnapshot group_;
+
+  /**
+   * @brief The first row to read.
+   */
+  long first_ = 0;
+
+  /**
+   * @brief One past the last row to read.
+   */
+  long last_ = 0;
+
+  /**
+   * @brief Most rows per block.
+   */
+  long blockRows_ = 8192;
+
+  /**
+   * @brief Whether blocks are read by a background thread.
+   */
+  bool readahead_ = true;
+
+  /**
+   * @brief Decodes the rows.
+   */
+  RowDecoder<Schema> decoder_;
+
+  /**
+   * @brief Reads the blocks, from begin().
+   */
+  std::unique_ptr<RowBlockReader> reader_;
+
+  /**
+   * @brief The block holding the current row.
+   */
+  RowBlock block_;
+
+  /**
+   * @brief The current row in the block.
+   */
+  std::size_t index_ = 0;
+
+  /**
+   * @brief The decoded current row.
+   */
+  typename Schema::row_type value_{};
+
+  /**
+   * @brief The current row.
+   */
+  RowView<Schema> view_;
+
+  /**
+   * @brief Moves to the next row, reading the next block if needed.
+   * @return false once every row has been read.
+   */
+  bool advance() {
+    ++index_;
+    while (index_ >= block_.lines.size()) {
+      if (!reader_ || !reader_->next(block_)) {
+        reader_.reset();
+        return false;
+      }
+      index_ = 0;
+    }
+    const std::string_view line = block_.lines[index_];
+    if (!decoder_.decode(line, value_)) {
+      throw std::runtime_error("Failed to decode row: " + std::string(line));
+    }
+    view_.row = block_.firstRow + static_cast<long>(index_);
+    view_.line = line;
+    return true;
+  }
+
+  /**
+   * @brief Construct a range of rows given as first and one past the last,
+   * -1 for every row.
+   */
+  RowRange(CsvGroupSnapshot group, std::pair<long, long> rows, long blockRows,
+           bool readahead)
+      : group_(std::move(group)), first_(rows.first),
+        last_(rows.second < 0 ? group_.size() : rows.second),
+        blockRows_(blockRows), readahead_(readahead),
+        decoder_(group_.metadata()) {
+    if (first_ < 0 || first_ > last_ || last_ > group_.size()) {
+      throw std::out_of_range("Row range out of range");
+    }
+    if (blockRows_ <= 0) {
+      throw std::invalid_argument("Row blocks need at least one row");
+    }
+    view_.value = &value_;
+  }
+
+public:
+  /**
+   * @brief Iterates the rows of the range.
+   */
+  struct iterator {
+  private:
+    /**
+     * @brief The range, nullptr once past the last row.
+     */
+    RowRange *range_ = nullptr;
+
+  public:
+    using value_type = RowView<Schema>;
+    using difference_type = std::ptrdiff_t;
+    using iterator_concept = std::input_iterator_tag;
+
+    iterator() = default;
+
+    /**
+     * @brief Construct an iterator at the current row of a range.
+     */
+    explicit iterator(RowRange *range) : range_(range) {}
+
+    /**
+     * @brief Gets the current row.
+     */
+    const RowView<Schema> &operator*() const { return range_->view_; }
+
+    /**
+     * @brief Moves to the next row.
+     * @throws std::runtime_error if a row cannot be read or decoded.
+     */
+    iterator &operator++() {
+      if (!range_->advance()) {
+        range_ = nullptr;
+      }
+      return *this;
+    }
+
+    void operator++(int) { ++*this; }
+
+    /**
+     * @brief Checks whether the iterator is past the last row.
+     */
+    friend bool operator==(const iterator &it, std::default_sentinel_t) {
+      return it.range_ == nullptr;
+    }
+  };
+
+  /**
+   * @brief Construct a range of the rows of a group.
+   * @param group The rows to read.
+   * @param first The first row to read.
+   * @param last One past the last row to read, -1 for every row.
+   * @param blockRows Most rows per block.
+   * @param readahead If true, blocks are read by a background thread.
+   * @throws std::runtime_error if a schema column is not in the group.
+   * @throws std::out_of_range if the rows are out of range.
+   * @throws std::invalid_argument if blockRows is not positive.
+   */
+  explicit RowRange(CsvGroupSnapshot group, long first = 0, long last = -1,
+                    long blockRows = 8192, bool readahead = true)
+      : RowRange(std::move(group), std::pair<long, long>(first, last),
+                 blockRows, readahead) {}
+
+  /**
+   * @brief Construct a range of the rows of a time group within a time
+   * interval.
+   * @param rows The rows to read, in time order.
+   * @param start The earliest time wanted.
+   * @param end The latest time wanted.
+   * @param blockRows Most rows per block.
+   * @param readahead If true, blocks are read by a background thread.
+   * @throws std::runtime_error if a schema column is not in the group.
+   * @throws std::invalid_argument if blockRows is not positive.
+   */
+  RowRange(const CsvTimeSnapshot &rows, date_time start, date_time end,
+           long blockRows = 8192, bool readahead = true)
+      : RowRange(rows.group(), rowsBetween(rows, start, end), blockRows,
+                 readahead) {}
+
+  RowRange(const RowRange &) = delete;
+  RowRange &operator=(const RowRange &) = delete;
+
+  /**
+   * @brief Gets the first row of the range.
+   */
+  long first() const { return first_; }
+
+  /**
+   * @brief Gets one past the last row of the range.
+   */
+  long last() const { return last_; }
+
+  /**
+   * @brief Starts reading from the first row.
+   * @return An iterator at the first row.
+   * @throws std::runtime_error if a row cannot be read or decoded.
+   */
+  iterator begin() {
+    reader_.reset();
+    block_.lines.clear();
+    if (first_ < last_) {
+      reader_ = std::make_unique<RowBlockReader>(group_, first_, last_,
+                                                 blockRows_, readahead_);
+    }
+    // advance() moves past the current row, of which there is none yet
+    index_ = static_cast<std::size_t>(-1);
+    return advance() ? iterator(this) : iterator();
+  }
+
+  /**
+   * @brief Gets the end of the range.
+   */
+  std::default_sentinel_t end() const { return std::default_sentinel; }
+};
+
+#endif // __ROWRANGE_H__
@@ -0,0 +1,262 @@
+#ifndef __ROWSCHEMA_H__
+#define __ROWSCHEMA_H__
+
+#include "../Utils/FieldParse.hpp"
+#include "Tokenizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief A column name usable as a template argument.
+ * @tparam N Size of the string literal, including the terminator.
+ */
+template <std::size_t N> struct ColumnName {
+  char value[N];
+
+  constexpr ColumnName(const char (&name)[N]) {
+    std::copy_n(name, N, value);
+  }
+
+  constexpr operator std::string_view() const {
+    return std::string_view(value, N - 1);
+  }
+};
+
+/**
+ * @brief Binds a named column of a CSV file to a member of a row struct.
+ * @tparam Name The column name, as it appears in the column names.
+ * @tparam Member Pointer to the row member receiving the column's value, or
+ * nullptr for a column that is part of the file layout but never decoded.
+ */
+template <ColumnName Name, auto Member = nullptr> struct Column {
+  static constexpr std::string_view name = Name;
+  static constexpr auto member = Member;
+
+  /**
+   * @brief Whether the column is decoded into the row.
+   */
+  static constexpr bool bound =
+      !std::is_null_pointer_v<std::remove_const_t<decltype(Member)>>;
+};
+
+/**
+ * @brief Compile-time description of the columns read into a row struct.
+ *
+ * Rows are plain structs with one member per column of interest, so values
+ * are accessed as `row.Si_Phase` instead of through a string lookup, and a
+ * misspelled column is a compile error. The schema is checked against the
+ * column names of a file when a RowDecoder is created.
+ *
+ * Example:
+ * @code
+ * struct SiFreqRow {
+ *   std::string Time;
+ *   quad Si_Freq;
+ * };
+ * using SiFreqSchema = RowSchema<SiFreqRow, Column<"Time", &SiFreqRow::Time>,
+ *                                Column<"Si_Freq", &SiFreqRow::Si_Freq>>;
+ * @endcode
+ *
+ * Listing every column of the file, bound or not, in file order lets the
+ * schema also serve as the column names of the metadata.
+ *
+ * @tparam Row The row struct.
+ * @tparam Columns The Column bindings.
+ */
+template <typename Row, typename... Columns> struct RowSchema {
+  using row_type = Row;
+
+  /**
+   * @brief Number of columns in the schema.
+   */
+  static constexpr std::size_t size = sizeof...(Columns);
+
+  /**
+   * @brief Names of the columns in the schema, in declaration order.
+   */
+  static constexpr std::array<std::string_view, size> names = {
+      Columns::name...};
+
+  static_assert(size > 0, "A row schema needs at least one column");
+
+  /**
+   * @brief Whether each column is decoded into the row.
+   */
+  static constexpr std::array<bool, size> bound = {Columns::bound...};
+
+  static_assert(((!Columns::bound ||
+                  std::is_member_object_pointer_v<decltype(Columns::member)>) &&
+                 ...),
+                "Columns must bind to data members of the row");
+  static_assert(
+      [] {
+        for (std::size_t i = 0; i < size; ++i) {
+          for (std::size_t j = i + 1; j < size; ++j) {
+            if (names[i] == names[j]) {
+              return false;
+            }
+          }
+        }
+        return true;
+      }(),
+      "Column names in a row schema must be unique");
+
+  /**
+   * @brief Gets the column names of the schema, for building metadata.
+   * @return A vector of the column names in declaration order.
+   */
+  static std::vector<std::string> colNames() {
+    return std::vector<std::string>(names.begin(), names.end());
+  }
+
+  /**
+   * @brief Decodes the fields of a row into a row struct.
+   * @param fields The fields of the row, in file order.
+   * @param positions The field position of each schema column, only read for
+   * bound columns.
+   * @param row Receives the decoded values.
+   * @return false if any field could not be parsed.
+   */
+  static bool decode(const std::vector<std::string_view> &fields,
+                     const std::array<std::size_t, size> &positions,
+                     Row &row) {
+    return decodeColumns(fields, positions, row,
+                         std::make_index_sequence<size>());
+  }
+
+private:
+  template <std::size_t... I>
+  static bool decodeColumns(const std::vector<std::string_view> &fields,
+                            const std::array<std::size_t, size> &positions,
+                            Row &row, std::index_sequence<I...>) {
+    return (decodeColumn<Columns>(fields, positions[I], row) && ...);
+  }
+
+  template <typename C>
+  static bool decodeColumn(const std::vector<std::string_view> &fields,
+                           std::size_t position, Row &row) {
+    // Unbound columns may lie past the fields split by RowDecoder
+    if constexpr (C::bound) {
+      return decodeField(fields[position], row.*C::member);
+    } else {
+      return true;
+    }
+  }
+
+  template <typename T>
+  static bool decodeField(std::string_view field, T &value) {
+    if constexpr (std::is_same_v<T, std::string>) {
+      value.assign(field);
+      return true;
+    } else {
+      return parseField(field, value);
+    }
+  }
+};
+
+/**
+ * @brief Decodes raw lines of a CSV file into the row struct of a schema.
+ *
+ * Looks up the position of each schema column once, then splits each line
+ * only as far as the last bound column.
+ *
+ * @tparam Schema A RowSchema.
+ */
+template <typename Schema> struct RowDecoder {
+  using row_type = typename Schema::row_type;
+
+private:
+  /**
+   * @brief Splits lines into fields using the delimiter configuration.
+   */
+  Tokenizer tokenizer_;
+
+  /**
+   * @brief Field position of each schema column in the file.
+   */
+  std::array<std::size_t, Schema::size> positions_{};
+
+  /**
+   * @brief Number of fields that need splitting to reach every bound column.
+   */
+  std::size_t fieldCount_ = 0;
+
+  /**
+   * @brief Reused storage for the fields of the current line.
+   */
+  std::vector<std::string_view> fields_;
+
+public:
+  /**
+   * @brief Construct a decoder for files with the given layout.
+   * @param colNames The column names of the files.
+   * @param delimiter Characters separating fields.
+   * @param multiDelimiter If true, empty fields are skipped.
+   * @throws std::runtime_error if a schema column is not in colNames.
+   */
+  RowDecoder(const std::vector<std::string> &colNames,
+             const std::string &delimiter, bool multiDelimiter)
+      : tokenizer_(delimiter, multiDelimiter) {
+    for (std::size_t i = 0; i < Schema::size; ++i) {
+      auto it = std::find(colNames.begin(), colNames.end(), Schema::names[i]);
+      if (it == colNames.end()) {
+        throw std::runtime_error("Column '" + std::string(Schema::names[i]) +
+                                 "' not found in the file column names");
+      }
+      positions_[i] = it - colNames.begin();
+      if (Schema::bound[i]) {
+        fieldCount_ = std::max(fieldCount_, positions_[i] + 1);
+      }
+    }
+    fields_.reserve(fieldCount_);
+  }
+
+  /**
+   * @brief Construct a decoder from file or group metadata.
+   * @param metadata A CsvFileMetadata or CsvGroupMetadata.
+   * @throws std::runtime_error if a schema column is not in the metadata.
+   */
+  template <typename Metadata>
+  explicit RowDecoder(const Metadata &metadata)
+      : RowDecoder(metadata.colNames(), metadata.delimiter(),
+                   metadata.multiDelimiter()) {}
+
+  /**
+   * @brief Decodes a raw line into a row.
+   * @param line The raw line.
+   * @param row Receives the decoded values.
+   * @return false if the line is missing columns or a field is invalid.
+   * @throws std::runtime_error if the line has an invalid escape sequence.
+   */
+  bool decode(std::string_view line, row_type &row) {
+    tokenizer_.split(line, fields_, fieldCount_);
+
+    if (fields_.size() < fieldCount_) {
+      return false;
+    }
+    return Schema::decode(fields_, positions_, row);
+  }
+
+  /**
+   * @brief Decodes a raw line into a row.
+   * @param line The raw line.
+   * @return The decoded row.
+   * @throws std::runtime_error if the line cannot be decoded.
+   */
+  row_type operator()(std::string_view line) {
+    row_type row;
+    if (!decode(line, row)) {
+      throw std::runtime_error("Failed to decode row: " + std::string(line));
+    }
+    return row;
+  }
+};
+
+#endif // __ROWSCHEMA_H__
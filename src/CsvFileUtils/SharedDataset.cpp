@@ -0,0 +1,370 @@
+#include "SharedDataset.hpp"
+#include "../Utils/FieldParse.hpp"
+#include "../Utils/Fingerprint.hpp"
+
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include <cerrno>
+#include <csignal>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace bip = boost::interprocess;
+
+namespace {
+/**
+ * @brief Identifies a dataset segment and its layout version.
+ */
+constexpr std::uint64_t segmentMagic = 0x544b444154415345; // "TKDATASE"
+constexpr std::uint32_t segmentVersion = 1;
+
+/**
+ * @brief Publication state of a segment.
+ */
+enum SegmentState : std::uint32_t { building = 0, ready = 1, failed = 2 };
+
+/**
+ * @brief Start of every segment, followed by the times and then each column.
+ */
+struct SegmentHeader {
+  std::uint64_t magic;
+  std::uint32_t version;
+  std::atomic<std::uint32_t> state;
+  std::int64_t rows;
+  std::uint64_t columns;
+  /**
+   * @brief Process id of the publisher, zero until it has mapped the segment.
+   */
+  std::atomic<std::int64_t> builder;
+};
+
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free &&
+                  std::atomic<std::int64_t>::is_always_lock_free,
+              "Shared state needs lock free atomics");
+
+constexpr std::size_t timesOffset = 64;
+static_assert(sizeof(SegmentHeader) <= timesOffset);
+
+std::size_t columnOffset(std::int64_t rows, std::size_t column) {
+  return timesOffset + rows * sizeof(time_ticks) +
+         column * rows * sizeof(PackedQuad);
+}
+
+std::size_t segmentSize(std::int64_t rows, std::size_t columns) {
+  return columnOffset(rows, columns);
+}
+
+/**
+ * @brief Who is building a segment that is not yet ready.
+ */
+enum class Builder { running, exited, unknown };
+
+/**
+ * @brief Checks whether the publisher of a segment is still running.
+ * @return unknown if the segment is not yet sized or its publisher has not
+ * recorded itself.
+ */
+Builder segmentBuilder(const std::string &name) {
+  bip::shared_memory_object segment(bip::open_only, name.c_str(),
+                                    bip::read_only);
+  bip::offset_t size = 0;
+  if (!segment.get_size(size) ||
+      static_cast<std::size_t>(size) < sizeof(SegmentHeader)) {
+    return Builder::unknown;
+  }
+  bip::mapped_region region(segment, bip::read_only, 0,
+                            sizeof(SegmentHeader));
+  const auto *header =
+      static_cast<const SegmentHeader *>(region.get_address());
+  std::int64_t pid = header->builder.load(std::memory_order_acquire);
+  if (pid <= 0) {
+    return Builder::unknown;
+  }
+  // EPERM means the process exists but belongs to another user
+  return ::kill(static_cast<pid_t>(pid), 0) != 0 && errno == ESRCH
+             ? Builder::exited
+             : Builder::running;
+}
+
+/**
+ * @brief Maps a segment and checks it holds the expected dataset.
+ * @return The mapping, or nullptr if the segment is not yet sized or still
+ * being built.
+ */
+std::shared_ptr<bip::mapped_region> mapReady(const std::string &name,
+                                             std::int64_t rows,
+                                             std::size_t columns) {
+  bip::shared_memory_object segment(bip::open_only, name.c_str(),
+                                    bip::read_only);
+  bip::offset_t size = 0;
+  if (!segment.get_size(size) ||
+      static_cast<std::size_t>(size) < segmentSize(rows, columns)) {
+    // The publisher has not sized it yet
+    return nullptr;
+  }
+
+  auto region =
+      std::make_shared<bip::mapped_region>(segment, bip::read_only);
+  const auto *header =
+      static_cast<const SegmentHeader *>(region->get_address());
+  // The layout fields are only written once the segment is sized, and are
+  // published with the state
+  std::uint32_t state = header->state.load(std::memory_order_acquire);
+  if (state == building) {
+    return nullptr;
+  }
+  if (state == ready &&
+      (header->magic != segmentMagic || header->version != segmentVersion ||
+       header->rows != rows || header->columns != columns)) {
+    throw std::runtime_error("Shared dataset segment " + name +
+                             " has an unexpected layout");
+  }
+  return region;
+}
+/**
+ * @brief Integer type holding the mantissa of a quad.
+ */
+using mantissa_type = boost::multiprecision::number<
+    std::decay_t<decltype(std::declval<quad>().backend().bits())>,
+    boost::multiprecision::et_off>;
+} // namespace
+
+PackedQuad packQuad(const quad &value) {
+  const auto &backend = value.backend();
+  // The limb layout of the mantissa depends on the platform, so split it
+  // arithmetically into two 64-bit words
+  const mantissa_type bits(backend.bits());
+  const mantissa_type low = std::numeric_limits<std::uint64_t>::max();
+
+  PackedQuad packed{};
+  packed.mantissa[0] = static_cast<std::uint64_t>(bits & low);
+  packed.mantissa[1] = static_cast<std::uint64_t>(bits >> 64);
+  packed.exponent = backend.exponent();
+  packed.sign = backend.sign();
+  return packed;
+}
+
+quad unpackQuad(const PackedQuad &packed) {
+  quad value;
+  auto &backend = value.backend();
+  const mantissa_type bits = (mantissa_type(packed.mantissa[1]) << 64) |
+                             mantissa_type(packed.mantissa[0]);
+  backend.bits() = bits.backend();
+  backend.exponent() = packed.exponent;
+  backend.sign() = packed.sign != 0;
+  return value;
+}
+
+std::string
+SharedDataset::segmentName(const CsvTimeSnapshot &snapshot,
+                           const std::vector<std::string> &columns) {
+  const CsvGroupMetadata &metadata = snapshot.group().metadata();
+
+  Fingerprint fingerprint;
+  for (const auto &path : metadata.dataPaths()) {
+    fingerprint.add(path);
+
+    // Rewritten or extended files change size or modification time
+    struct stat file_stat;
+    if (::stat(path.c_str(), &file_stat) == 0) {
+      fingerprint.addValue(file_stat.st_ino);
+      fingerprint.addValue(file_stat.st_size);
+      fingerprint.addValue(file_stat.st_mtim.tv_sec);
+      fingerprint.addValue(file_stat.st_mtim.tv_nsec);
+    }
+  }
+  fingerprint.addValue(snapshot.size());
+  fingerprint.addValue(snapshot.timeFormat());
+  fingerprint.add(metadata.delimiter());
+  fingerprint.addValue(metadata.multiDelimiter());
+  for (const auto &column : columns) {
+    fingerprint.add(column);
+  }
+  fingerprint.addValue(segmentVersion);
+
+  char name[32];
+  std::snprintf(name, sizeof(name), "TimeKeeping.%016llx",
+                static_cast<unsigned long long>(fingerprint.hash));
+  return name;
+}
+
+std::shared_ptr<const SharedDataset>
+SharedDataset::attachOrBuild(const CsvTimeSnapshot &snapshot,
+                             const std::vector<std::string> &columns,
+                             std::shared_ptr<const SharedDataset> previous,
+                             std::chrono::milliseconds wait) {
+  const std::int64_t rows = snapshot.size();
+  const std::string name = segmentName(snapshot, columns);
+
+  // Check the columns exist before touching shared memory
+  Projection projection = snapshot.group().project(columns);
+
+  std::shared_ptr<bip::mapped_region> region;
+  bool owner = false;
+  auto deadline = std::chrono::steady_clock::now() + wait;
+  long polls = 0;
+
+  while (!region) {
+    try {
+      // Whoever creates the segment decodes the dataset
+      bip::shared_memory_object segment(bip::create_only, name.c_str(),
+                                        bip::read_write);
+      owner = true;
+      segment.truncate(segmentSize(rows, columns.size()));
+      region = std::make_shared<bip::mapped_region>(segment, bip::read_write);
+      static_cast<SegmentHeader *>(region->get_address())
+          ->builder.store(::getpid(), std::memory_order_release);
+    } catch (const bip::interprocess_exception &error) {
+      if (owner) {
+        bip::shared_memory_object::remove(name.c_str());
+        return nullptr;
+      }
+      if (error.get_error_code() != bip::already_exists_error) {
+        // No shared memory on this system
+        return nullptr;
+      }
+    }
+    if (owner) {
+      break;
+    }
+
+    // Another process created it, wait until it is published
+    try {
+      region = mapReady(name, rows, columns.size());
+    } catch (const bip::interprocess_exception &) {
+      // Removed by a failed publisher, try to create it again
+      region = nullptr;
+      continue;
+    }
+    if (region) {
+      const auto *header =
+          static_cast<const SegmentHeader *>(region->get_address());
+      std::uint32_t state = header->state.load(std::memory_order_acquire);
+      if (state == ready) {
+        break;
+      }
+      if (state == failed) {
+        return nullptr;
+      }
+      region = nullptr;
+    }
+
+    // Take over from a publisher that exited without finishing. One that
+    // never recorded itself gets the whole wait before its segment is freed.
+    bool expired = std::chrono::steady_clock::now() > deadline;
+    if (++polls % 100 == 0 || expired) {
+      Builder builder = Builder::running;
+      try {
+        builder = segmentBuilder(name);
+      } catch (const bip::interprocess_exception &) {
+        continue;
+      }
+      if (builder == Builder::exited ||
+          (expired && builder == Builder::unknown)) {
+        bip::shared_memory_object::remove(name.c_str());
+        if (!expired) {
+          continue;
+        }
+      }
+    }
+    if (expired) {
+      return nullptr;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  char *base = static_cast<char *>(region->get_address());
+  auto *header = reinterpret_cast<SegmentHeader *>(base);
+
+  if (owner) {
+    try {
+      header->magic = segmentMagic;
+      header->version = segmentVersion;
+      header->rows = rows;
+      header->columns = columns.size();
+
+      // Copy the rows an earlier dataset of the group already decoded, if
+      // its last row is still in place
+      std::int64_t first = 0;
+      if (previous && previous->columns_ == columns && previous->size_ > 0 &&
+          previous->size_ <= rows &&
+          snapshot.cursor().timesOfRows(previous->size_ - 1,
+                                        previous->size_)[0] ==
+              previous->times_[previous->size_ - 1]) {
+        first = previous->size_;
+        std::copy_n(previous->times_, first,
+                    reinterpret_cast<time_ticks *>(base + timesOffset));
+        for (std::size_t c = 0; c < columns.size(); ++c) {
+          std::copy_n(previous->values_[c], first,
+                      reinterpret_cast<PackedQuad *>(base +
+                                                     columnOffset(rows, c)));
+        }
+      }
+
+      // Decode the times, then every column in one pass over the new rows
+      std::vector<time_ticks> times =
+          snapshot.cursor().timesOfRows(first, rows);
+      std::copy(times.begin(), times.end(),
+                reinterpret_cast<time_ticks *>(base + timesOffset) + first);
+
+      CsvGroupCursor cursor = snapshot.group().cursor(first);
+      std::vector<std::string_view> fields;
+      quad value;
+      for (std::int64_t row = first; cursor.next(); ++row) {
+        cursor.fields(projection, fields);
+        for (std::size_t c = 0; c < columns.size(); ++c) {
+          if (!parseField(fields[c], value)) {
+            throw std::runtime_error("Invalid value in column " + columns[c] +
+                                     ": " + std::string(fields[c]));
+          }
+          reinterpret_cast<PackedQuad *>(base + columnOffset(rows, c))[row] =
+              packQuad(value);
+        }
+      }
+    } catch (...) {
+      header->state.store(failed, std::memory_order_release);
+      bip::shared_memory_object::remove(name.c_str());
+      throw;
+    }
+    header->state.store(ready, std::memory_order_release);
+  }
+
+  auto dataset = std::shared_ptr<SharedDataset>(new SharedDataset());
+  dataset->mapping_ = std::shared_ptr<const void>(region, base);
+  dataset->name_ = name;
+  dataset->columns_ = columns;
+  dataset->size_ = rows;
+  dataset->owner_ = owner;
+  dataset->times_ = reinterpret_cast<const time_ticks *>(base + timesOffset);
+  for (std::size_t c = 0; c < columns.size(); ++c) {
+    dataset->values_.push_back(
+        reinterpret_cast<const PackedQuad *>(base + columnOffset(rows, c)));
+  }
+  return dataset;
+}
+
+bool SharedDataset::remove(const CsvTimeSnapshot &snapshot,
+                           const std::vector<std::string> &columns) {
+  return bip::shared_memory_object::remove(
+      segmentName(snapshot, columns).c_str());
+}
+
+bool SharedDataset::remove(const std::string &name) {
+  return bip::shared_memory_object::remove(name.c_str());
+}
+
+long SharedDataset::columnIndex(const std::string &colName) const {
+  auto it = std::find(columns_.begin(), columns_.end(), colName);
+  return it == columns_.end() ? -1 : it - columns_.begin();
+}
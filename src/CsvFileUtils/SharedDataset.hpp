@@ -0,0 +1,204 @@
+#ifndef __SHAREDDATASET_H__
+#define __SHAREDDATASET_H__
+
+#include "CsvTimeSnapshot.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A quad stored exactly in a fixed, pointer free layout.
+ *
+ * quad is not trivially copyable, so values in shared memory are kept as the
+ * raw fields of its binary representation and converted on access.
+ */
+struct PackedQuad {
+  /**
+   * @brief The mantissa bits, least significant limb first.
+   */
+  std::uint64_t mantissa[2];
+
+  /**
+   * @brief The binary exponent, including the special zero, infinity and NaN
+   * exponents.
+   */
+  std::int32_t exponent;
+
+  /**
+   * @brief Nonzero for negative values.
+   */
+  std::int32_t sign;
+};
+
+/**
+ * @brief Packs a quad into its exact binary fields.
+ * @param value The value to pack.
+ * @return The packed value.
+ */
+PackedQuad packQuad(const quad &value);
+
+/**
+ * @brief Restores a quad from its packed binary fields.
+ * @param packed The packed value.
+ * @return The exact original value.
+ */
+quad unpackQuad(const PackedQuad &packed);
+
+/**
+ * @brief Decoded row times and columns of a time group, in shared memory.
+ *
+ * Several processes on one node often open the same groups, and each would
+ * otherwise parse the same timestamps and values into private memory. The
+ * first process to ask for a dataset decodes it into a POSIX shared memory
+ * segment named after a fingerprint of the group. Later processes map the
+ * segment read only and use it in place, so the node holds one copy.
+ *
+ * The fingerprint covers the data files' paths, sizes and modification
+ * times, the pinned row count, the time format and the decoded columns. Any
+ * change to the data gives a new segment rather than modifying one in use.
+ * Segments outlive the processes that made them, use remove() to free them.
+ * A segment whose publisher exited before finishing it is removed and built
+ * again by the next process waiting for it.
+ */
+struct SharedDataset {
+private:
+  /**
+   * @brief The mapping, unmapped with the last reference.
+   */
+  std::shared_ptr<const void> mapping_;
+
+  /**
+   * @brief Name of the shared memory segment.
+   */
+  std::string name_;
+
+  /**
+   * @brief Names of the decoded columns, in storage order.
+   */
+  std::vector<std::string> columns_;
+
+  /**
+   * @brief Number of rows decoded.
+   */
+  long size_ = 0;
+
+  /**
+   * @brief Whether this process decoded the dataset.
+   */
+  bool owner_ = false;
+
+  /**
+   * @brief Row times as ticks since 1970-01-01, in the mapping.
+   */
+  const time_ticks *times_ = nullptr;
+
+  /**
+   * @brief The start of each decoded column, in the mapping.
+   */
+  std::vector<const PackedQuad *> values_;
+
+  SharedDataset() = default;
+
+public:
+  /**
+   * @brief Gets the name of the shared memory segment for a dataset.
+   * @param snapshot The rows to decode.
+   * @param columns The value columns to decode.
+   * @return The segment name, derived from the dataset fingerprint.
+   */
+  static std::string segmentName(const CsvTimeSnapshot &snapshot,
+                                 const std::vector<std::string> &columns);
+
+  /**
+   * @brief Attaches to the shared dataset, decoding and publishing it first if
+   * no other process has.
+   * @param snapshot The rows to decode.
+   * @param columns The value columns to decode.
+   * @param previous A dataset of an earlier snapshot of the same group, whose
+   * rows are copied instead of decoded again when this process publishes, or
+   * nullptr.
+   * @param wait How long to wait for another process that is still decoding.
+   * @return The dataset, or nullptr if shared memory is unavailable or the
+   * other process did not finish in time, so the caller can decode privately.
+   * @throws std::runtime_error if a column is missing or a value is invalid.
+   */
+  static std::shared_ptr<const SharedDataset>
+  attachOrBuild(const CsvTimeSnapshot &snapshot,
+                const std::vector<std::string> &columns,
+                std::shared_ptr<const SharedDataset> previous = nullptr,
+                std::chrono::milliseconds wait = std::chrono::seconds(30));
+
+  /**
+   * @brief Removes a dataset's segment. Processes already attached keep
+   * their mapping.
+   * @param snapshot The rows of the dataset.
+   * @param columns The value columns of the dataset.
+   * @return true if a segment was removed.
+   */
+  static bool remove(const CsvTimeSnapshot &snapshot,
+                     const std::vector<std::string> &columns);
+
+  /**
+   * @brief Removes a segment by name, such as one replaced after its files
+   * grew and so no longer found by fingerprint.
+   * @param name The segment name, from name().
+   * @return true if a segment was removed.
+   */
+  static bool remove(const std::string &name);
+
+  /**
+   * @brief Gets the name of the shared memory segment.
+   * @return The segment name.
+   */
+  const std::string &name() const { return name_; }
+
+  /**
+   * @brief Gets the number of rows decoded.
+   * @return The number of rows.
+   */
+  long size() const { return size_; }
+
+  /**
+   * @brief Checks whether this process decoded and published the dataset.
+   * @return true for the publishing process, false for one that attached.
+   */
+  bool owner() const { return owner_; }
+
+  /**
+   * @brief Gets the times of all rows.
+   * @return Ticks since 1970-01-01, one per row, in shared memory.
+   */
+  std::span<const time_ticks> times() const { return {times_, size_t(size_)}; }
+
+  /**
+   * @brief Gets the position of a decoded column.
+   * @param colName The column name.
+   * @return The column index, or -1 if the column was not decoded.
+   */
+  long columnIndex(const std::string &colName) const;
+
+  /**
+   * @brief Gets the packed values of a decoded column.
+   * @param column The column index, from columnIndex().
+   * @return One value per row, in shared memory.
+   */
+  std::span<const PackedQuad> column(long column) const {
+    return {values_[column], size_t(size_)};
+  }
+
+  /**
+   * @brief Gets a decoded value.
+   * @param column The column index, from columnIndex().
+   * @param row The row number (0-based index).
+   * @return The value.
+   */
+  quad value(long column, long row) const {
+    return unpackQuad(values_[column][row]);
+  }
+};
+
+#endif // __SHAREDDATASET_H__
@@ -0,0 +1,403 @@
+#include "SyntheticData.hpp"
+#include "../Utils/CivilTime.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+/**
+ * @brief Ticks in a day.
+ */
+constexpr time_ticks ticksPerDay = 86400LL * 1000000;
+
+/**
+ * @brief Nominal frequencies of the Si, Rb, H and Z channels, in nHz.
+ */
+constexpr std::int64_t channelFrequency[4] = {
+    995532689745283, 10000000007542960, 5000000000000007, 10000000000};
+
+/**
+ * @brief Frequency the Si3 counter wanders around, in uHz.
+ */
+constexpr std::int64_t siFrequency = 2500000000;
+
+/**
+ * @brief Size of the buffer each file is written through.
+ */
+constexpr std::size_t bufferSize = 4 << 20;
+
+/**
+ * @brief Room left in the buffer for the longest row and comment.
+ */
+constexpr std::size_t lineRoom = 512;
+
+/**
+ * @brief Independent draws, one stream per kind of value.
+ */
+enum Stream : std::uint64_t {
+  jitterStream = 1,
+  gapStream = 2,
+  siStream = 3,
+  phaseStream = 4,
+  frequencyStream = 8
+};
+
+/**
+ * @brief Spreads a counter over 64 bits (splitmix64's finalizer).
+ */
+std::uint64_t mix(std::uint64_t value) {
+  value += 0x9E3779B97F4A7C15;
+  value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9;
+  value = (value ^ (value >> 27)) * 0x94D049BB133111EB;
+  return value ^ (value >> 31);
+}
+
+/**
+ * @brief Draws a value in [-amplitude, amplitude] from one stream of a seed.
+ */
+std::int64_t draw(std::uint64_t seed, std::uint64_t stream,
+                  std::uint64_t counter, std::int64_t amplitude) {
+  if (amplitude <= 0) {
+    return 0;
+  }
+  std::uint64_t value = mix(seed ^ mix((stream << 56) ^ counter));
+  return static_cast<std::int64_t>(
+             value % (2 * static_cast<std::uint64_t>(amplitude) + 1)) -
+         amplitude;
+}
+
+/**
+ * @brief Powers of ten that fit in 64 bits.
+ */
+std::uint64_t pow10(int exponent) {
+  std::uint64_t value = 1;
+  while (exponent-- > 0) {
+    value *= 10;
+  }
+  return value;
+}
+
+/**
+ * @brief Writes a number as exactly width digits, zero padded.
+ */
+void putDigits(char *&out, std::uint64_t value, int width) {
+  for (int i = width - 1; i >= 0; --i) {
+    out[i] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  }
+  out += width;
+}
+
+/**
+ * @brief Writes a number with as many digits as it needs.
+ */
+void putUnsigned(char *&out, std::uint64_t value) {
+  int width = 1;
+  for (std::uint64_t rest = value / 10; rest > 0; rest /= 10) {
+    ++width;
+  }
+  putDigits(out, value, width);
+}
+
+/**
+ * @brief Writes a fixed point number held as an integer count of
+ * 10^-decimals.
+ */
+void putFixed(char *&out, std::int64_t value, int decimals) {
+  if (value < 0) {
+    *out++ = '-';
+    value = -value;
+  }
+  std::uint64_t scale = pow10(decimals);
+  putUnsigned(out, static_cast<std::uint64_t>(value) / scale);
+  *out++ = '.';
+  putDigits(out, static_cast<std::uint64_t>(value) % scale, decimals);
+}
+
+/**
+ * @brief Writes a fixed point number too wide for 64 bits, held as an integer
+ * count of 10^-decimals.
+ */
+void putFixed(char *&out, __int128 value, int decimals) {
+  if (value < 0) {
+    *out++ = '-';
+    value = -value;
+  }
+  std::uint64_t scale = pow10(decimals);
+  putUnsigned(out, static_cast<std::uint64_t>(value / scale));
+  *out++ = '.';
+  putDigits(out, static_cast<std::uint64_t>(value % scale), decimals);
+}
+
+/**
+ * @brief Writes text.
+ */
+void putText(char *&out, std::string_view text) {
+  out = std::copy(text.begin(), text.end(), out);
+}
+
+/**
+ * @brief Number of rows due in a group.
+ */
+long dueRows(const SyntheticGroup &group) {
+  return static_cast<long>((group.duration + group.interval - 1) /
+                           group.interval);
+}
+
+/**
+ * @brief Whether a row due at an offset from the start falls in a gap.
+ */
+bool inGap(const SyntheticGroup &group, time_ticks offset) {
+  if (group.gapEvery <= 0 || group.gapLength <= 0) {
+    return false;
+  }
+  time_ticks period = offset / group.gapEvery;
+  time_ticks gap_start =
+      period * group.gapEvery +
+      static_cast<time_ticks>(
+          mix(group.seed ^ mix((std::uint64_t(gapStream) << 56) ^ period)) %
+          static_cast<std::uint64_t>(group.gapEvery - group.gapLength + 1));
+  return offset >= gap_start && offset < gap_start + group.gapLength;
+}
+
+/**
+ * @brief Fraction digits the times of a group are written with: as many as
+ * the layout's files have, or more if the times need them to be exact.
+ */
+int timeDigits(const SyntheticGroup &group) {
+  int digits = group.layout == SyntheticLayout::phaseFreq ? 1 : 3;
+  if (group.jitter > 0) {
+    return 6;
+  }
+  while (digits < 6) {
+    time_ticks resolution = static_cast<time_ticks>(pow10(6 - digits));
+    if (group.start % resolution == 0 && group.interval % resolution == 0) {
+      break;
+    }
+    ++digits;
+  }
+  return digits;
+}
+
+/**
+ * @brief Writes a number zero padded to at least width digits, for file
+ * names.
+ */
+std::string paddedNumber(std::uint64_t value, int width) {
+  std::string text = std::to_string(value);
+  if (static_cast<int>(text.size()) < width) {
+    text.insert(0, width - text.size(), '0');
+  }
+  return text;
+}
+} // namespace
+
+std::vector<std::string> syntheticColumns(SyntheticLayout layout) {
+  if (layout == SyntheticLayout::si3) {
+    return {"Time", "Si_Freq"};
+  }
+  return {"Day",      "Time",    "S",       "Si_Phase",
+          "Rb_Phase", "H_Phase", "Z_Phase", "Si_Freq",
+          "Rb_Freq",  "H_Freq",  "Z_Freq"};
+}
+
+CsvTimeFormat syntheticTimeFormat(SyntheticLayout layout) {
+  return layout == SyntheticLayout::si3 ? CsvTimeFormat::oneColStandard
+                                        : CsvTimeFormat::twoColShort;
+}
+
+CsvGroupMetadata syntheticMetadata(const SyntheticGroup &group) {
+  if (group.layout == SyntheticLayout::si3) {
+    return CsvGroupMetadata(group.directory,
+                            group.prefix + "_[0-9]{2,}\\.csv", {}, "", "#",
+                            ",\r", false, true,
+                            syntheticColumns(group.layout), -1);
+  }
+  return CsvGroupMetadata(group.directory,
+                          group.prefix + "_[0-9]{6}_[0-9]+\\.txt", {}, "",
+                          "#", " ", true, false,
+                          syntheticColumns(group.layout));
+}
+
+std::vector<SyntheticFile> planSyntheticFiles(const SyntheticGroup &group) {
+  if (group.interval <= 0 || group.duration <= 0) {
+    throw std::invalid_argument(
+        "Synthetic groups need a positive interval and duration");
+  }
+  long rows = dueRows(group);
+  if (group.files < 1 || group.files > rows) {
+    throw std::invalid_argument(
+        "Synthetic groups need between one file and one file per row");
+  }
+  if (group.jitter < 0 || 2 * group.jitter >= group.interval) {
+    throw std::invalid_argument(
+        "Synthetic jitter must be less than half the interval");
+  }
+  if (group.gapEvery < 0 || group.gapLength < 0 ||
+      (group.gapEvery > 0 && group.gapLength >= group.gapEvery)) {
+    throw std::invalid_argument(
+        "Synthetic gaps must be shorter than the time between them");
+  }
+  if (group.commentEvery < 0) {
+    throw std::invalid_argument("Synthetic comment spacing must be positive");
+  }
+
+  std::vector<SyntheticFile> files;
+  std::int64_t previous_day = std::numeric_limits<std::int64_t>::min();
+  long day_file = 0;
+  for (long k = 0; k < group.files; ++k) {
+    // Split as evenly as the rows allow, without overflowing on large groups
+    long first = static_cast<long>(static_cast<__int128>(rows) * k /
+                                   group.files);
+    long last = static_cast<long>(static_cast<__int128>(rows) * (k + 1) /
+                                  group.files);
+
+    std::string name;
+    if (group.layout == SyntheticLayout::si3) {
+      name = group.prefix + "_" + paddedNumber(k + 1, 2) + ".csv";
+    } else {
+      // Numbered from 1 within the day of the file's first row
+      std::int64_t day =
+          floorDiv(group.start + first * group.interval, ticksPerDay);
+      day_file = day == previous_day ? day_file + 1 : 1;
+      previous_day = day;
+      CivilDate date = civilFromDays(day);
+      name = group.prefix + "_" +
+             paddedNumber(date.year % 100 * 10000 + date.month * 100 +
+                              date.day,
+                          6) +
+             "_" + std::to_string(day_file) + ".txt";
+    }
+    files.push_back(
+        {(std::filesystem::path(group.directory) / name).string(), first,
+         last});
+  }
+  return files;
+}
+
+std::uintmax_t writeSyntheticFile(const SyntheticGroup &group,
+                                  const SyntheticFile &file) {
+  std::ofstream output(file.path, std::ios::binary | std::ios::trunc);
+  if (!output) {
+    throw std::runtime_error("Could not create synthetic file " + file.path);
+  }
+
+  const bool si3 = group.layout == SyntheticLayout::si3;
+  const std::string_view line_end = si3 ? "\r\n" : "\n";
+  const int digits = timeDigits(group);
+  const std::uint64_t fraction_scale = pow10(6 - digits);
+
+  std::vector<char> buffer(bufferSize);
+  char *out = buffer.data();
+  char *const full = buffer.data() + buffer.size() - lineRoom;
+  std::uintmax_t bytes = 0;
+  auto flush = [&]() {
+    output.write(buffer.data(), out - buffer.data());
+    bytes += out - buffer.data();
+    out = buffer.data();
+  };
+
+  if (si3) {
+    putText(out, "Time,Si_Freq\r\n");
+  }
+
+  // The date text only changes once a day
+  std::int64_t cached_day = std::numeric_limits<std::int64_t>::min();
+  char date_text[16];
+  std::string_view date;
+
+  for (long row = file.first; row < file.last; ++row) {
+    time_ticks due = row * group.interval;
+    if (group.commentEvery > 0 && row % group.commentEvery == 0) {
+      putText(out, "# Synthetic row ");
+      putUnsigned(out, static_cast<std::uint64_t>(row));
+      putText(out, line_end);
+    }
+    if (inGap(group, due)) {
+      continue;
+    }
+
+    time_ticks time =
+        group.start + due + draw(group.seed, jitterStream, row, group.jitter);
+    std::int64_t day = floorDiv(time, ticksPerDay);
+    std::uint64_t clock = static_cast<std::uint64_t>(time - day * ticksPerDay);
+    if (day != cached_day) {
+      CivilDate civil = civilFromDays(day);
+      char *text = date_text;
+      if (si3) {
+        putDigits(text, static_cast<std::uint64_t>(civil.year), 4);
+        *text++ = '-';
+        putDigits(text, civil.month, 2);
+        *text++ = '-';
+        putDigits(text, civil.day, 2);
+        *text++ = ' ';
+      } else {
+        putDigits(text, static_cast<std::uint64_t>(civil.year % 100), 2);
+        putDigits(text, civil.month, 2);
+        putDigits(text, civil.day, 2);
+        *text++ = ' ';
+        *text++ = ' ';
+      }
+      date = std::string_view(date_text, text - date_text);
+      cached_day = day;
+    }
+
+    putText(out, date);
+    std::uint64_t seconds = clock / 1000000;
+    putDigits(out, seconds / 3600, 2);
+    if (si3) {
+      *out++ = ':';
+    }
+    putDigits(out, seconds / 60 % 60, 2);
+    if (si3) {
+      *out++ = ':';
+    }
+    putDigits(out, seconds % 60, 2);
+    *out++ = '.';
+    putDigits(out, clock % 1000000 / fraction_scale, digits);
+
+    if (si3) {
+      *out++ = ',';
+      putFixed(out, siFrequency + draw(group.seed, siStream, row, 250000), 6);
+    } else {
+      *out++ = ' ';
+      putUnsigned(out, static_cast<std::uint64_t>(row));
+
+      // Phases in ucycles, counted from one interval before the start
+      time_ticks elapsed = time - group.start + group.interval;
+      for (std::size_t c = 0; c < 4; ++c) {
+        __int128 phase =
+            static_cast<__int128>(channelFrequency[c]) * elapsed / 1000000000;
+        *out++ = ' ';
+        *out++ = ' ';
+        putFixed(out, phase + draw(group.seed, phaseStream + c, row, 50), 6);
+      }
+
+      // Frequencies in nHz, scattered by about a part in 1e12
+      for (std::size_t c = 0; c < 4; ++c) {
+        std::int64_t amplitude =
+            std::max<std::int64_t>(3, channelFrequency[c] / 1000000000000);
+        *out++ = ' ';
+        putFixed(out,
+                 channelFrequency[c] +
+                     draw(group.seed, frequencyStream + c, row, amplitude),
+                 9);
+      }
+    }
+    putText(out, line_end);
+
+    if (out >= full) {
+      flush();
+    }
+  }
+  flush();
+
+  output.close();
+  if (!output) {
+    throw std::runtime_error("Could not write synthetic file " + file.path);
+  }
+  return bytes;
+}
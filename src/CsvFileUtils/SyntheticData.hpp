@@ -0,0 +1,165 @@
+#ifndef __SYNTHETICDATA_H__
+#define __SYNTHETICDATA_H__
+
+#include "CsvGroupMetadata.hpp"
+#include "TimeParse.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The file layouts a synthetic group can be written in.
+ */
+enum class SyntheticLayout {
+  /**
+   * @brief Si3 vs Maser phase and frequency logs: "YYMMDD HHMMSS.f" time
+   * columns, a row counter, four phases and four frequencies, separated by
+   * runs of spaces, with no header. Files are named
+   * "<prefix>_YYMMDD_<n>.txt" after the day of their first row.
+   */
+  phaseFreq,
+
+  /**
+   * @brief Si3 frequency logs: a "YYYY-MM-DD HH:MM:SS.fff" time and the
+   * frequency, comma separated with CRLF line endings under a "Time,Si_Freq"
+   * header. Files are named "<prefix>_<nn>.csv".
+   */
+  si3
+};
+
+/**
+ * @brief Describes a synthetic CSV group, for benchmarks and scale tests.
+ *
+ * Rows are due every interval from start until start + duration. Rows due
+ * inside a gap are left out, and the others are logged up to jitter early or
+ * late. Every value of a row is a function of the seed and the row's number
+ * alone, so the files of a group can be written in any order, by any number
+ * of threads or machines, and always come out the same.
+ */
+struct SyntheticGroup {
+  /**
+   * @brief The layout of the files.
+   */
+  SyntheticLayout layout = SyntheticLayout::phaseFreq;
+
+  /**
+   * @brief Directory the files are written to.
+   */
+  std::string directory;
+
+  /**
+   * @brief Start of the file names, without regex special characters.
+   */
+  std::string prefix = "PhaseFreq";
+
+  /**
+   * @brief Time the first row is due, as ticks since 1970-01-01.
+   */
+  time_ticks start = 0;
+
+  /**
+   * @brief Ticks from the first row due to the end of the group.
+   */
+  time_ticks duration = 0;
+
+  /**
+   * @brief Ticks between rows.
+   */
+  time_ticks interval = 100000;
+
+  /**
+   * @brief Number of files the rows are split evenly across.
+   */
+  long files = 1;
+
+  /**
+   * @brief Largest shift of a row from the time it is due, in ticks, less
+   * than half the interval so rows stay in order.
+   */
+  time_ticks jitter = 0;
+
+  /**
+   * @brief Ticks between the starts of successive gaps, or 0 for no gaps.
+   * @details One gap falls at a random point of every period of this length.
+   */
+  time_ticks gapEvery = 0;
+
+  /**
+   * @brief Ticks of rows left out by each gap, less than gapEvery.
+   */
+  time_ticks gapLength = 0;
+
+  /**
+   * @brief Rows between comment lines, or 0 for no comments.
+   */
+  long commentEvery = 0;
+
+  /**
+   * @brief Seed of the values and of the gap and jitter positions.
+   */
+  std::uint64_t seed = 1;
+};
+
+/**
+ * @brief One file of a synthetic group.
+ */
+struct SyntheticFile {
+  /**
+   * @brief Path of the file.
+   */
+  std::string path;
+
+  /**
+   * @brief Number of the first row due in the file.
+   */
+  long first = 0;
+
+  /**
+   * @brief One past the number of the last row due in the file.
+   */
+  long last = 0;
+};
+
+/**
+ * @brief Gets the column names of a layout.
+ * @param layout The layout.
+ * @return The column names, in file order.
+ */
+std::vector<std::string> syntheticColumns(SyntheticLayout layout);
+
+/**
+ * @brief Gets the time format of a layout's time columns.
+ * @param layout The layout.
+ * @return The time format, for CsvTimeGroup.
+ */
+CsvTimeFormat syntheticTimeFormat(SyntheticLayout layout);
+
+/**
+ * @brief Gets the metadata that reads a synthetic group back.
+ * @param group The group.
+ * @return The metadata, with a template matching the group's file names.
+ */
+CsvGroupMetadata syntheticMetadata(const SyntheticGroup &group);
+
+/**
+ * @brief Splits a synthetic group into its files.
+ * @param group The group.
+ * @return The files, in time order.
+ * @throws std::invalid_argument if the interval, duration, files, jitter or
+ * gaps are out of range.
+ */
+std::vector<SyntheticFile> planSyntheticFiles(const SyntheticGroup &group);
+
+/**
+ * @brief Writes one file of a synthetic group, replacing any file there.
+ * @details Safe to call for different files of a group at once.
+ * @param group The group.
+ * @param file The file, from planSyntheticFiles().
+ * @return The number of bytes written.
+ * @throws std::runtime_error if the file cannot be written.
+ */
+std::uintmax_t writeSyntheticFile(const SyntheticGroup &group,
+                                  const SyntheticFile &file);
+
+#endif // __SYNTHETICDATA_H__
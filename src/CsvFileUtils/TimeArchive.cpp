@@ -0,0 +1,746 @@
+#include "TimeArchive.hpp"
+#include "../Utils/FieldParse.hpp"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/math/statistics/linear_regression.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+
+namespace bip = boost::interprocess;
+
+namespace {
+/**
+ * @brief Identifies an archive, at its start and its end.
+ */
+constexpr std::uint64_t archiveMagic = 0x5649484352414b54; // "TKARCHIV"
+constexpr std::uint32_t archiveVersion = 1;
+
+/**
+ * @brief Size of the trailer at the end of an archive.
+ */
+constexpr std::size_t trailerSize = 3 * sizeof(std::uint64_t);
+
+using archive_codec::get;
+using archive_codec::getString;
+using archive_codec::put;
+using archive_codec::putString;
+
+/**
+ * @brief Reads a varint length and the bytes it covers.
+ * @throws std::runtime_error if data is too short.
+ */
+std::string_view getSection(std::string_view data, std::size_t &position) {
+  auto size = archive_codec::getVarint(data, position);
+  if (size > data.size() - position) {
+    throw std::runtime_error("Archive block is truncated");
+  }
+  std::string_view section = data.substr(position, std::size_t(size));
+  position += std::size_t(size);
+  return section;
+}
+
+/**
+ * @brief Finds each column's position among the time columns of a format.
+ * @return -1 for columns that are not time columns.
+ */
+std::vector<int> timeParts(const std::vector<std::string> &colNames,
+                           CsvTimeFormat format) {
+  std::vector<std::string> time_columns = timeColumns(format);
+  std::vector<int> parts;
+  for (const auto &name : colNames) {
+    auto it = std::find(time_columns.begin(), time_columns.end(), name);
+    parts.push_back(it == time_columns.end() ? -1
+                                             : int(it - time_columns.begin()));
+  }
+  return parts;
+}
+} // namespace
+
+TimeArchiveWriter::TimeArchiveWriter(std::string path,
+                                     std::vector<std::string> colNames,
+                                     CsvTimeFormat timeFormat,
+                                     const std::string &delimiter,
+                                     bool multiDelimiter,
+                                     std::size_t blockRows)
+    : path_(std::move(path)), file_(path_), colNames_(std::move(colNames)),
+      timeFormat_(timeFormat), blockRows_(std::max<std::size_t>(1, blockRows)) {
+  timeParts_ = timeParts(colNames_, timeFormat_);
+  if (std::count_if(timeParts_.begin(), timeParts_.end(),
+                    [](int part) { return part >= 0; }) !=
+      long(timeColumns(timeFormat_).size())) {
+    throw std::invalid_argument(
+        "The columns do not include the time columns of the format");
+  }
+  values_.resize(colNames_.size());
+
+  std::string header;
+  put(header, archiveMagic);
+  put(header, archiveVersion);
+  put(header, static_cast<std::uint8_t>(timeFormat_));
+  put(header, static_cast<std::uint8_t>(multiDelimiter));
+  put(header, static_cast<std::uint16_t>(colNames_.size()));
+  putString(header, delimiter);
+  for (const auto &name : colNames_) {
+    putString(header, name);
+  }
+  write(header);
+}
+
+void TimeArchiveWriter::write(std::string_view bytes) {
+  file_.write(bytes);
+  offset_ += bytes.size();
+}
+
+void TimeArchiveWriter::append(time_ticks time,
+                               std::span<const std::string_view> fields) {
+  if (fields.size() != colNames_.size()) {
+    throw std::invalid_argument("Row has " + std::to_string(fields.size()) +
+                                " fields, expected " +
+                                std::to_string(colNames_.size()));
+  }
+  times_.push_back(time);
+  for (std::size_t column = 0; column < fields.size(); ++column) {
+    values_[column].emplace_back(fields[column]);
+  }
+  if (times_.size() == blockRows_) {
+    writeBlock();
+  }
+}
+
+void TimeArchiveWriter::encodeColumn(std::size_t column, std::string &out,
+                                     ArchiveBlock &block) {
+  using namespace archive_codec;
+  const auto &texts = values_[column];
+  std::string text;
+
+  // Time columns are formatted from the row times, if that gives them back
+  if (timeParts_[column] >= 0) {
+    TimeTextLayout layout =
+        detectTimeText(timeFormat_, timeParts_[column], texts[0]);
+    bool exact = true;
+    for (std::size_t row = 0; exact && row < texts.size(); ++row) {
+      text.clear();
+      formatTimeText(timeFormat_, layout, times_[row], text);
+      exact = text == texts[row];
+    }
+    if (exact) {
+      put(out, static_cast<std::uint8_t>(ArchiveCodec::timeText));
+      put(out, layout.fractionDigits);
+      put(out, static_cast<std::uint8_t>(layout.separator));
+      putVarint(out, 0);
+      return;
+    }
+  }
+
+  // Fixed point values keep their mantissas, if they share a scale, and
+  // padding or a "-0" survive formatting them again
+  std::vector<wide_int> mantissas(texts.size());
+  DecimalLayout layout;
+  bool fixed = parseDecimal(texts[0], mantissas[0], layout);
+  for (std::size_t row = 0; fixed && row < texts.size(); ++row) {
+    DecimalLayout row_layout;
+    text.clear();
+    fixed = parseDecimal(texts[row], mantissas[row], row_layout) &&
+            row_layout.scale == layout.scale;
+    if (fixed) {
+      formatDecimal(mantissas[row], layout, text);
+      fixed = text == texts[row];
+    }
+  }
+  if (fixed) {
+    // Ramps such as phases and counters shrink to almost nothing as deltas
+    // of deltas, noisy values are smaller as plain deltas
+    std::string delta, delta_of_delta;
+    encodeIntegers(mantissas, 1, delta);
+    encodeIntegers(mantissas, 2, delta_of_delta);
+    bool ramp = delta_of_delta.size() < delta.size();
+    put(out, static_cast<std::uint8_t>(ramp
+                                           ? ArchiveCodec::decimalDeltaOfDelta
+                                           : ArchiveCodec::decimalDelta));
+    put(out, layout.scale);
+    put(out, layout.width);
+    const std::string &body = ramp ? delta_of_delta : delta;
+    putVarint(out, body.size());
+    out += body;
+
+    auto [low, high] = std::minmax_element(mantissas.begin(), mantissas.end());
+    block.min[column] = static_cast<double>(decimalValue(*low, layout.scale));
+    block.max[column] = static_cast<double>(decimalValue(*high, layout.scale));
+    return;
+  }
+
+  std::string body;
+  for (const auto &value : texts) {
+    putVarint(body, value.size());
+    body += value;
+
+    // fmin and fmax skip the NaN the statistics start at
+    double number;
+    if (parseField(std::string_view(value), number)) {
+      block.min[column] = std::fmin(block.min[column], number);
+      block.max[column] = std::fmax(block.max[column], number);
+    }
+  }
+  put(out, static_cast<std::uint8_t>(ArchiveCodec::text));
+  put(out, std::uint8_t(0));
+  put(out, std::uint8_t(0));
+  putVarint(out, body.size());
+  out += body;
+}
+
+void TimeArchiveWriter::writeBlock() {
+  if (times_.empty()) {
+    return;
+  }
+
+  ArchiveBlock block;
+  block.offset = offset_;
+  block.rows = static_cast<std::uint32_t>(times_.size());
+  block.firstTime = times_.front();
+  block.lastTime = times_.back();
+  block.min.assign(colNames_.size(), std::numeric_limits<double>::quiet_NaN());
+  block.max.assign(colNames_.size(), std::numeric_limits<double>::quiet_NaN());
+
+  std::string data;
+  std::string times;
+  archive_codec::encodeTimes(times_, times);
+  archive_codec::putVarint(data, times.size());
+  data += times;
+  for (std::size_t column = 0; column < colNames_.size(); ++column) {
+    encodeColumn(column, data, block);
+
+    // Rounding to a double can land either side of the exact value, one step
+    // outwards makes the statistics bound it
+    block.min[column] = std::nextafter(block.min[column],
+                                       -std::numeric_limits<double>::infinity());
+    block.max[column] = std::nextafter(block.max[column],
+                                       std::numeric_limits<double>::infinity());
+  }
+
+  block.bytes = static_cast<std::uint32_t>(data.size());
+  write(data);
+  blocks_.push_back(std::move(block));
+
+  times_.clear();
+  for (auto &values : values_) {
+    values.clear();
+  }
+}
+
+void TimeArchiveWriter::close() {
+  if (closed_) {
+    return;
+  }
+  writeBlock();
+
+  std::string index;
+  std::uint64_t index_offset = offset_;
+  for (const auto &block : blocks_) {
+    put(index, block.offset);
+    put(index, block.bytes);
+    put(index, block.rows);
+    put(index, block.firstTime);
+    put(index, block.lastTime);
+    for (std::size_t column = 0; column < colNames_.size(); ++column) {
+      put(index, block.min[column]);
+      put(index, block.max[column]);
+    }
+  }
+  put(index, index_offset);
+  put(index, static_cast<std::uint64_t>(blocks_.size()));
+  put(index, archiveMagic);
+  write(index);
+
+  file_.commit();
+  closed_ = true;
+}
+
+/**
+ * @brief The mapped archives, their index and layout.
+ */
+struct TimeArchive::Contents {
+  /**
+   * @brief The mapped archives.
+   */
+  std::vector<bip::mapped_region> regions;
+
+  /**
+   * @brief The bytes of each archive.
+   */
+  std::vector<std::string_view> files;
+
+  /**
+   * @brief The blocks of all archives, in row order.
+   */
+  std::vector<ArchiveBlock> blocks;
+
+  /**
+   * @brief The archive of each block.
+   */
+  std::vector<std::size_t> blockFiles;
+
+  /**
+   * @brief The first row of each block, then the total row count.
+   */
+  std::vector<long> firstRows = {0};
+
+  /**
+   * @brief Names of the columns.
+   */
+  std::vector<std::string> colNames;
+
+  /**
+   * @brief Delimiter of the archived files.
+   */
+  std::string delimiter;
+
+  /**
+   * @brief Whether empty fields were skipped.
+   */
+  bool multiDelimiter = false;
+
+  /**
+   * @brief The format of the time columns.
+   */
+  CsvTimeFormat timeFormat = CsvTimeFormat::oneColStandard;
+
+  /**
+   * @brief Each column's position among the time columns, or -1.
+   */
+  std::vector<int> timeParts;
+
+  /**
+   * @brief Total size of the archives.
+   */
+  std::uint64_t bytes = 0;
+};
+
+TimeArchive::TimeArchive(const std::vector<std::string> &paths) {
+  if (paths.empty()) {
+    throw std::runtime_error("No archives to open");
+  }
+
+  auto contents = std::make_shared<Contents>();
+  for (const auto &path : paths) {
+    try {
+      bip::file_mapping mapping(path.c_str(), bip::read_only);
+      contents->regions.emplace_back(mapping, bip::read_only);
+    } catch (const bip::interprocess_exception &e) {
+      throw std::runtime_error("Failed to map archive " + path + ": " +
+                               e.what());
+    }
+    const auto &region = contents->regions.back();
+    std::string_view data(static_cast<const char *>(region.get_address()),
+                          region.get_size());
+    contents->files.push_back(data);
+    contents->bytes += data.size();
+
+    // Only close() writes the trailer, so its magic marks a whole archive
+    if (data.size() < trailerSize + sizeof(std::uint64_t)) {
+      throw std::runtime_error(path + " is not a complete archive");
+    }
+    std::size_t position = data.size() - trailerSize;
+    auto index_offset = get<std::uint64_t>(data, position);
+    auto block_count = get<std::uint64_t>(data, position);
+    if (get<std::uint64_t>(data, position) != archiveMagic) {
+      throw std::runtime_error(path + " is not a complete archive");
+    }
+
+    position = 0;
+    if (get<std::uint64_t>(data, position) != archiveMagic ||
+        get<std::uint32_t>(data, position) != archiveVersion) {
+      throw std::runtime_error(path + " is not a supported archive");
+    }
+    auto time_format =
+        static_cast<CsvTimeFormat>(get<std::uint8_t>(data, position));
+    bool multi_delimiter = get<std::uint8_t>(data, position) != 0;
+    std::vector<std::string> col_names(get<std::uint16_t>(data, position));
+    std::string delimiter = getString(data, position);
+    for (auto &name : col_names) {
+      name = getString(data, position);
+    }
+
+    if (contents->files.size() == 1) {
+      contents->colNames = col_names;
+      contents->delimiter = delimiter;
+      contents->multiDelimiter = multi_delimiter;
+      contents->timeFormat = time_format;
+      contents->timeParts = timeParts(col_names, time_format);
+    } else if (col_names != contents->colNames ||
+               delimiter != contents->delimiter ||
+               multi_delimiter != contents->multiDelimiter ||
+               time_format != contents->timeFormat) {
+      throw std::runtime_error(path + " has different columns from " +
+                               paths.front());
+    }
+
+    position = index_offset;
+    for (std::uint64_t b = 0; b < block_count; ++b) {
+      ArchiveBlock block;
+      block.offset = get<std::uint64_t>(data, position);
+      block.bytes = get<std::uint32_t>(data, position);
+      block.rows = get<std::uint32_t>(data, position);
+      block.firstTime = get<time_ticks>(data, position);
+      block.lastTime = get<time_ticks>(data, position);
+      for (std::size_t column = 0; column < col_names.size(); ++column) {
+        block.min.push_back(get<double>(data, position));
+        block.max.push_back(get<double>(data, position));
+      }
+      if (block.offset + block.bytes > index_offset) {
+        throw std::runtime_error(path + " has a block past its index");
+      }
+      contents->firstRows.push_back(contents->firstRows.back() + block.rows);
+      contents->blockFiles.push_back(contents->files.size() - 1);
+      contents->blocks.push_back(std::move(block));
+    }
+  }
+
+  columns_.resize(contents->colNames.size());
+  contents_ = std::move(contents);
+}
+
+std::vector<std::string> TimeArchive::find(const std::string &directory) {
+  std::vector<std::string> paths;
+  for (const auto &entry :
+       std::filesystem::recursive_directory_iterator(directory)) {
+    if (entry.is_regular_file() && entry.path().extension() == ".tka") {
+      paths.push_back(entry.path().string());
+    }
+  }
+  std::sort(paths.begin(), paths.end());
+  return paths;
+}
+
+long TimeArchive::size() const { return contents_->firstRows.back(); }
+
+const std::vector<std::string> &TimeArchive::colNames() const {
+  return contents_->colNames;
+}
+
+const std::string &TimeArchive::delimiter() const {
+  return contents_->delimiter;
+}
+
+bool TimeArchive::multiDelimiter() const { return contents_->multiDelimiter; }
+
+CsvTimeFormat TimeArchive::timeFormat() const { return contents_->timeFormat; }
+
+const std::vector<ArchiveBlock> &TimeArchive::blocks() const {
+  return contents_->blocks;
+}
+
+long TimeArchive::firstRowOfBlock(size_t block) const {
+  return contents_->firstRows.at(block);
+}
+
+std::uint64_t TimeArchive::bytes() const { return contents_->bytes; }
+
+long TimeArchive::blockOfRow(size_t index) const {
+  if (index >= size_t(size())) {
+    throw std::out_of_range("Row index out of range");
+  }
+  const auto &first_rows = contents_->firstRows;
+  return std::upper_bound(first_rows.begin(), first_rows.end(), long(index)) -
+         first_rows.begin() - 1;
+}
+
+std::string_view TimeArchive::blockData(long block) const {
+  const ArchiveBlock &entry = contents_->blocks[block];
+  return contents_->files[contents_->blockFiles[block]].substr(entry.offset,
+                                                               entry.bytes);
+}
+
+const std::vector<time_ticks> &TimeArchive::blockTimes(long block) {
+  if (timesBlock_ != block) {
+    std::string_view data = blockData(block);
+    std::size_t position = 0;
+    std::string_view times = getSection(data, position);
+    times_.resize(contents_->blocks[block].rows);
+    archive_codec::decodeTimes(times, contents_->blocks[block].firstTime,
+                               times_);
+    timesBlock_ = block;
+  }
+  return times_;
+}
+
+const TimeArchive::ColumnCache &TimeArchive::blockColumn(long block,
+                                                         std::size_t column) {
+  ColumnCache &cache = columns_[column];
+  if (cache.block == block) {
+    return cache;
+  }
+
+  // Skip the times and the columns before this one without decoding them
+  std::string_view data = blockData(block);
+  std::size_t position = 0;
+  getSection(data, position);
+  std::string_view body;
+  for (std::size_t c = 0; c <= column; ++c) {
+    cache.codec = static_cast<ArchiveCodec>(get<std::uint8_t>(data, position));
+    cache.parameters[0] = get<std::uint8_t>(data, position);
+    cache.parameters[1] = get<std::uint8_t>(data, position);
+    body = getSection(data, position);
+  }
+
+  std::size_t rows = contents_->blocks[block].rows;
+  switch (cache.codec) {
+  case ArchiveCodec::timeText:
+    break;
+  case ArchiveCodec::decimalDelta:
+  case ArchiveCodec::decimalDeltaOfDelta:
+    cache.mantissas.resize(rows);
+    archive_codec::decodeIntegers(
+        body, cache.codec == ArchiveCodec::decimalDelta ? 1 : 2,
+        cache.mantissas);
+    break;
+  case ArchiveCodec::text: {
+    cache.texts.resize(rows);
+    std::size_t text_position = 0;
+    for (auto &text : cache.texts) {
+      text.assign(getSection(body, text_position));
+    }
+    break;
+  }
+  default:
+    throw std::runtime_error("Archive block has an unknown codec");
+  }
+  cache.block = block;
+  return cache;
+}
+
+std::size_t TimeArchive::columnIndex(const std::string &colName) const {
+  const auto &names = contents_->colNames;
+  auto it = std::find(names.begin(), names.end(), colName);
+  if (it == names.end()) {
+    throw std::runtime_error("Column '" + colName +
+                             "' not found in the archive");
+  }
+  return it - names.begin();
+}
+
+quad TimeArchive::valueOfRow(size_t index, std::size_t column) {
+  long block = blockOfRow(index);
+  const ColumnCache &cache = blockColumn(block, column);
+  std::size_t row = index - contents_->firstRows[block];
+  if (cache.codec == ArchiveCodec::decimalDelta ||
+      cache.codec == ArchiveCodec::decimalDeltaOfDelta) {
+    return archive_codec::decimalValue(cache.mantissas[row],
+                                       cache.parameters[0]);
+  }
+
+  std::string text;
+  fieldOfRow(index, column, text);
+  quad value;
+  if (!parseField(std::string_view(text), value)) {
+    throw std::runtime_error("Invalid value in column " +
+                             contents_->colNames[column] + ": " + text);
+  }
+  return value;
+}
+
+void TimeArchive::fieldOfRow(size_t index, std::size_t column,
+                             std::string &out) {
+  long block = blockOfRow(index);
+  const ColumnCache &cache = blockColumn(block, column);
+  std::size_t row = index - contents_->firstRows[block];
+  switch (cache.codec) {
+  case ArchiveCodec::timeText: {
+    archive_codec::TimeTextLayout layout;
+    layout.part = static_cast<std::uint8_t>(contents_->timeParts[column]);
+    layout.fractionDigits = cache.parameters[0];
+    layout.separator = static_cast<char>(cache.parameters[1]);
+    archive_codec::formatTimeText(contents_->timeFormat, layout,
+                                  blockTimes(block)[row], out);
+    break;
+  }
+  case ArchiveCodec::decimalDelta:
+  case ArchiveCodec::decimalDeltaOfDelta:
+    archive_codec::formatDecimal(
+        cache.mantissas[row], {cache.parameters[0], cache.parameters[1]}, out);
+    break;
+  default:
+    out += cache.texts[row];
+    break;
+  }
+}
+
+date_time TimeArchive::timeOfRow(size_t index) {
+  long block = blockOfRow(index);
+  return fromTicks(blockTimes(block)[index - contents_->firstRows[block]]);
+}
+
+std::vector<time_ticks> TimeArchive::timesOfRows(size_t first, size_t last) {
+  if (first > last || last > size_t(size())) {
+    throw std::out_of_range("Row index out of range");
+  }
+
+  std::vector<time_ticks> ticks;
+  ticks.reserve(last - first);
+  while (first < last) {
+    long block = blockOfRow(first);
+    const auto &times = blockTimes(block);
+    std::size_t offset = first - contents_->firstRows[block];
+    std::size_t count = std::min(last - first, times.size() - offset);
+    ticks.insert(ticks.end(), times.begin() + offset,
+                 times.begin() + offset + count);
+    first += count;
+  }
+  return ticks;
+}
+
+void TimeArchive::readRange(size_t first, size_t last,
+                            const std::string &colName,
+                            std::vector<date_time> &times,
+                            std::vector<quad> &values) {
+  if (first > last || last > size_t(size())) {
+    throw std::out_of_range("Row index out of range");
+  }
+  std::size_t column = columnIndex(colName);
+  times.clear();
+  values.clear();
+
+  while (first < last) {
+    long block = blockOfRow(first);
+    const auto &block_times = blockTimes(block);
+    std::size_t offset = first - contents_->firstRows[block];
+    std::size_t count = std::min(last - first, block_times.size() - offset);
+    for (std::size_t row = offset; row < offset + count; ++row) {
+      times.push_back(fromTicks(block_times[row]));
+    }
+
+    const ColumnCache &cache = blockColumn(block, column);
+    if (cache.codec == ArchiveCodec::decimalDelta ||
+        cache.codec == ArchiveCodec::decimalDeltaOfDelta) {
+      for (std::size_t row = offset; row < offset + count; ++row) {
+        values.push_back(archive_codec::decimalValue(cache.mantissas[row],
+                                                     cache.parameters[0]));
+      }
+    } else {
+      for (std::size_t row = 0; row < count; ++row) {
+        values.push_back(valueOfRow(first + row, column));
+      }
+    }
+    first += count;
+  }
+}
+
+std::pair<size_t, size_t> TimeArchive::bounds(date_time time) {
+  long end_index = size() - 1;
+  if (time < startTime()) {
+    return {-1, 0};
+  }
+  if (time > endTime()) {
+    return {end_index, -1};
+  }
+  if (end_index == 0) {
+    return {0, 0};
+  }
+
+  // The first block ending at or after the time holds the first row at or
+  // after it, the rows found by CsvTimeCursor::bounds are that row and the
+  // one before
+  time_ticks ticks = toTicks(time);
+  const auto &blocks = contents_->blocks;
+  long block = std::partition_point(blocks.begin(), blocks.end(),
+                                    [ticks](const ArchiveBlock &entry) {
+                                      return entry.lastTime < ticks;
+                                    }) -
+               blocks.begin();
+  const auto &times = blockTimes(block);
+  size_t index = contents_->firstRows[block] +
+                 (std::lower_bound(times.begin(), times.end(), ticks) -
+                  times.begin());
+  if (index == 0) {
+    return {0, 1};
+  }
+  return {index - 1, index};
+}
+
+size_t TimeArchive::closestIndex(date_time time) {
+  auto [start_index, end_index] = bounds(time);
+  if (start_index == size_t(-1)) {
+    return end_index;
+  }
+  if (end_index == size_t(-1)) {
+    return start_index;
+  }
+
+  date_time start_time = timeOfRow(start_index);
+  date_time end_time = timeOfRow(end_index);
+
+  return (time - start_time < end_time - time) ? start_index : end_index;
+}
+
+std::tuple<date_time, quad, quad>
+TimeArchive::fitEnd(bool high, const std::string &colName) {
+  date_time ref_time = high ? endTime() : startTime();
+  std::size_t first = high ? size() - 10 : 0;
+
+  std::vector<date_time> row_times;
+  std::vector<quad> values;
+  readRange(first, first + 10, colName, row_times, values);
+
+  std::vector<quad> times;
+  for (const auto &row_time : row_times) {
+    times.push_back((row_time - ref_time).total_microseconds());
+  }
+
+  auto [constant, slope] =
+      boost::math::statistics::simple_ordinary_least_squares(times, values);
+  return {ref_time, constant, slope};
+}
+
+quad TimeArchive::colAtTime(date_time time, const std::string &colName) {
+  // Extrapolate outside the rows as CsvTimeCursor does, from a line through
+  // the ten rows at that end
+  if (time < startTime() || time > endTime()) {
+    bool high = time > endTime();
+    auto &cache = high ? extrapolationCacheHigh_ : extrapolationCacheLow_;
+    auto it = cache.find(colName);
+    if (it == cache.end()) {
+      it = cache.emplace(colName, fitEnd(high, colName)).first;
+    }
+    auto &[ref_time, constant, slope] = it->second;
+    return constant + slope * (time - ref_time).total_microseconds();
+  }
+
+  // Interpolate between the rows that enclose the time
+  auto [start_index, end_index] = bounds(time);
+  std::size_t column = columnIndex(colName);
+
+  quad start_value = valueOfRow(start_index, column);
+  quad end_value = valueOfRow(end_index, column);
+
+  date_time start_time = timeOfRow(start_index);
+  date_time end_time = timeOfRow(end_index);
+
+  return start_value + (end_value - start_value) *
+                           (time - start_time).total_microseconds() /
+                           (end_time - start_time).total_microseconds();
+}
+
+std::string TimeArchive::getRawLine(size_t index) {
+  char separator = contents_->delimiter.empty() ? ',' : contents_->delimiter[0];
+  std::string line;
+  for (std::size_t column = 0; column < contents_->colNames.size(); ++column) {
+    if (column > 0) {
+      line += separator;
+    }
+    fieldOfRow(index, column, line);
+  }
+  return line;
+}
+
+std::map<std::string, std::string> TimeArchive::operator[](size_t index) {
+  std::map<std::string, std::string> row;
+  for (std::size_t column = 0; column < contents_->colNames.size(); ++column) {
+    fieldOfRow(index, column, row[contents_->colNames[column]]);
+  }
+  return row;
+}
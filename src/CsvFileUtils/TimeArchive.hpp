@@ -0,0 +1,473 @@
+#ifndef __TIMEARCHIVE_H__
+#define __TIMEARCHIVE_H__
+
+#include "ArchiveCodec.hpp"
+#include "AtomicFile.hpp"
+#include "RowSchema.hpp"
+#include "TimeParse.hpp"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+/*
+ * Archive file format for finished CSV time data, one archive per data file.
+ *
+ * Rows are stored in blocks of a few thousand, column by column, so a scan
+ * of one column decodes only that column. All integers are little endian.
+ *
+ *   header   uint64 magic "TKARCHIV", uint32 version, uint8 time format,
+ *            uint8 multi delimiter, uint16 columns, string delimiter,
+ *            string column name...
+ *   blocks   per block: varint length and the encoded times, then per
+ *            column: uint8 codec, uint8 parameter, uint8 parameter, varint
+ *            length and the encoded column
+ *   index    per block: uint64 offset, uint32 bytes, uint32 rows, int64 first
+ *            time, int64 last time, then per column double min, double max
+ *   trailer  uint64 index offset, uint64 blocks, uint64 magic
+ *
+ * Strings are a uint16 length followed by the bytes. Times are ticks since
+ * 1970-01-01. The codecs are in ArchiveCodec.hpp, every field is stored so
+ * that its text is reproduced exactly.
+ */
+
+/**
+ * @brief How a column of a block is encoded.
+ */
+enum class ArchiveCodec : std::uint8_t {
+  /**
+   * @brief A time column, formatted from the row times. The parameters are
+   * the fraction digits and the date separator.
+   */
+  timeText = 0,
+
+  /**
+   * @brief Fixed point values as deltas of their mantissas. The parameters
+   * are the scale and zero padded width.
+   */
+  decimalDelta = 1,
+
+  /**
+   * @brief Fixed point values as deltas of deltas of their mantissas, for
+   * values that ramp. The parameters are the scale and zero padded width.
+   */
+  decimalDeltaOfDelta = 2,
+
+  /**
+   * @brief The text of each field, length prefixed.
+   */
+  text = 3,
+};
+
+/**
+ * @brief Index entry of a block, with statistics for skipping blocks.
+ */
+struct ArchiveBlock {
+  /**
+   * @brief Offset of the block in its file.
+   */
+  std::uint64_t offset = 0;
+
+  /**
+   * @brief Size of the block in bytes.
+   */
+  std::uint32_t bytes = 0;
+
+  /**
+   * @brief Number of rows in the block.
+   */
+  std::uint32_t rows = 0;
+
+  /**
+   * @brief Time of the first row.
+   */
+  time_ticks firstTime = 0;
+
+  /**
+   * @brief Time of the last row.
+   */
+  time_ticks lastTime = 0;
+
+  /**
+   * @brief A double at or below the smallest value of each column, NaN for
+   * columns with no numeric values in the block.
+   */
+  std::vector<double> min;
+
+  /**
+   * @brief A double at or above the largest value of each column, NaN for
+   * columns with no numeric values in the block.
+   */
+  std::vector<double> max;
+};
+
+/**
+ * @brief Writes the rows of a data file into an archive.
+ *
+ * The archive is written under a temporary name next to its final path and
+ * renamed into place by close(), so a reader never sees a partial archive
+ * and a writer destroyed before close() leaves nothing behind.
+ */
+struct TimeArchiveWriter {
+private:
+  /**
+   * @brief Final path of the archive.
+   */
+  std::string path_;
+
+  /**
+   * @brief The archive being written, under a temporary name.
+   */
+  AtomicFile file_;
+
+  /**
+   * @brief Names of the columns.
+   */
+  std::vector<std::string> colNames_;
+
+  /**
+   * @brief The format of the time columns.
+   */
+  CsvTimeFormat timeFormat_;
+
+  /**
+   * @brief For each column, its position in the time columns of the format,
+   * or -1 if it is not a time column.
+   */
+  std::vector<int> timeParts_;
+
+  /**
+   * @brief Rows per block.
+   */
+  std::size_t blockRows_;
+
+  /**
+   * @brief Times of the rows of the current block.
+   */
+  std::vector<time_ticks> times_;
+
+  /**
+   * @brief Text of each column of the rows of the current block.
+   */
+  std::vector<std::vector<std::string>> values_;
+
+  /**
+   * @brief Index entries of the blocks written.
+   */
+  std::vector<ArchiveBlock> blocks_;
+
+  /**
+   * @brief Bytes written so far.
+   */
+  std::uint64_t offset_ = 0;
+
+  /**
+   * @brief Whether close() has finished the archive.
+   */
+  bool closed_ = false;
+
+  /**
+   * @brief Appends bytes to the archive.
+   * @throws std::runtime_error if the write fails.
+   */
+  void write(std::string_view bytes);
+
+  /**
+   * @brief Encodes and writes the current block.
+   */
+  void writeBlock();
+
+  /**
+   * @brief Encodes a column of the current block with the smallest codec that
+   * reproduces its text.
+   * @param column The column.
+   * @param out The buffer to append to.
+   * @param block Receives the column's statistics.
+   */
+  void encodeColumn(std::size_t column, std::string &out, ArchiveBlock &block);
+
+public:
+  /**
+   * @brief Starts an archive.
+   * @param path Path of the archive.
+   * @param colNames Names of the columns.
+   * @param timeFormat The format of the time columns.
+   * @param delimiter Characters separating fields in the data file.
+   * @param multiDelimiter If true, empty fields are skipped.
+   * @param blockRows Rows per block.
+   * @throws std::invalid_argument if a time column of the format is missing.
+   * @throws std::runtime_error if the archive cannot be created.
+   */
+  TimeArchiveWriter(std::string path, std::vector<std::string> colNames,
+                    CsvTimeFormat timeFormat, const std::string &delimiter,
+                    bool multiDelimiter, std::size_t blockRows = 4096);
+
+  TimeArchiveWriter(const TimeArchiveWriter &) = delete;
+  TimeArchiveWriter &operator=(const TimeArchiveWriter &) = delete;
+
+  /**
+   * @brief Appends a row.
+   * @param time The time of the row, from its time columns.
+   * @param fields The text of every column, in column order.
+   * @throws std::invalid_argument if the row has the wrong number of fields.
+   * @throws std::runtime_error if a block cannot be written.
+   */
+  void append(time_ticks time, std::span<const std::string_view> fields);
+
+  /**
+   * @brief Writes the last block and the index, and moves the archive to its
+   * path.
+   * @throws std::runtime_error if the archive cannot be written.
+   */
+  void close();
+};
+
+/**
+ * @brief Reads archives of a group's data files as one series of rows.
+ *
+ * Offers the same time lookups and typed rows as CsvTimeCursor, on rows
+ * decoded from the archives rather than parsed from text. Decoded blocks are
+ * cached, so like a cursor it is for a single thread. Copies share the mapped
+ * archives and are cheap, hand one to each worker.
+ */
+struct TimeArchive {
+private:
+  struct Contents;
+
+  /**
+   * @brief Decoded column of a block.
+   */
+  struct ColumnCache {
+    /**
+     * @brief The decoded block, -1 for none.
+     */
+    long block = -1;
+
+    /**
+     * @brief The codec of the column in that block.
+     */
+    ArchiveCodec codec = ArchiveCodec::text;
+
+    /**
+     * @brief The codec parameters.
+     */
+    std::uint8_t parameters[2] = {0, 0};
+
+    /**
+     * @brief Mantissas of fixed point columns.
+     */
+    std::vector<archive_codec::wide_int> mantissas;
+
+    /**
+     * @brief Text of text columns.
+     */
+    std::vector<std::string> texts;
+  };
+
+  /**
+   * @brief The mapped archives and their index, shared by copies.
+   */
+  std::shared_ptr<const Contents> contents_;
+
+  /**
+   * @brief The block whose times are decoded, -1 for none.
+   */
+  long timesBlock_ = -1;
+
+  /**
+   * @brief Times of the decoded block.
+   */
+  std::vector<time_ticks> times_;
+
+  /**
+   * @brief The decoded block of each column.
+   */
+  std::vector<ColumnCache> columns_;
+
+  /**
+   * @brief Extrapolation parameters below the first row.
+   * @details Maps from column name to a tuple of (reference_time, constant,
+   * slope).
+   */
+  std::map<std::string, std::tuple<date_time, quad, quad>>
+      extrapolationCacheLow_;
+
+  /**
+   * @brief Extrapolation parameters above the last row.
+   * @details Maps from column name to a tuple of (reference_time, constant,
+   * slope).
+   */
+  std::map<std::string, std::tuple<date_time, quad, quad>>
+      extrapolationCacheHigh_;
+
+  /**
+   * @brief Gets the block holding a row.
+   * @throws std::out_of_range if the row index is out of range.
+   */
+  long blockOfRow(size_t index) const;
+
+  /**
+   * @brief Gets the encoded bytes of a block.
+   */
+  std::string_view blockData(long block) const;
+
+  /**
+   * @brief Decodes the times of a block.
+   */
+  const std::vector<time_ticks> &blockTimes(long block);
+
+  /**
+   * @brief Decodes a column of a block.
+   */
+  const ColumnCache &blockColumn(long block, std::size_t column);
+
+  /**
+   * @brief Gets the position of a column.
+   * @throws std::runtime_error if there is no such column.
+   */
+  std::size_t columnIndex(const std::string &colName) const;
+
+  /**
+   * @brief Gets the value of a column in a row.
+   * @throws std::runtime_error if the value is not a number.
+   */
+  quad valueOfRow(size_t index, std::size_t column);
+
+  /**
+   * @brief Appends the text of a column in a row.
+   */
+  void fieldOfRow(size_t index, std::size_t column, std::string &out);
+
+  /**
+   * @brief Fits a line to the ten rows at one end, for extrapolating.
+   * @param high true for the last rows, false for the first.
+   * @param colName The column to fit.
+   * @return The reference time, constant and slope per microsecond.
+   */
+  std::tuple<date_time, quad, quad> fitEnd(bool high,
+                                           const std::string &colName);
+
+public:
+  /**
+   * @brief Opens archives of a group's data files.
+   * @param paths The archives, in time order.
+   * @throws std::runtime_error if an archive cannot be read, is incomplete,
+   * or has different columns from the first.
+   */
+  explicit TimeArchive(const std::vector<std::string> &paths);
+
+  /**
+   * @brief Finds the archives under a directory.
+   * @param directory The directory tkarchive wrote to.
+   * @return The paths of the archives, sorted by path as a group sorts its
+   * files.
+   */
+  static std::vector<std::string> find(const std::string &directory);
+
+  /**
+   * @brief Gets the number of rows.
+   */
+  long size() const;
+
+  /**
+   * @brief Gets the column names.
+   */
+  const std::vector<std::string> &colNames() const;
+
+  /**
+   * @brief Gets the delimiter of the archived files, for RowDecoder.
+   */
+  const std::string &delimiter() const;
+
+  /**
+   * @brief Gets whether empty fields were skipped, for RowDecoder.
+   */
+  bool multiDelimiter() const;
+
+  /**
+   * @brief Gets the format of the time columns.
+   */
+  CsvTimeFormat timeFormat() const;
+
+  /**
+   * @brief Gets the index of every block, for skipping blocks on their time
+   * range or statistics.
+   * @return The blocks in row order.
+   */
+  const std::vector<ArchiveBlock> &blocks() const;
+
+  /**
+   * @brief Gets the first row of a block.
+   * @param block The position of the block in blocks().
+   */
+  long firstRowOfBlock(size_t block) const;
+
+  /**
+   * @brief Gets the size of the archives.
+   * @return The total bytes of the archive files.
+   */
+  std::uint64_t bytes() const;
+
+  date_time timeOfRow(size_t index);
+
+  /**
+   * @brief Gets the times of a range of rows.
+   * @param first The index of the first row.
+   * @param last One past the index of the last row.
+   * @return The time of each row as ticks since 1970-01-01.
+   * @throws std::out_of_range if the range is out of range.
+   */
+  std::vector<time_ticks> timesOfRows(size_t first, size_t last);
+
+  /**
+   * @brief Reads the times and values of a range of rows.
+   * @param first The index of the first row.
+   * @param last One past the index of the last row.
+   * @param colName The value column to read.
+   * @param times Receives the time of each row.
+   * @param values Receives the value of each row.
+   * @throws std::runtime_error if a value is not a number.
+   */
+  void readRange(size_t first, size_t last, const std::string &colName,
+                 std::vector<date_time> &times, std::vector<quad> &values);
+
+  date_time startTime() { return timeOfRow(0); }
+
+  date_time endTime() { return timeOfRow(size() - 1); }
+
+  std::pair<size_t, size_t> bounds(date_time time);
+
+  size_t closestIndex(date_time time);
+
+  quad colAtTime(date_time time, const std::string &colName);
+
+  /**
+   * @brief Rebuilds the line of a row, fields joined by the first delimiter
+   * character.
+   * @param index The row number to read (0-based index).
+   * @return The line.
+   * @throws std::out_of_range if the row index is out of range.
+   */
+  std::string getRawLine(size_t index);
+
+  std::map<std::string, std::string> operator[](size_t index);
+
+  /**
+   * @brief Reads a row into the row struct of a schema.
+   * @param index The row number to read (0-based index).
+   * @param decoder A decoder created from this archive, which has the column
+   * names and delimiters of the archived files.
+   * @return The decoded row.
+   */
+  template <typename Schema>
+  typename Schema::row_type row(size_t index, RowDecoder<Schema> &decoder) {
+    return decoder(getRawLine(index));
+  }
+};
+
+#endif // __TIMEARCHIVE_H__
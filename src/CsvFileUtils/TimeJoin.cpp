@@ -0,0 +1,118 @@
+#include "TimeJoin.hpp"
+#include "../Utils/FieldParse.hpp"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <cstdlib>
+#include <numeric>
+
+TimeAligner::TimeAligner(const CsvTimeSnapshot &rows,
+                         std::vector<std::string> columns,
+                         ResampleMethod method, time_delt tolerance,
+                         long batchRows)
+    : cursor_(rows.cursor()), columns_(std::move(columns)),
+      projection_(rows.group().project(columns_)), method_(method),
+      tolerance_(tolerance.ticks()), batchRows_(batchRows) {
+  if (batchRows < 2) {
+    throw std::invalid_argument("Aligner batches need at least two rows");
+  }
+}
+
+void TimeAligner::load(long first) {
+  const long last = std::min(cursor_.group().size(), first + batchRows_);
+  first_ = first;
+  times_ = cursor_.timesOfRows(first, last);
+
+  std::vector<long> rows(last - first);
+  std::iota(rows.begin(), rows.end(), first);
+  std::vector<std::string> lines = cursor_.group().readRows(rows);
+  values_.clear();
+  for (std::size_t i = 0; i < lines.size(); ++i) {
+    cursor_.group().splitFields(lines[i], projection_, fields_);
+    for (std::size_t c = 0; c < columns_.size(); ++c) {
+      quad value;
+      if (!parseField(fields_[c], value)) {
+        throw std::runtime_error("Invalid value in column " + columns_[c] +
+                                 ": " + std::string(fields_[c]));
+      }
+      values_.push_back(value);
+    }
+  }
+}
+
+bool TimeAligner::align(date_time time, std::span<quad> values) {
+  const long size = cursor_.group().size();
+  if (size == 0) {
+    return false;
+  }
+  const time_ticks ticks = toTicks(time);
+
+  // Walking forward from the last time only pairs the time with the rows
+  // bounds() would if the row before end_ is held and earlier than the time,
+  // and the time is not past the rows held. Anything else, a time at or
+  // before that row included, moves with a search.
+  const long held_end = first_ + static_cast<long>(times_.size());
+  const bool held = !times_.empty() && end_ > first_ && end_ <= held_end;
+  if (!held || ticks > times_.back() || ticks <= times_[end_ - 1 - first_]) {
+    auto [start_index, end_index] = cursor_.bounds(time);
+    if (start_index == static_cast<size_t>(-1)) {
+      end_ = 0;
+    } else if (end_index == static_cast<size_t>(-1)) {
+      end_ = size;
+    } else {
+      end_ = static_cast<long>(end_index);
+    }
+    load(std::max(0L, end_ - 1));
+  } else {
+    while (end_ < held_end && times_[end_ - first_] < ticks) {
+      ++end_;
+    }
+  }
+
+  // The rows before and at or after the time, -1 where there are none
+  const long before = end_ - 1;
+  const long after = end_ < size ? end_ : -1;
+  auto row_time = [&](long row) { return times_[row - first_]; };
+  auto row_values = [&](long row) {
+    return values_.begin() + (row - first_) * columns_.size();
+  };
+
+  long row = -1;
+  switch (method_) {
+  case ResampleMethod::linear: {
+    if (before < 0 || after < 0 || ticks - row_time(before) > tolerance_ ||
+        row_time(after) - ticks > tolerance_) {
+      return false;
+    }
+    const date_time start_time = fromTicks(row_time(before));
+    const date_time end_time = fromTicks(row_time(after));
+    auto start_values = row_values(before);
+    auto end_values = row_values(after);
+    const auto offset = (time - start_time).total_microseconds();
+    const auto span = (end_time - start_time).total_microseconds();
+    for (std::size_t c = 0; c < columns_.size(); ++c) {
+      values[c] = start_values[c] +
+                  (end_values[c] - start_values[c]) * offset / span;
+    }
+    return true;
+  }
+  case ResampleMethod::previous:
+    row = after >= 0 && row_time(after) == ticks ? after : before;
+    if (row < 0 || ticks - row_time(row) > tolerance_) {
+      return false;
+    }
+    break;
+  case ResampleMethod::nearest:
+    if (before < 0 || after < 0) {
+      row = before < 0 ? after : before;
+    } else {
+      row = ticks - row_time(before) < row_time(after) - ticks ? before : after;
+    }
+    if (std::abs(row_time(row) - ticks) > tolerance_) {
+      return false;
+    }
+    break;
+  }
+  std::copy_n(row_values(row), columns_.size(), values.begin());
+  return true;
+}
@@ -0,0 +1,289 @@
+#ifndef __TIMEJOIN_H__
+#define __TIMEJOIN_H__
+
+#include "CsvGroupSnapshot.hpp"
+#include "CsvTimeSnapshot.hpp"
+#include "Projection.hpp"
+#include "Resample.hpp"
+#include "RowSchema.hpp"
+#include "TimeParse.hpp"
+
+#include <algorithm>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Aligns columns of a time group to a stream of times, reading the
+ * group's rows in one sequential pass.
+ *
+ * Times are expected in ascending order. The aligner keeps one batch of rows
+ * and walks it with the times, reading the next batch, found by bounds(),
+ * only once a time passes the rows it holds. Times out of order are found
+ * the same way, so they are correct but slower.
+ *
+ * Aligned values are what the method gives on the rows: ResampleMethod::linear
+ * interpolates exactly as CsvTimeCursor::colAtTime, but does not extrapolate
+ * past the first or last row. A time only aligns if the rows it is taken from
+ * are within the tolerance of it. Like a cursor, an aligner is for a single
+ * thread.
+ */
+struct TimeAligner {
+private:
+  /**
+   * @brief Time lookups on the rows, for moving to a time.
+   */
+  CsvTimeCursor cursor_;
+
+  /**
+   * @brief The columns to align.
+   */
+  std::vector<std::string> columns_;
+
+  /**
+   * @brief Projection of the columns to align.
+   */
+  Projection projection_;
+
+  /**
+   * @brief How values are taken from the rows around a time.
+   */
+  ResampleMethod method_ = ResampleMethod::linear;
+
+  /**
+   * @brief The furthest a row may be from a time it is aligned to, in ticks.
+   */
+  time_ticks tolerance_ = 0;
+
+  /**
+   * @brief Rows read per batch.
+   */
+  long batchRows_ = 4096;
+
+  /**
+   * @brief The first row held.
+   */
+  long first_ = 0;
+
+  /**
+   * @brief The time of each row held, as ticks since 1970-01-01.
+   */
+  std::vector<time_ticks> times_;
+
+  /**
+   * @brief The values of each row held, row after row.
+   */
+  std::vector<quad> values_;
+
+  /**
+   * @brief The first row at or after the last time, or the row count if the
+   * time was after every row.
+   */
+  long end_ = 0;
+
+  /**
+   * @brief Reused storage for the fields of the current row.
+   */
+  std::vector<std::string_view> fields_;
+
+  /**
+   * @brief Reads a batch of rows.
+   * @param first The first row to hold.
+   */
+  void load(long first);
+
+public:
+  /**
+   * @brief Default constructor for an aligner over no rows.
+   */
+  TimeAligner() = default;
+
+  /**
+   * @brief Construct an aligner of columns of a time group.
+   * @param rows The rows to align.
+   * @param columns The value columns to align.
+   * @param method How values are taken from the rows around a time.
+   * @param tolerance The furthest a row may be from a time it is aligned to.
+   * @param batchRows Rows read per batch.
+   * @throws std::runtime_error if a column is missing.
+   * @throws std::invalid_argument if batchRows is less than two.
+   */
+  TimeAligner(const CsvTimeSnapshot &rows, std::vector<std::string> columns,
+              ResampleMethod method, time_delt tolerance,
+              long batchRows = 4096);
+
+  /**
+   * @brief Gets the aligned columns.
+   */
+  const std::vector<std::string> &columns() const { return columns_; }
+
+  /**
+   * @brief Aligns the columns to a time.
+   * @param time The time to align to.
+   * @param values Receives the value of each column.
+   * @return false if no rows within the tolerance give values at the time,
+   * in which case values is unchanged.
+   * @throws std::runtime_error if a value is not a number.
+   */
+  bool align(date_time time, std::span<quad> values);
+};
+
+/**
+ * @brief A row of the left group of a TimeJoin, with the right group's
+ * columns aligned to its time.
+ * @tparam Schema The RowSchema of the left group.
+ */
+template <typename Schema> struct JoinedRow {
+  /**
+   * @brief The row in the left group.
+   */
+  long row = 0;
+
+  /**
+   * @brief The time of the left row.
+   */
+  date_time time;
+
+  /**
+   * @brief The decoded left row.
+   */
+  typename Schema::row_type left{};
+
+  /**
+   * @brief The aligned right columns, in the order they were requested.
+   */
+  std::vector<quad> right;
+
+  /**
+   * @brief Whether the right columns aligned within the tolerance, right
+   * is left as it was for the previous row otherwise.
+   */
+  bool matched = false;
+};
+
+/**
+ * @brief Joins two time groups on time, in one sequential pass over each.
+ *
+ * Each row of the left group, read in order and decoded into its schema's
+ * row struct, is paired with the right group's columns aligned to its time by
+ * a TimeAligner. Both groups are read a batch at a time, so memory stays
+ * bounded however many rows are joined.
+ *
+ * Example:
+ * @code
+ * TimeJoin<PhaseFreqSchema> join(phase_freq.snapshot(), si_freq.snapshot(),
+ *                                {"Si_Freq"}, ResampleMethod::linear,
+ *                                boost::posix_time::seconds(1));
+ * JoinedRow<PhaseFreqSchema> row;
+ * while (join.next(row)) {
+ *   if (row.matched) {
+ *     use(row.left.Si_Phase, row.right[0]);
+ *   }
+ * }
+ * @endcode
+ *
+ * @tparam Schema The RowSchema of the left group.
+ */
+template <typename Schema> struct TimeJoin {
+private:
+  /**
+   * @brief Time lookups on the left rows.
+   */
+  CsvTimeCursor leftTimes_;
+
+  /**
+   * @brief Sequential reads of the left rows.
+   */
+  CsvGroupCursor leftRows_;
+
+  /**
+   * @brief Decodes the left rows.
+   */
+  RowDecoder<Schema> decoder_;
+
+  /**
+   * @brief Aligns the right columns to the left times.
+   */
+  TimeAligner right_;
+
+  /**
+   * @brief One past the last left row to join.
+   */
+  long last_ = 0;
+
+  /**
+   * @brief Left rows read per batch.
+   */
+  long batchRows_ = 4096;
+
+  /**
+   * @brief The first left row of the batch of times.
+   */
+  long timesFirst_ = 0;
+
+  /**
+   * @brief Times of a batch of left rows, as ticks since 1970-01-01.
+   */
+  std::vector<time_ticks> times_;
+
+public:
+  /**
+   * @brief Construct a join of two time groups.
+   * @param left The rows to stream.
+   * @param right The rows to align to the left rows.
+   * @param rightColumns The value columns of the right rows to align.
+   * @param method How right values are taken from the rows around a time.
+   * @param tolerance The furthest a right row may be from a left row it is
+   * aligned to.
+   * @param first The first left row to join.
+   * @param last One past the last left row to join, -1 for every row.
+   * @param batchRows Rows read per batch, from each group.
+   * @throws std::runtime_error if a column is missing.
+   * @throws std::out_of_range if the left rows are out of range.
+   */
+  TimeJoin(const CsvTimeSnapshot &left, const CsvTimeSnapshot &right,
+           std::vector<std::string> rightColumns, ResampleMethod method,
+           time_delt tolerance, long first = 0, long last = -1,
+           long batchRows = 4096)
+      : leftTimes_(left.cursor()), leftRows_(left.group(), first),
+        decoder_(left.group().metadata()),
+        right_(right, std::move(rightColumns), method, tolerance, batchRows),
+        last_(last < 0 ? left.size() : last), batchRows_(batchRows),
+        timesFirst_(first) {
+    if (first < 0 || first > last_ || last_ > left.size()) {
+      throw std::out_of_range("Joined rows out of range");
+    }
+  }
+
+  /**
+   * @brief Reads the next left row and aligns the right columns to it.
+   * @param row Receives the joined row.
+   * @return false once every left row has been joined.
+   * @throws std::runtime_error if a row cannot be read or decoded.
+   */
+  bool next(JoinedRow<Schema> &row) {
+    const long index = leftRows_.row();
+    if (index >= last_ || !leftRows_.next()) {
+      return false;
+    }
+    if (index - timesFirst_ >= static_cast<long>(times_.size())) {
+      timesFirst_ = index;
+      times_ = leftTimes_.timesOfRows(index,
+                                      std::min(last_, index + batchRows_));
+    }
+    if (!decoder_.decode(leftRows_.line(), row.left)) {
+      throw std::runtime_error("Failed to decode row: " +
+                               std::string(leftRows_.line()));
+    }
+
+    row.row = index;
+    row.time = fromTicks(times_[index - timesFirst_]);
+    row.right.resize(right_.columns().size());
+    row.matched = right_.align(row.time, row.right);
+    return true;
+  }
+};
+
+#endif // __TIMEJOIN_H__
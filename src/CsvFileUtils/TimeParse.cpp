@@ -0,0 +1,96 @@
+#include "TimeParse.hpp"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+date_time parseTime(TimeFormat format, const std::string &time_str) {
+  switch (format) {
+  case TimeFormat::standard:
+    return boost::posix_time::time_from_string(time_str);
+  case TimeFormat::iso:
+    return boost::posix_time::from_iso_string(time_str);
+  case TimeFormat::isoExtended:
+    return boost::posix_time::from_iso_extended_string(time_str);
+  default:
+    throw std::invalid_argument("Unsupported time format: " +
+                                std::to_string(static_cast<int>(format)));
+  }
+}
+
+std::vector<std::string> timeColumns(CsvTimeFormat format) {
+  switch (format) {
+  case CsvTimeFormat::oneColStandard: {
+    const auto &columns = TimeParser<CsvTimeFormat::oneColStandard>::columns;
+    return std::vector<std::string>(columns.begin(), columns.end());
+  }
+  case CsvTimeFormat::twoColShort: {
+    const auto &columns = TimeParser<CsvTimeFormat::twoColShort>::columns;
+    return std::vector<std::string>(columns.begin(), columns.end());
+  }
+  default:
+    throw std::invalid_argument("Unsupported CSV time format: " +
+                                std::to_string(static_cast<int>(format)));
+  }
+}
+
+namespace {
+/**
+ * @brief The reference point of time_ticks.
+ */
+const date_time tickEpoch(boost::gregorian::date(1970, 1, 1));
+} // namespace
+
+time_ticks toTicks(const date_time &time) {
+  return (time - tickEpoch).ticks();
+}
+
+date_time fromTicks(time_ticks ticks) {
+  return tickEpoch + time_delt(0, 0, 0, ticks);
+}
+
+namespace time_parse_detail {
+
+bool parseFraction(std::string_view text, std::int64_t &ticks) {
+  ticks = 0;
+  if (text.empty()) {
+    return true;
+  }
+  if ((text[0] != '.' && text[0] != ',') || text.size() < 2) {
+    return false;
+  }
+
+  // Take as many digits as the tick resolution holds, truncating the rest
+  const int resolution = time_delt::num_fractional_digits();
+  int digits = 0;
+  for (std::size_t i = 1; i < text.size(); ++i) {
+    char c = text[i];
+    if (c < '0' || c > '9') {
+      return false;
+    }
+    if (digits < resolution) {
+      ticks = ticks * 10 + (c - '0');
+      ++digits;
+    }
+  }
+  for (; digits < resolution; ++digits) {
+    ticks *= 10;
+  }
+  return true;
+}
+
+bool fieldsToTicks(std::int64_t year, unsigned month, unsigned day,
+                   unsigned hour, unsigned minute, unsigned second,
+                   std::int64_t fraction, time_ticks &ticks) {
+  // Boost date range, anything else is left to Boost to reject
+  if (year < 1400 || year > 9999 || month < 1 || month > 12 || day < 1 ||
+      day > daysInMonth(year, month) || hour > 23 || minute > 59 ||
+      second > 59) {
+    return false;
+  }
+
+  std::int64_t seconds = daysFromCivil(year, month, day) * 86400 +
+                         hour * 3600 + minute * 60 + second;
+  ticks = seconds * time_delt::ticks_per_second() + fraction;
+  return true;
+}
+
+} // namespace time_parse_detail
@@ -0,0 +1,341 @@
+#ifndef __TIMEPARSE_H__
+#define __TIMEPARSE_H__
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using date_time = boost::posix_time::ptime;
+using time_delt = boost::posix_time::time_duration;
+
+/**
+ * @brief A point in time as a count of date_time ticks since 1970-01-01.
+ * @details Uses the tick resolution of time_delt, so conversions to and from
+ * date_time are exact.
+ */
+using time_ticks = std::int64_t;
+
+/**
+ * @brief Formats for parsing time strings into date_time objects.
+ */
+enum TimeFormat {
+  /**
+   * @brief "YYYY-MM-DD HH:MM:SS.fffffffff"
+   */
+  standard,
+
+  /**
+   * @brief "YYYYMMDDTHHMMSS.fffffffff"
+   */
+  iso,
+
+  /**
+   * @brief "YYYY-MM-DDTHH:MM:SS.fffffffff"
+   */
+  isoExtended
+};
+
+/**
+ * @brief Parses a time string into a boost::posix_time::ptime object.
+ * @param format: The format of the time string
+ * @param time_str: The time string to parse
+ * @return: A boost::posix_time::ptime object representing the parsed time
+ */
+date_time parseTime(TimeFormat format, const std::string &time_str);
+
+/**
+ * @brief Represents the format of time data in the CSV files.
+ */
+enum class CsvTimeFormat {
+  /**
+   * @brief Time Data stored in a single column, "Time", in standard format.
+   */
+  oneColStandard,
+
+  /**
+   * @brief Time Data stored in two columns, "Day" and "Time", with
+   * "Day" as "YYMMDD" and "Time" as "HHMMSS.fffffffff".
+   */
+  twoColShort,
+};
+
+/**
+ * @brief Gets the names of the columns holding the time in a format.
+ * @param format The time format of the CSV files.
+ * @return The column names, in the order the parsers take them.
+ */
+std::vector<std::string> timeColumns(CsvTimeFormat format);
+
+/**
+ * @brief Converts a date_time to ticks since 1970-01-01.
+ */
+time_ticks toTicks(const date_time &time);
+
+/**
+ * @brief Converts ticks since 1970-01-01 to a date_time.
+ */
+date_time fromTicks(time_ticks ticks);
+
+namespace time_parse_detail {
+
+/**
+ * @brief Days from 1970-01-01 to the given proleptic Gregorian date.
+ */
+constexpr std::int64_t daysFromCivil(std::int64_t year, unsigned month,
+                                     unsigned day) {
+  year -= month <= 2;
+  const std::int64_t era = (year >= 0 ? year : year - 399) / 400;
+  const unsigned year_of_era = static_cast<unsigned>(year - era * 400);
+  const unsigned day_of_year =
+      (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  const unsigned day_of_era =
+      year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+  return era * 146097 + static_cast<std::int64_t>(day_of_era) - 719468;
+}
+
+/**
+ * @brief Number of days in a month of the given year.
+ */
+constexpr unsigned daysInMonth(std::int64_t year, unsigned month) {
+  constexpr unsigned days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+  return month == 2 && leap ? 29 : days[month - 1];
+}
+
+/**
+ * @brief Parses eight ASCII digits at once using 64-bit lane arithmetic.
+ * @param chars Pointer to at least eight characters.
+ * @param value Receives the parsed value.
+ * @return false if any of the eight characters is not a digit.
+ */
+inline bool parseEightDigits(const char *chars, std::uint32_t &value) {
+  if constexpr (std::endian::native == std::endian::little) {
+    std::uint64_t lanes;
+    std::memcpy(&lanes, chars, sizeof(lanes));
+
+    // Every byte must be in '0'..'9': high nibble 3, and adding 6 must not
+    // carry into the high nibble
+    if ((((lanes & 0xF0F0F0F0F0F0F0F0) |
+          (((lanes + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4))) !=
+        0x3333333333333333) {
+      return false;
+    }
+
+    lanes -= 0x3030303030303030;
+    lanes = (lanes * 10) + (lanes >> 8);
+    lanes = (((lanes & 0x000000FF000000FF) * (100 + (1000000ULL << 32))) +
+             (((lanes >> 16) & 0x000000FF000000FF) * (1 + (10000ULL << 32)))) >>
+            32;
+    value = static_cast<std::uint32_t>(lanes);
+    return true;
+  } else {
+    value = 0;
+    for (int i = 0; i < 8; ++i) {
+      if (chars[i] < '0' || chars[i] > '9') {
+        return false;
+      }
+      value = value * 10 + (chars[i] - '0');
+    }
+    return true;
+  }
+}
+
+/**
+ * @brief Parses an optional fractional second, truncated to tick resolution.
+ * @param text The text following the seconds digits, starting with the
+ * decimal separator if there is a fraction.
+ * @param ticks Receives the fraction in ticks.
+ * @return false if the text is not empty and not a valid fraction.
+ */
+bool parseFraction(std::string_view text, std::int64_t &ticks);
+
+/**
+ * @brief Combines checked calendar fields into ticks.
+ * @return false if any field is out of range.
+ */
+bool fieldsToTicks(std::int64_t year, unsigned month, unsigned day,
+                   unsigned hour, unsigned minute, unsigned second,
+                   std::int64_t fraction, time_ticks &ticks);
+
+} // namespace time_parse_detail
+
+/**
+ * @brief Hand-written parser for the time columns of a CsvTimeFormat.
+ *
+ * Parses the fixed-width fields directly into ticks without allocating.
+ * Inputs that do not match the fixed layout are rejected so callers can fall
+ * back to the general Boost parsers.
+ *
+ * @tparam Format The time format of the CSV files.
+ */
+template <CsvTimeFormat Format> struct TimeParser;
+
+/**
+ * @brief Parser for a single "YYYY-MM-DD HH:MM:SS.fff" column.
+ */
+template <> struct TimeParser<CsvTimeFormat::oneColStandard> {
+  /**
+   * @brief Names of the columns holding the time, in the order parsed.
+   */
+  static constexpr std::array<std::string_view, 1> columns = {"Time"};
+
+  /**
+   * @brief Parses the time fields of one row.
+   * @param fields The text of each column listed in columns.
+   * @param ticks Receives the parsed time.
+   * @return false if the fields do not match the fixed layout.
+   */
+  static bool parse(std::span<const std::string_view, 1> fields,
+                    time_ticks &ticks) {
+    std::string_view text = fields[0];
+    if (text.size() < 19 || text[4] != '-' || text[7] != '-' ||
+        text[10] != ' ' || text[13] != ':' || text[16] != ':') {
+      return false;
+    }
+
+    // Gather the digits into "YYYYMMDD" and "HHMMSS00"
+    char digits[16] = {text[0],  text[1],  text[2],  text[3], text[5], text[6],
+                       text[8],  text[9],  text[11], text[12], text[14],
+                       text[15], text[17], text[18], '0',      '0'};
+    std::uint32_t date, clock;
+    std::int64_t fraction;
+    if (!time_parse_detail::parseEightDigits(digits, date) ||
+        !time_parse_detail::parseEightDigits(digits + 8, clock) ||
+        !time_parse_detail::parseFraction(text.substr(19), fraction)) {
+      return false;
+    }
+
+    return time_parse_detail::fieldsToTicks(
+        date / 10000, date / 100 % 100, date % 100, clock / 1000000,
+        clock / 10000 % 100, clock / 100 % 100, fraction, ticks);
+  }
+};
+
+/**
+ * @brief Parser for "YYMMDD" and "HHMMSS.ffff" columns.
+ */
+template <> struct TimeParser<CsvTimeFormat::twoColShort> {
+  /**
+   * @brief Names of the columns holding the time, in the order parsed.
+   */
+  static constexpr std::array<std::string_view, 2> columns = {"Day", "Time"};
+
+  /**
+   * @brief Parses the time fields of one row.
+   * @param fields The text of each column listed in columns.
+   * @param ticks Receives the parsed time.
+   * @return false if the fields do not match the fixed layout.
+   */
+  static bool parse(std::span<const std::string_view, 2> fields,
+                    time_ticks &ticks) {
+    std::string_view day = fields[0];
+    std::string_view time = fields[1];
+    // Boost also reads a time with no fraction, as whole seconds
+    if (day.size() != 6 || time.size() < 6) {
+      return false;
+    }
+
+    // Gather the digits into "YYMMDDHH" and "MMSS0000"
+    char digits[16] = {day[0],  day[1],  day[2],  day[3], day[4], day[5],
+                       time[0], time[1], time[2], time[3], time[4], time[5],
+                       '0',     '0',     '0',     '0'};
+    std::uint32_t date_hour, minute_second;
+    std::int64_t fraction;
+    if (!time_parse_detail::parseEightDigits(digits, date_hour) ||
+        !time_parse_detail::parseEightDigits(digits + 8, minute_second) ||
+        !time_parse_detail::parseFraction(time.substr(6), fraction)) {
+      return false;
+    }
+
+    return time_parse_detail::fieldsToTicks(
+        2000 + date_hour / 1000000, date_hour / 10000 % 100,
+        date_hour / 100 % 100, date_hour % 100, minute_second / 1000000,
+        minute_second / 10000 % 100, fraction, ticks);
+  }
+};
+
+/**
+ * @brief Parses the time fields of one row with the general Boost parsers.
+ * @details This is the reference behaviour the fast parsers must match.
+ * @param fields The text of each column listed in TimeParser::columns.
+ * @return The parsed time.
+ * @throws std::exception if Boost cannot parse the time.
+ */
+template <CsvTimeFormat Format>
+date_time
+parseTimeBoost(std::span<const std::string_view,
+                         TimeParser<Format>::columns.size()>
+                   fields) {
+  if constexpr (Format == CsvTimeFormat::oneColStandard) {
+    return parseTime(TimeFormat::standard, std::string(fields[0]));
+  } else {
+    std::string time(fields[1]);
+    return parseTime(TimeFormat::iso,
+                     "20" + std::string(fields[0]) + "T" +
+                         time.replace(6, 1, ","));
+  }
+}
+
+/**
+ * @brief Parses the time fields of one row, falling back to Boost for inputs
+ * the fast parser does not handle.
+ * @param fields The text of each column listed in TimeParser::columns.
+ * @return The parsed time in ticks.
+ * @throws std::exception if neither parser can parse the time.
+ */
+template <CsvTimeFormat Format>
+time_ticks
+parseTimeTicks(std::span<const std::string_view,
+                         TimeParser<Format>::columns.size()>
+                   fields) {
+  time_ticks ticks;
+  if (TimeParser<Format>::parse(fields, ticks)) {
+    return ticks;
+  }
+  return toTicks(parseTimeBoost<Format>(fields));
+}
+
+/**
+ * @brief Parses the times of many rows at once, for building time indices.
+ * @details Each row's fields are stored consecutively in `fields`, in the
+ * order of TimeParser::columns. Rows the fast parser rejects are parsed with
+ * Boost.
+ * @param fields The time fields of all rows.
+ * @param ticks Receives the time of each row, sized to the number of rows.
+ * @param validate If true, also parses every row with Boost and counts the
+ * rows where the two parsers disagree.
+ * @return The number of rows that needed the Boost fallback, or disagreed
+ * when validating.
+ */
+template <CsvTimeFormat Format>
+std::size_t parseTimeBatch(std::span<const std::string_view> fields,
+                           std::span<time_ticks> ticks,
+                           bool validate = false) {
+  constexpr std::size_t width = TimeParser<Format>::columns.size();
+  std::size_t count = 0;
+
+  for (std::size_t row = 0; row < ticks.size(); ++row) {
+    std::span<const std::string_view, width> row_fields(
+        fields.data() + row * width, width);
+
+    bool fast = TimeParser<Format>::parse(row_fields, ticks[row]);
+    if (!fast) {
+      ticks[row] = toTicks(parseTimeBoost<Format>(row_fields));
+      ++count;
+    } else if (validate &&
+               ticks[row] != toTicks(parseTimeBoost<Format>(row_fields))) {
+      ++count;
+    }
+  }
+
+  return count;
+}
+
+#endif // __TIMEPARSE_H__
@@ -0,0 +1,118 @@
+#include "TimeSegments.hpp"
+#include "../Utils/CivilTime.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+/**
+ * @brief Divides rounding toward positive infinity.
+ */
+time_ticks ceilDiv(time_ticks a, time_ticks b) { return -floorDiv(-a, b); }
+} // namespace
+
+std::shared_ptr<const TimeSegments>
+TimeSegments::build(const CsvTimeSnapshot &snapshot,
+                    std::shared_ptr<const TimeSegments> previous) {
+  auto result = std::make_shared<TimeSegments>();
+  result->size_ = snapshot.size();
+  CsvTimeCursor cursor = snapshot.cursor();
+
+  long from = 0;
+  if (previous && !previous->segments_.empty() &&
+      previous->size_ <= result->size_) {
+    // Rows appended since may continue the last segment, so it is detected
+    // again along with them
+    const TimeSegment &last = previous->segments_.back();
+    if (toTicks(cursor.timeOfRow(last.firstRow)) == last.start) {
+      result->segments_.assign(previous->segments_.begin(),
+                               std::prev(previous->segments_.end()));
+      from = last.firstRow;
+    }
+  }
+
+  if (from < result->size_) {
+    auto times = cursor.timesOfRows(from, result->size_);
+    auto found = detect(times, from);
+    result->segments_.insert(result->segments_.end(), found.begin(),
+                             found.end());
+  }
+  return result;
+}
+
+std::vector<TimeSegment>
+TimeSegments::detect(std::span<const time_ticks> times, long firstRow) {
+  std::vector<TimeSegment> segments;
+  const long count = static_cast<long>(times.size());
+
+  long first = 0;
+  while (first + 1 < count) {
+    const time_ticks step = times[first + 1] - times[first];
+    if (step <= 0) {
+      ++first;
+      continue;
+    }
+
+    // Extend the segment while rows stay near their nominal times
+    const time_ticks tolerance = step / 4;
+    time_ticks jitter = 0;
+    long row = first + 1;
+    for (; row < count && times[row] > times[row - 1]; ++row) {
+      time_ticks deviation =
+          times[row] - (times[first] + (row - first) * step);
+      deviation = deviation < 0 ? -deviation : deviation;
+      if (deviation > tolerance) {
+        break;
+      }
+      jitter = std::max(jitter, deviation);
+    }
+
+    if (row - first >= minRows) {
+      segments.push_back(
+          {firstRow + first, row - first, times[first], step, jitter});
+      first = row;
+    } else {
+      ++first;
+    }
+  }
+  return segments;
+}
+
+long TimeSegments::uniformRows() const {
+  long rows = 0;
+  for (const auto &segment : segments_) {
+    rows += segment.rows;
+  }
+  return rows;
+}
+
+std::pair<long, long> TimeSegments::window(time_ticks time) const {
+  // The first segment that does not end before the time
+  auto it = std::lower_bound(segments_.begin(), segments_.end(), time,
+                             [](const TimeSegment &segment, time_ticks time) {
+                               return segment.lastTime() + segment.jitter <
+                                      time;
+                             });
+  const long before_segment =
+      it == segments_.begin() ? 0 : std::prev(it)->endRow() - 1;
+  if (it == segments_.end()) {
+    return {before_segment, size_ - 1};
+  }
+  const long after_segment =
+      std::next(it) == segments_.end() ? size_ - 1 : std::next(it)->firstRow;
+
+  // Between segments only the irregular rows are left to search
+  const TimeSegment &segment = *it;
+  if (time <= segment.start - segment.jitter) {
+    return {before_segment, segment.firstRow};
+  }
+
+  // The last row surely before the time, and the first surely at or after it
+  const time_ticks offset = time - segment.start;
+  const time_ticks before =
+      floorDiv(offset - segment.jitter - 1, segment.step);
+  const time_ticks after = ceilDiv(offset + segment.jitter, segment.step);
+  return {before < 0 ? before_segment : segment.firstRow + long(before),
+          after >= segment.rows ? after_segment
+                                : segment.firstRow + long(after)};
+}
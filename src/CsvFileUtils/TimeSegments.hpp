@@ -0,0 +1,135 @@
+#ifndef __TIMESEGMENTS_H__
+#define __TIMESEGMENTS_H__
+
+#include "CsvTimeSnapshot.hpp"
+#include "TimeParse.hpp"
+
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief A run of rows sampled at a fixed rate.
+ *
+ * Row firstRow + k is within jitter of start + k * step.
+ */
+struct TimeSegment {
+  /**
+   * @brief The first row of the segment in the group.
+   */
+  long firstRow = 0;
+
+  /**
+   * @brief Number of rows in the segment.
+   */
+  long rows = 0;
+
+  /**
+   * @brief Time of the first row, as ticks since 1970-01-01.
+   */
+  time_ticks start = 0;
+
+  /**
+   * @brief Ticks between rows.
+   */
+  time_ticks step = 0;
+
+  /**
+   * @brief The largest distance of a row from its nominal time, in ticks.
+   */
+  time_ticks jitter = 0;
+
+  /**
+   * @brief Gets the row after the last row of the segment.
+   */
+  long endRow() const { return firstRow + rows; }
+
+  /**
+   * @brief Gets the nominal time of the last row.
+   */
+  time_ticks lastTime() const { return start + (rows - 1) * step; }
+};
+
+/**
+ * @brief The piecewise uniform segments of a time group's rows, for finding
+ * the rows around a time arithmetically instead of by search.
+ *
+ * Logged data is mostly written at a nominal rate, so long runs of rows have
+ * times start + k * step up to a small jitter. A lookup inside a segment
+ * computes the few rows that can enclose a time, and one between segments
+ * narrows the search to the irregular rows between them. CsvTimeCursor
+ * verifies the rows before using them, so bounds() gives the same rows
+ * either way.
+ *
+ * Segments are immutable once built and may be shared between threads.
+ */
+struct TimeSegments {
+private:
+  /**
+   * @brief Number of rows the segments were detected in.
+   */
+  long size_ = 0;
+
+  /**
+   * @brief The segments, in row order.
+   */
+  std::vector<TimeSegment> segments_;
+
+public:
+  /**
+   * @brief Fewest rows of a segment, shorter runs are searched.
+   */
+  static constexpr long minRows = 16;
+
+  /**
+   * @brief Detects the segments of a snapshot's rows.
+   * @param snapshot The rows to scan.
+   * @param previous Segments of an earlier snapshot of the same group, whose
+   * rows before its last segment are not scanned again, or nullptr.
+   * @return The segments.
+   */
+  static std::shared_ptr<const TimeSegments>
+  build(const CsvTimeSnapshot &snapshot,
+        std::shared_ptr<const TimeSegments> previous = nullptr);
+
+  /**
+   * @brief Detects the segments of a run of row times.
+   * @details A segment continues while each row is later than the one before
+   * and within a quarter step of its nominal time, the step being the
+   * spacing of the segment's first two rows.
+   * @param times The time of each row, as ticks since 1970-01-01.
+   * @param firstRow The row of the first time.
+   * @return The segments, in row order.
+   */
+  static std::vector<TimeSegment> detect(std::span<const time_ticks> times,
+                                         long firstRow = 0);
+
+  /**
+   * @brief Gets the number of rows the segments were detected in.
+   */
+  long size() const { return size_; }
+
+  /**
+   * @brief Gets the segments.
+   * @return The segments, in row order.
+   */
+  const std::vector<TimeSegment> &segments() const { return segments_; }
+
+  /**
+   * @brief Gets the number of rows inside segments.
+   */
+  long uniformRows() const;
+
+  /**
+   * @brief Narrows the rows that can enclose a time.
+   * @details If the row times are as detected, the first row at or after the
+   * time is in (first, last], and the time of first is before the time, or
+   * first is 0.
+   * @param time The time to look up, as ticks since 1970-01-01.
+   * @return The first and last candidate rows.
+   */
+  std::pair<long, long> window(time_ticks time) const;
+};
+
+#endif // __TIMESEGMENTS_H__
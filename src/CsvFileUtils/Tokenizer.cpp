@@ -0,0 +1,152 @@
+#include "Tokenizer.hpp"
+
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+
+namespace {
+/**
+ * @brief Checks whether a character is removed by trimming, matching
+ * std::isspace in the C locale.
+ */
+constexpr bool isTrim(char c) {
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+/**
+ * @brief Checks whether a line has quotes or escapes that need the quoted
+ * path, with memchr scanning many bytes per step.
+ */
+bool needsQuotedPath(std::string_view line) {
+  return std::memchr(line.data(), '"', line.size()) ||
+         std::memchr(line.data(), '\\', line.size());
+}
+} // namespace
+
+Tokenizer::Tokenizer(const std::string &delimiter, bool multiDelimiter)
+    : delimiter_(delimiter), multiDelimiter_(multiDelimiter) {
+  for (unsigned char c : delimiter_) {
+    isDelimiter_[c] = true;
+  }
+  mode_ = delimiter_.size() == 1 ? TokenizerMode::singleChar
+                                 : TokenizerMode::charSet;
+}
+
+std::size_t Tokenizer::findDelimiter(std::string_view line,
+                                     std::size_t pos) const {
+  switch (mode_) {
+  case TokenizerMode::singleChar: {
+    // memchr scans many bytes per step in the C library
+    const void *found =
+        std::memchr(line.data() + pos, delimiter_[0], line.size() - pos);
+    return found ? static_cast<const char *>(found) - line.data()
+                 : line.size();
+  }
+  default:
+    while (pos < line.size() &&
+           !isDelimiter_[static_cast<unsigned char>(line[pos])]) {
+      ++pos;
+    }
+    return pos;
+  }
+}
+
+void Tokenizer::addField(std::string_view field,
+                         std::vector<std::string_view> &fields) const {
+  while (!field.empty() && isTrim(field.front())) {
+    field.remove_prefix(1);
+  }
+  while (!field.empty() && isTrim(field.back())) {
+    field.remove_suffix(1);
+  }
+
+  if (multiDelimiter_ && field.empty()) {
+    return;
+  }
+  fields.push_back(field);
+}
+
+void Tokenizer::split(std::string_view line,
+                      std::vector<std::string_view> &fields,
+                      std::size_t maxFields) const {
+  fields.clear();
+  if (line.empty()) {
+    return;
+  }
+
+  if (needsQuotedPath(line)) {
+    splitQuoted(line, fields, maxFields);
+    return;
+  }
+
+  // Every delimiter ends a field, including a trailing one
+  std::size_t pos = 0;
+  while (fields.size() < maxFields) {
+    std::size_t end = findDelimiter(line, pos);
+    addField(line.substr(pos, end - pos), fields);
+    if (end == line.size()) {
+      break;
+    }
+    pos = end + 1;
+
+    // A run of delimiters only yields empty fields, which would be dropped
+    if (multiDelimiter_) {
+      while (pos < line.size() &&
+             isDelimiter_[static_cast<unsigned char>(line[pos])]) {
+        ++pos;
+      }
+    }
+  }
+}
+
+void Tokenizer::splitQuoted(std::string_view line,
+                            std::vector<std::string_view> &fields,
+                            std::size_t maxFields) const {
+  // Storage for the unescaped fields, a deque so earlier fields stay in place
+  // as more are added
+  thread_local std::deque<std::string> unescaped;
+  unescaped.clear();
+  std::string field;
+  bool in_quote = false;
+  bool in_escape = false;
+
+  for (char c : line) {
+    if (in_escape) {
+      switch (c) {
+      case '\\':
+      case '"':
+        field += c;
+        break;
+      case 'n':
+        field += '\n';
+        break;
+      default:
+        // An escaped delimiter is kept as part of the field
+        if (!isDelimiter_[static_cast<unsigned char>(c)]) {
+          throw std::runtime_error("Unknown escape sequence in line: " +
+                                   std::string(line));
+        }
+        field += c;
+      }
+      in_escape = false;
+    } else if (c == '\\') {
+      in_escape = true;
+    } else if (c == '"') {
+      in_quote = !in_quote;
+    } else if (!in_quote && isDelimiter_[static_cast<unsigned char>(c)]) {
+      addField(unescaped.emplace_back(std::move(field)), fields);
+      field.clear();
+      if (fields.size() >= maxFields) {
+        return;
+      }
+    } else {
+      field += c;
+    }
+  }
+
+  if (in_escape) {
+    throw std::runtime_error("Line ends with an escape character: " +
+                             std::string(line));
+  }
+  addField(unescaped.emplace_back(std::move(field)), fields);
+}
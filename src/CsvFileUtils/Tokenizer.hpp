@@ -0,0 +1,111 @@
+#ifndef __TOKENIZER_H__
+#define __TOKENIZER_H__
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief How a Tokenizer finds field boundaries, chosen from the delimiter.
+ */
+enum class TokenizerMode {
+  /**
+   * @brief A single delimiter character, located with memchr.
+   */
+  singleChar,
+
+  /**
+   * @brief Several delimiter characters, located with a lookup table.
+   */
+  charSet,
+};
+
+/**
+ * @brief Splits CSV lines into trimmed fields.
+ *
+ * Produces the same fields as boost::escaped_list_separator with a backslash
+ * escape and double quotes, followed by trimming each field and, with
+ * multiDelimiter, dropping empty fields. Lines without quotes or escapes are
+ * split in place and the fields are views into the line. Lines that need
+ * unescaping are copied into storage owned by the calling thread, so one
+ * tokenizer can split lines on any number of threads at once.
+ */
+struct Tokenizer {
+private:
+  /**
+   * @brief Characters separating fields.
+   */
+  std::string delimiter_;
+
+  /**
+   * @brief If true, empty fields are dropped so runs of delimiters act as one.
+   */
+  bool multiDelimiter_ = false;
+
+  /**
+   * @brief How field boundaries are found.
+   */
+  TokenizerMode mode_ = TokenizerMode::charSet;
+
+  /**
+   * @brief Lookup table of delimiter characters.
+   */
+  std::array<bool, 256> isDelimiter_{};
+
+  /**
+   * @brief Finds the next delimiter at or after pos.
+   * @return The position of the delimiter, or line.size() if there is none.
+   */
+  std::size_t findDelimiter(std::string_view line, std::size_t pos) const;
+
+  /**
+   * @brief Adds a field to the output, trimming it and dropping it if empty
+   * with multiDelimiter.
+   */
+  void addField(std::string_view field,
+                std::vector<std::string_view> &fields) const;
+
+  /**
+   * @brief Splits a line containing quotes or escapes.
+   */
+  void splitQuoted(std::string_view line, std::vector<std::string_view> &fields,
+                   std::size_t maxFields) const;
+
+public:
+  /**
+   * @brief Default constructor, splitting on commas.
+   */
+  Tokenizer() : Tokenizer(",", false) {}
+
+  /**
+   * @brief Construct a tokenizer for a delimiter configuration.
+   * @param delimiter Characters separating fields, any one of them ends a
+   * field.
+   * @param multiDelimiter If true, empty fields are dropped.
+   */
+  Tokenizer(const std::string &delimiter, bool multiDelimiter);
+
+  /**
+   * @brief Splits a line into fields.
+   * @param line The line to split.
+   * @param fields Cleared, then receives the fields. Views are into the line,
+   * or into thread local storage for unescaped fields, and stay valid until
+   * the next call on the same thread.
+   * @param maxFields Stop once this many fields have been found.
+   * @throws std::runtime_error if the line has an invalid escape sequence.
+   */
+  void split(std::string_view line, std::vector<std::string_view> &fields,
+             std::size_t maxFields = std::numeric_limits<std::size_t>::max())
+      const;
+
+  /**
+   * @brief Gets how field boundaries are found.
+   * @return The tokenizer mode.
+   */
+  TokenizerMode mode() const { return mode_; }
+};
+
+#endif // __TOKENIZER_H__
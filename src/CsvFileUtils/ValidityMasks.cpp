@@ -0,0 +1,360 @@
+#include "ValidityMasks.hpp"
+#include "ArchiveCodec.hpp"
+#include "AtomicFile.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+/**
+ * @brief Identifies a saved set of masks.
+ */
+constexpr std::uint64_t masksMagic = 0x00534b53414d4b54; // "TKMASKS"
+constexpr std::uint32_t masksVersion = 1;
+
+/**
+ * @brief Gets the path the masks of a data file are saved to.
+ */
+std::string masksPath(const std::string &dataPath) {
+  return dataPath + ".masks";
+}
+
+using archive_codec::get;
+using archive_codec::getString;
+using archive_codec::put;
+using archive_codec::putString;
+} // namespace
+
+RowMask::RowMask(long size, bool value)
+    : size_(size), words_((size + 63) / 64, value ? ~std::uint64_t(0) : 0) {
+  clearTail();
+}
+
+void RowMask::clearTail() {
+  if (size_ % 64 != 0) {
+    words_.back() &= (std::uint64_t(1) << (size_ % 64)) - 1;
+  }
+}
+
+void RowMask::checkSize(const RowMask &other) const {
+  if (other.size_ != size_) {
+    throw std::invalid_argument("Masks cover " + std::to_string(size_) +
+                                " and " + std::to_string(other.size_) +
+                                " rows");
+  }
+}
+
+std::uint64_t RowMask::rangeBits(std::size_t word, long first, long last) {
+  long start = long(word * 64);
+  std::uint64_t bits = ~std::uint64_t(0);
+  if (first > start) {
+    bits &= ~std::uint64_t(0) << (first - start);
+  }
+  if (last < start + 64) {
+    bits &= (std::uint64_t(1) << (last - start)) - 1;
+  }
+  return bits;
+}
+
+RowMask RowMask::fromRuns(long size,
+                          std::span<const std::pair<long, long>> runs) {
+  RowMask mask(size);
+  for (const auto &[first, last] : runs) {
+    mask.setRange(first, last);
+  }
+  return mask;
+}
+
+void RowMask::resize(long size, bool value) {
+  long old_size = size_;
+  size_ = size;
+  words_.resize((size + 63) / 64, 0);
+  if (value && size > old_size) {
+    setRange(old_size, size);
+  }
+  clearTail();
+}
+
+bool RowMask::test(long row) const {
+  if (row < 0 || row >= size_) {
+    throw std::out_of_range("Row index out of range");
+  }
+  return words_[row / 64] >> (row % 64) & 1;
+}
+
+void RowMask::set(long row, bool value) {
+  if (row < 0 || row >= size_) {
+    throw std::out_of_range("Row index out of range");
+  }
+  std::uint64_t bit = std::uint64_t(1) << (row % 64);
+  words_[row / 64] = value ? words_[row / 64] | bit : words_[row / 64] & ~bit;
+}
+
+void RowMask::setRange(long first, long last, bool value) {
+  if (first < 0 || last > size_ || first > last) {
+    throw std::out_of_range("Row range out of range");
+  }
+  if (first == last) {
+    return;
+  }
+  for (std::size_t word = first / 64; word <= std::size_t(last - 1) / 64;
+       ++word) {
+    std::uint64_t bits = rangeBits(word, first, last);
+    words_[word] = value ? words_[word] | bits : words_[word] & ~bits;
+  }
+}
+
+long RowMask::count() const {
+  long total = 0;
+  for (std::uint64_t word : words_) {
+    total += std::popcount(word);
+  }
+  return total;
+}
+
+long RowMask::count(long first, long last) const {
+  if (first < 0 || last > size_ || first > last) {
+    throw std::out_of_range("Row range out of range");
+  }
+  long total = 0;
+  if (first == last) {
+    return total;
+  }
+  for (std::size_t word = first / 64; word <= std::size_t(last - 1) / 64;
+       ++word) {
+    total += std::popcount(words_[word] & rangeBits(word, first, last));
+  }
+  return total;
+}
+
+bool RowMask::any() const {
+  return std::any_of(words_.begin(), words_.end(),
+                     [](std::uint64_t word) { return word != 0; });
+}
+
+RowMask &RowMask::operator&=(const RowMask &other) {
+  checkSize(other);
+  for (std::size_t i = 0; i < words_.size(); ++i) {
+    words_[i] &= other.words_[i];
+  }
+  return *this;
+}
+
+RowMask &RowMask::operator|=(const RowMask &other) {
+  checkSize(other);
+  for (std::size_t i = 0; i < words_.size(); ++i) {
+    words_[i] |= other.words_[i];
+  }
+  return *this;
+}
+
+RowMask &RowMask::operator^=(const RowMask &other) {
+  checkSize(other);
+  for (std::size_t i = 0; i < words_.size(); ++i) {
+    words_[i] ^= other.words_[i];
+  }
+  return *this;
+}
+
+RowMask &RowMask::andNot(const RowMask &other) {
+  checkSize(other);
+  for (std::size_t i = 0; i < words_.size(); ++i) {
+    words_[i] &= ~other.words_[i];
+  }
+  return *this;
+}
+
+RowMask RowMask::operator~() const {
+  RowMask result = *this;
+  for (auto &word : result.words_) {
+    word = ~word;
+  }
+  result.clearTail();
+  return result;
+}
+
+RowMask RowMask::pairs() const {
+  RowMask result = *this;
+  for (std::size_t i = 0; i < words_.size(); ++i) {
+    // Bring the next row of every bit into its place, carrying the first
+    // row of the next word into the top bit
+    std::uint64_t next = words_[i] >> 1;
+    if (i + 1 < words_.size()) {
+      next |= words_[i + 1] << 63;
+    }
+    result.words_[i] &= next;
+  }
+  return result;
+}
+
+std::vector<std::pair<long, long>> RowMask::runs() const {
+  std::vector<std::pair<long, long>> result;
+  long row = 0;
+  while (row < size_) {
+    // Skip to the next set row, then to the next clear row, a word at a time
+    std::size_t word = row / 64;
+    std::uint64_t bits = words_[word] & (~std::uint64_t(0) << (row % 64));
+    while (bits == 0 && ++word < words_.size()) {
+      bits = words_[word];
+    }
+    if (bits == 0) {
+      break;
+    }
+    long first = long(word * 64) + std::countr_zero(bits);
+
+    bits = ~words_[word] & (~std::uint64_t(0) << (first % 64));
+    while (bits == 0 && ++word < words_.size()) {
+      bits = ~words_[word];
+    }
+    row = bits == 0 ? size_
+                    : std::min(size_, long(word * 64) + std::countr_zero(bits));
+    result.emplace_back(first, row);
+  }
+  return result;
+}
+
+RowMask timeGaps(std::span<const time_ticks> times, time_delt limit) {
+  RowMask gaps(times.size());
+  const time_ticks limit_ticks = limit.ticks();
+  for (std::size_t word = 0; word * 64 < times.size(); ++word) {
+    // Build each word from comparisons rather than setting rows one by one
+    std::uint64_t bits = 0;
+    std::size_t end = std::min(times.size(), word * 64 + 64);
+    for (std::size_t row = std::max<std::size_t>(word * 64, 1); row < end;
+         ++row) {
+      bits |= std::uint64_t(times[row] - times[row - 1] > limit_ticks)
+              << (row % 64);
+    }
+    gaps.words_[word] = bits;
+  }
+  return gaps;
+}
+
+ValidityMasks ValidityMasks::load(CsvGroupSnapshot group) {
+  ValidityMasks masks(std::move(group));
+  const CsvGroupSnapshot &rows = masks.group_;
+
+  for (long f = 0; f < rows.fileCount(); ++f) {
+    std::string path = masksPath(rows.metadata().dataPaths()[f]);
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+      continue;
+    }
+    std::string data((std::istreambuf_iterator<char>(file)),
+                     std::istreambuf_iterator<char>());
+
+    std::size_t position = 0;
+    if (get<std::uint64_t>(data, position) != masksMagic ||
+        get<std::uint32_t>(data, position) != masksVersion) {
+      throw std::runtime_error(path + " is not a mask file");
+    }
+    // Appending keeps the saved rows, any other change to the file means
+    // the marks are for rows that are gone
+    auto [first, last] = rows.fileRows(f);
+    auto saved_rows = long(get<std::uint64_t>(data, position));
+    std::string last_line = getString(data, position);
+    if (saved_rows > last - first ||
+        (saved_rows > 0 &&
+         rows.getRawLine(first + saved_rows - 1) != last_line)) {
+      throw std::runtime_error(path + " was saved for " +
+                               std::to_string(saved_rows) +
+                               " rows that no longer match its data file");
+    }
+
+    auto count = get<std::uint16_t>(data, position);
+    for (std::uint16_t m = 0; m < count; ++m) {
+      RowMask &mask = masks.mask(getString(data, position));
+
+      // Runs are the gap since the previous run and the run's length
+      auto runs = archive_codec::getVarint(data, position);
+      long row = 0;
+      for (decltype(runs) r = 0; r < runs; ++r) {
+        row += long(archive_codec::getVarint(data, position));
+        long end = row + long(archive_codec::getVarint(data, position));
+        if (row < 0 || end < row || end > saved_rows) {
+          throw std::runtime_error(path + " has a run past its rows");
+        }
+        mask.setRange(first + row, first + end);
+        row = end;
+      }
+    }
+  }
+  return masks;
+}
+
+void ValidityMasks::save() const {
+  for (long f = 0; f < group_.fileCount(); ++f) {
+    std::string path = masksPath(group_.metadata().dataPaths()[f]);
+    auto [first, last] = group_.fileRows(f);
+
+    bool marked = false;
+    std::string data;
+    put(data, masksMagic);
+    put(data, masksVersion);
+    put(data, static_cast<std::uint64_t>(last - first));
+    putString(data, last > first ? group_.getRawLine(last - 1) : "");
+    put(data, static_cast<std::uint16_t>(masks_.size()));
+    for (const auto &[name, mask] : masks_) {
+      putString(data, name);
+
+      RowMask rows(last - first);
+      mask.forEach(first, last, [&](long row) { rows.set(row - first); });
+      auto runs = rows.runs();
+      marked = marked || !runs.empty();
+      archive_codec::putVarint(data, runs.size());
+      long row = 0;
+      for (const auto &[run_first, run_last] : runs) {
+        archive_codec::putVarint(data, run_first - row);
+        archive_codec::putVarint(data, run_last - run_first);
+        row = run_last;
+      }
+    }
+
+    // Files nothing was ever marked in get no mask file
+    if (!marked && !std::filesystem::exists(path)) {
+      continue;
+    }
+
+    AtomicFile file(path);
+    file.write(data);
+    file.commit();
+  }
+}
+
+std::vector<std::string> ValidityMasks::names() const {
+  std::vector<std::string> result;
+  for (const auto &[name, mask] : masks_) {
+    result.push_back(name);
+  }
+  return result;
+}
+
+RowMask &ValidityMasks::mask(const std::string &name) {
+  auto it = masks_.find(name);
+  if (it == masks_.end()) {
+    it = masks_.emplace(name, RowMask(group_.size())).first;
+  }
+  return it->second;
+}
+
+const RowMask &ValidityMasks::mask(const std::string &name) const {
+  auto it = masks_.find(name);
+  if (it == masks_.end()) {
+    throw std::out_of_range("No mask named '" + name + "'");
+  }
+  return it->second;
+}
+
+RowMask ValidityMasks::excluded(const std::vector<std::string> &names) const {
+  RowMask result(group_.size());
+  for (const auto &[name, mask] : masks_) {
+    if (names.empty() ||
+        std::find(names.begin(), names.end(), name) != names.end()) {
+      result |= mask;
+    }
+  }
+  return result;
+}
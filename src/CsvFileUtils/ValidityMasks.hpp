@@ -0,0 +1,389 @@
+#ifndef __VALIDITYMASKS_H__
+#define __VALIDITYMASKS_H__
+
+#include "CsvGroupSnapshot.hpp"
+#include "TimeParse.hpp"
+
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief A set of rows, one bit per row.
+ *
+ * Masks combine a word of 64 rows at a time, and iteration jumps from set bit
+ * to set bit, so consumers skip excluded rows without a branch per row. Bits
+ * past size() are always clear.
+ */
+struct RowMask {
+private:
+  /**
+   * @brief Number of rows covered.
+   */
+  long size_ = 0;
+
+  /**
+   * @brief The bits, row r in bit r % 64 of word r / 64.
+   */
+  std::vector<std::uint64_t> words_;
+
+  /**
+   * @brief Clears the bits past size() in the last word.
+   */
+  void clearTail();
+
+  /**
+   * @brief Checks that another mask covers the same rows.
+   * @throws std::invalid_argument if the sizes differ.
+   */
+  void checkSize(const RowMask &other) const;
+
+  /**
+   * @brief Gets the bits of a word that fall in a row range.
+   */
+  static std::uint64_t rangeBits(std::size_t word, long first, long last);
+
+  friend RowMask timeGaps(std::span<const time_ticks> times, time_delt limit);
+
+public:
+  /**
+   * @brief Default constructor for a mask of no rows.
+   */
+  RowMask() = default;
+
+  /**
+   * @brief Construct a mask of the given rows.
+   * @param size Number of rows covered.
+   * @param value Whether every row starts set.
+   */
+  explicit RowMask(long size, bool value = false);
+
+  /**
+   * @brief Construct a mask from runs of set rows, such as the result of
+   * ZoneMap::query.
+   * @param size Number of rows covered.
+   * @param runs The first row and one past the last row of each run.
+   * @throws std::out_of_range if a run is outside the mask.
+   */
+  static RowMask fromRuns(long size,
+                          std::span<const std::pair<long, long>> runs);
+
+  /**
+   * @brief Gets the number of rows covered.
+   */
+  long size() const { return size_; }
+
+  /**
+   * @brief Gets the bits, 64 rows per word.
+   */
+  std::span<const std::uint64_t> words() const { return words_; }
+
+  /**
+   * @brief Changes the number of rows covered.
+   * @param size Number of rows covered.
+   * @param value Whether added rows are set.
+   */
+  void resize(long size, bool value = false);
+
+  /**
+   * @brief Checks whether a row is set.
+   * @throws std::out_of_range if the row is outside the mask.
+   */
+  bool test(long row) const;
+
+  /**
+   * @brief Sets or clears a row.
+   * @throws std::out_of_range if the row is outside the mask.
+   */
+  void set(long row, bool value = true);
+
+  /**
+   * @brief Sets or clears a range of rows.
+   * @param first The first row.
+   * @param last One past the last row.
+   * @param value Whether to set the rows.
+   * @throws std::out_of_range if the range is outside the mask.
+   */
+  void setRange(long first, long last, bool value = true);
+
+  /**
+   * @brief Counts the set rows.
+   */
+  long count() const;
+
+  /**
+   * @brief Counts the set rows in a range.
+   * @param first The first row.
+   * @param last One past the last row.
+   * @throws std::out_of_range if the range is outside the mask.
+   */
+  long count(long first, long last) const;
+
+  /**
+   * @brief Checks whether any row is set.
+   */
+  bool any() const;
+
+  /**
+   * @brief Keeps the rows set in both masks.
+   * @throws std::invalid_argument if the sizes differ.
+   */
+  RowMask &operator&=(const RowMask &other);
+
+  /**
+   * @brief Adds the rows set in the other mask.
+   * @throws std::invalid_argument if the sizes differ.
+   */
+  RowMask &operator|=(const RowMask &other);
+
+  /**
+   * @brief Keeps the rows set in exactly one of the masks.
+   * @throws std::invalid_argument if the sizes differ.
+   */
+  RowMask &operator^=(const RowMask &other);
+
+  /**
+   * @brief Removes the rows set in the other mask.
+   * @throws std::invalid_argument if the sizes differ.
+   */
+  RowMask &andNot(const RowMask &other);
+
+  /**
+   * @brief Gets the rows not set.
+   */
+  RowMask operator~() const;
+
+  friend RowMask operator&(RowMask a, const RowMask &b) { return a &= b; }
+
+  friend RowMask operator|(RowMask a, const RowMask &b) { return a |= b; }
+
+  friend RowMask operator^(RowMask a, const RowMask &b) { return a ^= b; }
+
+  bool operator==(const RowMask &other) const = default;
+
+  /**
+   * @brief Gets the rows set together with the row after them, the intervals
+   * an integral over valid rows may use.
+   */
+  RowMask pairs() const;
+
+  /**
+   * @brief Gets the runs of set rows.
+   * @return The first row and one past the last row of each run, in order.
+   */
+  std::vector<std::pair<long, long>> runs() const;
+
+  /**
+   * @brief Calls func(row) for every set row in a range, in order.
+   * @param first The first row.
+   * @param last One past the last row.
+   * @param func The function to call.
+   * @throws std::out_of_range if a non-empty range is outside the mask.
+   */
+  template <typename Func>
+  void forEach(long first, long last, Func &&func) const {
+    if (first >= last) {
+      return;
+    }
+    if (first < 0 || last > size_) {
+      throw std::out_of_range("Row range out of range");
+    }
+    for (std::size_t word = first / 64; word <= std::size_t(last - 1) / 64;
+         ++word) {
+      std::uint64_t bits = words_[word] & rangeBits(word, first, last);
+      while (bits != 0) {
+        func(long(word * 64) + std::countr_zero(bits));
+        bits &= bits - 1;
+      }
+    }
+  }
+
+  /**
+   * @brief Calls func(row) for every set row, in order.
+   */
+  template <typename Func> void forEach(Func &&func) const {
+    forEach(0, size_, std::forward<Func>(func));
+  }
+};
+
+/**
+ * @brief Sums the values of the set rows.
+ * @param mask The rows to include.
+ * @param values The value of each row from first on.
+ * @param first The row of the first value.
+ * @return The sum of the values of the set rows.
+ * @throws std::out_of_range if the values run outside the mask.
+ */
+template <typename T>
+T maskedSum(const RowMask &mask, std::span<const T> values, long first = 0) {
+  T sum = 0;
+  mask.forEach(first, first + long(values.size()),
+               [&](long row) { sum += values[row - first]; });
+  return sum;
+}
+
+/**
+ * @brief Averages the values of the set rows.
+ * @param mask The rows to include.
+ * @param values The value of each row from first on.
+ * @param first The row of the first value.
+ * @return The mean of the values of the set rows, NaN if there are none.
+ * @throws std::out_of_range if the values run outside the mask.
+ */
+template <typename T>
+T maskedMean(const RowMask &mask, std::span<const T> values, long first = 0) {
+  long count = mask.count(first, first + long(values.size()));
+  if (count == 0) {
+    return T(std::numeric_limits<double>::quiet_NaN());
+  }
+  return maskedSum(mask, values, first) / count;
+}
+
+/**
+ * @brief Integrates values over time with the trapezoid rule, using only the
+ * intervals between consecutive set rows.
+ * @param mask The rows to include.
+ * @param times The time of each row from first on, as ticks since 1970-01-01.
+ * @param values The value of each row from first on.
+ * @param first The row of the first value.
+ * @return The integral in value seconds.
+ * @throws std::invalid_argument if there are fewer times than values.
+ * @throws std::out_of_range if the values run outside the mask.
+ */
+template <typename T>
+T maskedIntegral(const RowMask &mask, std::span<const time_ticks> times,
+                 std::span<const T> values, long first = 0) {
+  if (times.size() < values.size()) {
+    throw std::invalid_argument("Fewer times than values");
+  }
+  const T ticks_per_second = time_delt::ticks_per_second();
+  T integral = 0;
+  mask.pairs().forEach(first, first + long(values.size()) - 1, [&](long row) {
+    long i = row - first;
+    integral += T(times[i + 1] - times[i]) * (values[i] + values[i + 1]) / 2;
+  });
+  return integral / ticks_per_second;
+}
+
+/**
+ * @brief Marks the rows that follow a gap in the times.
+ * @param times The time of each row, as ticks since 1970-01-01.
+ * @param limit The longest step between rows that is not a gap.
+ * @return A mask with the row after each gap set.
+ */
+RowMask timeGaps(std::span<const time_ticks> times, time_delt limit);
+
+/**
+ * @brief Named masks of rows to exclude from a group, such as "outliers",
+ * "gaps" and "manual".
+ *
+ * Consumers combine the masks they care about with valid() and skip the
+ * excluded rows through the RowMask helpers, instead of each repeating the
+ * decisions. The masks of each data file are saved next to it as
+ * "<file>.masks", as runs of excluded rows, so rows keep their marks when
+ * files are added to the group or grow.
+ */
+struct ValidityMasks {
+private:
+  /**
+   * @brief The rows the masks cover.
+   */
+  CsvGroupSnapshot group_;
+
+  /**
+   * @brief The masks by name, each covering every row of the group.
+   */
+  std::map<std::string, RowMask> masks_;
+
+public:
+  /**
+   * @brief Default constructor for masks of no rows.
+   */
+  ValidityMasks() = default;
+
+  /**
+   * @brief Construct empty masks for a group.
+   * @param group The rows the masks cover.
+   */
+  explicit ValidityMasks(CsvGroupSnapshot group) : group_(std::move(group)) {}
+
+  /**
+   * @brief Reads the saved masks of a group's files.
+   * @details Rows added since the masks were saved are not excluded. A file
+   * that has fewer rows than its masks were saved for, or whose last saved
+   * row reads differently, was rewritten and its masks are rejected.
+   * @param group The rows the masks cover.
+   * @return The masks.
+   * @throws std::runtime_error if a saved file is damaged or its masks no
+   * longer match the rows of its data file.
+   */
+  static ValidityMasks load(CsvGroupSnapshot group);
+
+  /**
+   * @brief Saves the masks next to each data file that has marked rows or
+   * saved masks.
+   * @throws std::runtime_error if a file cannot be written.
+   */
+  void save() const;
+
+  /**
+   * @brief Gets the rows the masks cover.
+   */
+  const CsvGroupSnapshot &group() const { return group_; }
+
+  /**
+   * @brief Gets the names of the masks.
+   */
+  std::vector<std::string> names() const;
+
+  /**
+   * @brief Checks whether a mask exists.
+   */
+  bool contains(const std::string &name) const {
+    return masks_.contains(name);
+  }
+
+  /**
+   * @brief Gets a mask, creating it with no rows set if it does not exist.
+   * @param name The name of the mask.
+   * @return The mask, covering every row of the group.
+   */
+  RowMask &mask(const std::string &name);
+
+  /**
+   * @brief Gets a mask.
+   * @param name The name of the mask.
+   * @return The mask, covering every row of the group.
+   * @throws std::out_of_range if the mask does not exist.
+   */
+  const RowMask &mask(const std::string &name) const;
+
+  /**
+   * @brief Removes a mask, its rows are no longer excluded once saved.
+   */
+  void remove(const std::string &name) { masks_.erase(name); }
+
+  /**
+   * @brief Gets the rows excluded by any of the given masks.
+   * @param names The masks to combine, every mask if empty. Missing masks
+   * exclude nothing.
+   */
+  RowMask excluded(const std::vector<std::string> &names = {}) const;
+
+  /**
+   * @brief Gets the rows no given mask excludes.
+   * @param names The masks to combine, every mask if empty. Missing masks
+   * exclude nothing.
+   */
+  RowMask valid(const std::vector<std::string> &names = {}) const {
+    return ~excluded(names);
+  }
+};
+
+#endif // __VALIDITYMASKS_H__
@@ -0,0 +1,522 @@
+#include "ZoneMap.hpp"
+#include "ArchiveCodec.hpp"
+#include "AtomicFile.hpp"
+#include "../Utils/FieldParse.hpp"
+#include "../Utils/LineChunks.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <stdexcept>
+
+#include <sys/stat.h>
+
+namespace {
+/**
+ * @brief Identifies a saved zone map.
+ */
+constexpr std::uint64_t zonesMagic = 0x0053454e4f5a4b54; // "TKZONES"
+constexpr std::uint32_t zonesVersion = 1;
+
+using archive_codec::get;
+using archive_codec::getString;
+using archive_codec::put;
+using archive_codec::putString;
+
+/**
+ * @brief Gets the path blocks of a data file are saved to.
+ */
+std::string zonesPath(const std::string &dataPath) {
+  return dataPath + ".zones";
+}
+
+/**
+ * @brief Gets the identity of a data file as it is now.
+ * @return A zero stamp if the file cannot be read.
+ */
+ZoneStamp stampOf(const std::string &path) {
+  ZoneStamp stamp;
+  struct stat file_stat;
+  if (::stat(path.c_str(), &file_stat) == 0) {
+    stamp.inode = file_stat.st_ino;
+    stamp.size = file_stat.st_size;
+    stamp.modified = std::int64_t(file_stat.st_mtim.tv_sec) * 1000000000 +
+                     file_stat.st_mtim.tv_nsec;
+  }
+  return stamp;
+}
+
+/**
+ * @brief Parses a field into a double, falling back to the quad parser for
+ * text from_chars does not accept.
+ * @return false if the field is not a number.
+ */
+bool parseBound(std::string_view field, double &value) {
+  if (parseField(field, value)) {
+    return true;
+  }
+  quad exact;
+  if (!parseField(field, exact)) {
+    return false;
+  }
+  value = static_cast<double>(exact);
+  return true;
+}
+
+/**
+ * @brief Computes the statistics of a range of rows.
+ * @param cursor A cursor of the worker computing the block.
+ * @param projection The indexed columns.
+ * @param columns The number of indexed columns.
+ * @param first The first row of the block.
+ * @param last One past the last row of the block.
+ */
+ZoneBlock summarize(CsvTimeCursor &cursor, const Projection &projection,
+                    std::size_t columns, long first, long last) {
+  constexpr double infinity = std::numeric_limits<double>::infinity();
+
+  ZoneBlock block;
+  block.firstRow = first;
+  block.rows = last - first;
+  block.min.assign(columns, infinity);
+  block.max.assign(columns, -infinity);
+  block.sum.assign(columns, 0);
+  block.count.assign(columns, 0);
+
+  std::vector<time_ticks> times = cursor.timesOfRows(first, last);
+  auto [earliest, latest] = std::minmax_element(times.begin(), times.end());
+  block.minTime = *earliest;
+  block.maxTime = *latest;
+
+  std::vector<long> rows(last - first);
+  std::iota(rows.begin(), rows.end(), first);
+  std::vector<std::string> lines = cursor.group().readRows(rows);
+
+  std::vector<std::string_view> fields;
+  for (const auto &line : lines) {
+    cursor.group().splitFields(line, projection, fields);
+    for (std::size_t column = 0; column < columns; ++column) {
+      double value;
+      if (!parseBound(fields[column], value) || std::isnan(value)) {
+        continue;
+      }
+      block.min[column] = std::min(block.min[column], value);
+      block.max[column] = std::max(block.max[column], value);
+      block.sum[column] += value;
+      ++block.count[column];
+    }
+  }
+
+  for (std::size_t column = 0; column < columns; ++column) {
+    if (block.count[column] == 0) {
+      block.min[column] = std::numeric_limits<double>::quiet_NaN();
+      block.max[column] = std::numeric_limits<double>::quiet_NaN();
+    } else {
+      // The parsed doubles are within an ulp of the quads read by queries
+      block.min[column] = std::nextafter(block.min[column], -infinity);
+      block.max[column] = std::nextafter(block.max[column], infinity);
+    }
+  }
+  return block;
+}
+
+/**
+ * @brief Runs func(worker, task) for every task, spread over workers, and
+ * rethrows the first exception a worker threw.
+ * @param tasks The number of tasks.
+ * @param threads The requested number of workers, 0 for one per core.
+ * @param func The task, called with the worker and task index.
+ */
+template <typename Func>
+void forEachTask(std::size_t tasks, long threads, Func &&func) {
+  std::size_t workers = std::min(workerCount(threads), tasks);
+  if (workers == 0) {
+    return;
+  }
+
+  std::vector<std::exception_ptr> errors(workers);
+  parallelFor(workers, [&](std::size_t worker) {
+    try {
+      for (std::size_t task = worker; task < tasks; task += workers) {
+        func(worker, task);
+      }
+    } catch (...) {
+      errors[worker] = std::current_exception();
+    }
+  });
+  for (const auto &error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+} // namespace
+
+bool ZoneMap::load(FileZones &file) const {
+  std::ifstream in(zonesPath(file.path), std::ios::binary);
+  if (!in.is_open()) {
+    return false;
+  }
+  std::string data((std::istreambuf_iterator<char>(in)),
+                   std::istreambuf_iterator<char>());
+
+  try {
+    std::size_t position = 0;
+    if (get<std::uint64_t>(data, position) != zonesMagic ||
+        get<std::uint32_t>(data, position) != zonesVersion ||
+        long(get<std::uint32_t>(data, position)) != blockRows_ ||
+        get<std::uint16_t>(data, position) != columns_.size()) {
+      return false;
+    }
+    for (const auto &name : columns_) {
+      if (getString(data, position) != name) {
+        return false;
+      }
+    }
+
+    FileZones loaded;
+    loaded.path = file.path;
+    loaded.stamp.inode = get<std::uint64_t>(data, position);
+    loaded.stamp.size = get<std::uint64_t>(data, position);
+    loaded.stamp.modified = get<std::int64_t>(data, position);
+    loaded.firstLine = getString(data, position);
+    loaded.lastLine = getString(data, position);
+
+    auto blocks = get<std::uint64_t>(data, position);
+    long row = 0;
+    for (std::uint64_t b = 0; b < blocks; ++b) {
+      ZoneBlock block;
+      block.firstRow = row;
+      block.rows = get<std::uint32_t>(data, position);
+      block.minTime = get<time_ticks>(data, position);
+      block.maxTime = get<time_ticks>(data, position);
+      row += block.rows;
+      for (std::size_t column = 0; column < columns_.size(); ++column) {
+        block.min.push_back(get<double>(data, position));
+        block.max.push_back(get<double>(data, position));
+        block.sum.push_back(get<double>(data, position));
+        block.count.push_back(get<std::int64_t>(data, position));
+      }
+      loaded.blocks.push_back(std::move(block));
+    }
+    file = std::move(loaded);
+  } catch (const std::runtime_error &) {
+    // Truncated or not a zone map file, the blocks are summarized again
+    return false;
+  }
+  return true;
+}
+
+void ZoneMap::save(const FileZones &file) const {
+  std::string data;
+  put(data, zonesMagic);
+  put(data, zonesVersion);
+  put(data, static_cast<std::uint32_t>(blockRows_));
+  put(data, static_cast<std::uint16_t>(columns_.size()));
+  for (const auto &name : columns_) {
+    putString(data, name);
+  }
+  put(data, file.stamp.inode);
+  put(data, file.stamp.size);
+  put(data, file.stamp.modified);
+  putString(data, file.firstLine);
+  putString(data, file.lastLine);
+  put(data, static_cast<std::uint64_t>(file.blocks.size()));
+  for (const auto &block : file.blocks) {
+    put(data, static_cast<std::uint32_t>(block.rows));
+    put(data, block.minTime);
+    put(data, block.maxTime);
+    for (std::size_t column = 0; column < columns_.size(); ++column) {
+      put(data, block.min[column]);
+      put(data, block.max[column]);
+      put(data, block.sum[column]);
+      put(data, static_cast<std::int64_t>(block.count[column]));
+    }
+  }
+
+  AtomicFile out(zonesPath(file.path));
+  out.write(data);
+  out.commit();
+}
+
+bool ZoneMap::current(const FileZones &file, const ZoneStamp &stamp,
+                      const CsvGroupSnapshot &group, long first,
+                      long last) const {
+  if (file.blocks.empty()) {
+    return true;
+  }
+  if (file.rows() > last - first) {
+    return false;
+  }
+  if (file.stamp == stamp) {
+    return true;
+  }
+
+  // Appending rows changes the size and time of a file but leaves the rows
+  // the blocks cover as they were, check the first and last of those
+  return stamp.inode == file.stamp.inode && stamp.size > file.stamp.size &&
+         group.getRawLine(first) == file.firstLine &&
+         group.getRawLine(first + file.rows() - 1) == file.lastLine;
+}
+
+std::shared_ptr<const ZoneMap>
+ZoneMap::build(const CsvTimeSnapshot &snapshot,
+               std::vector<std::string> columns,
+               std::shared_ptr<const ZoneMap> previous, bool ignoreCache,
+               long blockRows, long threads) {
+  auto map = std::make_shared<ZoneMap>();
+  map->snapshot_ = snapshot;
+  map->columns_ = std::move(columns);
+  map->blockRows_ = std::max(1L, blockRows);
+
+  const CsvGroupSnapshot &group = snapshot.group();
+  Projection projection = group.project(map->columns_);
+
+  // Files already indexed by the previous map skip reading their saved blocks
+  std::map<std::string, const FileZones *> indexed;
+  if (previous && !ignoreCache && previous->columns_ == map->columns_ &&
+      previous->blockRows_ == map->blockRows_) {
+    for (const auto &file : previous->files_) {
+      indexed[file.path] = &file;
+    }
+  }
+
+  // Collect the blocks each file is missing
+  struct Task {
+    std::size_t file;
+    long first;
+    long last;
+  };
+  std::vector<Task> tasks;
+  for (long f = 0; f < group.fileCount(); ++f) {
+    auto [first, last] = group.fileRows(f);
+    FileZones zones;
+    zones.path = group.metadata().dataPaths()[f];
+    ZoneStamp stamp = stampOf(zones.path);
+    auto it = indexed.find(zones.path);
+    if (it != indexed.end()) {
+      zones = *it->second;
+    } else if (!ignoreCache) {
+      map->load(zones);
+    }
+
+    // Blocks of a rewritten file are summarized again
+    if (!map->current(zones, stamp, group, first, last)) {
+      zones.blocks.clear();
+    }
+    zones.stamp = stamp;
+    // A partial last block is summarized again once the file grows
+    if (!zones.blocks.empty() && zones.blocks.back().rows < map->blockRows_ &&
+        zones.rows() < last - first) {
+      zones.blocks.pop_back();
+    }
+
+    for (long row = first + zones.rows(); row < last; row += map->blockRows_) {
+      tasks.push_back(
+          {map->files_.size(), row, std::min(row + map->blockRows_, last)});
+    }
+    map->files_.push_back(std::move(zones));
+  }
+
+  std::vector<ZoneBlock> summarized(tasks.size());
+  std::vector<CsvTimeCursor> cursors(workerCount(threads), snapshot.cursor());
+  forEachTask(tasks.size(), threads,
+              [&](std::size_t worker, std::size_t task) {
+                summarized[task] =
+                    summarize(cursors[worker], projection,
+                              map->columns_.size(), tasks[task].first,
+                              tasks[task].last);
+              });
+
+  // Tasks are in file and row order, append them and save the files
+  for (std::size_t task = 0; task < tasks.size(); ++task) {
+    FileZones &zones = map->files_[tasks[task].file];
+    summarized[task].firstRow -= group.fileRows(tasks[task].file).first;
+    zones.blocks.push_back(std::move(summarized[task]));
+    if (task + 1 == tasks.size() || tasks[task + 1].file != tasks[task].file) {
+      long first = group.fileRows(tasks[task].file).first;
+      zones.firstLine = group.getRawLine(first);
+      zones.lastLine = group.getRawLine(first + zones.rows() - 1);
+      map->save(zones);
+    }
+  }
+
+  for (std::size_t f = 0; f < map->files_.size(); ++f) {
+    long first = group.fileRows(f).first;
+    for (ZoneBlock block : map->files_[f].blocks) {
+      block.firstRow += first;
+      map->blocks_.push_back(std::move(block));
+    }
+  }
+  return map;
+}
+
+std::size_t ZoneMap::columnIndex(const std::string &column) const {
+  auto it = std::find(columns_.begin(), columns_.end(), column);
+  if (it == columns_.end()) {
+    throw std::runtime_error("Column '" + column +
+                             "' has no zone map statistics");
+  }
+  return it - columns_.begin();
+}
+
+bool ZoneMap::mayMatch(std::size_t block, std::size_t column,
+                       const ZonePredicate &predicate) const {
+  const ZoneBlock &zone = blocks_[block];
+  if (std::isnan(zone.min[column])) {
+    // No numeric values to match
+    return false;
+  }
+  quad low = zone.min[column];
+  quad high = zone.max[column];
+
+  switch (predicate.kind) {
+  case ZonePredicate::Kind::above:
+    return high > predicate.low;
+  case ZonePredicate::Kind::below:
+    return low < predicate.low;
+  case ZonePredicate::Kind::between:
+    return high >= predicate.low && low <= predicate.high;
+  case ZonePredicate::Kind::outside:
+    return low < predicate.low || high > predicate.high;
+  case ZonePredicate::Kind::jump:
+    // The first row jumps from the last row of the previous block
+    if (block > 0 && !std::isnan(blocks_[block - 1].min[column])) {
+      low = std::min(low, quad(blocks_[block - 1].min[column]));
+      high = std::max(high, quad(blocks_[block - 1].max[column]));
+    }
+    return high - low > predicate.low;
+  }
+  return true;
+}
+
+std::vector<std::size_t>
+ZoneMap::candidates(date_time start, date_time end,
+                    const std::vector<ZonePredicate> &predicates) const {
+  time_ticks first = toTicks(start);
+  time_ticks last = toTicks(end);
+  std::vector<std::size_t> columns;
+  for (const auto &predicate : predicates) {
+    columns.push_back(columnIndex(predicate.column));
+  }
+
+  std::vector<std::size_t> result;
+  for (std::size_t block = 0; block < blocks_.size(); ++block) {
+    if (blocks_[block].maxTime < first || blocks_[block].minTime > last) {
+      continue;
+    }
+    bool possible = true;
+    for (std::size_t i = 0; possible && i < predicates.size(); ++i) {
+      possible = mayMatch(block, columns[i], predicates[i]);
+    }
+    if (possible) {
+      result.push_back(block);
+    }
+  }
+  return result;
+}
+
+std::vector<long>
+ZoneMap::scanBlock(CsvTimeCursor &cursor, std::size_t block, time_ticks start,
+                   time_ticks end,
+                   const std::vector<ZonePredicate> &predicates,
+                   const Projection &projection) const {
+  const ZoneBlock &zone = blocks_[block];
+  bool jumps = std::any_of(predicates.begin(), predicates.end(),
+                           [](const ZonePredicate &predicate) {
+                             return predicate.kind == ZonePredicate::Kind::jump;
+                           });
+
+  // Jumps into the first row need the row before it
+  long first = zone.firstRow - (jumps && zone.firstRow > 0 ? 1 : 0);
+  long last = zone.firstRow + zone.rows;
+  std::vector<time_ticks> times = cursor.timesOfRows(first, last);
+  std::vector<long> rows(last - first);
+  std::iota(rows.begin(), rows.end(), first);
+  std::vector<std::string> lines = cursor.group().readRows(rows);
+
+  std::vector<quad> values(predicates.size());
+  std::vector<quad> previous(predicates.size());
+  std::vector<bool> valid(predicates.size(), false);
+  std::vector<bool> previous_valid(predicates.size(), false);
+  std::vector<std::string_view> fields;
+  std::vector<long> matches;
+  for (long row = first; row < last; ++row) {
+    cursor.group().splitFields(lines[row - first], projection, fields);
+    bool match = row >= zone.firstRow && times[row - first] >= start &&
+                 times[row - first] <= end;
+    for (std::size_t i = 0; i < predicates.size(); ++i) {
+      valid[i] = parseField(fields[i], values[i]);
+      if (!match) {
+        continue;
+      }
+
+      const ZonePredicate &predicate = predicates[i];
+      const quad &value = values[i];
+      switch (predicate.kind) {
+      case ZonePredicate::Kind::above:
+        match = valid[i] && value > predicate.low;
+        break;
+      case ZonePredicate::Kind::below:
+        match = valid[i] && value < predicate.low;
+        break;
+      case ZonePredicate::Kind::between:
+        match = valid[i] && value >= predicate.low && value <= predicate.high;
+        break;
+      case ZonePredicate::Kind::outside:
+        match = valid[i] && (value < predicate.low || value > predicate.high);
+        break;
+      case ZonePredicate::Kind::jump:
+        match = valid[i] && previous_valid[i] &&
+                abs(value - previous[i]) > predicate.low;
+        break;
+      }
+    }
+    if (match) {
+      matches.push_back(row);
+    }
+    std::swap(values, previous);
+    std::swap(valid, previous_valid);
+  }
+  return matches;
+}
+
+std::vector<std::pair<long, long>>
+ZoneMap::query(date_time start, date_time end,
+               const std::vector<ZonePredicate> &predicates,
+               long threads) const {
+  std::vector<std::size_t> blocks = candidates(start, end, predicates);
+
+  std::vector<std::string> columns;
+  for (const auto &predicate : predicates) {
+    columns.push_back(predicate.column);
+  }
+  Projection projection = snapshot_.group().project(columns);
+
+  std::vector<std::vector<long>> matches(blocks.size());
+  std::vector<CsvTimeCursor> cursors(workerCount(threads), snapshot_.cursor());
+  forEachTask(blocks.size(), threads,
+              [&](std::size_t worker, std::size_t task) {
+                matches[task] =
+                    scanBlock(cursors[worker], blocks[task], toTicks(start),
+                              toTicks(end), predicates, projection);
+              });
+
+  // Blocks are in row order, join matches on consecutive rows into runs
+  std::vector<std::pair<long, long>> runs;
+  for (const auto &block_matches : matches) {
+    for (long row : block_matches) {
+      if (!runs.empty() && runs.back().second == row) {
+        ++runs.back().second;
+      } else {
+        runs.emplace_back(row, row + 1);
+      }
+    }
+  }
+  return runs;
+}
@@ -0,0 +1,373 @@
+#ifndef __ZONEMAP_H__
+#define __ZONEMAP_H__
+
+#include "CsvTimeSnapshot.hpp"
+#include "TimeParse.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Statistics of one block of rows of a time group.
+ *
+ * The bounds are doubles widened by one unit in the last place, so they
+ * bound the quad values of the block even where parsing into a double
+ * rounded.
+ */
+struct ZoneBlock {
+  /**
+   * @brief The first row of the block in the group.
+   */
+  long firstRow = 0;
+
+  /**
+   * @brief Number of rows in the block.
+   */
+  long rows = 0;
+
+  /**
+   * @brief Earliest time of the rows, as ticks since 1970-01-01.
+   */
+  time_ticks minTime = 0;
+
+  /**
+   * @brief Latest time of the rows, as ticks since 1970-01-01.
+   */
+  time_ticks maxTime = 0;
+
+  /**
+   * @brief Lower bound of each column, NaN if it has no numeric values.
+   */
+  std::vector<double> min;
+
+  /**
+   * @brief Upper bound of each column, NaN if it has no numeric values.
+   */
+  std::vector<double> max;
+
+  /**
+   * @brief Sum of the numeric values of each column.
+   */
+  std::vector<double> sum;
+
+  /**
+   * @brief Number of numeric values of each column.
+   */
+  std::vector<long> count;
+};
+
+/**
+ * @brief Identity of a data file when its blocks were summarized.
+ */
+struct ZoneStamp {
+  /**
+   * @brief Inode of the file, which changes when it is replaced.
+   */
+  std::uint64_t inode = 0;
+
+  /**
+   * @brief Size of the file in bytes.
+   */
+  std::uint64_t size = 0;
+
+  /**
+   * @brief Modification time of the file, in nanoseconds since 1970-01-01.
+   */
+  std::int64_t modified = 0;
+
+  bool operator==(const ZoneStamp &) const = default;
+};
+
+/**
+ * @brief A condition on the values of one column, for ZoneMap::query.
+ */
+struct ZonePredicate {
+  /**
+   * @brief The kinds of condition.
+   */
+  enum class Kind {
+    /**
+     * @brief The value is greater than low.
+     */
+    above,
+
+    /**
+     * @brief The value is less than low.
+     */
+    below,
+
+    /**
+     * @brief The value is in [low, high].
+     */
+    between,
+
+    /**
+     * @brief The value is less than low or greater than high.
+     */
+    outside,
+
+    /**
+     * @brief The value differs from the previous row's by more than low.
+     */
+    jump
+  };
+
+  /**
+   * @brief The column the condition is on.
+   */
+  std::string column;
+
+  /**
+   * @brief The kind of condition.
+   */
+  Kind kind = Kind::above;
+
+  /**
+   * @brief The threshold, or the lower limit of a range.
+   */
+  quad low = 0;
+
+  /**
+   * @brief The upper limit of a range.
+   */
+  quad high = 0;
+
+  /**
+   * @brief Matches values greater than a threshold.
+   */
+  static ZonePredicate above(std::string column, quad threshold) {
+    return {std::move(column), Kind::above, threshold, 0};
+  }
+
+  /**
+   * @brief Matches values less than a threshold.
+   */
+  static ZonePredicate below(std::string column, quad threshold) {
+    return {std::move(column), Kind::below, threshold, 0};
+  }
+
+  /**
+   * @brief Matches values in [low, high].
+   */
+  static ZonePredicate between(std::string column, quad low, quad high) {
+    return {std::move(column), Kind::between, low, high};
+  }
+
+  /**
+   * @brief Matches values less than low or greater than high, such as
+   * residuals outside a tolerance.
+   */
+  static ZonePredicate outside(std::string column, quad low, quad high) {
+    return {std::move(column), Kind::outside, low, high};
+  }
+
+  /**
+   * @brief Matches rows whose value differs from the previous row's by more
+   * than a threshold.
+   */
+  static ZonePredicate jump(std::string column, quad threshold) {
+    return {std::move(column), Kind::jump, threshold, 0};
+  }
+};
+
+/**
+ * @brief Per block statistics of the numeric columns of a time group, for
+ * skipping blocks that cannot match a query.
+ *
+ * The rows of each data file are split into blocks of blockRows(), and each
+ * block keeps its time range and the bounds, sum and count of every indexed
+ * column. The blocks of a file are saved next to it as "<file>.zones", so
+ * only rows added since the last build are parsed, starting from the file's
+ * last partial block. Saved blocks are kept while the file's inode, size and
+ * modification time are unchanged, or when the file has grown and the first
+ * and last rows they cover read as they did. Otherwise the file is
+ * summarized again.
+ *
+ * A zone map is immutable once built and safe to query from any thread. It
+ * reads the rows of the snapshot it was built from.
+ */
+struct ZoneMap {
+private:
+  /**
+   * @brief The blocks of one data file.
+   */
+  struct FileZones {
+    /**
+     * @brief Path of the data file.
+     */
+    std::string path;
+
+    /**
+     * @brief The file when the blocks were summarized.
+     */
+    ZoneStamp stamp;
+
+    /**
+     * @brief Text of the first row of the file.
+     */
+    std::string firstLine;
+
+    /**
+     * @brief Text of the last row the blocks cover.
+     */
+    std::string lastLine;
+
+    /**
+     * @brief The blocks, with rows counted from the start of the file.
+     */
+    std::vector<ZoneBlock> blocks;
+
+    /**
+     * @brief Rows covered by the blocks.
+     */
+    long rows() const {
+      return blocks.empty() ? 0 : blocks.back().firstRow + blocks.back().rows;
+    }
+  };
+
+  /**
+   * @brief The rows the map was built from.
+   */
+  CsvTimeSnapshot snapshot_;
+
+  /**
+   * @brief The indexed columns.
+   */
+  std::vector<std::string> columns_;
+
+  /**
+   * @brief Rows per block.
+   */
+  long blockRows_ = 4096;
+
+  /**
+   * @brief The blocks of each file, in group order.
+   */
+  std::vector<FileZones> files_;
+
+  /**
+   * @brief The blocks of all files, with group rows, in group order.
+   */
+  std::vector<ZoneBlock> blocks_;
+
+  /**
+   * @brief Reads a file's saved blocks.
+   * @return false if there are none, or they are for other columns.
+   */
+  bool load(FileZones &file) const;
+
+  /**
+   * @brief Saves a file's blocks next to it.
+   * @throws std::runtime_error if the file cannot be written.
+   */
+  void save(const FileZones &file) const;
+
+  /**
+   * @brief Checks whether a file's blocks still describe its rows.
+   * @param file The blocks, from the previous map or the saved file.
+   * @param stamp The data file as it is now.
+   * @param group The rows being indexed.
+   * @param first The first row of the file in the group.
+   * @param last One past the last row of the file in the group.
+   * @return false if the file was rewritten since.
+   */
+  bool current(const FileZones &file, const ZoneStamp &stamp,
+               const CsvGroupSnapshot &group, long first, long last) const;
+
+  /**
+   * @brief Gets the position of an indexed column.
+   * @throws std::runtime_error if the column is not indexed.
+   */
+  std::size_t columnIndex(const std::string &column) const;
+
+  /**
+   * @brief Checks whether a block may hold a row matching a predicate.
+   * @param block The position of the block in blocks().
+   * @param column The position of the predicate's column.
+   */
+  bool mayMatch(std::size_t block, std::size_t column,
+                const ZonePredicate &predicate) const;
+
+  /**
+   * @brief Finds the matching rows of one block.
+   */
+  std::vector<long> scanBlock(CsvTimeCursor &cursor, std::size_t block,
+                              time_ticks start, time_ticks end,
+                              const std::vector<ZonePredicate> &predicates,
+                              const Projection &projection) const;
+
+public:
+  /**
+   * @brief Builds the zone map of a snapshot.
+   * @param snapshot The rows to index.
+   * @param columns The numeric columns to keep statistics of.
+   * @param previous A zone map of an earlier snapshot of the same group, whose
+   * complete blocks are reused, or nullptr.
+   * @param ignoreCache If true, parses every row instead of reading the saved
+   * blocks.
+   * @param blockRows Rows per block.
+   * @param threads Worker threads parsing rows, 0 for one per core.
+   * @return The zone map.
+   * @throws std::runtime_error if a column is missing or a file cannot be
+   * read or its blocks saved.
+   */
+  static std::shared_ptr<const ZoneMap>
+  build(const CsvTimeSnapshot &snapshot, std::vector<std::string> columns,
+        std::shared_ptr<const ZoneMap> previous = nullptr,
+        bool ignoreCache = false, long blockRows = 4096, long threads = 0);
+
+  /**
+   * @brief Gets the rows the map was built from.
+   */
+  const CsvTimeSnapshot &snapshot() const { return snapshot_; }
+
+  /**
+   * @brief Gets the indexed columns, in the order of the block statistics.
+   */
+  const std::vector<std::string> &columns() const { return columns_; }
+
+  /**
+   * @brief Gets the rows per block.
+   */
+  long blockRows() const { return blockRows_; }
+
+  /**
+   * @brief Gets the statistics of every block.
+   * @return The blocks of all files, in row order.
+   */
+  const std::vector<ZoneBlock> &blocks() const { return blocks_; }
+
+  /**
+   * @brief Finds the blocks that may hold rows matching a query.
+   * @param start The earliest time of a matching row.
+   * @param end The latest time of a matching row.
+   * @param predicates Conditions every matching row meets.
+   * @return Positions in blocks() of the blocks to scan, in row order.
+   * @throws std::runtime_error if a predicate's column is not indexed.
+   */
+  std::vector<std::size_t>
+  candidates(date_time start, date_time end,
+             const std::vector<ZonePredicate> &predicates) const;
+
+  /**
+   * @brief Finds the rows in a time range that meet every predicate.
+   * @details Only the candidate blocks are read, in parallel. Values are
+   * compared as quads, the block statistics only rule blocks out.
+   * @param start The earliest time of a matching row.
+   * @param end The latest time of a matching row.
+   * @param predicates Conditions every matching row meets.
+   * @param threads Worker threads scanning blocks, 0 for one per core.
+   * @return Runs of consecutive matching rows, as the first row and one past
+   * the last, in row order.
+   * @throws std::runtime_error if a predicate's column is not indexed or a
+   * block cannot be read.
+   */
+  std::vector<std::pair<long, long>>
+  query(date_time start, date_time end,
+        const std::vector<ZonePredicate> &predicates, long threads = 0) const;
+};
+
+#endif // __ZONEMAP_H__
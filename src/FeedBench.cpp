@@ -0,0 +1,200 @@
+/*
+ * FeedBench.cpp
+ * Measures the publish cost and reader latency of the shared memory deviation
+ * feed.
+ *
+ * This file is part of the TimeKeeping project.
+ *
+ */
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Utils/DeviationFeed.hpp"
+
+#include "TimekeepingConfig.h"
+#include <argparse/argparse.hpp>
+
+/* Nanoseconds on the clock publish() stamps samples with.
+ */
+std::int64_t nowNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+/* Prints percentiles of a set of latencies in nanoseconds.
+ */
+void report(const std::string& name, std::vector<std::int64_t> latencies)
+{
+    if (latencies.empty())
+    {
+        std::cout << std::left << std::setw(24) << name << "no samples"
+                  << std::endl;
+        return;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p)
+    { return latencies[size_t(p * (latencies.size() - 1))]; };
+    std::cout << std::left << std::setw(24) << name << std::right
+              << std::setw(8) << percentile(0.5) << " ns p50, "
+              << std::setw(8) << percentile(0.99) << " ns p99, "
+              << std::setw(8) << percentile(0.999) << " ns p99.9, "
+              << std::setw(10) << latencies.back() << " ns max ("
+              << latencies.size() << " samples)" << std::endl;
+}
+
+/* Times publishing with no readers attached.
+ */
+void measurePublish(DeviationPublisher& publisher, long samples)
+{
+    DeviationSample sample;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < samples; ++i)
+    {
+        sample.index = i;
+        sample.deviation = i * 1e-12;
+        publisher.publish(sample);
+    }
+    std::chrono::duration<double, std::nano> elapsed
+        = std::chrono::steady_clock::now() - start;
+    std::cout << std::left << std::setw(24) << "publish" << std::right
+              << std::fixed << std::setprecision(1) << std::setw(8)
+              << elapsed.count() / samples << " ns/sample" << std::endl;
+}
+
+/* Publishes samples at a fixed interval while readers spin on the feed, and
+ * reports the delay from publishing to each reader seeing the sample.
+ */
+void measureLatency(
+    DeviationPublisher& publisher, long samples, int readers, long interval_ns)
+{
+    std::atomic<bool> done = false;
+    std::vector<std::vector<std::int64_t>> latencies(readers);
+    std::vector<long> torn(readers, 0);
+
+    std::vector<std::thread> threads;
+    for (int r = 0; r < readers; ++r)
+    {
+        threads.emplace_back(
+            [&, r]()
+            {
+                DeviationReader reader(publisher.name());
+                DeviationSample sample;
+                std::uint64_t last = reader.count();
+                latencies[r].reserve(samples);
+                while (!done.load(std::memory_order_relaxed))
+                {
+                    if (reader.count() == last)
+                    {
+                        continue;
+                    }
+                    last = reader.read(sample);
+                    latencies[r].push_back(nowNanoseconds() - sample.published);
+                    // Fields of one sample are written together
+                    if (sample.deviation != sample.index * 1e-12)
+                    {
+                        ++torn[r];
+                    }
+                }
+            });
+    }
+
+    // Let the readers attach before publishing
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    DeviationSample sample;
+    for (long i = 0; i < samples; ++i)
+    {
+        auto next = std::chrono::steady_clock::now()
+                  + std::chrono::nanoseconds(interval_ns);
+        sample.index = i;
+        sample.deviation = i * 1e-12;
+        publisher.publish(sample);
+        while (std::chrono::steady_clock::now() < next)
+        {
+        }
+    }
+    done = true;
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    std::vector<std::int64_t> all;
+    long torn_total = 0;
+    for (int r = 0; r < readers; ++r)
+    {
+        all.insert(all.end(), latencies[r].begin(), latencies[r].end());
+        torn_total += torn[r];
+    }
+    report(std::format("latency, {} readers", readers), all);
+    std::cout << "Torn reads: " << torn_total << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    argparse::ArgumentParser parser(
+        "FeedBench",
+        std::format(
+            "v{}.{}", Timekeeping_VERSION_MAJOR, Timekeeping_VERSION_MINOR),
+        argparse::default_arguments::all,
+        true);
+    parser.add_description(
+        "FeedBench - Measure the publish cost and reader latency of the shared "
+        "memory deviation feed.");
+    parser.add_argument("-n", "--samples")
+        .nargs(1)
+        .default_value("100000")
+        .help("Number of samples to publish per pass.");
+    parser.add_argument("-r", "--readers")
+        .nargs(1)
+        .default_value("2")
+        .help("Number of reader threads.");
+    parser.add_argument("-i", "--interval")
+        .nargs(1)
+        .default_value("10000")
+        .help("Nanoseconds between published samples in the latency pass.");
+
+    try
+    {
+        parser.parse_args(argc, argv);
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    long samples
+        = std::max(1L, std::stol(parser.get<std::string>("--samples")));
+    int readers = std::max(1, std::stoi(parser.get<std::string>("--readers")));
+    long interval_ns = std::stol(parser.get<std::string>("--interval"));
+
+    std::string name = std::format("TimeKeeping.FeedBench.{}", getpid());
+    try
+    {
+        DeviationPublisher publisher(name);
+        measurePublish(publisher, samples);
+        measureLatency(publisher, samples, readers, interval_ns);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        DeviationPublisher::remove(name);
+        return 1;
+    }
+    DeviationPublisher::remove(name);
+
+    return 0;
+}
@@ -0,0 +1,222 @@
+/*
+ * KernelBench.cpp
+ * Measures the throughput of the Phaser and Timer row kernels in each mode.
+ *
+ * This file is part of the TimeKeeping project.
+ *
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "Utils/PhaserKernel.hpp"
+#include "Utils/TimerKernel.hpp"
+
+#include "TimekeepingConfig.h"
+#include <argparse/argparse.hpp>
+
+/* Stream buffer that discards everything written to it, so the benchmark
+ * measures formatting rather than disk speed.
+ */
+struct NullBuffer : std::streambuf
+{
+protected:
+    int overflow(int c) override { return c; }
+
+    std::streamsize xsputn(const char*, std::streamsize count) override
+    {
+        return count;
+    }
+};
+
+/* Generates synthetic input lines in the Freq (frequency only), PhaseFreq and
+ * Phaser output layouts.
+ */
+std::vector<std::string> makeLines(long rows, bool phases, bool timerLayout)
+{
+    std::vector<std::string> lines;
+    lines.reserve(rows);
+
+    const double nominal[channelCount] = {
+        995532.6897452829, 10000000.00754296, 5000000.0000000065, 10};
+    double phase[channelCount] = {0, 0, 0, 0};
+
+    std::ostringstream line;
+    line.precision(17);
+    for (long i = 0; i < rows; ++i)
+    {
+        line.str("");
+        long seconds = i / 10;
+        if (timerLayout)
+        {
+            line << "2025 7 11 " << (seconds / 3600) % 24 << " "
+                 << (seconds / 60) % 60 << " " << seconds % 60 + (i % 10) / 10.0
+                 << " " << i;
+        }
+        else
+        {
+            line << "250711 " << std::setfill('0') << std::setw(2)
+                 << (seconds / 3600) % 24 << std::setw(2) << (seconds / 60) % 60
+                 << std::setw(2) << seconds % 60 << "." << i % 10
+                 << std::setfill(' ') << " " << i;
+        }
+
+        for (size_t c = 0; c < channelCount; ++c)
+        {
+            phase[c] += nominal[c] * 0.1 * (1 + 1e-9 * ((i * 7 + c) % 13));
+        }
+        if (phases)
+        {
+            for (size_t c = 0; c < channelCount; ++c)
+            {
+                line << " " << phase[c];
+            }
+        }
+        for (size_t c = 0; c < channelCount; ++c)
+        {
+            line << " " << nominal[c] * (1 + 1e-9 * ((i * 7 + c) % 13));
+        }
+        lines.push_back(line.str());
+    }
+
+    return lines;
+}
+
+/* Runs one pass of the Phaser main loop body over the lines.
+ */
+template <typename Kernel>
+void phaserPass(const std::vector<std::string>& lines, std::ostream& output)
+{
+    const quad interval("0.1");
+    const Channels<quad> start;
+
+    PhaserRow row;
+    Channels<quad> phase;
+    bool first_line = true;
+    for (const auto& line : lines)
+    {
+        if (!Kernel::parse(line, row))
+        {
+            continue;
+        }
+        if (first_line)
+        {
+            phase = Kernel::first(row, start, interval);
+            first_line = false;
+        }
+        else
+        {
+            phase += Kernel::increment(row, interval);
+        }
+        Kernel::write(output, row, phase);
+    }
+}
+
+/* Runs one pass of the Timer main loop body over the lines.
+ */
+template <typename Kernel>
+void timerPass(const std::vector<std::string>& lines, std::ostream& output)
+{
+    TimerParameters parameters;
+    parameters.meanFreq = {
+        {quad("995532.6897452829"),
+         quad("10000000.00754296"),
+         quad("5000000.0000000065"),
+         quad(10)}};
+    parameters.errorFreq = parameters.meanFreq;
+
+    TimerRow row;
+    long long interval_n = 0;
+    for (const auto& line : lines)
+    {
+        if (!Kernel::parse(line, row))
+        {
+            continue;
+        }
+        Kernel::write(output, row, Kernel::compute(row, ++interval_n, parameters));
+    }
+}
+
+/* Times repeated passes of a kernel and prints the throughput.
+ */
+template <typename Pass>
+void measure(
+    const std::string& name,
+    const std::vector<std::string>& lines,
+    int repeat,
+    Pass pass)
+{
+    NullBuffer null_buffer;
+    std::ostream output(&null_buffer);
+
+    std::vector<double> rates;
+    for (int r = 0; r < repeat; ++r)
+    {
+        auto start = std::chrono::steady_clock::now();
+        pass(lines, output);
+        std::chrono::duration<double> elapsed
+            = std::chrono::steady_clock::now() - start;
+        rates.push_back(lines.size() / elapsed.count());
+    }
+
+    std::sort(rates.begin(), rates.end());
+    std::cout << std::left << std::setw(24) << name << std::right
+              << std::fixed << std::setprecision(0) << std::setw(12)
+              << rates[rates.size() / 2] << " rows/s (median), "
+              << std::setw(12) << rates.back() << " rows/s (best)"
+              << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    argparse::ArgumentParser parser(
+        "KernelBench",
+        std::format(
+            "v{}.{}", Timekeeping_VERSION_MAJOR, Timekeeping_VERSION_MINOR),
+        argparse::default_arguments::all,
+        true);
+    parser.add_description(
+        "KernelBench - Measure rows/s of the Phaser and Timer kernels in each "
+        "mode.");
+    parser.add_argument("-n", "--rows")
+        .nargs(1)
+        .default_value("200000")
+        .help("Number of synthetic rows per pass.");
+    parser.add_argument("-r", "--repeat")
+        .nargs(1)
+        .default_value("5")
+        .help("Number of timed passes per mode.");
+
+    try
+    {
+        parser.parse_args(argc, argv);
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    long rows = std::stol(parser.get<std::string>("--rows"));
+    int repeat = std::max(1, std::stoi(parser.get<std::string>("--repeat")));
+
+    std::cout << "Generating " << rows << " rows per layout" << std::endl;
+    std::vector<std::string> freq_lines = makeLines(rows, false, false);
+    std::vector<std::string> phase_freq_lines = makeLines(rows, true, false);
+    std::vector<std::string> timer_lines = makeLines(rows, true, true);
+
+    measure("Phaser", freq_lines, repeat, phaserPass<PhaserKernel<false>>);
+    measure(
+        "Phaser --check", phase_freq_lines, repeat, phaserPass<PhaserKernel<true>>);
+    measure("Timer", timer_lines, repeat, timerPass<TimerKernel<false>>);
+    measure("Timer --error", timer_lines, repeat, timerPass<TimerKernel<true>>);
+
+    return 0;
+}
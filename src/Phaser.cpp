@@ -1,5 +1,8 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <string_view>
+#include <vector>
 
 #include <cmath>
 #include <boost/multiprecision/cpp_bin_float.hpp>
@@ -7,6 +10,10 @@
 #include <argparse/argparse.hpp>
 #include <TimekeepingConfig.h>
 
+#include "Utils/Channels.hpp"
+#include "Utils/LineChunks.hpp"
+#include "Utils/PhaserKernel.hpp"
+
 using quad = boost::multiprecision::cpp_bin_float_quad;
 
 /*
@@ -32,6 +39,7 @@ using quad = boost::multiprecision::cpp_bin_float_quad;
  * --rb_start: Specify the begining of the Rb phase data.
  * --h_start: Specify the begining of the H phase data.
  * --z_start: Specify the begining of the Z phase data.
+ * --threads: Number of worker threads, 0 for one per core. Default is 1 (serial).
  */
 void parse_args(argparse::ArgumentParser& program, int argc, char* argv[]) {
 
@@ -70,6 +78,11 @@ void parse_args(argparse::ArgumentParser& program, int argc, char* argv[]) {
         .default_value("")
         .help("Specify the beginning of the Z phase data. Default is 0.");
 
+    program.add_argument("-j", "--threads")
+        .nargs(1)
+        .default_value("1")
+        .help("Number of worker threads, 0 for one per core. Default is 1 (serial).");
+
     program.add_argument("in_file")
         .default_value("stdin")
         .help("Input CSV file, defaultes to stdin.");
@@ -92,6 +105,198 @@ void parse_args(argparse::ArgumentParser& program, int argc, char* argv[]) {
     }
 }
 
+/*
+ * Options read once from the command line, shared by every kernel.
+ */
+struct PhaserOptions {
+    std::string in_file;
+    quad interval;
+    Channels<quad> start;
+    size_t threads = 1;
+};
+
+/*
+ * Serial main loop, reading and writing one line at a time.
+ */
+template <typename Kernel>
+int run_serial(std::istream& input_stream, std::ostream& output_stream, const PhaserOptions& options) {
+    // Fields for input and output data
+    PhaserRow row;
+    Channels<quad> Phase_From_Freq;
+
+    // Read the input file line by line
+
+    std::string newline;
+    bool first_line = true;
+
+    while (std::getline(input_stream, newline)){
+        // Process each line of input
+        // Output file will add the computed columns: Si_Phase_From_Freq, Rb_Phase_From_Freq, H_Phase_From_Freq, Z_Phase_From_Freq,
+        // Also break down Day and Time into separate columns: Year, Month, Day, Hour, Minute, Second
+        // Si_Phase_Error, Rb_Phase_Error, H_Phase_Error, Z_Phase_Error
+
+        // Comment lines starting with '#' are ignored
+        if (newline.empty() || newline[0] == '#') {
+            continue;
+        }
+
+        if (!Kernel::parse(newline, row)) {
+            std::cerr << "Error reading line: " << newline << std::endl;
+            continue; // Skip this line if reading fails
+        }
+
+        if (first_line) {
+            // Print header for the output CSV
+            Kernel::writeHeader(output_stream, options.in_file, options.interval);
+
+            // Initialize phase values from the first line
+            Phase_From_Freq = Kernel::first(row, options.start, options.interval);
+            first_line = false;
+        } else {
+            // Accumulate phase values from frequencies
+            Phase_From_Freq += Kernel::increment(row, options.interval);
+        }
+
+        Kernel::write(output_stream, row, Phase_From_Freq);
+    }
+
+    return 0;
+}
+
+/*
+ * Work for one chunk of lines in parallel mode.
+ */
+struct PhaserChunk {
+    std::string_view lines;
+    std::vector<PhaserRow> rows;
+    std::vector<std::string> errors;
+
+    // Phase accumulated by the first row alone, and by all following rows
+    Channels<quad> head_sum;
+    Channels<quad> tail_sum;
+
+    // Phase before the first row, fixed up once all earlier chunks are known
+    Channels<quad> offset;
+    bool first_in_input = false;
+
+    std::ostringstream output;
+};
+
+/*
+ * Parallel main loop.
+ *
+ * The accumulated phase is a prefix sum of Freq * interval, so the input is read in large blocks,
+ * each block is split into one chunk of lines per thread and processed in two passes:
+ *  1. Each worker parses its chunk and sums the phase its rows contribute.
+ *  2. The chunk sums are scanned in order to give each chunk its starting phase, then each worker
+ *     formats its rows from that offset.
+ * Chunk output is then written in input order, so the result matches the serial mode up to
+ * rounding in the last digit of the accumulated phase.
+ */
+template <typename Kernel>
+int run_parallel(std::istream& input_stream, std::ostream& output_stream, const PhaserOptions& options) {
+    const quad& interval = options.interval;
+
+    // Large enough blocks that thread start-up is negligible, small enough to stream through pipes
+    LineBlockReader reader(input_stream, options.threads * (size_t(4) << 20));
+    std::string block;
+    bool first_line = true;
+    Channels<quad> Phase_From_Freq;
+
+    while (reader.next(block)) {
+        std::vector<std::string_view> views = splitLines(block, options.threads);
+        std::vector<PhaserChunk> chunks(views.size());
+        for (size_t i = 0; i < views.size(); ++i) {
+            chunks[i].lines = views[i];
+        }
+
+        // Pass 1: parse and sum each chunk independently
+        parallelFor(chunks.size(), [&chunks, &interval](size_t i) {
+            PhaserChunk& chunk = chunks[i];
+            std::string_view lines = chunk.lines;
+            while (!lines.empty()) {
+                size_t newline = lines.find('\n');
+                std::string_view line = lines.substr(0, newline);
+                lines.remove_prefix(newline == std::string_view::npos ? lines.size() : newline + 1);
+
+                // Comment lines starting with '#' are ignored
+                if (line.empty() || line[0] == '#') {
+                    continue;
+                }
+
+                PhaserRow row;
+                if (!Kernel::parse(line, row)) {
+                    chunk.errors.push_back(std::string(line));
+                    continue; // Skip this line if reading fails
+                }
+
+                if (chunk.rows.empty()) {
+                    chunk.head_sum = Kernel::increment(row, interval);
+                } else {
+                    chunk.tail_sum += Kernel::increment(row, interval);
+                }
+                chunk.rows.push_back(std::move(row));
+            }
+        });
+
+        // Fix up the starting phase of each chunk from the sums of the ones before it
+        for (auto& chunk : chunks) {
+            if (chunk.rows.empty()) {
+                continue;
+            }
+            if (first_line) {
+                Kernel::writeHeader(output_stream, options.in_file, options.interval);
+
+                // Initialize phase values from the first line
+                Phase_From_Freq = Kernel::first(chunk.rows.front(), options.start, interval);
+                chunk.first_in_input = true;
+                first_line = false;
+            } else {
+                Phase_From_Freq += chunk.head_sum;
+            }
+
+            chunk.offset = Phase_From_Freq;
+            Phase_From_Freq += chunk.tail_sum;
+        }
+
+        // Pass 2: format each chunk from its starting phase
+        parallelFor(chunks.size(), [&chunks, &interval](size_t i) {
+            PhaserChunk& chunk = chunks[i];
+            if (chunk.rows.empty()) {
+                return;
+            }
+
+            Channels<quad> phase = chunk.offset;
+            Kernel::write(chunk.output, chunk.rows.front(), phase);
+            for (size_t r = 1; r < chunk.rows.size(); ++r) {
+                phase += Kernel::increment(chunk.rows[r], interval);
+                Kernel::write(chunk.output, chunk.rows[r], phase);
+            }
+        });
+
+        // Write the chunks out in input order
+        for (auto& chunk : chunks) {
+            for (const auto& error : chunk.errors) {
+                std::cerr << "Error reading line: " << error << std::endl;
+            }
+            output_stream << chunk.output.view();
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Runs the serial or parallel loop for the selected kernel.
+ */
+template <typename Kernel>
+int run(std::istream& input_stream, std::ostream& output_stream, const PhaserOptions& options) {
+    if (options.threads > 1) {
+        return run_parallel<Kernel>(input_stream, output_stream, options);
+    }
+    return run_serial<Kernel>(input_stream, output_stream, options);
+}
+
 /*
  * Main entry point for the Phaser application.
  */
@@ -146,179 +351,59 @@ int main(int argc, char* argv[]) {
     std::istream input_stream(read_stdio ? std::cin.rdbuf() : csv_in_file.rdbuf());
     std::ostream output_stream(write_stdio ? std::cout.rdbuf() : csv_out_file.rdbuf());
 
+    // Read all options once, the kernels never look at the parser
+    PhaserOptions options;
+    options.in_file = in_file;
+    bool check = program.get<bool>("--check");
+
     // Parse time delta between measurements
-    quad interval;
     try {
         std::istringstream iss(program.get<std::string>("--interval"));
-        iss >> interval;
+        iss >> options.interval;
     } catch (const std::exception &e) {
         std::cerr << "Error parsing --interval: " << e.what() << std::endl;
         std::cerr << program;
         return 1;
     }
 
-    // Fields for input data
-    int Day;
-    double Time;
-    int S;
-    quad Si_Freq = 0;
-    quad Rb_Freq = 0;
-    quad H_Freq = 0;
-    quad Z_Freq = 0;
-    quad Si_Phase = 0;
-    quad Rb_Phase = 0;
-    quad H_Phase = 0;
-    quad Z_Phase = 0;
-
-    // Fields for output data
-    quad Si_Phase_From_Freq = 0;
-    quad Rb_Phase_From_Freq = 0;
-    quad H_Phase_From_Freq = 0;
-    quad Z_Phase_From_Freq = 0;
-    quad Si_Phase_Error = 0;
-    quad Rb_Phase_Error = 0;
-    quad H_Phase_Error = 0;
-    quad Z_Phase_Error = 0;
-
-    // Read the input file line by line
-
-    std::string newline;
-    bool first_line = true;
-
-    while (std::getline(input_stream, newline)){
-        // Process each line of input
-        // Input file has columns: Day, Time, S, Si_Phase, Rb_Phase, H_Phase, Z_Phase, Si_Freq, Rb_Freq, H_Freq, Z_Freq
-        // Output file will add the computed columns: Si_Phase_From_Freq, Rb_Phase_From_Freq, H_Phase_From_Freq, Z_Phase_From_Freq,
-        // Also break down Day and Time into separate columns: Year, Month, Day, Hour, Minute, Second
-        // Si_Phase_Error, Rb_Phase_Error, H_Phase_Error, Z_Phase_Error
-
-        // Comment lines starting with '#' are ignored
-        if (newline.empty() || newline[0] == '#') {
-            continue;
+    // Parse the number of worker threads
+    long threads_requested = 1;
+    {
+        std::istringstream iss_threads(program.get<std::string>("--threads"));
+        if (!(iss_threads >> threads_requested) || threads_requested < 0) {
+            std::cerr << "Error parsing --threads: " << program.get<std::string>("--threads") << std::endl;
+            return 1;
         }
-
-        std::istringstream iss(newline);
-
-        // If only converting frequencies to phases, we can skip the phase data
-        if (program.get<bool>("--check")) {
-            if(!(iss >> Day >> Time >> S >> Si_Phase >> Rb_Phase >> H_Phase >> Z_Phase 
-                >> Si_Freq >> Rb_Freq >> H_Freq >> Z_Freq)) {
-                std::cerr << "Error reading line: " << newline << std::endl;
-                continue; // Skip this line if reading fails
-            }
-        } else {
-            // If not checking, we read frequencies only
-            if(!(iss >> Day >> Time >> S >> Si_Freq >> Rb_Freq >> H_Freq >> Z_Freq)) {
-                std::cerr << "Error reading line: " << newline << std::endl;
-                continue; // Skip this line if reading fails
+    }
+    options.threads = workerCount(threads_requested);
+
+    // Starting phase values, only used when not checking against given phase data
+    if (!check) {
+        if (!program.get<std::string>("--si_start").empty()) {
+            std::istringstream iss_si(program.get<std::string>("--si_start"));
+            if(!(iss_si >> options.start[Si])) {
+                std::cerr << "Error reading --si_start value." << std::endl;
+                return 1;
             }
         }
-
-        if (first_line) {
-            // Print header for the output CSV
-            output_stream << "#Phase data computed from frequency data by Phaser tool." << std::endl
-                        << "#Input file: " << program.get<std::string>("in_file") << std::endl
-                        << "#Interval: " << interval << " seconds" << std::endl;
-
-            if (program.get<bool>("--check")) {
-                output_stream << "Year Month Day Hour Minute Second S Si_Phase Rb_Phase H_Phase Z_Phase Si_Freq Rb_Freq H_Freq Z_Freq "
-                             << "Si_Phase_From_Freq Rb_Phase_From_Freq H_Phase_From_Freq Z_Phase_From_Freq "
-                             << "Si_Phase_Error Rb_Phase_Error H_Phase_Error Z_Phase_Error" << std::endl;
-            } else {
-                output_stream << "Year Month Day Hour Minute Second S Si_Phase Rb_Phase H_Phase Z_Phase"
-                             << "Si_Freq Rb_Freq H_Freq Z_Freq" << std::endl;
-            }
-
-            // Initialize phase values from the first line
-            if (program.get<bool>("--check")) {
-                Si_Phase_From_Freq = Si_Phase;
-                Rb_Phase_From_Freq = Rb_Phase;
-                H_Phase_From_Freq = H_Phase;
-                Z_Phase_From_Freq = Z_Phase;
-            } else {
-                if (!program.get<std::string>("--si_start").empty()) {
-                    std::istringstream iss_si(program.get<std::string>("--si_start"));
-                    if(!(iss_si >> Si_Phase_From_Freq)) {
-                        std::cerr << "Error reading --si_start value." << std::endl;
-                        return 1;
-                    }
-                }
-                if (!program.get<std::string>("--rb_start").empty()) {
-                    std::istringstream iss_rb(program.get<std::string>("--rb_start"));
-                    iss_rb >> Rb_Phase_From_Freq;
-                }
-                if (!program.get<std::string>("--h_start").empty()) {
-                    std::istringstream iss_h(program.get<std::string>("--h_start"));
-                    iss_h >> H_Phase_From_Freq;
-                }
-                if (!program.get<std::string>("--z_start").empty()) {
-                    std::istringstream iss_z(program.get<std::string>("--z_start"));
-                    iss_z >> Z_Phase_From_Freq;
-                }
-
-                // Accumulate phase values from the first line
-                Si_Phase_From_Freq += Si_Freq * interval;
-                Rb_Phase_From_Freq += Rb_Freq * interval;
-                H_Phase_From_Freq += H_Freq * interval;
-                Z_Phase_From_Freq += Z_Freq * interval;
-            }
-
-            first_line = false;
-        } else {
-            // Accumulate phase values from frequencies
-            Si_Phase_From_Freq += Si_Freq * interval;
-            Rb_Phase_From_Freq += Rb_Freq * interval;
-            H_Phase_From_Freq += H_Freq * interval;
-            Z_Phase_From_Freq += Z_Freq * interval; 
+        if (!program.get<std::string>("--rb_start").empty()) {
+            std::istringstream iss_rb(program.get<std::string>("--rb_start"));
+            iss_rb >> options.start[Rb];
         }
-
-        if (program.get<bool>("--check")) {
-            // If checking, compute phase errors
-            Si_Phase_Error = Si_Phase - Si_Phase_From_Freq;
-            Rb_Phase_Error = Rb_Phase - Rb_Phase_From_Freq;
-            H_Phase_Error = H_Phase - H_Phase_From_Freq;
-            Z_Phase_Error = Z_Phase - Z_Phase_From_Freq;
-        } 
-
-        // Convert Day and Time to Year, Month, Day, Hour, Minute, Second
-        int Year = Day / 10000;
-        Year += 2000; // Assuming the year is in the 21st century
-        int Month = (Day % 10000) / 100;
-        int DayOfMonth = Day % 100;
-        int Hour = Time / 10000;
-        int Minute = (fmod(Time, 10000) / 100);
-        double Second = fmod(Time, 100);
-
-        // Write the output to the CSV file
-        output_stream.precision(std::numeric_limits<double>::digits10);
-        output_stream << Year << " " << Month << " " << DayOfMonth << " "
-                      << Hour << " " << Minute << " " << Second << " ";
-
-        output_stream << S << " ";
-
-        output_stream.precision(std::numeric_limits<quad>::digits10);
-        if (program.get<bool>("--check")) {
-            // Write the output with phase errors
-            output_stream << Si_Phase << " " << Rb_Phase << " " << H_Phase << " " << Z_Phase << " "
-                         << Si_Freq << " " << Rb_Freq << " " << H_Freq << " " << Z_Freq << " "
-                         << Si_Phase_From_Freq << " " << Rb_Phase_From_Freq 
-                         << " " << H_Phase_From_Freq << " " << Z_Phase_From_Freq 
-                         << " " << Si_Phase_Error << " " 
-                         << Rb_Phase_Error << " "
-                         << H_Phase_Error << " "
-                         << Z_Phase_Error 
-                         << std::endl;
-        } else {
-            // Write the output without phase errors
-            output_stream << Si_Phase_From_Freq << " "
-                         << Rb_Phase_From_Freq << " "
-                         << H_Phase_From_Freq << " "
-                         << Z_Phase_From_Freq << " "
-                         << Si_Freq << " " << Rb_Freq << " " << H_Freq << " " << Z_Freq
-                         << std::endl;
+        if (!program.get<std::string>("--h_start").empty()) {
+            std::istringstream iss_h(program.get<std::string>("--h_start"));
+            iss_h >> options.start[H];
+        }
+        if (!program.get<std::string>("--z_start").empty()) {
+            std::istringstream iss_z(program.get<std::string>("--z_start"));
+            iss_z >> options.start[Z];
         }
     }
 
+    // Select the kernel for the mode once, outside the row loop
+    int result = check ? run<PhaserKernel<true>>(input_stream, output_stream, options)
+                       : run<PhaserKernel<false>>(input_stream, output_stream, options);
+
     // Close the files
     output_stream.flush();
     if (!read_stdio) {
@@ -327,5 +412,5 @@ int main(int argc, char* argv[]) {
     if (!write_stdio) {
         csv_out_file.close();
     }
-    return 0;
-}
\ No newline at end of file
+    return result;
+}
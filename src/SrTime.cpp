@@ -18,10 +18,14 @@
 #include <fstream>
 #include <ios>
 #include <iostream>
+#include <optional>
 #include <string>
 
 #include "CsvFileUtils/CsvGroupMetadata.hpp"
 #include "CsvFileUtils/CsvTimeGroup.hpp"
+#include "CsvFileUtils/Resample.hpp"
+#include "CsvFileUtils/RowSchema.hpp"
+#include "Utils/DeviationFeed.hpp"
 #include "Utils/ProgressBar.hpp"
 
 using quad = boost::multiprecision::cpp_bin_float_quad;
@@ -29,6 +33,38 @@ using quad = boost::multiprecision::cpp_bin_float_quad;
 #include "TimekeepingConfig.h"
 #include <argparse/argparse.hpp>
 
+/* Si3 vs Sr frequency rows. Only read through CsvTimeGroup::colAtTime, so
+ * nothing is bound.
+ */
+struct SiFreqRow
+{
+};
+
+using SiFreqSchema = RowSchema<SiFreqRow, Column<"Time">, Column<"Si_Freq">>;
+
+/* Si3 vs Maser phase and frequency rows, with the columns used in the main
+ * loop bound.
+ */
+struct PhaseFreqRow
+{
+    quad Si_Phase;
+    quad Si_Freq;
+};
+
+using PhaseFreqSchema = RowSchema<
+    PhaseFreqRow,
+    Column<"Day">,
+    Column<"Time">,
+    Column<"S">,
+    Column<"Si_Phase", &PhaseFreqRow::Si_Phase>,
+    Column<"Rb_Phase">,
+    Column<"H_Phase">,
+    Column<"Z_Phase">,
+    Column<"Si_Freq", &PhaseFreqRow::Si_Freq>,
+    Column<"Rb_Freq">,
+    Column<"H_Freq">,
+    Column<"Z_Freq">>;
+
 /* Argument parsing and command line interface setup
  */
 void setupArgParser(argparse::ArgumentParser& parser, int argc, char* argv[])
@@ -122,7 +158,7 @@ int main(int argc, char* argv[])
         ",\r",
         false,
         true,
-        {"Time", "Si_Freq"},
+        SiFreqSchema::colNames(),
         -1);
     CsvTimeGroup si_freq_files(
         si_freq_metadata, CsvTimeFormat::oneColStandard, false);
@@ -137,20 +173,29 @@ int main(int argc, char* argv[])
         " ",
         true,
         false,
-        {"Day",
-         "Time",
-         "S",
-         "Si_Phase",
-         "Rb_Phase",
-         "H_Phase",
-         "Z_Phase",
-         "Si_Freq",
-         "Rb_Freq",
-         "H_Freq",
-         "Z_Freq"});
+        PhaseFreqSchema::colNames());
     CsvTimeGroup phase_freq_files(
         phase_freq_metadata, CsvTimeFormat::twoColShort, false);
 
+    // Share decoded times between concurrent runs on the same data
+    if (config.contains("Shared_Dataset") && config["Shared_Dataset"].as_bool())
+    {
+        si_freq_files.useSharedDataset({"Si_Freq"});
+        phase_freq_files.useSharedDataset({});
+    }
+
+    // Find rows by time arithmetically where they were logged at a fixed
+    // rate, at the cost of parsing every row time at startup
+    if (config.contains("Time_Segments") && config["Time_Segments"].as_bool())
+    {
+        si_freq_files.useTimeSegments();
+        phase_freq_files.useTimeSegments();
+    }
+
+    // Check the schemas against the loaded column names
+    RowDecoder<SiFreqSchema> si_freq_rows(si_freq_files.metadata());
+    RowDecoder<PhaseFreqSchema> phase_freq_rows(phase_freq_files.metadata());
+
     quad si_offset = get_si_offset(config);
     std::cout << "Si3 Frequency Offset: " << si_offset << " Hz" << std::endl;
 
@@ -193,6 +238,37 @@ int main(int argc, char* argv[])
 
     quad half_time = time_step / 2;
 
+    // Resample the Si3 frequency onto the time grid once, later runs read
+    // the cached points by index
+    std::optional<ResampledColumn> si_freq_grid;
+    if (config.contains("Resample_Cache") && config["Resample_Cache"].as_bool())
+    {
+        time_delt grid_step = boost::posix_time::microseconds(
+            long(round(time_step * 1e6)));
+        try
+        {
+            si_freq_grid = ResampledColumn::build(
+                si_freq_files.snapshot(),
+                "Si_Freq",
+                epoch_time,
+                grid_step,
+                end_time);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        std::cout << "Resampled " << si_freq_grid->resampled() << " of "
+                  << si_freq_grid->size() << " Si3 frequency points"
+                  << std::endl;
+    }
+    auto si_freq_at = [&](date_time time)
+    {
+        return si_freq_grid ? si_freq_grid->valueAt(time)
+                            : si_freq_files.colAtTime(time, "Si_Freq");
+    };
+
     date_time current_time = epoch_time;
     date_time mean_time;
     long interval_count = 0;
@@ -208,18 +284,18 @@ int main(int argc, char* argv[])
         return 1;
     }
     std::cout << "Epoch data index: " << epoch_data_index << std::endl;
-    std::map<std::string, std::string> data_row
-        = phase_freq_files[epoch_data_index];
+    PhaseFreqRow data_row
+        = phase_freq_files.row(epoch_data_index, phase_freq_rows);
     date_time data_time = phase_freq_files.timeOfRow(epoch_data_index);
     std::cout << "Epoch data time: "
               << boost::posix_time::to_iso_extended_string(data_time)
               << std::endl;
-    quad data_phase = boost::lexical_cast<quad>(data_row["Si_Phase"]);
-    quad data_freq = boost::lexical_cast<quad>(data_row["Si_Freq"]);
+    quad data_phase = data_row.Si_Phase;
+    quad data_freq = data_row.Si_Freq;
     std::cout << "Epoch data phase: " << data_phase << std::endl;
     quad epoch_data_phase = data_phase;
 
-    std::map<std::string, std::string> new_data_row;
+    PhaseFreqRow new_data_row;
     quad new_data_phase;
     quad new_data_freq;
     time_delt half_time_gap = boost::posix_time::seconds(long(half_time))
@@ -270,6 +346,25 @@ int main(int argc, char* argv[])
                 << std::endl;
     output_file.precision(std::numeric_limits<quad>::digits10);
 
+    // Publish each result for monitors on this host, if configured
+    std::optional<DeviationPublisher> deviation_feed;
+    if (config.contains("Deviation_Feed"))
+    {
+        std::string feed_name = config["Deviation_Feed"].as_string().c_str();
+        try
+        {
+            deviation_feed.emplace(feed_name);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        std::cout << "Publishing results to shared memory: " << feed_name
+                  << std::endl;
+    }
+    const date_time unix_epoch(boost::gregorian::date(1970, 1, 1));
+
     std::cout << "Starting time calculation from epoch time" << std::endl;
     ProgressBar progress_bar;
     while (current_time <= end_time)
@@ -277,7 +372,7 @@ int main(int argc, char* argv[])
         // Calculate the mean time for the current interval
         mean_time = current_time;
 
-        si_frequency = si_freq_files.colAtTime(mean_time, "Si_Freq");
+        si_frequency = si_freq_at(mean_time);
         si_frequency = (si_frequency + si_offset) / si_division;
 
         // Calculate the time deviation
@@ -293,6 +388,19 @@ int main(int argc, char* argv[])
                         << h_freq << "," << data_freq << ","
                         << boost::posix_time::to_iso_extended_string(data_time)
                         << "\n";
+
+            if (deviation_feed)
+            {
+                DeviationSample sample;
+                sample.index = interval_count;
+                sample.time = (current_time - unix_epoch).total_microseconds();
+                sample.dataTime = (data_time - unix_epoch).total_microseconds();
+                sample.deviation = static_cast<double>(time_deviation);
+                sample.siFrequency = static_cast<double>(si_frequency);
+                sample.hFrequency = static_cast<double>(h_freq);
+                sample.dataFrequency = static_cast<double>(data_freq);
+                deviation_feed->publish(sample);
+            }
         }
 
         // Update the progress bar every minute
@@ -317,9 +425,9 @@ int main(int argc, char* argv[])
         acc_phase += (h_freq - si_frequency) * time_step;
         h_freq *= 1 + h_drift * time_step;
 
-        new_data_row = phase_freq_files[++epoch_data_index];
-        new_data_phase = boost::lexical_cast<quad>(new_data_row["Si_Phase"]);
-        new_data_freq = boost::lexical_cast<quad>(new_data_row["Si_Freq"]);
+        new_data_row = phase_freq_files.row(++epoch_data_index, phase_freq_rows);
+        new_data_phase = new_data_row.Si_Phase;
+        new_data_freq = new_data_row.Si_Freq;
         if (fabs((new_data_phase - data_phase) - (new_data_freq * time_step))
             > 1e-6)
         {
@@ -353,9 +461,8 @@ int main(int argc, char* argv[])
                                   - long(time_step * interval_count))
                                  * 1e6));
                 mean_time = current_time + half_time_gap;
-                si_frequency = (si_freq_files.colAtTime(mean_time, "Si_Freq")
-                                + si_offset)
-                             / si_division;
+                si_frequency
+                    = (si_freq_at(mean_time) + si_offset) / si_division;
                 acc_phase += (h_freq - si_frequency) * time_step;
 
                 h_freq *= 1 + h_drift * time_step;
@@ -364,8 +471,8 @@ int main(int argc, char* argv[])
 
         data_row = new_data_row;
         data_time = phase_freq_files.timeOfRow(epoch_data_index);
-        data_phase = boost::lexical_cast<quad>(data_row["Si_Phase"]);
-        data_freq = boost::lexical_cast<quad>(data_row["Si_Freq"]);
+        data_phase = data_row.Si_Phase;
+        data_freq = data_row.Si_Freq;
 
         interval_count++;
         current_time
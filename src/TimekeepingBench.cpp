@@ -0,0 +1,809 @@
+/*
+ * TimekeepingBench.cpp
+ * Measures the hot paths of the CSV readers, the time lookups and the quad
+ * arithmetic on synthetic data, from line map lookups up to a full SrTime run.
+ *
+ * Every benchmark is warmed up once and then timed over repeated passes, and
+ * reported as the median time per operation with its spread. Inputs and the
+ * rows looked up come from fixed seeds, so runs on the same machine are
+ * comparable. Results can be written as JSON and compared with a previous run
+ * saved as a baseline.
+ *
+ * This file is part of the TimeKeeping project.
+ *
+ */
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/json.hpp>
+#include <boost/multiprecision/cpp_bin_float.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "CsvFileUtils/CsvFile.hpp"
+#include "CsvFileUtils/CsvGroup.hpp"
+#include "CsvFileUtils/CsvTimeGroup.hpp"
+#include "CsvFileUtils/LineMapFile.hpp"
+#include "CsvFileUtils/LineMapView.hpp"
+#include "CsvFileUtils/RowArena.hpp"
+#include "CsvFileUtils/RowRange.hpp"
+#include "CsvFileUtils/RowSchema.hpp"
+#include "CsvFileUtils/SyntheticData.hpp"
+#include "Utils/FieldParse.hpp"
+
+using quad = boost::multiprecision::cpp_bin_float_quad;
+
+#include "TimekeepingConfig.h"
+#include <argparse/argparse.hpp>
+
+namespace fs = std::filesystem;
+
+/* Keeps a value observable, so the work producing it is not optimized away.
+ */
+template <typename T>
+void keep(const T& value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+/* Si3 vs Maser phase and frequency rows, with every value decoded.
+ */
+struct PhaseFreqRow
+{
+    quad Si_Phase;
+    quad Rb_Phase;
+    quad H_Phase;
+    quad Z_Phase;
+    quad Si_Freq;
+    quad Rb_Freq;
+    quad H_Freq;
+    quad Z_Freq;
+};
+
+using PhaseFreqSchema = RowSchema<
+    PhaseFreqRow,
+    Column<"Day">,
+    Column<"Time">,
+    Column<"S">,
+    Column<"Si_Phase", &PhaseFreqRow::Si_Phase>,
+    Column<"Rb_Phase", &PhaseFreqRow::Rb_Phase>,
+    Column<"H_Phase", &PhaseFreqRow::H_Phase>,
+    Column<"Z_Phase", &PhaseFreqRow::Z_Phase>,
+    Column<"Si_Freq", &PhaseFreqRow::Si_Freq>,
+    Column<"Rb_Freq", &PhaseFreqRow::Rb_Freq>,
+    Column<"H_Freq", &PhaseFreqRow::H_Freq>,
+    Column<"Z_Freq", &PhaseFreqRow::Z_Freq>>;
+
+/* The time of the first synthetic row.
+ */
+const date_time dataStart(
+    boost::gregorian::date(2025, 7, 11), boost::posix_time::hours(0));
+
+/* Writes every file of a synthetic group. Returns the bytes written.
+ */
+std::uintmax_t writeGroup(const SyntheticGroup& group)
+{
+    fs::create_directories(group.directory);
+    std::uintmax_t bytes = 0;
+    for (const auto& file : planSyntheticFiles(group))
+    {
+        bytes += writeSyntheticFile(group, file);
+    }
+    return bytes;
+}
+
+/* Timings of one benchmark.
+ */
+struct BenchResult
+{
+    std::string name;
+
+    /* Operations, rows and bytes per timed pass, rows and bytes 0 where they
+     * do not apply.
+     */
+    long ops = 0;
+    long rows = 0;
+    long bytes = 0;
+
+    /* Seconds taken by each timed pass.
+     */
+    std::vector<double> seconds;
+
+    double median() const
+    {
+        std::vector<double> sorted = seconds;
+        std::sort(sorted.begin(), sorted.end());
+        size_t middle = sorted.size() / 2;
+        return sorted.size() % 2
+                 ? sorted[middle]
+                 : (sorted[middle - 1] + sorted[middle]) / 2;
+    }
+
+    double best() const
+    {
+        return *std::min_element(seconds.begin(), seconds.end());
+    }
+
+    double mean() const
+    {
+        double sum = 0;
+        for (double s : seconds)
+        {
+            sum += s;
+        }
+        return sum / seconds.size();
+    }
+
+    double stddev() const
+    {
+        if (seconds.size() < 2)
+        {
+            return 0;
+        }
+        double m = mean();
+        double sum = 0;
+        for (double s : seconds)
+        {
+            sum += (s - m) * (s - m);
+        }
+        return std::sqrt(sum / (seconds.size() - 1));
+    }
+
+    double nsPerOp(double pass_seconds) const
+    {
+        return pass_seconds * 1e9 / ops;
+    }
+};
+
+/* Runs the benchmarks selected by a filter and collects their timings.
+ */
+struct BenchRunner
+{
+    int repeat = 7;
+    std::string filter;
+    std::vector<BenchResult> results;
+
+    bool selected(const std::string& name) const
+    {
+        return filter.empty() || name.find(filter) != std::string::npos;
+    }
+
+    /* Times repeated passes of a body doing ops operations, after one
+     * untimed pass to warm caches.
+     */
+    template <typename Body>
+    void run(const std::string& name, long ops, long rows, long bytes, Body body)
+    {
+        if (!selected(name))
+        {
+            return;
+        }
+        body();
+
+        BenchResult result{name, ops, rows, bytes, {}};
+        for (int r = 0; r < repeat; ++r)
+        {
+            auto start = std::chrono::steady_clock::now();
+            body();
+            std::chrono::duration<double> elapsed
+                = std::chrono::steady_clock::now() - start;
+            result.seconds.push_back(elapsed.count());
+        }
+        print(result);
+        results.push_back(std::move(result));
+    }
+
+    static void print(const BenchResult& result)
+    {
+        double median = result.median();
+        std::cout << std::left << std::setw(28) << result.name << std::right
+                  << std::fixed << std::setprecision(1) << std::setw(12)
+                  << result.nsPerOp(median) << " ns/op" << std::setw(7)
+                  << 100 * result.stddev() / result.mean() << "% sd";
+        if (result.rows > 0)
+        {
+            std::cout << std::setprecision(0) << std::setw(14)
+                      << result.rows / median << " rows/s";
+        }
+        if (result.bytes > 0)
+        {
+            std::cout << std::setprecision(1) << std::setw(10)
+                      << result.bytes / median / 1e6 << " MB/s";
+        }
+        std::cout << std::endl;
+    }
+};
+
+/* Converts the timings to JSON, one entry per benchmark.
+ */
+boost::json::object toJson(
+    const std::vector<BenchResult>& results, long rows, int repeat)
+{
+    boost::json::object output;
+    output["Tool"] = "TimekeepingBench";
+    output["Version"] = std::format(
+        "v{}.{}.{}",
+        Timekeeping_VERSION_MAJOR,
+        Timekeeping_VERSION_MINOR,
+        Timekeeping_VERSION_PATCH);
+    output["Git_Commit"] = GIT_COMMIT_HASH;
+    output["Git_Branch"] = GIT_BRANCH_NAME;
+    output["Rows"] = rows;
+    output["Repeat"] = repeat;
+
+    boost::json::array entries;
+    for (const auto& result : results)
+    {
+        boost::json::object entry;
+        double median = result.median();
+        entry["Name"] = result.name;
+        entry["Ops"] = result.ops;
+        entry["Rows"] = result.rows;
+        entry["Bytes"] = result.bytes;
+        entry["Median_Ns_Per_Op"] = result.nsPerOp(median);
+        entry["Best_Ns_Per_Op"] = result.nsPerOp(result.best());
+        entry["Mean_Ns_Per_Op"] = result.nsPerOp(result.mean());
+        entry["Stddev_Ns_Per_Op"] = result.nsPerOp(result.stddev());
+        entry["Rows_Per_Second"] = result.rows > 0 ? result.rows / median : 0.0;
+        entry["Bytes_Per_Second"]
+            = result.bytes > 0 ? result.bytes / median : 0.0;
+        entry["Seconds"] = boost::json::value_from(result.seconds);
+        entries.push_back(std::move(entry));
+    }
+    output["Results"] = std::move(entries);
+    return output;
+}
+
+/* Prints each benchmark's median against the same benchmark in a baseline,
+ * marking changes beyond the tolerance or three standard deviations,
+ * whichever is larger. Returns the number of benchmarks that got slower.
+ */
+int compareBaseline(
+    const std::vector<BenchResult>& results,
+    const std::string& baseline_path,
+    double tolerance)
+{
+    std::ifstream baseline_file(baseline_path);
+    if (!baseline_file)
+    {
+        throw std::runtime_error(
+            "Could not open baseline file: " + baseline_path);
+    }
+    boost::json::value baseline_json;
+    baseline_file >> baseline_json;
+
+    std::map<std::string, double> baseline;
+    for (const auto& entry :
+         baseline_json.as_object().at("Results").as_array())
+    {
+        const auto& fields = entry.as_object();
+        baseline[fields.at("Name").as_string().c_str()]
+            = fields.at("Median_Ns_Per_Op").to_number<double>();
+    }
+
+    std::cout << std::endl << "Compared with " << baseline_path << std::endl;
+    int slower = 0;
+    for (const auto& result : results)
+    {
+        auto it = baseline.find(result.name);
+        if (it == baseline.end())
+        {
+            std::cout << std::left << std::setw(28) << result.name
+                      << "not in baseline" << std::endl;
+            continue;
+        }
+        double current = result.nsPerOp(result.median());
+        double ratio = current / it->second;
+        double noise = std::max(
+            tolerance, 3 * result.stddev() / result.mean());
+        const char* verdict = "";
+        if (ratio > 1 + noise)
+        {
+            verdict = "  slower";
+            ++slower;
+        }
+        else if (ratio < 1 - noise)
+        {
+            verdict = "  faster";
+        }
+        std::cout << std::left << std::setw(28) << result.name << std::right
+                  << std::fixed << std::setprecision(1) << std::setw(12)
+                  << it->second << " -> " << std::setw(12) << current
+                  << " ns/op" << std::setprecision(3) << std::setw(8) << ratio
+                  << "x" << verdict << std::endl;
+    }
+    return slower;
+}
+
+/* Runs SrTime over the synthetic groups with a generated configuration.
+ * Returns false if SrTime failed.
+ */
+bool runSrTime(
+    const std::string& srtime,
+    const fs::path& directory,
+    const SyntheticGroup& phase_freq_data,
+    const SyntheticGroup& si_data,
+    double seconds,
+    const std::string& step)
+{
+    date_time end = dataStart
+                  + boost::posix_time::seconds(long(seconds))
+                  - boost::posix_time::seconds(10);
+
+    boost::json::object config;
+    config["Epoch_Time"]
+        = boost::posix_time::to_iso_extended_string(dataStart);
+    config["Start_Time"]
+        = boost::posix_time::to_iso_extended_string(dataStart);
+    config["End_Time"] = boost::posix_time::to_iso_extended_string(end);
+    config["Time_Step"] = step;
+    config["Output_File"] = (directory / "SrTime.csv").string();
+    config["Si3_Data_Path"] = si_data.directory;
+    config["Si3_Maser_Data_Path"] = phase_freq_data.directory;
+    config["Si3_Data_Template"] = syntheticMetadata(si_data).dataTemplate();
+    config["Si3_Maser_Data_Template"]
+        = syntheticMetadata(phase_freq_data).dataTemplate();
+    config["Si3_Major_Offset"] = "194.397648670701e12";
+    config["Si3_Minor_Offset"] = "77.7588759615e6";
+    config["Si3_Division"] = 777577;
+    config["Maser_Nominal_Frequency"] = "251e6";
+    config["Maser_Starting_Fractional_Offset"] = "-8.238383023387408e-12";
+    config["Maser_Fractional_Drift_Rate"] = "-2.333e-20";
+
+    fs::path config_path = directory / "SrTime.json";
+    std::ofstream(config_path) << boost::json::serialize(config) << std::endl;
+
+    std::string command = std::format(
+        "\"{}\" -c \"{}\" > \"{}\" 2>&1",
+        srtime,
+        config_path.string(),
+        (directory / "SrTime.log").string());
+    return std::system(command.c_str()) == 0;
+}
+
+int main(int argc, char* argv[])
+{
+    argparse::ArgumentParser parser(
+        "TimekeepingBench",
+        std::format(
+            "v{}.{}", Timekeeping_VERSION_MAJOR, Timekeeping_VERSION_MINOR),
+        argparse::default_arguments::all,
+        true);
+    parser.add_description(
+        "TimekeepingBench - Measure the CSV reading, time lookup and quad hot "
+        "paths on synthetic data.");
+    parser.add_argument("-n", "--rows")
+        .nargs(1)
+        .default_value("200000")
+        .help("Number of synthetic PhaseFreq rows, Si3 gets a fifth as many.");
+    parser.add_argument("-r", "--repeat")
+        .nargs(1)
+        .default_value("7")
+        .help("Number of timed passes per benchmark.");
+    parser.add_argument("-f", "--filter")
+        .nargs(1)
+        .default_value("")
+        .help("Only run benchmarks whose name contains this text.");
+    parser.add_argument("-d", "--directory")
+        .nargs(1)
+        .default_value(
+            (fs::temp_directory_path() / "TimekeepingBench").string())
+        .help("Directory for the synthetic data, replaced on each run.");
+    parser.add_argument("-j", "--json")
+        .nargs(1)
+        .default_value("")
+        .help("Write the results as JSON to this file.");
+    parser.add_argument("-b", "--baseline")
+        .nargs(1)
+        .default_value("")
+        .help("Compare the results with a JSON file from an earlier run.");
+    parser.add_argument("-t", "--tolerance")
+        .nargs(1)
+        .default_value("0.05")
+        .help("Smallest relative change reported against the baseline.");
+    parser.add_argument("--srtime")
+        .nargs(1)
+        .default_value("")
+        .help("SrTime executable for the full run, defaults to the one "
+              "beside this benchmark.");
+    parser.add_argument("--keep")
+        .default_value(false)
+        .implicit_value(true)
+        .help("Keep the synthetic data after the run.");
+
+    try
+    {
+        parser.parse_args(argc, argv);
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    long rows = std::max(1000L, std::stol(parser.get<std::string>("--rows")));
+    BenchRunner bench;
+    bench.repeat = std::max(1, std::stoi(parser.get<std::string>("--repeat")));
+    bench.filter = parser.get<std::string>("--filter");
+    fs::path directory = parser.get<std::string>("--directory");
+
+    // Synthetic data, the same on every run
+    fs::remove_all(directory);
+    long si_rows = rows / 5;
+    SyntheticGroup phase_freq_data;
+    phase_freq_data.directory = (directory / "PhaseFreq").string();
+    phase_freq_data.prefix = "PF";
+    phase_freq_data.start = toTicks(dataStart);
+    phase_freq_data.duration = rows * phase_freq_data.interval;
+    phase_freq_data.files = 4;
+    phase_freq_data.commentEvery = rows / 4;
+    SyntheticGroup si_data;
+    si_data.layout = SyntheticLayout::si3;
+    si_data.directory = (directory / "Si3").string();
+    si_data.prefix = "Si3";
+    si_data.start = toTicks(dataStart);
+    si_data.interval = 500000;
+    si_data.duration = si_rows * si_data.interval;
+
+    std::cout << "Generating " << rows << " PhaseFreq and " << si_rows
+              << " Si3 rows in " << directory << std::endl;
+    long phase_freq_bytes = writeGroup(phase_freq_data);
+    writeGroup(si_data);
+
+    CsvGroupMetadata phase_freq_metadata = syntheticMetadata(phase_freq_data);
+    CsvGroupMetadata si_metadata = syntheticMetadata(si_data);
+    CsvGroup phase_freq(phase_freq_metadata, true);
+    CsvTimeGroup si(si_metadata, CsvTimeFormat::oneColStandard, true);
+    CsvTimeGroup si_segments(si_metadata, CsvTimeFormat::oneColStandard);
+    si_segments.useTimeSegments();
+
+    const long lookups = 100000;
+    std::mt19937_64 random(42);
+    std::vector<long> random_rows(lookups);
+    std::uniform_int_distribution<long> row_distribution(
+        0, phase_freq.metadata().size() - 1);
+    for (auto& row : random_rows)
+    {
+        row = row_distribution(random);
+    }
+
+    // Line maps
+    std::string first_file
+        = phase_freq.metadata().dataPaths().front();
+    long first_file_rows = phase_freq.snapshot().fileRows(0).second;
+    std::vector<long> file_rows(lookups);
+    std::uniform_int_distribution<long> file_row_distribution(
+        0, first_file_rows - 1);
+    for (auto& row : file_rows)
+    {
+        row = file_row_distribution(random);
+    }
+    LineMapFile line_map(first_file + ".cache");
+    bench.run(
+        "linemap.file.lookup",
+        lookups,
+        0,
+        0,
+        [&]
+        {
+            std::streamoff sum = 0;
+            for (long row : file_rows)
+            {
+                sum += line_map[row];
+            }
+            keep(sum);
+        });
+    LineMapView line_view(first_file + ".cache", first_file_rows);
+    bench.run(
+        "linemap.view.lookup",
+        lookups,
+        0,
+        0,
+        [&]
+        {
+            std::streamoff sum = 0;
+            for (long row : file_rows)
+            {
+                sum += line_view[row];
+            }
+            keep(sum);
+        });
+
+    // Indexing a file from scratch
+    CsvFileMetadata index_metadata(
+        (directory / "index.txt").string(),
+        "",
+        "",
+        "#",
+        " ",
+        true,
+        false,
+        PhaseFreqSchema::colNames(),
+        -1);
+    fs::copy_file(first_file, directory / "index.txt");
+    bench.run(
+        "csvfile.update",
+        first_file_rows,
+        first_file_rows,
+        fs::file_size(first_file),
+        [&]
+        {
+            CsvFile file(index_metadata, true);
+            keep(file.metadata().size());
+        });
+
+    // Reading rows at random
+    long random_bytes = 0;
+    for (long row : random_rows)
+    {
+        random_bytes += phase_freq.getRawLine(row).size() + 1;
+    }
+    bench.run(
+        "group.raw_line",
+        lookups,
+        lookups,
+        random_bytes,
+        [&]
+        {
+            size_t sum = 0;
+            for (long row : random_rows)
+            {
+                sum += phase_freq.getRawLine(row).size();
+            }
+            keep(sum);
+        });
+    bench.run(
+        "group.row_map",
+        lookups,
+        lookups,
+        random_bytes,
+        [&]
+        {
+            size_t sum = 0;
+            for (long row : random_rows)
+            {
+                sum += phase_freq.getRow(row).size();
+            }
+            keep(sum);
+        });
+    RowArena arena;
+    bench.run(
+        "group.row_arena",
+        lookups,
+        lookups,
+        random_bytes,
+        [&]
+        {
+            size_t sum = 0;
+            for (long i = 0; i < lookups; ++i)
+            {
+                if (i % 1024 == 0)
+                {
+                    arena.reset();
+                }
+                sum += phase_freq.getRow(random_rows[i], arena)["Si_Freq"].size();
+            }
+            keep(sum);
+        });
+    RowDecoder<PhaseFreqSchema> decoder(phase_freq.metadata());
+    bench.run(
+        "group.row_typed",
+        lookups,
+        lookups,
+        random_bytes,
+        [&]
+        {
+            quad sum = 0;
+            for (long row : random_rows)
+            {
+                sum += phase_freq.getRow(row, decoder).Si_Freq;
+            }
+            keep(sum);
+        });
+
+    // Reading every row in order
+    bench.run(
+        "group.scan_typed",
+        phase_freq.metadata().size(),
+        phase_freq.metadata().size(),
+        phase_freq_bytes,
+        [&]
+        {
+            quad sum = 0;
+            for (const auto& row : RowRange<PhaseFreqSchema>(
+                     phase_freq.snapshot()))
+            {
+                sum += row->Si_Freq;
+            }
+            keep(sum);
+        });
+
+    // Time lookups, inside the rows and past either end
+    date_time si_start = si.timeOfRow(0);
+    long si_span
+        = (si.timeOfRow(si_rows - 1) - si_start).total_microseconds();
+    std::uniform_int_distribution<long> offset_distribution(0, si_span);
+    std::vector<date_time> times(lookups);
+    std::vector<date_time> outside_times(lookups);
+    for (long i = 0; i < lookups; ++i)
+    {
+        times[i] = si_start
+                 + boost::posix_time::microseconds(
+                     offset_distribution(random));
+        outside_times[i] = si_start
+                         + boost::posix_time::microseconds(
+                             (i % 2 ? 2 : -1) * si_span
+                             + offset_distribution(random) % 1000000);
+    }
+    for (auto* group : {&si, &si_segments})
+    {
+        std::string prefix
+            = group == &si ? "time.search." : "time.segments.";
+        bench.run(
+            prefix + "bounds",
+            lookups,
+            0,
+            0,
+            [&]
+            {
+                size_t sum = 0;
+                for (const auto& time : times)
+                {
+                    sum += group->bounds(time).second;
+                }
+                keep(sum);
+            });
+        bench.run(
+            prefix + "col_at_time",
+            lookups,
+            0,
+            0,
+            [&]
+            {
+                quad sum = 0;
+                for (const auto& time : times)
+                {
+                    sum += group->colAtTime(time, "Si_Freq");
+                }
+                keep(sum);
+            });
+    }
+    bench.run(
+        "time.extrapolate",
+        lookups,
+        0,
+        0,
+        [&]
+        {
+            quad sum = 0;
+            for (const auto& time : outside_times)
+            {
+                sum += si.colAtTime(time, "Si_Freq");
+            }
+            keep(sum);
+        });
+
+    // Quad parsing and arithmetic
+    std::vector<std::string> fields;
+    for (long i = 0; i < 4096; ++i)
+    {
+        fields.push_back(std::format(
+            "{:.9f}", 995532.6897452829 * (1 + 1e-9 * (i % 13))));
+    }
+    bench.run(
+        "quad.parse",
+        fields.size(),
+        0,
+        0,
+        [&]
+        {
+            quad sum = 0;
+            quad value;
+            for (const auto& field : fields)
+            {
+                parseField(field, value);
+                sum += value;
+            }
+            keep(sum);
+        });
+    const long arithmetic_ops = 1000000;
+    bench.run(
+        "quad.multiply_add_divide",
+        arithmetic_ops,
+        0,
+        0,
+        [&]
+        {
+            quad phase = 0;
+            quad interval("0.1");
+            quad frequency("995532.6897452829");
+            quad nominal("10000000.00754296");
+            for (long i = 0; i < arithmetic_ops; ++i)
+            {
+                phase += frequency * interval / nominal;
+            }
+            keep(phase);
+        });
+
+    // A full SrTime run, one output row per second of Si3 data
+    if (bench.selected("srtime.run"))
+    {
+        std::string srtime = parser.get<std::string>("--srtime");
+        if (srtime.empty())
+        {
+            srtime = (fs::absolute(argv[0]).parent_path() / "SrTime").string();
+        }
+        double seconds = rows / 10.0;
+        long intervals = long(seconds) - 10;
+        if (!runSrTime(
+                srtime, directory, phase_freq_data, si_data, seconds, "1"))
+        {
+            std::cout << std::left << std::setw(28) << "srtime.run"
+                      << "skipped, " << srtime << " failed, see "
+                      << (directory / "SrTime.log").string() << std::endl;
+        }
+        else
+        {
+            bench.run(
+                "srtime.run",
+                intervals,
+                intervals,
+                0,
+                [&]
+                {
+                    runSrTime(
+                        srtime,
+                        directory,
+                        phase_freq_data,
+                        si_data,
+                        seconds,
+                        "1");
+                });
+        }
+    }
+
+    std::string json_path = parser.get<std::string>("--json");
+    if (!json_path.empty())
+    {
+        std::ofstream json_file(json_path);
+        json_file << boost::json::serialize(
+            toJson(bench.results, rows, bench.repeat))
+                  << std::endl;
+        std::cout << "Results written to: " << json_path << std::endl;
+    }
+
+    int slower = 0;
+    std::string baseline_path = parser.get<std::string>("--baseline");
+    if (!baseline_path.empty())
+    {
+        try
+        {
+            slower = compareBaseline(
+                bench.results,
+                baseline_path,
+                std::stod(parser.get<std::string>("--tolerance")));
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    if (!parser.get<bool>("--keep"))
+    {
+        fs::remove_all(directory);
+    }
+    return slower > 0 ? 2 : 0;
+}
@@ -1,5 +1,12 @@
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <sstream>
+#include <string_view>
+#include <vector>
+#include <unistd.h>
 
 #include <cmath>
 #include <boost/multiprecision/cpp_bin_float.hpp>
@@ -7,6 +14,12 @@
 #include <argparse/argparse.hpp>
 #include <TimekeepingConfig.h>
 
+#include "CsvFileUtils/CsvFile.hpp"
+#include "CsvFileUtils/CsvGroup.hpp"
+#include "Utils/Channels.hpp"
+#include "Utils/LineChunks.hpp"
+#include "Utils/TimerKernel.hpp"
+
 using quad = boost::multiprecision::cpp_bin_float_quad;
 
 /*
@@ -36,6 +49,15 @@ using quad = boost::multiprecision::cpp_bin_float_quad;
  * --rb_error_freq: Specify the frequency of the Rb data phase errors. Defaults to --rb_freq.
  * --h_error_freq: Specify the frequency of the H data phase errors. Defaults to --h_freq.
  * --z_error_freq: Specify the frequency of the Z data phase errors. Defaults to --z_freq.
+ * --threads: Number of worker threads, 0 for one per core. Default is 1 (serial).
+ * --path: Parent directory of a group of Phaser output files to read instead of in_file.
+ * --template: Regex matching the files of the group under --path, a single positional argument
+ *             then names the output file.
+ *
+ * With more than one thread the input file, or the group given by --template, is indexed and
+ * row ranges are processed concurrently, each row's interval count taken from its position in
+ * the input. A single input file is indexed into a temporary directory, so its own directory
+ * is never written to.
  */
 void parse_args(argparse::ArgumentParser& program, int argc, char* argv[]) {
 
@@ -99,6 +121,21 @@ void parse_args(argparse::ArgumentParser& program, int argc, char* argv[]) {
         .default_value("")
         .help("Specify the frequency of the Z data phase errors. Defaults to --z_freq.");
 
+    program.add_argument("-j", "--threads")
+        .nargs(1)
+        .default_value("1")
+        .help("Number of worker threads, 0 for one per core. Default is 1 (serial).");
+
+    program.add_argument("--path")
+        .nargs(1)
+        .default_value(".")
+        .help("Parent directory of a group of Phaser output files, used with --template.");
+
+    program.add_argument("--template")
+        .nargs(1)
+        .default_value("")
+        .help("Regex matching the files of the group under --path, read instead of in_file.");
+
     program.add_argument("in_file")
         .default_value("")
         .help("Input CSV file, required unless --io is used.");
@@ -121,6 +158,107 @@ void parse_args(argparse::ArgumentParser& program, int argc, char* argv[]) {
     }
 }
 
+/*
+ * Main loop, reading and writing one line at a time.
+ */
+template <typename Kernel>
+int run_serial(std::istream& input_stream, std::ostream& output_stream, const std::string& in_file,
+               const TimerParameters& parameters) {
+    long long interval_n = 0;
+
+    // Fields for input and output data
+    TimerRow row;
+    Channels<quad> Time;
+
+    // Read the input file line by line
+
+    std::string newline;
+    bool first_line = true;
+
+    while (std::getline(input_stream, newline)) {
+        // Process each line of input
+        // Output file will add the computed columns: Si_Time, Rb_Time, H_Time, Z_Time
+        // Comment lines starting with '#' are ignored
+
+        if (newline.empty() || newline[0] == '#') {
+            continue;
+        }
+
+        if (first_line) {
+            // Print header for the output CSV
+            Kernel::writeHeader(output_stream, in_file, parameters);
+
+            first_line = false;
+
+            continue; // Skip the header line
+        }
+
+        // Parse the line into variables
+        if (!Kernel::parse(newline, row)) {
+            std::cerr << "Error reading line: " << newline << std::endl;
+            continue; // Skip this line if reading fails
+        }
+
+        // Compute the time values from the phase data
+        Time = Kernel::compute(row, ++interval_n, parameters);
+
+        // Write the output to the CSV file
+        Kernel::write(output_stream, row, Time);
+    }
+
+    return 0;
+}
+
+/*
+ * Indexed main loop, processing row ranges on several threads.
+ *
+ * Each row only depends on its own values and its position in the input, so the rows are
+ * processed in batches, each batch split into one contiguous range per thread. The ranges
+ * are formatted concurrently and written in order before the next batch starts, so output
+ * streams with bounded memory. for_each_line(first, last, body) calls body(index, line) for
+ * each row of a range, and must be safe to call from several threads at once.
+ */
+template <typename Kernel, typename ForEachLine>
+int run_indexed(long rows, ForEachLine for_each_line, std::ostream& output_stream,
+                const std::string& in_file, const TimerParameters& parameters, size_t threads) {
+    // Print header for the output CSV
+    Kernel::writeHeader(output_stream, in_file, parameters);
+
+    const long batch_rows = threads * 16384;
+
+    for (long batch_start = 0; batch_start < rows; batch_start += batch_rows) {
+        long batch_end = std::min(rows, batch_start + batch_rows);
+        std::vector<std::ostringstream> outputs(threads);
+        std::vector<std::vector<std::string>> errors(threads);
+
+        parallelFor(threads, [&](size_t t) {
+            long first = batch_start + (batch_end - batch_start) * t / threads;
+            long last = batch_start + (batch_end - batch_start) * (t + 1) / threads;
+
+            TimerRow row;
+            for_each_line(first, last, [&](long index, std::string_view line) {
+                if (!Kernel::parse(line, row)) {
+                    errors[t].emplace_back(line);
+                    return; // Skip this line if reading fails
+                }
+
+                // The interval count is the 1-based position of the row in the input
+                Kernel::write(outputs[t], row, Kernel::compute(row, index + 1, parameters));
+            });
+        });
+
+        // Write the ranges out in input order
+        for (size_t t = 0; t < threads; ++t) {
+            for (const auto& error : errors[t]) {
+                std::cerr << "Error reading line: " << error << std::endl;
+            }
+            output_stream << outputs[t].view();
+        }
+    }
+
+    return 0;
+}
+
 /*
  * Main entry point for the Timer application.
  */
@@ -141,6 +279,14 @@ int main(int argc, char* argv[]) {
     std::string in_file = program.get<std::string>("in_file");
     std::string out_file = program.get<std::string>("out_file");
 
+    // A group given by --template replaces the input file, a single positional argument then names the output
+    if (!program.get<std::string>("--template").empty()) {
+        if (out_file.empty()) {
+            out_file = in_file;
+        }
+        in_file = "";
+    }
+
     // If the input or output file is not specified, use stdin/stdout
     if (in_file.empty() || in_file == "stdin") {
         read_stdio = true;
@@ -175,219 +321,146 @@ int main(int argc, char* argv[]) {
     std::istream input_stream(read_stdio ? std::cin.rdbuf() : csv_in_file.rdbuf());
     std::ostream output_stream(write_stdio ? std::cout.rdbuf() : csv_out_file.rdbuf());
 
+    // Read all options once, the kernels never look at the parser
+    TimerParameters parameters;
+    bool error = program.get<bool>("--error");
+
     // Parse start time and interval
-    quad reference_time = 0; // Default reference time
     if (!program.get<std::string>("--start").empty()) {
         std::istringstream iss_start(program.get<std::string>("--start"));
-        if (!(iss_start >> reference_time)) {
+        if (!(iss_start >> parameters.referenceTime)) {
             std::cerr << "Error: Invalid start time value: " << program.get<std::string>("--start") << std::endl;
             return 1;
         }
     }
 
-    quad interval = 0.1; // Default interval
-    if (program.get<bool>("--error")) {
+    if (error) {
         if (!program.get<std::string>("--interval").empty()) {
             std::istringstream iss_int(program.get<std::string>("--interval"));
-            if (!(iss_int >> interval)) {
+            if (!(iss_int >> parameters.interval)) {
                 std::cerr << "Error: Invalid interval value: " << program.get<std::string>("--interval") << std::endl;
                 return 1;
             }
         }
     }
 
-    long long interval_n = 0;
-
-    // Fields for input data
-    int Year = 0;
-    int Month = 0;
-    int Day = 0;
-    int Hour = 0;
-    int Minute = 0;
-    quad Second = 0.0;
-
-    int S = 0;
-
-    quad Si_Phase = 0;
-    quad Rb_Phase = 0;
-    quad H_Phase = 0;
-    quad Z_Phase = 0;
-
-    quad Si_Freq = 1;
-    quad Rb_Freq = 1;
-    quad H_Freq = 1;
-    quad Z_Freq = 1;
-
-    // Fields for output data
-    quad Si_Mean_Freq = 1;
-    quad Rb_Mean_Freq = 1;
-    quad H_Mean_Freq = 1;
-    quad Z_Mean_Freq = 1;
-    quad Si_Error_Freq = 0;
-    quad Rb_Error_Freq = 0;
-    quad H_Error_Freq = 0;
-    quad Z_Error_Freq = 0;
-
-    quad Si_Time = 0;
-    quad Rb_Time = 0;
-    quad H_Time = 0;
-    quad Z_Time = 0;
-
     // Read reference frequencies from command-line arguments
-    if (!program.get<std::string>("--si_freq").empty()) {
-        std::istringstream iss_si(program.get<std::string>("--si_freq"));
-        if (!(iss_si >> Si_Mean_Freq)) {
-            std::cerr << "Error: Invalid Si Frequency value: " << program.get<std::string>("--si_freq") << std::endl;
-            return 1;
+    const char* channel_names[channelCount] = {"si", "rb", "h", "z"};
+    const char* channel_labels[channelCount] = {"Si", "Rb", "H", "Z"};
+    for (size_t c = 0; c < channelCount; ++c) {
+        parameters.meanFreq[c] = 1;
+        std::string freq_arg = std::string("--") + channel_names[c] + "_freq";
+        if (!program.get<std::string>(freq_arg).empty()) {
+            std::istringstream iss_freq(program.get<std::string>(freq_arg));
+            if (!(iss_freq >> parameters.meanFreq[c])) {
+                std::cerr << "Error: Invalid " << channel_labels[c] << " Frequency value: "
+                          << program.get<std::string>(freq_arg) << std::endl;
+                return 1;
+            }
         }
     }
-    if (!program.get<std::string>("--rb_freq").empty()) {
-        std::istringstream iss_rb(program.get<std::string>("--rb_freq"));
-        if (!(iss_rb >> Rb_Mean_Freq)) {
-            std::cerr << "Error: Invalid Rb Frequency value: " << program.get<std::string>("--rb_freq") << std::endl;
-            return 1;
+
+    // Read error frequencies if --error is specified
+    if (error) {
+        for (size_t c = 0; c < channelCount; ++c) {
+            std::string error_freq_arg = std::string("--") + channel_names[c] + "_error_freq";
+            if (!program.get<std::string>(error_freq_arg).empty()) {
+                std::istringstream iss_err(program.get<std::string>(error_freq_arg));
+                if (!(iss_err >> parameters.errorFreq[c])) {
+                    std::cerr << "Error: Invalid " << channel_labels[c] << " Error Frequency value: "
+                              << program.get<std::string>(error_freq_arg) << std::endl;
+                    return 1;
+                }
+            } else {
+                // Matches the input frequency field before any row is read
+                parameters.errorFreq[c] = 1;
+            }
         }
     }
-    if (!program.get<std::string>("--h_freq").empty()) {
-        std::istringstream iss_h(program.get<std::string>("--h_freq"));
-        if (!(iss_h >> H_Mean_Freq)) {
-            std::cerr << "Error: Invalid H Frequency value: " << program.get<std::string>("--h_freq") << std::endl;
+
+    // Parse the number of worker threads
+    long threads_requested = 1;
+    {
+        std::istringstream iss_threads(program.get<std::string>("--threads"));
+        if (!(iss_threads >> threads_requested) || threads_requested < 0) {
+            std::cerr << "Error: Invalid thread count: " << program.get<std::string>("--threads") << std::endl;
             return 1;
         }
     }
-    if (!program.get<std::string>("--z_freq").empty()) {
-        std::istringstream iss_z(program.get<std::string>("--z_freq"));
-        if (!(iss_z >> Z_Mean_Freq)) {
-            std::cerr << "Error: Invalid Z Frequency value: " << program.get<std::string>("--z_freq") << std::endl;
-            return 1;
-        }
+    size_t threads = workerCount(threads_requested);
+
+    std::string group_template = program.get<std::string>("--template");
+    if (group_template.empty() && threads > 1 && read_stdio) {
+        std::cerr << "Warning: Parallel mode needs an input file or --template, running serially." << std::endl;
     }
 
-    // Read error frequencies if --error is specified
-    if (program.get<bool>("--error")) {
-        if (!program.get<std::string>("--si_error_freq").empty()) {
-            std::istringstream iss_si_err(program.get<std::string>("--si_error_freq"));
-            if (!(iss_si_err >> Si_Error_Freq)) {
-                std::cerr << "Error: Invalid Si Error Frequency value: " << program.get<std::string>("--si_error_freq") << std::endl;
-                return 1;
-            }
-        } else {
-            Si_Error_Freq = Si_Freq;
-        }
-        if (!program.get<std::string>("--rb_error_freq").empty()) {
-            std::istringstream iss_rb_err(program.get<std::string>("--rb_error_freq"));
-            if (!(iss_rb_err >> Rb_Error_Freq)) {
-                std::cerr << "Error: Invalid Rb Error Frequency value: " << program.get<std::string>("--rb_error_freq") << std::endl;
-                return 1;
-            }
-        } else {
-            Rb_Error_Freq = Rb_Freq;
-        }
-        if (!program.get<std::string>("--h_error_freq").empty()) {
-            std::istringstream iss_h_err(program.get<std::string>("--h_error_freq"));
-            if (!(iss_h_err >> H_Error_Freq)) {
-                std::cerr << "Error: Invalid H Error Frequency value: " << program.get<std::string>("--h_error_freq") << std::endl;
-                return 1;
-            }
-        } else {
-            H_Error_Freq = H_Freq;
+    int result = 0;
+    if (!group_template.empty()) {
+        // Index the group, with its caches beside the data files
+        std::unique_ptr<CsvGroup> group;
+        try {
+            CsvGroupMetadata metadata(program.get<std::string>("--path"), group_template, {}, "", "#", " ", true,
+                                      true);
+            group = std::make_unique<CsvGroup>(metadata);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: Could not index input files: " << e.what() << std::endl;
+            return 1;
         }
-        if (!program.get<std::string>("--z_error_freq").empty()) {
-            std::istringstream iss_z_err(program.get<std::string>("--z_error_freq"));
-            if (!(iss_z_err >> Z_Error_Freq)) {
-                std::cerr << "Error: Invalid Z Error Frequency value: " << program.get<std::string>("--z_error_freq") << std::endl;
-                return 1;
+        std::string input_name = program.get<std::string>("--path") + "/" + group_template;
+
+        // The workers share one snapshot of the group and each reads its range through its own cursor
+        CsvGroupSnapshot snapshot = group->snapshot();
+        auto group_lines = [&snapshot](long first, long last, auto&& body) {
+            CsvGroupCursor cursor = snapshot.cursor(first);
+            for (long index = first; index < last && cursor.next(); ++index) {
+                body(index, cursor.line());
             }
-        } else {
-            Z_Error_Freq = Z_Freq;
-        }
-    } 
-
-
-    // Read the input file line by line
-
-    std::string newline;
-    bool first_line = true;
-
-    while (std::getline(input_stream, newline)) {
-        // Process each line of input
-        // Input file has columns: Year, Month, Day, Hour, Minute, Second, S, Si_Phase, Rb_Phase, H_Phase, Z_Phase, Si_Freq, Rb_Freq, H_Freq, Z_Freq
-        // Output file will add the computed columns: Si_Time, Rb_Time, H_Time, Z_Time
-        // Comment lines starting with '#' are ignored
-
-        if (newline.empty() || newline[0] == '#') {
-            continue;
+        };
+
+        // Select the kernel for the mode once, outside the row loop
+        result = error ? run_indexed<TimerKernel<true>>(snapshot.size(), group_lines, output_stream, input_name,
+                                                        parameters, threads)
+                       : run_indexed<TimerKernel<false>>(snapshot.size(), group_lines, output_stream, input_name,
+                                                         parameters, threads);
+    } else if (threads > 1 && !read_stdio) {
+        // Index just the input file, keeping the line map and metadata out of the data directory
+        std::filesystem::path index_dir = std::filesystem::temp_directory_path() /
+                                          ("Timer_" + std::to_string(::getpid()));
+        std::unique_ptr<CsvFile> file;
+        try {
+            std::filesystem::create_directories(index_dir);
+            CsvFileMetadata metadata(in_file, (index_dir / "input.cache").string(),
+                                     (index_dir / "input.json").string(), "#", " ", true, true);
+            file = std::make_unique<CsvFile>(metadata, true);
+        } catch (const std::exception& e) {
+            std::error_code ignored;
+            std::filesystem::remove_all(index_dir, ignored);
+            std::cerr << "Error: Could not index input file: " << e.what() << std::endl;
+            return 1;
         }
 
-        if (first_line) {
-            // Print header for the output CSV
-            output_stream.precision(std::numeric_limits<quad>::digits10);
-            output_stream << "#Time data computed from Phase data by Timer tool." << std::endl;
-            output_stream << "#Input file: " << program.get<std::string>("in_file") << std::endl;
-            output_stream << "#Si Frequency: " << Si_Mean_Freq << " seconds" << std::endl;
-            output_stream << "#Rb Frequency: " << Rb_Mean_Freq << " seconds" << std::endl;
-            output_stream << "#H Frequency: " << H_Mean_Freq << " seconds" << std::endl;
-            output_stream << "#Z Frequency: " << Z_Mean_Freq << " seconds" << std::endl;
-            output_stream << "#Reference time: " << reference_time << " seconds" << std::endl;
-            if (program.get<bool>("--error")) {
-                output_stream << "#Interval: " << interval << " seconds" << std::endl;
-                output_stream << "#Si Error Frequency: " << Si_Error_Freq << " seconds" << std::endl;
-                output_stream << "#Rb Error Frequency: " << Rb_Error_Freq << " seconds" << std::endl;
-                output_stream << "#H Error Frequency: " << H_Error_Freq << " seconds" << std::endl;
-                output_stream << "#Z Error Frequency: " << Z_Error_Freq << " seconds" << std::endl;
-                output_stream << "#Time errors computed from Phase data." << std::endl;
+        // The workers share the file's view, each reading its own lines
+        const CsvFileView& view = file->view();
+        auto file_lines = [&view](long first, long last, auto&& body) {
+            std::string line;
+            for (long index = first; index < last; ++index) {
+                view.readLine(index, line);
+                body(index, line);
             }
-
-            output_stream << "Year Month Day Hour Minute Second S Si_Phase Rb_Phase H_Phase Z_Phase Si_Freq Rb_Freq H_Freq Z_Freq "
-                            << "Si_Time Rb_Time H_Time Z_Time" << std::endl;
-
-            first_line = false;
-
-            continue; // Skip the header line
-        }
-
-        // Parse the line into variables
-        std::istringstream iss(newline);
-        if(!(iss >> Year >> Month >> Day >> Hour >> Minute >> Second >> S 
-                >> Si_Phase >> Rb_Phase >> H_Phase >> Z_Phase
-            >> Si_Freq >> Rb_Freq >> H_Freq >> Z_Freq)) {
-            std::cerr << "Error reading line: " << newline << std::endl;
-            continue; // Skip this line if reading fails
-        }
-
-        // Compute the time values from the phase data
-        if (!program.get<bool>("--error")) {
-
-            // Cumulative time calculation
-            Si_Time = Si_Phase / Si_Mean_Freq + reference_time;
-            Rb_Time = Rb_Phase / Rb_Mean_Freq + reference_time;
-            H_Time = H_Phase / H_Mean_Freq + reference_time;
-            Z_Time = Z_Phase / Z_Mean_Freq + reference_time;
-
-        } else {
-
-            // Time error calculation
-            interval_n ++;
-            Si_Time = (Si_Phase - (interval_n * interval * Si_Mean_Freq)) / Si_Error_Freq;
-            Rb_Time = (Rb_Phase - interval_n * interval * Rb_Mean_Freq) / Rb_Error_Freq;
-            H_Time = (H_Phase - interval_n * interval * H_Mean_Freq) / H_Error_Freq;
-            Z_Time = (Z_Phase - interval_n * interval * Z_Mean_Freq) / Z_Error_Freq;
-
-        }
-
-        // Write the output to the CSV file
-
-        output_stream.precision(std::numeric_limits<double>::digits10);
-        output_stream << Year << " " << Month << " " << Day << " "
-                      << Hour << " " << Minute << " " << Second << " ";
-
-        output_stream << S << " ";
-
-        output_stream.precision(std::numeric_limits<quad>::digits10);
-        output_stream << Si_Phase << " " << Rb_Phase << " " << H_Phase << " " << Z_Phase << " "
-                      << Si_Freq << " " << Rb_Freq << " " << H_Freq << " " << Z_Freq << " "
-                      << Si_Time << " " << Rb_Time << " " << H_Time << " " << Z_Time
-                     << std::endl;
+        };
+
+        // Select the kernel for the mode once, outside the row loop
+        result = error ? run_indexed<TimerKernel<true>>(view.size(), file_lines, output_stream, in_file,
+                                                        parameters, threads)
+                       : run_indexed<TimerKernel<false>>(view.size(), file_lines, output_stream, in_file,
+                                                         parameters, threads);
+        file.reset();
+        std::error_code ignored;
+        std::filesystem::remove_all(index_dir, ignored);
+    } else {
+        // Select the kernel for the mode once, outside the row loop
+        result = error ? run_serial<TimerKernel<true>>(input_stream, output_stream, in_file, parameters)
+                       : run_serial<TimerKernel<false>>(input_stream, output_stream, in_file, parameters);
     }
 
     // Close the files
@@ -398,5 +471,5 @@ int main(int argc, char* argv[]) {
     if (!write_stdio) {
         csv_out_file.close();
     }
-    return 0;
-}
\ No newline at end of file
+    return result;
+}
@@ -0,0 +1,201 @@
+#include "TkdClient.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+/**
+ * @brief Throws a std::runtime_error describing errno.
+ */
+[[noreturn]] void throwErrno(const std::string &what) {
+  throw std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+/**
+ * @brief Reads exactly the given number of bytes from a socket.
+ */
+void readExactly(int fd, char *data, std::size_t size) {
+  while (size > 0) {
+    ssize_t count = recv(fd, data, size, 0);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count < 0) {
+      throwErrno("Could not read from tkd");
+    }
+    if (count == 0) {
+      throw std::runtime_error("tkd closed the connection");
+    }
+    data += count;
+    size -= count;
+  }
+}
+} // namespace
+
+TkdClient::TkdClient(const std::string &socketPath) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (socketPath.size() >= sizeof(address.sun_path)) {
+    throw std::runtime_error("Socket path too long: " + socketPath);
+  }
+  std::strcpy(address.sun_path, socketPath.c_str());
+
+  fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd_ < 0) {
+    throwErrno("Could not create socket");
+  }
+  if (connect(fd_, reinterpret_cast<const sockaddr *>(&address),
+              sizeof(address)) < 0) {
+    int error = errno;
+    ::close(fd_);
+    errno = error;
+    throwErrno("Could not connect to tkd at " + socketPath);
+  }
+}
+
+TkdClient::~TkdClient() { ::close(fd_); }
+
+std::string TkdClient::call(TkdOp op, TkdWriter &request) {
+  // The caller wrote only the payload, prefix it with the header
+  std::uint32_t id = nextId_++;
+  TkdWriter frame;
+  frame.begin(id, static_cast<std::uint16_t>(op));
+  frame.putBytes(request.buffer());
+  frame.end();
+
+  const std::string &bytes = frame.buffer();
+  std::size_t sent = 0;
+  while (sent < bytes.size()) {
+    ssize_t count =
+        send(fd_, bytes.data() + sent, bytes.size() - sent, MSG_NOSIGNAL);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count < 0) {
+      throwErrno("Could not write to tkd");
+    }
+    sent += count;
+  }
+
+  char header_bytes[tkdHeaderSize];
+  readExactly(fd_, header_bytes, tkdHeaderSize);
+  TkdFrameHeader header;
+  parseTkdHeader(std::string_view(header_bytes, tkdHeaderSize), header);
+  std::string payload(header.length, '\0');
+  readExactly(fd_, payload.data(), payload.size());
+
+  if (header.id != id) {
+    throw std::runtime_error("tkd answered request " +
+                             std::to_string(header.id) + " instead of " +
+                             std::to_string(id));
+  }
+  switch (static_cast<TkdStatus>(header.code)) {
+  case TkdStatus::ok:
+    return payload;
+  case TkdStatus::badRequest:
+    throw std::invalid_argument("tkd rejected the request: " + payload);
+  default:
+    throw std::runtime_error("tkd could not answer: " + payload);
+  }
+}
+
+TkdSeries TkdClient::readSeries(const std::string &payload) {
+  TkdReader response(payload);
+  auto count = response.get<std::uint32_t>();
+  std::vector<std::int64_t> times;
+  TkdSeries series;
+  response.getArray(count, times);
+  response.getArray(count, series.values);
+  for (std::int64_t time : times) {
+    series.times.push_back(fromTkdTime(time));
+  }
+  return series;
+}
+
+std::vector<TkdGroupInfo> TkdClient::list() {
+  TkdWriter request;
+  std::string payload = call(TkdOp::list, request);
+
+  TkdReader response(payload);
+  std::vector<TkdGroupInfo> groups(response.get<std::uint16_t>());
+  for (auto &group : groups) {
+    group.name = response.getString();
+    group.rows = response.get<std::int64_t>();
+    group.start = fromTkdTime(response.get<std::int64_t>());
+    group.end = fromTkdTime(response.get<std::int64_t>());
+    group.columns.resize(response.get<std::uint16_t>());
+    for (auto &column : group.columns) {
+      column = response.getString();
+    }
+  }
+  groups_ = groups;
+  return groups;
+}
+
+std::pair<std::uint16_t, std::uint16_t>
+TkdClient::resolve(const std::string &group, const std::string &column) {
+  if (groups_.empty()) {
+    list();
+  }
+  for (size_t g = 0; g < groups_.size(); ++g) {
+    if (groups_[g].name != group) {
+      continue;
+    }
+    const auto &columns = groups_[g].columns;
+    auto it = std::find(columns.begin(), columns.end(), column);
+    if (it == columns.end()) {
+      throw std::invalid_argument("No column " + column + " in group " + group);
+    }
+    return {static_cast<std::uint16_t>(g),
+            static_cast<std::uint16_t>(it - columns.begin())};
+  }
+  throw std::invalid_argument("No group " + group);
+}
+
+std::vector<double> TkdClient::valueAt(std::uint16_t group,
+                                       std::uint16_t column,
+                                       const std::vector<date_time> &times) {
+  TkdWriter request;
+  request.put(group);
+  request.put(column);
+  request.put(static_cast<std::uint32_t>(times.size()));
+  for (const auto &time : times) {
+    request.put(toTkdTime(time));
+  }
+  std::string payload = call(TkdOp::valueAt, request);
+
+  TkdReader response(payload);
+  std::vector<double> values;
+  response.getArray(response.get<std::uint32_t>(), values);
+  return values;
+}
+
+TkdSeries TkdClient::range(std::uint16_t group, std::uint16_t column,
+                           date_time start, date_time end,
+                           std::uint32_t maxRows) {
+  TkdWriter request;
+  request.put(group);
+  request.put(column);
+  request.put(toTkdTime(start));
+  request.put(toTkdTime(end));
+  request.put(maxRows);
+  return readSeries(call(TkdOp::range, request));
+}
+
+TkdSeries TkdClient::decimate(std::uint16_t group, std::uint16_t column,
+                              date_time start, date_time end,
+                              std::uint32_t points) {
+  TkdWriter request;
+  request.put(group);
+  request.put(column);
+  request.put(toTkdTime(start));
+  request.put(toTkdTime(end));
+  request.put(points);
+  return readSeries(call(TkdOp::decimate, request));
+}
@@ -0,0 +1,144 @@
+#ifndef __TKDCLIENT_H__
+#define __TKDCLIENT_H__
+
+#include "TkdProtocol.hpp"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief A group served by tkd, as reported by a list request.
+ */
+struct TkdGroupInfo {
+  /**
+   * @brief The group name.
+   */
+  std::string name;
+
+  /**
+   * @brief The number of rows.
+   */
+  long rows = 0;
+
+  /**
+   * @brief The time of the first row.
+   */
+  date_time start;
+
+  /**
+   * @brief The time of the last row.
+   */
+  date_time end;
+
+  /**
+   * @brief The column names, indexed as in requests.
+   */
+  std::vector<std::string> columns;
+};
+
+/**
+ * @brief Times and values returned by range and decimate requests.
+ */
+struct TkdSeries {
+  /**
+   * @brief The time of each point.
+   */
+  std::vector<date_time> times;
+
+  /**
+   * @brief The value of each point.
+   */
+  std::vector<double> values;
+};
+
+/**
+ * @brief A blocking connection to a tkd daemon.
+ *
+ * Each call sends one request and waits for its response. valueAt() takes a
+ * whole batch of times, so scripts should gather their lookups into few calls.
+ */
+struct TkdClient {
+private:
+  /**
+   * @brief The connected socket.
+   */
+  int fd_ = -1;
+
+  /**
+   * @brief The id of the next request.
+   */
+  std::uint32_t nextId_ = 1;
+
+  /**
+   * @brief Groups from the last list request, for name lookups.
+   */
+  std::vector<TkdGroupInfo> groups_;
+
+  /**
+   * @brief Sends a request and waits for its response payload.
+   * @throws std::invalid_argument if the daemon rejected the request.
+   * @throws std::runtime_error if the request failed or the connection broke.
+   */
+  std::string call(TkdOp op, TkdWriter &request);
+
+  /**
+   * @brief Reads a series response payload.
+   */
+  static TkdSeries readSeries(const std::string &payload);
+
+public:
+  /**
+   * @brief Connects to a daemon.
+   * @param socketPath Path of the daemon's Unix socket.
+   * @throws std::runtime_error if the daemon cannot be reached.
+   */
+  explicit TkdClient(const std::string &socketPath);
+
+  TkdClient(const TkdClient &) = delete;
+  TkdClient &operator=(const TkdClient &) = delete;
+
+  /**
+   * @brief Closes the connection.
+   */
+  ~TkdClient();
+
+  /**
+   * @brief Lists the served groups.
+   * @return The groups, in the order requests index them.
+   */
+  std::vector<TkdGroupInfo> list();
+
+  /**
+   * @brief Looks up the indices of a group and column by name.
+   * @details Lists the groups on first use.
+   * @return The group and column indices.
+   * @throws std::invalid_argument if either does not exist.
+   */
+  std::pair<std::uint16_t, std::uint16_t> resolve(const std::string &group,
+                                                  const std::string &column);
+
+  /**
+   * @brief Gets the values of a column at a batch of times.
+   * @return The value at each time, interpolated between rows.
+   */
+  std::vector<double> valueAt(std::uint16_t group, std::uint16_t column,
+                              const std::vector<date_time> &times);
+
+  /**
+   * @brief Gets the logged rows of a column between two times, inclusive.
+   * @param maxRows The most rows to return, 0 for the daemon's limit.
+   */
+  TkdSeries range(std::uint16_t group, std::uint16_t column, date_time start,
+                  date_time end, std::uint32_t maxRows = 0);
+
+  /**
+   * @brief Samples a column at evenly spaced times from start to end.
+   * @param points The number of samples.
+   */
+  TkdSeries decimate(std::uint16_t group, std::uint16_t column,
+                     date_time start, date_time end, std::uint32_t points);
+};
+
+#endif // __TKDCLIENT_H__
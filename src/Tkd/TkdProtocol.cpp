@@ -0,0 +1,95 @@
+#include "TkdProtocol.hpp"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+/**
+ * @brief Date_time ticks in one microsecond.
+ */
+const std::int64_t ticksPerMicro = time_delt::ticks_per_second() / 1000000;
+
+/**
+ * @brief Microseconds in one day.
+ */
+constexpr std::int64_t microsPerDay = 86400LL * 1000000;
+
+/**
+ * @brief Range of wire times, the dates date_time supports, as long as their
+ * ticks fit in time_ticks.
+ */
+const std::int64_t minTkdTime =
+    std::max(std::numeric_limits<std::int64_t>::min() / ticksPerMicro,
+             time_parse_detail::daysFromCivil(1400, 1, 1) * microsPerDay);
+const std::int64_t maxTkdTime =
+    std::min(std::numeric_limits<std::int64_t>::max() / ticksPerMicro,
+             time_parse_detail::daysFromCivil(9999, 12, 31) * microsPerDay);
+} // namespace
+
+bool parseTkdHeader(std::string_view buffer, TkdFrameHeader &header) {
+  if (buffer.size() < tkdHeaderSize) {
+    return false;
+  }
+  std::memcpy(&header.length, buffer.data(), 4);
+  std::memcpy(&header.id, buffer.data() + 4, 4);
+  std::memcpy(&header.code, buffer.data() + 8, 2);
+  if (header.length > tkdMaxPayload) {
+    throw std::invalid_argument("Frame of " + std::to_string(header.length) +
+                                " bytes is larger than the limit");
+  }
+  return true;
+}
+
+std::int64_t toTkdTime(const date_time &time) {
+  return toTicks(time) / ticksPerMicro;
+}
+
+date_time fromTkdTime(std::int64_t micros) {
+  if (micros < minTkdTime || micros > maxTkdTime) {
+    throw std::invalid_argument("Time " + std::to_string(micros) +
+                                " is out of range");
+  }
+  return fromTicks(micros * ticksPerMicro);
+}
+
+void TkdWriter::begin(std::uint32_t id, std::uint16_t code) {
+  frameStart_ = buffer_.size();
+  put<std::uint32_t>(0);
+  put(id);
+  put(code);
+  put<std::uint16_t>(0);
+}
+
+void TkdWriter::end() {
+  std::size_t length = buffer_.size() - frameStart_ - tkdHeaderSize;
+  if (length > tkdMaxPayload) {
+    throw std::length_error("Frame of " + std::to_string(length) +
+                            " bytes is larger than the limit");
+  }
+  std::uint32_t length32 = static_cast<std::uint32_t>(length);
+  std::memcpy(buffer_.data() + frameStart_, &length32, 4);
+}
+
+void TkdWriter::putString(std::string_view value) {
+  if (value.size() > UINT16_MAX) {
+    throw std::length_error("String too long for a tkd frame");
+  }
+  put(static_cast<std::uint16_t>(value.size()));
+  buffer_.append(value);
+}
+
+void TkdReader::require(std::size_t bytes) const {
+  if (data_.size() - position_ < bytes) {
+    throw std::invalid_argument("Truncated tkd payload");
+  }
+}
+
+std::string_view TkdReader::getString() {
+  std::size_t length = get<std::uint16_t>();
+  require(length);
+  std::string_view value = data_.substr(position_, length);
+  position_ += length;
+  return value;
+}
@@ -0,0 +1,287 @@
+#ifndef __TKDPROTOCOL_H__
+#define __TKDPROTOCOL_H__
+
+#include "../CsvFileUtils/TimeParse.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Wire format of the tkd query daemon.
+ *
+ * Every message is a frame: a 12 byte header followed by a payload. All
+ * integers and doubles are little endian, strings are a uint16 length followed
+ * by the bytes, and times are int64 microseconds since 1970-01-01.
+ *
+ *   header   uint32 payload length, uint32 request id, uint16 code, uint16 0
+ *
+ * A request's code is a TkdOp and a response's code is a TkdStatus. Responses
+ * carry the id of their request and may arrive out of order, so clients can
+ * pipeline many requests on one connection. An error response's payload is
+ * the message as raw bytes.
+ *
+ *   list      request:  (empty)
+ *             response: uint16 groups, then per group: string name,
+ *                       int64 rows, int64 start, int64 end, uint16 columns,
+ *                       string column...
+ *   valueAt   request:  uint16 group, uint16 column, uint32 n, int64 time[n]
+ *             response: uint32 n, double value[n]
+ *   range     request:  uint16 group, uint16 column, int64 start, int64 end,
+ *                       uint32 max rows (0 for the server limit)
+ *             response: uint32 n, int64 time[n], double value[n]
+ *   decimate  request:  uint16 group, uint16 column, int64 start, int64 end,
+ *                       uint32 points
+ *             response: uint32 n, int64 time[n], double value[n]
+ *
+ * range returns the logged rows with start <= time <= end. decimate samples
+ * the column at points evenly spaced times from start to end, interpolating
+ * as colAtTime does.
+ */
+
+static_assert(std::endian::native == std::endian::little,
+              "The tkd wire format is little endian");
+
+/**
+ * @brief Request codes.
+ */
+enum class TkdOp : std::uint16_t {
+  /**
+   * @brief Lists the groups, their row counts, time spans and columns.
+   */
+  list = 0,
+
+  /**
+   * @brief Values of a column at a batch of times.
+   */
+  valueAt = 1,
+
+  /**
+   * @brief Logged rows of a column between two times.
+   */
+  range = 2,
+
+  /**
+   * @brief A column sampled on an evenly spaced grid of times.
+   */
+  decimate = 3,
+};
+
+/**
+ * @brief Response codes.
+ */
+enum class TkdStatus : std::uint16_t {
+  /**
+   * @brief The request succeeded.
+   */
+  ok = 0,
+
+  /**
+   * @brief The request was malformed or named an unknown group or column.
+   */
+  badRequest = 1,
+
+  /**
+   * @brief The request failed while reading the data.
+   */
+  error = 2,
+};
+
+/**
+ * @brief Size in bytes of a frame header.
+ */
+constexpr std::size_t tkdHeaderSize = 12;
+
+/**
+ * @brief Largest payload accepted in either direction.
+ */
+constexpr std::uint32_t tkdMaxPayload = 64 << 20;
+
+/**
+ * @brief Largest number of rows or points returned by one request.
+ */
+constexpr std::uint32_t tkdMaxRows = 1 << 20;
+
+/**
+ * @brief Largest request payload a server accepts, a valueAt of tkdMaxRows
+ * times.
+ */
+constexpr std::uint32_t tkdMaxRequest = 8 + 8 * tkdMaxRows;
+
+/**
+ * @brief The header of a frame.
+ */
+struct TkdFrameHeader {
+  /**
+   * @brief The payload length in bytes.
+   */
+  std::uint32_t length = 0;
+
+  /**
+   * @brief The request id, echoed in the response.
+   */
+  std::uint32_t id = 0;
+
+  /**
+   * @brief The TkdOp of a request or TkdStatus of a response.
+   */
+  std::uint16_t code = 0;
+};
+
+/**
+ * @brief Parses the header at the start of a buffer.
+ * @param buffer The received bytes.
+ * @param header Receives the header.
+ * @return false if the buffer holds less than a header.
+ * @throws std::invalid_argument if the payload is larger than tkdMaxPayload.
+ */
+bool parseTkdHeader(std::string_view buffer, TkdFrameHeader &header);
+
+/**
+ * @brief Converts a time to its wire form.
+ * @param time The time.
+ * @return Microseconds since 1970-01-01.
+ */
+std::int64_t toTkdTime(const date_time &time);
+
+/**
+ * @brief Converts a time from its wire form.
+ * @param micros Microseconds since 1970-01-01.
+ * @return The time.
+ * @throws std::invalid_argument if the time is before 1400, after 9999 or
+ * past the range of time_ticks.
+ */
+date_time fromTkdTime(std::int64_t micros);
+
+/**
+ * @brief Builds frames into a buffer.
+ */
+struct TkdWriter {
+private:
+  /**
+   * @brief The encoded frames.
+   */
+  std::string buffer_;
+
+  /**
+   * @brief Offset of the header of the frame being built.
+   */
+  std::size_t frameStart_ = 0;
+
+public:
+  /**
+   * @brief Starts a frame.
+   * @param id The request id.
+   * @param code The TkdOp or TkdStatus of the frame.
+   */
+  void begin(std::uint32_t id, std::uint16_t code);
+
+  /**
+   * @brief Finishes the current frame, filling in its length.
+   * @throws std::length_error if the payload is larger than tkdMaxPayload.
+   */
+  void end();
+
+  /**
+   * @brief Appends an integer or double to the payload.
+   */
+  template <typename T> void put(T value) {
+    static_assert(std::is_arithmetic_v<T>);
+    buffer_.append(reinterpret_cast<const char *>(&value), sizeof(value));
+  }
+
+  /**
+   * @brief Appends a length prefixed string to the payload.
+   * @throws std::length_error if the string is longer than 65535 bytes.
+   */
+  void putString(std::string_view value);
+
+  /**
+   * @brief Appends raw bytes to the payload.
+   */
+  void putBytes(std::string_view value) { buffer_.append(value); }
+
+  /**
+   * @brief Gets the encoded frames.
+   * @return The buffer.
+   */
+  std::string &buffer() { return buffer_; }
+};
+
+/**
+ * @brief Reads fields from a payload.
+ */
+struct TkdReader {
+private:
+  /**
+   * @brief The payload.
+   */
+  std::string_view data_;
+
+  /**
+   * @brief Offset of the next field.
+   */
+  std::size_t position_ = 0;
+
+  /**
+   * @brief Checks that the payload holds at least the given bytes.
+   * @throws std::invalid_argument if it does not.
+   */
+  void require(std::size_t bytes) const;
+
+public:
+  /**
+   * @brief Construct a reader over a payload.
+   * @param data The payload bytes.
+   */
+  explicit TkdReader(std::string_view data) : data_(data) {}
+
+  /**
+   * @brief Reads an integer or double.
+   * @throws std::invalid_argument if the payload is too short.
+   */
+  template <typename T> T get() {
+    static_assert(std::is_arithmetic_v<T>);
+    require(sizeof(T));
+    T value;
+    std::memcpy(&value, data_.data() + position_, sizeof(T));
+    position_ += sizeof(T);
+    return value;
+  }
+
+  /**
+   * @brief Reads a length prefixed string.
+   * @return A view into the payload.
+   * @throws std::invalid_argument if the payload is too short.
+   */
+  std::string_view getString();
+
+  /**
+   * @brief Reads an array of integers or doubles.
+   * @param count The number of elements.
+   * @param values Receives the elements.
+   * @throws std::invalid_argument if the payload is too short.
+   */
+  template <typename T>
+  void getArray(std::size_t count, std::vector<T> &values) {
+    static_assert(std::is_arithmetic_v<T>);
+    require(count * sizeof(T));
+    values.resize(count);
+    std::memcpy(values.data(), data_.data() + position_, count * sizeof(T));
+    position_ += count * sizeof(T);
+  }
+
+  /**
+   * @brief Gets the bytes not yet read.
+   * @return A view into the payload.
+   */
+  std::string_view rest() const { return data_.substr(position_); }
+};
+
+#endif // __TKDPROTOCOL_H__
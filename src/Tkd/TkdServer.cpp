@@ -0,0 +1,644 @@
+#include "TkdServer.hpp"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * @brief A client connection of the server.
+ */
+struct TkdConnection {
+  /**
+   * @brief The socket.
+   */
+  int fd;
+
+  /**
+   * @brief Received bytes not yet parsed into requests, loop thread only.
+   */
+  std::string input;
+
+  /**
+   * @brief True while EPOLLOUT is armed, loop thread only.
+   */
+  bool wantWrite = false;
+
+  /**
+   * @brief Guards output and open.
+   */
+  std::mutex mutex;
+
+  /**
+   * @brief Response frames not yet written.
+   */
+  std::string output;
+
+  /**
+   * @brief False once the socket is closed, so late responses are dropped.
+   */
+  bool open = true;
+
+  /**
+   * @brief Set when a response would leave too much output unwritten, so
+   * the loop drops the client.
+   */
+  bool overflowed = false;
+
+  explicit TkdConnection(int socket) : fd(socket) {}
+};
+
+namespace {
+/**
+ * @brief Bytes read from a socket per call.
+ */
+constexpr std::size_t readChunk = 64 * 1024;
+
+/**
+ * @brief Most response bytes a client may leave unread before it is dropped.
+ */
+constexpr std::size_t maxPendingOutput = 4 * std::size_t(tkdMaxPayload);
+
+/**
+ * @brief Quiet time before a watched group's changed files are updated, and
+ * how often the refresh thread reads the watchers' events.
+ */
+constexpr std::chrono::milliseconds watchInterval(100);
+
+/**
+ * @brief Throws a std::runtime_error describing errno.
+ */
+[[noreturn]] void throwErrno(const std::string &what) {
+  throw std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+/**
+ * @brief Finds the first row logged at or after a time.
+ * @return The row index, or the row count if every row is earlier.
+ */
+size_t firstRowFrom(CsvTimeCursor &cursor, date_time time) {
+  auto [before, after] = cursor.bounds(time);
+  if (before == size_t(-1)) {
+    return 0;
+  }
+  if (after == size_t(-1)) {
+    return cursor.group().size();
+  }
+  return cursor.timeOfRow(before) >= time ? before : after;
+}
+
+/**
+ * @brief Writes times and values as the payload of a series response.
+ */
+void putSeries(TkdWriter &response, const std::vector<date_time> &times,
+               const std::vector<quad> &values) {
+  response.put(static_cast<std::uint32_t>(times.size()));
+  for (const auto &time : times) {
+    response.put(toTkdTime(time));
+  }
+  for (const auto &value : values) {
+    response.put(static_cast<double>(value));
+  }
+}
+} // namespace
+
+TkdServer::TkdServer(std::string socketPath, int workers,
+                     std::chrono::milliseconds refreshInterval, bool watch)
+    : socketPath_(std::move(socketPath)), workerCount_(std::max(1, workers)),
+      refreshInterval_(refreshInterval), watch_(watch) {
+  // Created up front so stop() always has something to signal
+  wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (wakeFd_ < 0) {
+    throwErrno("Could not create the tkd wake event");
+  }
+}
+
+TkdServer::~TkdServer() {
+  for (auto &[fd, connection] : connections_) {
+    ::close(fd);
+  }
+  if (listenFd_ >= 0) {
+    ::close(listenFd_);
+  }
+  if (epollFd_ >= 0) {
+    ::close(epollFd_);
+  }
+  ::close(wakeFd_);
+}
+
+void TkdServer::addGroup(std::string name, CsvGroupMetadata metadata,
+                         CsvTimeFormat timeFormat) {
+  // Watch first, so files written while the group loads are updated later
+  std::unique_ptr<CsvGroupWatcher> watcher;
+  if (watch_) {
+    watcher = std::make_unique<CsvGroupWatcher>(
+        metadata, watchInterval, 20 * watchInterval);
+  }
+  groups_.push_back(std::make_unique<CsvTimeGroup>(metadata, timeFormat));
+  watchers_.push_back(std::move(watcher));
+  names_.push_back(std::move(name));
+}
+
+void TkdServer::run() {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (socketPath_.size() >= sizeof(address.sun_path)) {
+    throw std::runtime_error("Socket path too long: " + socketPath_);
+  }
+  std::strcpy(address.sun_path, socketPath_.c_str());
+
+  // A socket file left by a previous run would make bind fail
+  ::unlink(socketPath_.c_str());
+  listenFd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (listenFd_ < 0) {
+    throwErrno("Could not create socket");
+  }
+  if (bind(listenFd_, reinterpret_cast<const sockaddr *>(&address),
+           sizeof(address)) < 0) {
+    throwErrno("Could not bind " + socketPath_);
+  }
+  if (listen(listenFd_, SOMAXCONN) < 0) {
+    throwErrno("Could not listen on " + socketPath_);
+  }
+
+  epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+  if (epollFd_ < 0) {
+    throwErrno("Could not create epoll instance");
+  }
+  for (int fd : {listenFd_, wakeFd_}) {
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+      throwErrno("Could not watch socket");
+    }
+  }
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < workerCount_; ++i) {
+    threads.emplace_back(&TkdServer::workerLoop, this);
+  }
+  threads.emplace_back(&TkdServer::refreshLoop, this);
+
+  epoll_event events[64];
+  while (!stopRequested_.load()) {
+    int count = epoll_wait(epollFd_, events, std::size(events), -1);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+
+    for (int i = 0; i < count; ++i) {
+      int fd = events[i].data.fd;
+      if (fd == listenFd_) {
+        acceptConnections();
+      } else if (fd == wakeFd_) {
+        std::uint64_t wakes;
+        while (read(wakeFd_, &wakes, sizeof(wakes)) > 0) {
+        }
+
+        std::vector<std::shared_ptr<TkdConnection>> flushes;
+        {
+          std::lock_guard<std::mutex> lock(flushMutex_);
+          flushes.swap(pendingFlushes_);
+        }
+        for (const auto &connection : flushes) {
+          // Skip connections closed since, whose fd may have been reused
+          auto it = connections_.find(connection->fd);
+          if (it != connections_.end() && it->second == connection) {
+            flushConnection(connection);
+          }
+        }
+      } else {
+        auto it = connections_.find(fd);
+        if (it == connections_.end()) {
+          continue;
+        }
+        std::shared_ptr<TkdConnection> connection = it->second;
+
+        if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+          if (!readConnection(connection)) {
+            continue;
+          }
+        }
+        if (events[i].events & EPOLLOUT) {
+          flushConnection(connection);
+        }
+      }
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    stopping_ = true;
+  }
+  queueReady_.notify_all();
+  stopped_.notify_all();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  while (!connections_.empty()) {
+    closeConnection(connections_.begin()->second);
+  }
+  ::unlink(socketPath_.c_str());
+}
+
+void TkdServer::stop() {
+  stopRequested_.store(true);
+  wake();
+}
+
+void TkdServer::wake() {
+  std::uint64_t one = 1;
+  // Only fails if the counter is saturated, which still wakes the loop
+  [[maybe_unused]] ssize_t written = write(wakeFd_, &one, sizeof(one));
+}
+
+void TkdServer::acceptConnections() {
+  while (true) {
+    int fd = accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // EAGAIN once all pending connections are accepted
+      return;
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.fd = fd;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+      ::close(fd);
+      continue;
+    }
+    connections_[fd] = std::make_shared<TkdConnection>(fd);
+  }
+}
+
+bool TkdServer::readConnection(
+    const std::shared_ptr<TkdConnection> &connection) {
+  char buffer[readChunk];
+  while (true) {
+    ssize_t count = recv(connection->fd, buffer, sizeof(buffer), 0);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      return true;
+    }
+    if (count <= 0) {
+      // Closed by the peer, or failed
+      closeConnection(connection);
+      return false;
+    }
+    connection->input.append(buffer, count);
+
+    // Queue each complete request as it arrives, so the input never holds
+    // more than one partial request
+    std::vector<Job> jobs;
+    std::string_view input = connection->input;
+    std::size_t consumed = 0;
+    TkdFrameHeader header;
+    try {
+      while (parseTkdHeader(input.substr(consumed), header)) {
+        if (header.length > tkdMaxRequest) {
+          throw std::invalid_argument("Request of " +
+                                      std::to_string(header.length) +
+                                      " bytes is larger than the limit");
+        }
+        if (input.size() - consumed < tkdHeaderSize + header.length) {
+          break;
+        }
+        jobs.push_back({connection, header,
+                        std::string(input.substr(consumed + tkdHeaderSize,
+                                                 header.length))});
+        consumed += tkdHeaderSize + header.length;
+      }
+    } catch (const std::invalid_argument &e) {
+      // The stream cannot be resynchronised after a bad frame
+      std::cerr << "tkd: dropping connection: " << e.what() << std::endl;
+      closeConnection(connection);
+      return false;
+    }
+    connection->input.erase(0, consumed);
+
+    if (!jobs.empty()) {
+      {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        for (auto &job : jobs) {
+          queue_.push_back(std::move(job));
+        }
+      }
+      queueReady_.notify_all();
+    }
+  }
+}
+
+bool TkdServer::flushConnection(
+    const std::shared_ptr<TkdConnection> &connection) {
+  bool failed = false;
+  bool pending;
+  {
+    std::lock_guard<std::mutex> lock(connection->mutex);
+    if (connection->overflowed) {
+      std::cerr << "tkd: dropping connection: more than " << maxPendingOutput
+                << " response bytes unread" << std::endl;
+      failed = true;
+    }
+    std::size_t written = 0;
+    while (!failed && written < connection->output.size()) {
+      ssize_t count = send(connection->fd, connection->output.data() + written,
+                           connection->output.size() - written, MSG_NOSIGNAL);
+      if (count >= 0) {
+        written += count;
+      } else if (errno != EINTR) {
+        failed = errno != EAGAIN && errno != EWOULDBLOCK;
+        break;
+      }
+    }
+    connection->output.erase(0, written);
+    pending = !connection->output.empty();
+  }
+
+  if (failed) {
+    closeConnection(connection);
+    return false;
+  }
+
+  // Wait for the socket to drain only while responses are left over
+  if (pending != connection->wantWrite) {
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLRDHUP;
+    if (pending) {
+      event.events |= EPOLLOUT;
+    }
+    event.data.fd = connection->fd;
+    epoll_ctl(epollFd_, EPOLL_CTL_MOD, connection->fd, &event);
+    connection->wantWrite = pending;
+  }
+  return true;
+}
+
+void TkdServer::closeConnection(
+    const std::shared_ptr<TkdConnection> &connection) {
+  // The argument may be the map entry erased below
+  std::shared_ptr<TkdConnection> closing = connection;
+  epoll_ctl(epollFd_, EPOLL_CTL_DEL, closing->fd, nullptr);
+  connections_.erase(closing->fd);
+  std::lock_guard<std::mutex> lock(closing->mutex);
+  ::close(closing->fd);
+  closing->open = false;
+}
+
+void TkdServer::workerLoop() {
+  WorkerState state;
+  state.cursors.resize(groups_.size());
+
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(queueMutex_);
+      queueReady_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+      if (stopping_) {
+        return;
+      }
+      job = std::move(queue_.front());
+      queue_.pop_front();
+    }
+
+    TkdWriter response;
+    try {
+      answer(job, state, response);
+    } catch (const std::exception &e) {
+      bool bad_request = dynamic_cast<const std::invalid_argument *>(&e);
+      response = TkdWriter();
+      response.begin(job.header.id,
+                     static_cast<std::uint16_t>(bad_request
+                                                    ? TkdStatus::badRequest
+                                                    : TkdStatus::error));
+      response.putBytes(e.what());
+      response.end();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(job.connection->mutex);
+      if (!job.connection->open) {
+        continue;
+      }
+      if (job.connection->output.size() + response.buffer().size() >
+          maxPendingOutput) {
+        job.connection->overflowed = true;
+      } else {
+        job.connection->output += response.buffer();
+      }
+    }
+    {
+      std::lock_guard<std::mutex> lock(flushMutex_);
+      pendingFlushes_.push_back(job.connection);
+    }
+    wake();
+  }
+}
+
+void TkdServer::refreshLoop() {
+  using clock = std::chrono::steady_clock;
+
+  // When watching, wake often to read the queued events, which costs a read
+  // per group and touches no files, and rescan only at the refresh interval
+  std::chrono::milliseconds tick = watch_ ? watchInterval : refreshInterval_;
+  bool rescans = refreshInterval_.count() > 0;
+  auto next_rescan = clock::now() + refreshInterval_;
+
+  std::unique_lock<std::mutex> lock(queueMutex_);
+  while (!stopping_) {
+    if (tick.count() <= 0) {
+      stopped_.wait(lock, [this] { return stopping_; });
+      break;
+    }
+    if (stopped_.wait_for(lock, tick, [this] { return stopping_; })) {
+      break;
+    }
+
+    bool rescan = rescans && clock::now() >= next_rescan;
+    if (rescan) {
+      next_rescan = clock::now() + refreshInterval_;
+    }
+
+    // Workers keep reading the previous rows while the groups update
+    lock.unlock();
+    for (size_t g = 0; g < groups_.size(); ++g) {
+      try {
+        if (rescan) {
+          groups_[g]->update();
+        } else if (watchers_[g]) {
+          CsvGroupChanges changes = watchers_[g]->poll();
+          if (!changes.empty()) {
+            groups_[g]->update(changes);
+          }
+        }
+      } catch (const std::exception &e) {
+        std::cerr << "tkd: could not update " << names_[g] << ": " << e.what()
+                  << std::endl;
+      }
+    }
+    lock.lock();
+  }
+}
+
+CsvTimeCursor &TkdServer::cursor(WorkerState &state, std::uint16_t group) {
+  if (group >= groups_.size()) {
+    throw std::invalid_argument("No group " + std::to_string(group));
+  }
+
+  CsvTimeSnapshot snapshot = groups_[group]->snapshot();
+  if (snapshot.size() == 0) {
+    throw std::runtime_error("Group " + names_[group] + " has no rows");
+  }
+
+  // Keep the cached lookups until the group gains rows
+  CsvTimeCursor &cursor = state.cursors[group];
+  if (static_cast<long>(cursor.group().size()) != snapshot.size()) {
+    cursor = snapshot.cursor();
+  }
+  return cursor;
+}
+
+const std::string &TkdServer::columnName(const CsvTimeCursor &rows,
+                                         std::uint16_t group,
+                                         std::uint16_t column) {
+  // Read from the pinned rows, the group's own metadata changes on update
+  const auto &columns = rows.group().metadata().colNames();
+  if (column >= columns.size()) {
+    throw std::invalid_argument("No column " + std::to_string(column) +
+                                " in group " + names_[group]);
+  }
+  return columns[column];
+}
+
+void TkdServer::answer(const Job &job, WorkerState &state,
+                       TkdWriter &response) {
+  TkdReader request(job.payload);
+
+  switch (static_cast<TkdOp>(job.header.code)) {
+  case TkdOp::list: {
+    response.begin(job.header.id, static_cast<std::uint16_t>(TkdStatus::ok));
+    response.put(static_cast<std::uint16_t>(groups_.size()));
+    for (size_t g = 0; g < groups_.size(); ++g) {
+      CsvTimeSnapshot snapshot = groups_[g]->snapshot();
+      response.putString(names_[g]);
+      response.put(static_cast<std::int64_t>(snapshot.size()));
+      if (snapshot.size() > 0) {
+        CsvTimeCursor &rows = cursor(state, g);
+        response.put(toTkdTime(rows.startTime()));
+        response.put(toTkdTime(rows.endTime()));
+      } else {
+        response.put<std::int64_t>(0);
+        response.put<std::int64_t>(0);
+      }
+
+      const auto &columns = snapshot.group().metadata().colNames();
+      response.put(static_cast<std::uint16_t>(columns.size()));
+      for (const auto &column : columns) {
+        response.putString(column);
+      }
+    }
+    response.end();
+    return;
+  }
+
+  case TkdOp::valueAt: {
+    auto group = request.get<std::uint16_t>();
+    auto column = request.get<std::uint16_t>();
+    auto count = request.get<std::uint32_t>();
+    if (count > tkdMaxRows) {
+      throw std::invalid_argument("Too many times in one request");
+    }
+    std::vector<std::int64_t> times;
+    request.getArray(count, times);
+
+    CsvTimeCursor &rows = cursor(state, group);
+    const std::string &name = columnName(rows, group, column);
+    response.begin(job.header.id, static_cast<std::uint16_t>(TkdStatus::ok));
+    response.put(count);
+    for (std::int64_t time : times) {
+      quad value = rows.colAtTime(fromTkdTime(time), name);
+      response.put(static_cast<double>(value));
+    }
+    response.end();
+    return;
+  }
+
+  case TkdOp::range: {
+    auto group = request.get<std::uint16_t>();
+    auto column = request.get<std::uint16_t>();
+    date_time start = fromTkdTime(request.get<std::int64_t>());
+    date_time end = fromTkdTime(request.get<std::int64_t>());
+    auto max_rows = request.get<std::uint32_t>();
+    if (max_rows == 0 || max_rows > tkdMaxRows) {
+      max_rows = tkdMaxRows;
+    }
+
+    CsvTimeCursor &rows = cursor(state, group);
+    const std::string &name = columnName(rows, group, column);
+    size_t first = firstRowFrom(rows, start);
+    size_t last =
+        end < start ? first : firstRowFrom(rows, end + time_delt::unit());
+    last = std::min(last, first + max_rows);
+
+    std::vector<date_time> times;
+    std::vector<quad> values;
+    rows.readRange(first, last, name, times, values);
+    response.begin(job.header.id, static_cast<std::uint16_t>(TkdStatus::ok));
+    putSeries(response, times, values);
+    response.end();
+    return;
+  }
+
+  case TkdOp::decimate: {
+    auto group = request.get<std::uint16_t>();
+    auto column = request.get<std::uint16_t>();
+    std::int64_t start = request.get<std::int64_t>();
+    std::int64_t end = request.get<std::int64_t>();
+    auto points = request.get<std::uint32_t>();
+    // Checked before subtracting, so the span cannot overflow
+    fromTkdTime(start);
+    fromTkdTime(end);
+    if (points == 0 || points > tkdMaxRows || end < start) {
+      throw std::invalid_argument("Invalid decimation grid");
+    }
+
+    CsvTimeCursor &rows = cursor(state, group);
+    const std::string &name = columnName(rows, group, column);
+    std::vector<date_time> times;
+    std::vector<quad> values;
+    for (std::uint32_t i = 0; i < points; ++i) {
+      double fraction = points > 1 ? double(i) / (points - 1) : 0;
+      date_time time = fromTkdTime(
+          start + std::llround(double(end - start) * fraction));
+      times.push_back(time);
+      values.push_back(rows.colAtTime(time, name));
+    }
+    response.begin(job.header.id, static_cast<std::uint16_t>(TkdStatus::ok));
+    putSeries(response, times, values);
+    response.end();
+    return;
+  }
+  }
+
+  throw std::invalid_argument("Unknown request code " +
+                              std::to_string(job.header.code));
+}
@@ -0,0 +1,265 @@
+#ifndef __TKDSERVER_H__
+#define __TKDSERVER_H__
+
+#include "../CsvFileUtils/CsvGroupWatcher.hpp"
+#include "../CsvFileUtils/CsvTimeGroup.hpp"
+#include "TkdProtocol.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct TkdConnection;
+
+/**
+ * @brief Serves time queries on warm CsvTimeGroups over a Unix socket.
+ *
+ * One thread runs an epoll loop that accepts connections, reads request
+ * frames and writes responses. Requests are answered by a pool of workers,
+ * each with its own cursor per group so lookups reuse cached times and
+ * extrapolations across requests. A refresh thread updates the groups
+ * periodically, or as their files change when watching them with inotify, and
+ * workers move to the new rows on their next request.
+ */
+struct TkdServer {
+private:
+  /**
+   * @brief A request waiting for a worker.
+   */
+  struct Job {
+    /**
+     * @brief The connection to answer on.
+     */
+    std::shared_ptr<TkdConnection> connection;
+
+    /**
+     * @brief The request header.
+     */
+    TkdFrameHeader header;
+
+    /**
+     * @brief The request payload.
+     */
+    std::string payload;
+  };
+
+  /**
+   * @brief Per worker lookups on each group.
+   */
+  struct WorkerState {
+    /**
+     * @brief A cursor per group, replaced when the group gains rows.
+     */
+    std::vector<CsvTimeCursor> cursors;
+  };
+
+  /**
+   * @brief The names of the served groups.
+   */
+  std::vector<std::string> names_;
+
+  /**
+   * @brief The served groups, updated by the refresh thread.
+   */
+  std::vector<std::unique_ptr<CsvTimeGroup>> groups_;
+
+  /**
+   * @brief A watcher per group when watching files, read by the refresh
+   * thread.
+   */
+  std::vector<std::unique_ptr<CsvGroupWatcher>> watchers_;
+
+  /**
+   * @brief Path of the listening socket.
+   */
+  std::string socketPath_;
+
+  /**
+   * @brief Number of worker threads.
+   */
+  int workerCount_;
+
+  /**
+   * @brief Time between group updates, zero to never update.
+   */
+  std::chrono::milliseconds refreshInterval_;
+
+  /**
+   * @brief Whether groups are updated as their files change.
+   */
+  bool watch_;
+
+  /**
+   * @brief The listening socket.
+   */
+  int listenFd_ = -1;
+
+  /**
+   * @brief The epoll instance of the loop.
+   */
+  int epollFd_ = -1;
+
+  /**
+   * @brief Event counter that wakes the loop to flush responses or stop.
+   */
+  int wakeFd_ = -1;
+
+  /**
+   * @brief Open connections by file descriptor, owned by the loop thread.
+   */
+  std::map<int, std::shared_ptr<TkdConnection>> connections_;
+
+  /**
+   * @brief Guards the job queue and stopping_.
+   */
+  std::mutex queueMutex_;
+
+  /**
+   * @brief Signalled when jobs are queued or the server stops.
+   */
+  std::condition_variable queueReady_;
+
+  /**
+   * @brief Signalled when the server stops, wakes the refresh thread.
+   */
+  std::condition_variable stopped_;
+
+  /**
+   * @brief Requests waiting for a worker.
+   */
+  std::deque<Job> queue_;
+
+  /**
+   * @brief Set when the workers and refresh thread should exit.
+   */
+  bool stopping_ = false;
+
+  /**
+   * @brief Guards pendingFlushes_.
+   */
+  std::mutex flushMutex_;
+
+  /**
+   * @brief Connections with responses for the loop to write.
+   */
+  std::vector<std::shared_ptr<TkdConnection>> pendingFlushes_;
+
+  /**
+   * @brief Set by stop(), checked by the loop.
+   */
+  std::atomic<bool> stopRequested_ = false;
+
+  /**
+   * @brief Accepts all pending connections.
+   */
+  void acceptConnections();
+
+  /**
+   * @brief Reads from a connection and queues its complete requests.
+   * @return false if the connection was closed.
+   */
+  bool readConnection(const std::shared_ptr<TkdConnection> &connection);
+
+  /**
+   * @brief Writes as much of a connection's responses as the socket takes.
+   * @return false if the connection was closed.
+   */
+  bool flushConnection(const std::shared_ptr<TkdConnection> &connection);
+
+  /**
+   * @brief Closes a connection and forgets it.
+   */
+  void closeConnection(const std::shared_ptr<TkdConnection> &connection);
+
+  /**
+   * @brief Wakes the loop.
+   */
+  void wake();
+
+  /**
+   * @brief Answers queued requests until the server stops.
+   */
+  void workerLoop();
+
+  /**
+   * @brief Updates the groups periodically, and as their files change when
+   * watching, until the server stops.
+   */
+  void refreshLoop();
+
+  /**
+   * @brief Answers a request.
+   * @param job The request.
+   * @param state The worker's cursors.
+   * @param response Receives the response frame.
+   */
+  void answer(const Job &job, WorkerState &state, TkdWriter &response);
+
+  /**
+   * @brief Gets the worker's cursor on a group, at the group's latest rows.
+   * @throws std::invalid_argument if the group does not exist.
+   */
+  CsvTimeCursor &cursor(WorkerState &state, std::uint16_t group);
+
+  /**
+   * @brief Gets the name of a column of a group.
+   * @param rows The worker's cursor on the group.
+   * @throws std::invalid_argument if the column does not exist.
+   */
+  const std::string &columnName(const CsvTimeCursor &rows, std::uint16_t group,
+                                std::uint16_t column);
+
+public:
+  /**
+   * @brief Construct a server with no groups.
+   * @param socketPath Path of the Unix socket to listen on.
+   * @param workers Number of worker threads.
+   * @param refreshInterval Time between group updates, zero to never update.
+   * When watching, the rescans only catch changes inotify cannot see, such as
+   * files written over NFS.
+   * @param watch If true, updates each group's changed files shortly after
+   * they are written.
+   */
+  TkdServer(std::string socketPath, int workers,
+            std::chrono::milliseconds refreshInterval, bool watch = false);
+
+  TkdServer(const TkdServer &) = delete;
+  TkdServer &operator=(const TkdServer &) = delete;
+
+  /**
+   * @brief Closes the sockets.
+   */
+  ~TkdServer();
+
+  /**
+   * @brief Opens a group and serves it under a name.
+   * @details Call before run(). Groups are numbered in the order added.
+   * @param name The group name reported by list requests.
+   * @param metadata The group's files and layout.
+   * @param timeFormat The format of the time data in the files.
+   * @throws std::runtime_error if watching and the files cannot be watched.
+   */
+  void addGroup(std::string name, CsvGroupMetadata metadata,
+                CsvTimeFormat timeFormat);
+
+  /**
+   * @brief Listens on the socket and serves requests until stop() is called.
+   * @throws std::runtime_error if the socket cannot be set up.
+   */
+  void run();
+
+  /**
+   * @brief Makes run() return.
+   * @details Safe to call from any thread and from a signal handler.
+   */
+  void stop();
+};
+
+#endif // __TKDSERVER_H__
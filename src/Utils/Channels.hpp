@@ -0,0 +1,90 @@
+#ifndef __CHANNELS_H__
+#define __CHANNELS_H__
+
+#include <array>
+#include <cstddef>
+
+/**
+ * @brief Index of each clock channel recorded by the phase/frequency counter.
+ */
+enum Channel { Si = 0, Rb = 1, H = 2, Z = 3 };
+
+/**
+ * @brief Number of clock channels (Si, Rb, H, Z).
+ */
+inline constexpr std::size_t channelCount = 4;
+
+/**
+ * @brief A value for each of the four clock channels, operated on lane-wise.
+ *
+ * Keeps the Si/Rb/H/Z arithmetic of the phase tools in a single expression
+ * per operation rather than four hand-written copies. For hardware floating
+ * point types the fixed-size loops are vectorised by the compiler; for the
+ * software quad type they simply unroll.
+ *
+ * @tparam T The numeric type stored in each lane.
+ */
+template <typename T> struct Channels {
+  /**
+   * @brief Values for each channel, indexed by Channel.
+   */
+  std::array<T, channelCount> lanes{};
+
+  /**
+   * @brief Access the value for a specific channel.
+   * @param channel The channel to access.
+   * @return A reference to the value of the channel.
+   */
+  T &operator[](std::size_t channel) { return lanes[channel]; }
+
+  /**
+   * @brief Access the value for a specific channel.
+   * @param channel The channel to access.
+   * @return A const reference to the value of the channel.
+   */
+  const T &operator[](std::size_t channel) const { return lanes[channel]; }
+
+  /**
+   * @brief Lane-wise addition.
+   */
+  Channels &operator+=(const Channels &other) {
+    for (std::size_t i = 0; i < channelCount; ++i) {
+      lanes[i] += other.lanes[i];
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Lane-wise subtraction.
+   */
+  Channels &operator-=(const Channels &other) {
+    for (std::size_t i = 0; i < channelCount; ++i) {
+      lanes[i] -= other.lanes[i];
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Multiply every lane by the same scalar.
+   */
+  Channels &operator*=(const T &scalar) {
+    for (std::size_t i = 0; i < channelCount; ++i) {
+      lanes[i] *= scalar;
+    }
+    return *this;
+  }
+
+  friend Channels operator+(Channels lhs, const Channels &rhs) {
+    return lhs += rhs;
+  }
+
+  friend Channels operator-(Channels lhs, const Channels &rhs) {
+    return lhs -= rhs;
+  }
+
+  friend Channels operator*(Channels lhs, const T &scalar) {
+    return lhs *= scalar;
+  }
+};
+
+#endif // __CHANNELS_H__
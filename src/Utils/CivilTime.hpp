@@ -0,0 +1,44 @@
+#ifndef __CIVILTIME_H__
+#define __CIVILTIME_H__
+
+#include <cstdint>
+
+/**
+ * @brief Divides rounding toward negative infinity, so times before 1970
+ * fall on the day or step that contains them.
+ */
+constexpr std::int64_t floorDiv(std::int64_t a, std::int64_t b) {
+  return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
+
+/**
+ * @brief A proleptic Gregorian date.
+ */
+struct CivilDate {
+  std::int64_t year;
+  unsigned month;
+  unsigned day;
+};
+
+/**
+ * @brief The date of a day counted from 1970-01-01, the inverse of
+ * time_parse_detail::daysFromCivil.
+ */
+constexpr CivilDate civilFromDays(std::int64_t days) {
+  days += 719468;
+  const std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+  const unsigned day_of_era = static_cast<unsigned>(days - era * 146097);
+  const unsigned year_of_era = (day_of_era - day_of_era / 1460 +
+                                day_of_era / 36524 - day_of_era / 146096) /
+                               365;
+  const unsigned day_of_year =
+      day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+  const unsigned shifted_month = (5 * day_of_year + 2) / 153;
+  const unsigned day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+  const unsigned month =
+      shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+  return {static_cast<std::int64_t>(year_of_era) + era * 400 + (month <= 2),
+          month, day};
+}
+
+#endif // __CIVILTIME_H__
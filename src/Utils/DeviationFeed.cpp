@@ -0,0 +1,168 @@
+#include "DeviationFeed.hpp"
+
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+
+#include <bit>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+namespace bip = boost::interprocess;
+
+namespace {
+/**
+ * @brief Marks a segment as a deviation record, "TKDEVIAT".
+ */
+constexpr std::uint64_t recordMagic = 0x5441495645444b54;
+
+/**
+ * @brief Bumped whenever the record layout changes.
+ */
+constexpr std::uint64_t recordVersion = 1;
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+              "Shared records need lock free 64-bit atomics");
+
+/**
+ * @brief Spins before a reader starts yielding to a stalled writer.
+ */
+constexpr int readSpins = 1000;
+
+/**
+ * @brief Maps the whole of a segment.
+ * @param segment The opened segment.
+ * @param mode The access mode.
+ * @return The mapping, holding the record pointer.
+ */
+std::shared_ptr<void> mapRecord(bip::shared_memory_object &segment,
+                                bip::mode_t mode) {
+  auto region =
+      std::make_shared<bip::mapped_region>(segment, mode, 0,
+                                           sizeof(DeviationRecord));
+  return std::shared_ptr<void>(region, region->get_address());
+}
+} // namespace
+
+DeviationPublisher::DeviationPublisher(const std::string &name) : name_(name) {
+  try {
+    bip::shared_memory_object segment(bip::open_or_create, name.c_str(),
+                                      bip::read_write);
+    bip::offset_t size = 0;
+    if (!segment.get_size(size) ||
+        size < bip::offset_t(sizeof(DeviationRecord))) {
+      // New segments are zero filled, which is an empty record
+      segment.truncate(sizeof(DeviationRecord));
+    }
+    mapping_ = mapRecord(segment, bip::read_write);
+  } catch (const bip::interprocess_exception &e) {
+    throw std::runtime_error("Could not create deviation feed " + name + ": " +
+                             e.what());
+  }
+  record_ = static_cast<DeviationRecord *>(mapping_.get());
+
+  if (record_->magic == 0) {
+    record_->version = recordVersion;
+    record_->magic = recordMagic;
+  } else if (record_->magic != recordMagic ||
+             record_->version != recordVersion) {
+    throw std::runtime_error("Deviation feed " + name +
+                             " has an unexpected layout");
+  }
+
+  // A previous publisher may have stopped mid write, leaving readers spinning
+  std::uint64_t sequence = record_->sequence.load(std::memory_order_relaxed);
+  if (sequence % 2 != 0) {
+    record_->sequence.store(sequence + 1, std::memory_order_release);
+  }
+}
+
+void DeviationPublisher::publish(DeviationSample sample) {
+  sample.published = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count();
+
+  std::uint64_t sequence = record_->sequence.load(std::memory_order_relaxed);
+  record_->sequence.store(sequence + 1, std::memory_order_relaxed);
+  // Readers that see any new field must also see the odd sequence
+  std::atomic_thread_fence(std::memory_order_release);
+
+  const std::uint64_t fields[DeviationRecord::fieldCount] = {
+      std::bit_cast<std::uint64_t>(sample.index),
+      std::bit_cast<std::uint64_t>(sample.time),
+      std::bit_cast<std::uint64_t>(sample.dataTime),
+      std::bit_cast<std::uint64_t>(sample.published),
+      std::bit_cast<std::uint64_t>(sample.deviation),
+      std::bit_cast<std::uint64_t>(sample.siFrequency),
+      std::bit_cast<std::uint64_t>(sample.hFrequency),
+      std::bit_cast<std::uint64_t>(sample.dataFrequency)};
+  for (size_t i = 0; i < DeviationRecord::fieldCount; ++i) {
+    record_->fields[i].store(fields[i], std::memory_order_relaxed);
+  }
+
+  record_->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool DeviationPublisher::remove(const std::string &name) {
+  return bip::shared_memory_object::remove(name.c_str());
+}
+
+DeviationReader::DeviationReader(const std::string &name) {
+  try {
+    bip::shared_memory_object segment(bip::open_only, name.c_str(),
+                                      bip::read_only);
+    bip::offset_t size = 0;
+    if (!segment.get_size(size) ||
+        size < bip::offset_t(sizeof(DeviationRecord))) {
+      throw std::runtime_error("Deviation feed " + name + " is not ready");
+    }
+    mapping_ = mapRecord(segment, bip::read_only);
+  } catch (const bip::interprocess_exception &e) {
+    throw std::runtime_error("Could not open deviation feed " + name + ": " +
+                             e.what());
+  }
+  record_ = static_cast<const DeviationRecord *>(mapping_.get());
+
+  if (record_->magic != recordMagic || record_->version != recordVersion) {
+    throw std::runtime_error("Deviation feed " + name +
+                             " has an unexpected layout");
+  }
+}
+
+std::uint64_t DeviationReader::count() const {
+  return record_->sequence.load(std::memory_order_acquire) / 2;
+}
+
+std::uint64_t DeviationReader::read(DeviationSample &sample) const {
+  std::uint64_t fields[DeviationRecord::fieldCount];
+  for (int attempt = 0;; ++attempt) {
+    if (attempt >= readSpins) {
+      std::this_thread::yield();
+    }
+
+    std::uint64_t before = record_->sequence.load(std::memory_order_acquire);
+    if (before % 2 != 0) {
+      continue;
+    }
+    if (before == 0) {
+      return 0;
+    }
+
+    for (size_t i = 0; i < DeviationRecord::fieldCount; ++i) {
+      fields[i] = record_->fields[i].load(std::memory_order_relaxed);
+    }
+    // The fields must be read before the sequence is checked again
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (record_->sequence.load(std::memory_order_relaxed) == before) {
+      sample.index = std::bit_cast<std::int64_t>(fields[0]);
+      sample.time = std::bit_cast<std::int64_t>(fields[1]);
+      sample.dataTime = std::bit_cast<std::int64_t>(fields[2]);
+      sample.published = std::bit_cast<std::int64_t>(fields[3]);
+      sample.deviation = std::bit_cast<double>(fields[4]);
+      sample.siFrequency = std::bit_cast<double>(fields[5]);
+      sample.hFrequency = std::bit_cast<double>(fields[6]);
+      sample.dataFrequency = std::bit_cast<double>(fields[7]);
+      return before / 2;
+    }
+  }
+}
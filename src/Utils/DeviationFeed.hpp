@@ -0,0 +1,189 @@
+#ifndef __DEVIATIONFEED_H__
+#define __DEVIATIONFEED_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * @brief One result of the time deviation calculation.
+ *
+ * Values are doubles, which keep the deviation well below a picosecond and
+ * the frequencies to about one part in 1e16. Readers that need the full
+ * precision should read the output file.
+ */
+struct DeviationSample {
+  /**
+   * @brief The interval index of the result.
+   */
+  std::int64_t index = 0;
+
+  /**
+   * @brief The time of the result, in microseconds since 1970-01-01.
+   */
+  std::int64_t time = 0;
+
+  /**
+   * @brief The time of the data row used, in microseconds since 1970-01-01.
+   */
+  std::int64_t dataTime = 0;
+
+  /**
+   * @brief When the sample was published, in nanoseconds of the system clock.
+   */
+  std::int64_t published = 0;
+
+  /**
+   * @brief The time deviation in seconds.
+   */
+  double deviation = 0;
+
+  /**
+   * @brief The Si3 frequency in Hz.
+   */
+  double siFrequency = 0;
+
+  /**
+   * @brief The Hydrogen Maser frequency in Hz.
+   */
+  double hFrequency = 0;
+
+  /**
+   * @brief The logged data frequency in Hz.
+   */
+  double dataFrequency = 0;
+};
+
+/**
+ * @brief Shared memory layout of a deviation feed.
+ *
+ * A seqlock: the writer makes the sequence odd, stores the fields, then makes
+ * it even again. Readers copy the fields and retry if the sequence changed or
+ * was odd, so they never block the writer and publishing is a handful of
+ * stores with no system call. Fields are atomics so the concurrent copies are
+ * well defined.
+ */
+struct DeviationRecord {
+  /**
+   * @brief The number of 64-bit fields in a sample.
+   */
+  static constexpr std::size_t fieldCount = 8;
+
+  /**
+   * @brief Identifies the segment layout.
+   */
+  std::uint64_t magic;
+
+  /**
+   * @brief The layout version.
+   */
+  std::uint64_t version;
+
+  /**
+   * @brief Twice the number of samples published, odd while one is written.
+   */
+  alignas(64) std::atomic<std::uint64_t> sequence;
+
+  /**
+   * @brief The fields of the last sample, in DeviationSample order.
+   */
+  std::atomic<std::uint64_t> fields[fieldCount];
+};
+
+/**
+ * @brief Writes deviation samples to a named shared memory record.
+ *
+ * The segment is created on first use and left in place on exit, so monitors
+ * can still read the last sample and stay attached across restarts.
+ */
+struct DeviationPublisher {
+private:
+  /**
+   * @brief Keeps the segment mapped.
+   */
+  std::shared_ptr<void> mapping_;
+
+  /**
+   * @brief The mapped record.
+   */
+  DeviationRecord *record_;
+
+  /**
+   * @brief The segment name.
+   */
+  std::string name_;
+
+public:
+  /**
+   * @brief Creates or opens the named record for writing.
+   * @param name The shared memory segment name.
+   * @throws std::runtime_error if the segment cannot be created or mapped.
+   */
+  explicit DeviationPublisher(const std::string &name);
+
+  /**
+   * @brief Publishes a sample, replacing the previous one.
+   * @details Only one publisher may write a record at a time.
+   * @param sample The sample to publish. Its published time is set here.
+   */
+  void publish(DeviationSample sample);
+
+  /**
+   * @brief Gets the segment name.
+   * @return The name.
+   */
+  const std::string &name() const { return name_; }
+
+  /**
+   * @brief Removes the named segment. Mapped readers keep their mapping.
+   * @param name The shared memory segment name.
+   * @return true if a segment was removed.
+   */
+  static bool remove(const std::string &name);
+};
+
+/**
+ * @brief Reads the latest sample from a named shared memory record.
+ *
+ * Reads are a copy out of the mapping with no system call and are safe from
+ * any number of threads and processes.
+ */
+struct DeviationReader {
+private:
+  /**
+   * @brief Keeps the segment mapped.
+   */
+  std::shared_ptr<void> mapping_;
+
+  /**
+   * @brief The mapped record.
+   */
+  const DeviationRecord *record_;
+
+public:
+  /**
+   * @brief Opens the named record read only.
+   * @param name The shared memory segment name.
+   * @throws std::runtime_error if no publisher has created the segment or its
+   * layout does not match.
+   */
+  explicit DeviationReader(const std::string &name);
+
+  /**
+   * @brief Gets the number of samples published so far.
+   * @details Cheap enough to poll for new samples.
+   * @return The sample count.
+   */
+  std::uint64_t count() const;
+
+  /**
+   * @brief Copies the latest sample.
+   * @param sample Receives the sample.
+   * @return The count of the sample read, or 0 if none has been published.
+   */
+  std::uint64_t read(DeviationSample &sample) const;
+};
+
+#endif // __DEVIATIONFEED_H__
@@ -0,0 +1,170 @@
+#ifndef __FIELDPARSE_H__
+#define __FIELDPARSE_H__
+
+#include <boost/multiprecision/cpp_bin_float.hpp>
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+
+namespace field_parse_detail {
+/**
+ * @brief Parses a plain decimal field of at most 19 significant digits into a
+ * multiprecision float, as the significant digits over a power of ten.
+ * @details Both are exact in a quad and the division is correctly rounded,
+ * so the value is the one Boost's string conversion gives, without the heap
+ * allocations that conversion makes for long fields.
+ * @param field The text of the field, digits with an optional sign and
+ * point.
+ * @param value Receives the parsed value.
+ * @return false if the field has another form, for Boost to parse.
+ */
+template <typename T>
+bool parseShortDecimal(std::string_view field, T &value) {
+  std::size_t pos = 0;
+  bool negative = false;
+  if (pos < field.size() && (field[pos] == '-' || field[pos] == '+')) {
+    negative = field[pos] == '-';
+    ++pos;
+  }
+
+  std::uint64_t mantissa = 0;
+  int significant = 0;
+  int integer = 0;
+  int fraction = 0;
+  bool point = false;
+  for (; pos < field.size(); ++pos) {
+    char c = field[pos];
+    if (c == '.' && !point) {
+      point = true;
+      continue;
+    }
+    if (c < '0' || c > '9') {
+      return false;
+    }
+    ++(point ? fraction : integer);
+    if (mantissa == 0 && c == '0') {
+      // Leading zeros are not significant
+      continue;
+    }
+    if (++significant > 19) {
+      return false;
+    }
+    mantissa = mantissa * 10 + (c - '0');
+  }
+
+  // Powers of ten up to 10^48 are exact in 113 bits, as 5^48 < 2^113
+  if (integer == 0 || (point && fraction == 0) || fraction > 48) {
+    return false;
+  }
+  static const std::array<T, 49> powers = [] {
+    std::array<T, 49> result;
+    result[0] = 1;
+    for (std::size_t i = 1; i < result.size(); ++i) {
+      result[i] = result[i - 1] * 10;
+    }
+    return result;
+  }();
+
+  value = T(mantissa);
+  if (fraction > 0) {
+    value /= powers[fraction];
+  }
+  if (negative && mantissa != 0) {
+    // Boost reads a negative zero as zero
+    value = -value;
+  }
+  return true;
+}
+} // namespace field_parse_detail
+
+/**
+ * @brief Parses a single numeric field without allocating.
+ * @param field The text of the field, without surrounding whitespace.
+ * @param value Receives the parsed value.
+ * @return true if the whole field was a valid number, false otherwise.
+ */
+template <typename T> bool parseField(std::string_view field, T &value) {
+  if constexpr (boost::multiprecision::is_number<T>::value) {
+    if constexpr (std::numeric_limits<T>::digits >= 113) {
+      if (field_parse_detail::parseShortDecimal(field, value)) {
+        return true;
+      }
+    }
+
+    // Multiprecision types have no from_chars, construct from a null
+    // terminated copy on the stack instead
+    char buffer[128];
+    if (field.empty() || field.size() >= sizeof(buffer)) {
+      return false;
+    }
+    field.copy(buffer, field.size());
+    buffer[field.size()] = '\0';
+    try {
+      value = T(buffer);
+    } catch (const std::exception &) {
+      return false;
+    }
+    return true;
+  } else {
+    auto [end, ec] =
+        std::from_chars(field.data(), field.data() + field.size(), value);
+    return ec == std::errc() && end == field.data() + field.size();
+  }
+}
+
+/**
+ * @brief Splits a line into fields separated by runs of whitespace.
+ *
+ * Views into the line are returned one at a time, nothing is copied.
+ */
+struct WhitespaceFields {
+private:
+  /**
+   * @brief The line being split.
+   */
+  std::string_view line_;
+
+  /**
+   * @brief Position of the next unread character.
+   */
+  std::size_t pos_ = 0;
+
+public:
+  /**
+   * @brief Construct a splitter over the given line.
+   * @param line The line to split, must outlive the splitter.
+   */
+  explicit WhitespaceFields(std::string_view line) : line_(line) {}
+
+  /**
+   * @brief Gets the next field.
+   * @return The next field, or an empty view once the line is exhausted.
+   */
+  std::string_view next() {
+    pos_ = line_.find_first_not_of(" \t\r", pos_);
+    if (pos_ == std::string_view::npos) {
+      pos_ = line_.size();
+      return {};
+    }
+    std::size_t end = line_.find_first_of(" \t\r", pos_);
+    if (end == std::string_view::npos) {
+      end = line_.size();
+    }
+    std::string_view field = line_.substr(pos_, end - pos_);
+    pos_ = end;
+    return field;
+  }
+
+  /**
+   * @brief Parses the next field into a value.
+   * @param value Receives the parsed value.
+   * @return true if the field existed and was a valid number.
+   */
+  template <typename T> bool next(T &value) { return parseField(next(), value); }
+};
+
+#endif // __FIELDPARSE_H__
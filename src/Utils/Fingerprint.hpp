@@ -0,0 +1,43 @@
+#ifndef __FINGERPRINT_H__
+#define __FINGERPRINT_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief 64-bit FNV-1a of a sequence of fields, for naming cached data after
+ * what it was built from.
+ */
+struct Fingerprint {
+  /**
+   * @brief The hash of the fields added so far.
+   */
+  std::uint64_t hash = 0xcbf29ce484222325;
+
+  /**
+   * @brief Adds raw bytes.
+   */
+  void add(const void *data, std::size_t size) {
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (std::size_t i = 0; i < size; ++i) {
+      hash = (hash ^ bytes[i]) * 0x100000001b3;
+    }
+  }
+
+  /**
+   * @brief Adds a string field.
+   */
+  void add(const std::string &text) {
+    add(text.data(), text.size());
+    // Separate fields so ("ab","c") and ("a","bc") differ
+    add("", 1);
+  }
+
+  /**
+   * @brief Adds the bytes of a value.
+   */
+  template <typename T> void addValue(T value) { add(&value, sizeof(value)); }
+};
+
+#endif // __FINGERPRINT_H__
@@ -0,0 +1,71 @@
+#include "LineChunks.hpp"
+
+#include <algorithm>
+
+bool LineBlockReader::next(std::string &block) {
+  block.clear();
+  block.swap(carry_);
+
+  // Top up the block with fresh data from the stream
+  std::size_t old_size = block.size();
+  if (old_size < blockSize_) {
+    block.resize(blockSize_);
+    input_.read(block.data() + old_size, blockSize_ - old_size);
+    block.resize(old_size + input_.gcount());
+  }
+
+  if (block.empty()) {
+    return false;
+  }
+
+  // Keep any trailing partial line for the next block, unless the stream has
+  // ended in which case the final line is returned without a newline
+  if (input_) {
+    std::size_t last_newline = block.rfind('\n');
+    if (last_newline == std::string::npos) {
+      // A single line longer than the block, keep reading until it ends
+      std::string rest;
+      std::getline(input_, rest);
+      block += rest;
+      if (!input_.eof()) {
+        block += '\n';
+      }
+    } else {
+      carry_.assign(block, last_newline + 1);
+      block.resize(last_newline + 1);
+    }
+  }
+
+  return true;
+}
+
+std::vector<std::string_view> splitLines(std::string_view block,
+                                         std::size_t chunks) {
+  std::vector<std::string_view> result;
+  if (chunks == 0) {
+    chunks = 1;
+  }
+  result.reserve(chunks);
+
+  std::size_t target = block.size() / chunks + 1;
+  std::size_t start = 0;
+  while (start < block.size()) {
+    std::size_t end = std::min(start + target, block.size());
+    if (end < block.size()) {
+      // Extend the chunk to the end of the line it finishes in
+      std::size_t newline = block.find('\n', end - 1);
+      end = newline == std::string_view::npos ? block.size() : newline + 1;
+    }
+    result.push_back(block.substr(start, end - start));
+    start = end;
+  }
+
+  return result;
+}
+
+std::size_t workerCount(long requested) {
+  if (requested > 0) {
+    return requested;
+  }
+  return std::max(1u, std::thread::hardware_concurrency());
+}
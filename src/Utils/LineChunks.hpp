@@ -0,0 +1,88 @@
+#ifndef __LINECHUNKS_H__
+#define __LINECHUNKS_H__
+
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Reads an input stream in large blocks that always end on a line
+ * boundary.
+ *
+ * Used by the streaming tools to hand whole lines to worker threads without
+ * reading the input one line at a time.
+ */
+struct LineBlockReader {
+private:
+  /**
+   * @brief The stream being read.
+   */
+  std::istream &input_;
+
+  /**
+   * @brief Target size in bytes of each block.
+   */
+  std::size_t blockSize_;
+
+  /**
+   * @brief Partial line left over from the previous block.
+   */
+  std::string carry_;
+
+public:
+  /**
+   * @brief Construct a reader over the given stream.
+   * @param input The stream to read from.
+   * @param blockSize Target size in bytes of each block.
+   */
+  LineBlockReader(std::istream &input, std::size_t blockSize)
+      : input_(input), blockSize_(blockSize) {}
+
+  /**
+   * @brief Reads the next block of complete lines.
+   * @param block Buffer receiving the block, replaced on every call.
+   * @return false once the input is exhausted and no data was read.
+   */
+  bool next(std::string &block);
+};
+
+/**
+ * @brief Splits a block of text into contiguous chunks of whole lines.
+ * @param block The text to split.
+ * @param chunks The desired number of chunks.
+ * @return Up to `chunks` views covering the block in order, each ending just
+ * after a newline (or at the end of the block).
+ */
+std::vector<std::string_view> splitLines(std::string_view block,
+                                         std::size_t chunks);
+
+/**
+ * @brief Runs func(i) for every i in [0, count) on its own thread and waits
+ * for all of them to finish.
+ * @param count The number of tasks to run.
+ * @param func The task, called with the task index.
+ */
+template <typename Func> void parallelFor(std::size_t count, Func &&func) {
+  if (count == 1) {
+    func(std::size_t{0});
+    return;
+  }
+
+  std::vector<std::jthread> workers;
+  workers.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    workers.emplace_back([&func, i]() { func(i); });
+  }
+}
+
+/**
+ * @brief Gets the number of worker threads to use for a requested count.
+ * @param requested The requested number of threads, 0 for one per core.
+ * @return The number of threads to use, at least 1.
+ */
+std::size_t workerCount(long requested);
+
+#endif // __LINECHUNKS_H__
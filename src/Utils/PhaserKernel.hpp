@@ -0,0 +1,172 @@
+#ifndef __PHASERKERNEL_H__
+#define __PHASERKERNEL_H__
+
+#include "Channels.hpp"
+#include "FieldParse.hpp"
+
+#include <boost/multiprecision/cpp_bin_float.hpp>
+
+#include <cmath>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+using quad = boost::multiprecision::cpp_bin_float_quad;
+
+/**
+ * @brief One row of Phaser input data.
+ * @details Phase is only read when checking against given phase data.
+ */
+struct PhaserRow {
+  int Day = 0;
+  double Time = 0;
+  int S = 0;
+  Channels<quad> Phase;
+  Channels<quad> Freq;
+};
+
+/**
+ * @brief Per-row work of the Phaser tool, specialised for one mode.
+ *
+ * The mode is fixed at compile time so the row loop carries no option
+ * lookups or mode branches; the tool selects an instantiation once at start
+ * up.
+ *
+ * @tparam Check If true, rows include the given phase data and the output
+ * includes the phase error against it. If false, rows only contain
+ * frequencies.
+ */
+template <bool Check> struct PhaserKernel {
+  /**
+   * @brief Whether this kernel checks against given phase data.
+   */
+  static constexpr bool check = Check;
+
+  /**
+   * @brief Parses a whitespace separated line into a row.
+   * @details Input columns are Day, Time, S, [Si_Phase, Rb_Phase, H_Phase,
+   * Z_Phase,] Si_Freq, Rb_Freq, H_Freq, Z_Freq. Extra columns are ignored.
+   * @param line The line to parse.
+   * @param row Receives the parsed values.
+   * @return false if the line does not contain the expected fields.
+   */
+  static bool parse(std::string_view line, PhaserRow &row) {
+    WhitespaceFields fields(line);
+    if (!fields.next(row.Day) || !fields.next(row.Time) ||
+        !fields.next(row.S)) {
+      return false;
+    }
+    if constexpr (Check) {
+      for (std::size_t c = 0; c < channelCount; ++c) {
+        if (!fields.next(row.Phase[c])) {
+          return false;
+        }
+      }
+    }
+    for (std::size_t c = 0; c < channelCount; ++c) {
+      if (!fields.next(row.Freq[c])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Gets the phase accumulated over one interval of a row.
+   * @param row The row.
+   * @param interval The time between rows in seconds.
+   * @return Freq * interval for each channel.
+   */
+  static Channels<quad> increment(const PhaserRow &row, const quad &interval) {
+    return row.Freq * interval;
+  }
+
+  /**
+   * @brief Gets the accumulated phase at the first row of the input.
+   * @details When checking, accumulation starts from the given phase of the
+   * first row. Otherwise the first row accumulates on top of the start values.
+   * @param row The first row of input.
+   * @param start The starting phase values.
+   * @param interval The time between rows in seconds.
+   * @return The accumulated phase to output for the first row.
+   */
+  static Channels<quad> first(const PhaserRow &row,
+                              const Channels<quad> &start,
+                              const quad &interval) {
+    if constexpr (Check) {
+      return row.Phase;
+    } else {
+      return start + increment(row, interval);
+    }
+  }
+
+  /**
+   * @brief Writes the comment block and column header of the output file.
+   * @param output The stream to write to.
+   * @param inFile The name of the input file, for the comment block.
+   * @param interval The time between rows in seconds.
+   */
+  static void writeHeader(std::ostream &output, const std::string &inFile,
+                          const quad &interval) {
+    output << "#Phase data computed from frequency data by Phaser tool."
+           << std::endl
+           << "#Input file: " << inFile << std::endl
+           << "#Interval: " << interval << " seconds" << std::endl;
+
+    if constexpr (Check) {
+      output << "Year Month Day Hour Minute Second S Si_Phase Rb_Phase "
+                "H_Phase Z_Phase Si_Freq Rb_Freq H_Freq Z_Freq "
+             << "Si_Phase_From_Freq Rb_Phase_From_Freq H_Phase_From_Freq "
+                "Z_Phase_From_Freq "
+             << "Si_Phase_Error Rb_Phase_Error H_Phase_Error Z_Phase_Error"
+             << std::endl;
+    } else {
+      output << "Year Month Day Hour Minute Second S Si_Phase Rb_Phase "
+                "H_Phase Z_Phase"
+             << "Si_Freq Rb_Freq H_Freq Z_Freq" << std::endl;
+    }
+  }
+
+  /**
+   * @brief Writes one output row.
+   * @param output The stream to write to.
+   * @param row The input row.
+   * @param phaseFromFreq The phase accumulated up to and including the row.
+   */
+  static void write(std::ostream &output, const PhaserRow &row,
+                    const Channels<quad> &phaseFromFreq) {
+    // Convert Day and Time to Year, Month, Day, Hour, Minute, Second
+    int year = row.Day / 10000 + 2000; // Assuming the 21st century
+    int month = (row.Day % 10000) / 100;
+    int day_of_month = row.Day % 100;
+    int hour = row.Time / 10000;
+    int minute = (std::fmod(row.Time, 10000) / 100);
+    double second = std::fmod(row.Time, 100);
+
+    output.precision(std::numeric_limits<double>::digits10);
+    output << year << " " << month << " " << day_of_month << " " << hour << " "
+           << minute << " " << second << " ";
+
+    output << row.S << " ";
+
+    output.precision(std::numeric_limits<quad>::digits10);
+    if constexpr (Check) {
+      Channels<quad> phase_error = row.Phase - phaseFromFreq;
+      output << row.Phase[Si] << " " << row.Phase[Rb] << " " << row.Phase[H]
+             << " " << row.Phase[Z] << " " << row.Freq[Si] << " "
+             << row.Freq[Rb] << " " << row.Freq[H] << " " << row.Freq[Z] << " "
+             << phaseFromFreq[Si] << " " << phaseFromFreq[Rb] << " "
+             << phaseFromFreq[H] << " " << phaseFromFreq[Z] << " "
+             << phase_error[Si] << " " << phase_error[Rb] << " "
+             << phase_error[H] << " " << phase_error[Z] << "\n";
+    } else {
+      output << phaseFromFreq[Si] << " " << phaseFromFreq[Rb] << " "
+             << phaseFromFreq[H] << " " << phaseFromFreq[Z] << " "
+             << row.Freq[Si] << " " << row.Freq[Rb] << " " << row.Freq[H]
+             << " " << row.Freq[Z] << "\n";
+    }
+  }
+};
+
+#endif // __PHASERKERNEL_H__
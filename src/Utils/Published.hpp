@@ -0,0 +1,68 @@
+#ifndef __PUBLISHED_H__
+#define __PUBLISHED_H__
+
+#include <atomic>
+#include <memory>
+
+/**
+ * @brief The current version of an immutable value, replaced by pointer swaps.
+ *
+ * A writer builds a new version off to the side and publishes it with a
+ * single atomic store. Readers take the current version with a single atomic
+ * load and keep using it for as long as they hold the pointer, so they never
+ * wait for the writer and never see a half-built version. Old versions are
+ * freed when their last reader lets go, as in read-copy-update.
+ *
+ * @tparam T The immutable value type.
+ */
+template <typename T> struct Published {
+private:
+  /**
+   * @brief The current version.
+   */
+  std::atomic<std::shared_ptr<const T>> current_;
+
+public:
+  /**
+   * @brief Default constructor, with no version published.
+   */
+  Published() = default;
+
+  /**
+   * @brief Construct with an initial version.
+   * @param value The version to publish.
+   */
+  explicit Published(std::shared_ptr<const T> value)
+      : current_(std::move(value)) {}
+
+  /**
+   * @brief Copy constructor, starting from the other's current version.
+   */
+  Published(const Published &other) : current_(other.load()) {}
+
+  /**
+   * @brief Copy assignment, publishing the other's current version.
+   */
+  Published &operator=(const Published &other) {
+    store(other.load());
+    return *this;
+  }
+
+  /**
+   * @brief Gets the current version.
+   * @return The version, or nullptr if none has been published.
+   */
+  std::shared_ptr<const T> load() const {
+    return current_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Publishes a new version, replacing the current one.
+   * @param value The new version.
+   */
+  void store(std::shared_ptr<const T> value) {
+    current_.store(std::move(value), std::memory_order_release);
+  }
+};
+
+#endif // __PUBLISHED_H__
@@ -0,0 +1,194 @@
+#ifndef __TIMERKERNEL_H__
+#define __TIMERKERNEL_H__
+
+#include "Channels.hpp"
+#include "FieldParse.hpp"
+
+#include <boost/multiprecision/cpp_bin_float.hpp>
+
+#include <limits>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+using quad = boost::multiprecision::cpp_bin_float_quad;
+
+/**
+ * @brief One row of Timer input data, as written by the Phaser tool.
+ */
+struct TimerRow {
+  int Year = 0;
+  int Month = 0;
+  int Day = 0;
+  int Hour = 0;
+  int Minute = 0;
+  quad Second = 0;
+  int S = 0;
+  Channels<quad> Phase;
+  Channels<quad> Freq;
+};
+
+/**
+ * @brief Parameters of the Timer calculation, read once from the command line.
+ */
+struct TimerParameters {
+  /**
+   * @brief Reference time added to cumulative times, in seconds.
+   */
+  quad referenceTime = 0;
+
+  /**
+   * @brief Time between rows in seconds, used for time errors.
+   */
+  quad interval = 0.1;
+
+  /**
+   * @brief Nominal frequency of each channel.
+   */
+  Channels<quad> meanFreq;
+
+  /**
+   * @brief Frequency used to convert each channel's phase error into time.
+   */
+  Channels<quad> errorFreq;
+};
+
+/**
+ * @brief Per-row work of the Timer tool, specialised for one mode.
+ *
+ * The mode is fixed at compile time so the row loop carries no option
+ * lookups or mode branches; the tool selects an instantiation once at start
+ * up.
+ *
+ * @tparam Error If true, computes the time error of each row against the
+ * nominal frequency. If false, computes the cumulative time.
+ */
+template <bool Error> struct TimerKernel {
+  /**
+   * @brief Whether this kernel computes time errors.
+   */
+  static constexpr bool error = Error;
+
+  /**
+   * @brief Parses a whitespace separated line into a row.
+   * @details Input columns are Year, Month, Day, Hour, Minute, Second, S,
+   * Si_Phase, Rb_Phase, H_Phase, Z_Phase, Si_Freq, Rb_Freq, H_Freq, Z_Freq.
+   * Extra columns are ignored.
+   * @param line The line to parse.
+   * @param row Receives the parsed values.
+   * @return false if the line does not contain the expected fields.
+   */
+  static bool parse(std::string_view line, TimerRow &row) {
+    WhitespaceFields fields(line);
+    if (!fields.next(row.Year) || !fields.next(row.Month) ||
+        !fields.next(row.Day) || !fields.next(row.Hour) ||
+        !fields.next(row.Minute) || !fields.next(row.Second) ||
+        !fields.next(row.S)) {
+      return false;
+    }
+    for (std::size_t c = 0; c < channelCount; ++c) {
+      if (!fields.next(row.Phase[c])) {
+        return false;
+      }
+    }
+    for (std::size_t c = 0; c < channelCount; ++c) {
+      if (!fields.next(row.Freq[c])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Computes the time values of a row.
+   * @details The result only depends on the row and its position, so rows can
+   * be computed in any order.
+   * @param row The input row.
+   * @param intervalN The 1-based position of the row among the data rows.
+   * @param parameters The calculation parameters.
+   * @return The time (or time error) of each channel.
+   */
+  static Channels<quad> compute(const TimerRow &row, long long intervalN,
+                                const TimerParameters &parameters) {
+    Channels<quad> time;
+    if constexpr (Error) {
+      // Difference from the phase expected after intervalN intervals at the
+      // nominal frequency
+      for (std::size_t c = 0; c < channelCount; ++c) {
+        time[c] = (row.Phase[c] - intervalN * parameters.interval *
+                                      parameters.meanFreq[c]) /
+                  parameters.errorFreq[c];
+      }
+    } else {
+      for (std::size_t c = 0; c < channelCount; ++c) {
+        time[c] =
+            row.Phase[c] / parameters.meanFreq[c] + parameters.referenceTime;
+      }
+    }
+    return time;
+  }
+
+  /**
+   * @brief Writes the comment block and column header of the output file.
+   * @param output The stream to write to.
+   * @param inFile The name of the input file, for the comment block.
+   * @param parameters The calculation parameters.
+   */
+  static void writeHeader(std::ostream &output, const std::string &inFile,
+                          const TimerParameters &parameters) {
+    output.precision(std::numeric_limits<quad>::digits10);
+    output << "#Time data computed from Phase data by Timer tool."
+           << std::endl;
+    output << "#Input file: " << inFile << std::endl;
+    output << "#Si Frequency: " << parameters.meanFreq[Si] << " seconds"
+           << std::endl;
+    output << "#Rb Frequency: " << parameters.meanFreq[Rb] << " seconds"
+           << std::endl;
+    output << "#H Frequency: " << parameters.meanFreq[H] << " seconds"
+           << std::endl;
+    output << "#Z Frequency: " << parameters.meanFreq[Z] << " seconds"
+           << std::endl;
+    output << "#Reference time: " << parameters.referenceTime << " seconds"
+           << std::endl;
+    if constexpr (Error) {
+      output << "#Interval: " << parameters.interval << " seconds"
+             << std::endl;
+      output << "#Si Error Frequency: " << parameters.errorFreq[Si]
+             << " seconds" << std::endl;
+      output << "#Rb Error Frequency: " << parameters.errorFreq[Rb]
+             << " seconds" << std::endl;
+      output << "#H Error Frequency: " << parameters.errorFreq[H]
+             << " seconds" << std::endl;
+      output << "#Z Error Frequency: " << parameters.errorFreq[Z]
+             << " seconds" << std::endl;
+      output << "#Time errors computed from Phase data." << std::endl;
+    }
+
+    output << "Year Month Day Hour Minute Second S Si_Phase Rb_Phase H_Phase "
+              "Z_Phase Si_Freq Rb_Freq H_Freq Z_Freq "
+           << "Si_Time Rb_Time H_Time Z_Time" << std::endl;
+  }
+
+  /**
+   * @brief Writes one output row.
+   * @param output The stream to write to.
+   * @param row The input row.
+   * @param time The computed time values of the row.
+   */
+  static void write(std::ostream &output, const TimerRow &row,
+                    const Channels<quad> &time) {
+    output.precision(std::numeric_limits<double>::digits10);
+    output << row.Year << " " << row.Month << " " << row.Day << " " << row.Hour
+           << " " << row.Minute << " " << row.Second << " ";
+
+    output << row.S << " ";
+
+    output.precision(std::numeric_limits<quad>::digits10);
+    output << row.Phase[Si] << " " << row.Phase[Rb] << " " << row.Phase[H]
+           << " " << row.Phase[Z] << " " << row.Freq[Si] << " " << row.Freq[Rb]
+           << " " << row.Freq[H] << " " << row.Freq[Z] << " " << time[Si]
+           << " " << time[Rb] << " " << time[H] << " " << time[Z] << "\n";
+  }
+};
+
+#endif // __TIMERKERNEL_H__
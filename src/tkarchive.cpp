@@ -0,0 +1,427 @@
+/*
+ * tkarchive.cpp
+ * Converts the data files of a CSV group into compressed columnar archives,
+ * one archive per file, and checks the archives against the CSV.
+ *
+ * This file is part of the TimeKeeping project.
+ *
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "CsvFileUtils/CsvGroup.hpp"
+#include "CsvFileUtils/CsvTimeSnapshot.hpp"
+#include "CsvFileUtils/TimeArchive.hpp"
+
+#include "TimekeepingConfig.h"
+#include <argparse/argparse.hpp>
+
+/* Rows read from the CSV at a time.
+ */
+constexpr long chunkRows = 65536;
+
+/* An archive and the rows of the group it holds.
+ */
+struct ArchivedFile
+{
+    std::string dataPath;
+    std::string archivePath;
+    long first;
+    long last;
+};
+
+/* Parses a time format name as used in the configs.
+ */
+CsvTimeFormat parseTimeFormat(const std::string& format)
+{
+    if (format == "oneColStandard")
+    {
+        return CsvTimeFormat::oneColStandard;
+    }
+    if (format == "twoColShort")
+    {
+        return CsvTimeFormat::twoColShort;
+    }
+    throw std::runtime_error("Unknown time format " + format);
+}
+
+/* Splits a comma separated list of column names.
+ */
+std::vector<std::string> splitColumns(const std::string& list)
+{
+    std::vector<std::string> columns;
+    std::size_t start = 0;
+    while (start < list.size())
+    {
+        std::size_t end = std::min(list.find(',', start), list.size());
+        columns.push_back(list.substr(start, end - start));
+        start = end + 1;
+    }
+    return columns;
+}
+
+/* Finds the row after the last row of the file the first row is in.
+ */
+long fileEnd(const CsvGroupSnapshot& snapshot, long first)
+{
+    long file = snapshot.getFileIndexAndRow(first).first;
+    long low = first + 1;
+    long high = snapshot.size();
+    while (low < high)
+    {
+        long middle = low + (high - low) / 2;
+        if (snapshot.getFileIndexAndRow(middle).first == file)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/* Splits the group into its files and the archive each is written to.
+ */
+std::vector<ArchivedFile> planArchives(
+    const CsvGroupSnapshot& snapshot, const std::string& output)
+{
+    const CsvGroupMetadata& metadata = snapshot.metadata();
+    std::vector<ArchivedFile> files;
+    for (long first = 0; first < snapshot.size();)
+    {
+        long last = fileEnd(snapshot, first);
+        std::string data_path
+            = metadata.dataPaths()[snapshot.getFileIndexAndRow(first).first];
+        std::filesystem::path relative
+            = std::filesystem::path(data_path).lexically_relative(
+                metadata.parentPath());
+        files.push_back(
+            {data_path,
+             (std::filesystem::path(output) / relative).string() + ".tka",
+             first,
+             last});
+        first = last;
+    }
+    return files;
+}
+
+/* Writes the archive of one file.
+ */
+void writeArchive(
+    CsvTimeCursor& cursor, const ArchivedFile& file, CsvTimeFormat time_format,
+    std::size_t block_rows)
+{
+    const CsvGroupSnapshot& snapshot = cursor.group();
+    const CsvGroupMetadata& metadata = snapshot.metadata();
+    Projection all_columns = snapshot.project(metadata.colNames());
+
+    std::filesystem::create_directories(
+        std::filesystem::path(file.archivePath).parent_path());
+    TimeArchiveWriter writer(
+        file.archivePath,
+        metadata.colNames(),
+        time_format,
+        metadata.delimiter(),
+        metadata.multiDelimiter(),
+        block_rows);
+
+    std::vector<std::string_view> fields;
+    for (long first = file.first; first < file.last; first += chunkRows)
+    {
+        long last = std::min(first + chunkRows, file.last);
+        std::vector<time_ticks> times = cursor.timesOfRows(first, last);
+        for (long row = first; row < last; ++row)
+        {
+            snapshot.getFields(row, all_columns, fields);
+            writer.append(times[row - first], fields);
+        }
+    }
+    writer.close();
+}
+
+/* Compares the archives with the CSV field by field and value by value, then
+ * times a scan of every value column through each.
+ */
+bool verifyArchives(
+    CsvTimeCursor& cursor, const std::vector<ArchivedFile>& files,
+    CsvTimeFormat time_format)
+{
+    const CsvGroupSnapshot& snapshot = cursor.group();
+    const CsvGroupMetadata& metadata = snapshot.metadata();
+
+    std::vector<std::string> paths;
+    std::uintmax_t csv_bytes = 0;
+    for (const auto& file : files)
+    {
+        paths.push_back(file.archivePath);
+        csv_bytes += std::filesystem::file_size(file.dataPath);
+    }
+    TimeArchive archive(paths);
+    if (archive.size() != snapshot.size())
+    {
+        std::cerr << "Archives hold " << archive.size() << " rows, the group "
+                  << snapshot.size() << std::endl;
+        return false;
+    }
+
+    // Every field must come back as the text it was logged as
+    Projection all_columns = snapshot.project(metadata.colNames());
+    char separator
+        = metadata.delimiter().empty() ? ',' : metadata.delimiter()[0];
+    std::vector<std::string_view> fields;
+    std::string line;
+    for (long row = 0; row < snapshot.size(); ++row)
+    {
+        snapshot.getFields(row, all_columns, fields);
+        line.clear();
+        for (std::size_t i = 0; i < fields.size(); ++i)
+        {
+            if (i > 0)
+            {
+                line += separator;
+            }
+            line += fields[i];
+        }
+        if (line != archive.getRawLine(row))
+        {
+            std::cerr << "Row " << row << " differs: '" << line << "' and '"
+                      << archive.getRawLine(row) << "'" << std::endl;
+            return false;
+        }
+    }
+
+    std::vector<std::string> time_columns = timeColumns(time_format);
+    std::vector<std::string> value_columns;
+    for (const auto& name : metadata.colNames())
+    {
+        if (std::find(time_columns.begin(), time_columns.end(), name)
+            == time_columns.end())
+        {
+            value_columns.push_back(name);
+        }
+    }
+
+    // Scan each numeric column through both, checking the values agree
+    using clock = std::chrono::steady_clock;
+    clock::duration csv_time {};
+    clock::duration archive_time {};
+    long scanned = 0;
+    std::vector<date_time> csv_times, archive_times;
+    std::vector<quad> csv_values, archive_values;
+    for (const auto& column : value_columns)
+    {
+        for (long first = 0; first < snapshot.size(); first += chunkRows)
+        {
+            long last = std::min(first + chunkRows, snapshot.size());
+            auto start = clock::now();
+            try
+            {
+                cursor.readRange(first, last, column, csv_times, csv_values);
+            }
+            catch (const std::runtime_error&)
+            {
+                // Not a numeric column, its text was checked above
+                break;
+            }
+            auto middle = clock::now();
+            archive.readRange(
+                first, last, column, archive_times, archive_values);
+            auto end = clock::now();
+            csv_time += middle - start;
+            archive_time += end - middle;
+            scanned += last - first;
+
+            if (csv_times != archive_times || csv_values != archive_values)
+            {
+                std::cerr << "Column " << column << " differs in rows "
+                          << first << " to " << last << std::endl;
+                return false;
+            }
+        }
+    }
+
+    // Interpolated values must agree too
+    for (const auto& column : value_columns)
+    {
+        try
+        {
+            cursor.colAtTime(cursor.startTime(), column);
+        }
+        catch (const std::runtime_error&)
+        {
+            continue;
+        }
+        for (long row = 1; row < snapshot.size(); row += 997)
+        {
+            date_time time = cursor.timeOfRow(row - 1)
+                           + (cursor.timeOfRow(row) - cursor.timeOfRow(row - 1))
+                                 / 3;
+            if (cursor.colAtTime(time, column)
+                != archive.colAtTime(time, column))
+            {
+                std::cerr << "Column " << column << " interpolates differently"
+                          << " before row " << row << std::endl;
+                return false;
+            }
+        }
+    }
+
+    std::chrono::duration<double> csv_seconds = csv_time;
+    std::chrono::duration<double> archive_seconds = archive_time;
+    double percent
+        = 100.0 * archive.bytes() / std::max<std::uintmax_t>(1, csv_bytes);
+    std::cout << std::fixed << std::setprecision(1) << "Size: " << csv_bytes
+              << " bytes of CSV, " << archive.bytes() << " bytes archived ("
+              << percent << "%)" << std::endl;
+    if (scanned > 0)
+    {
+        std::cout << std::setprecision(3) << "Scan: " << scanned
+                  << " values in " << csv_seconds.count() << " s from CSV, "
+                  << archive_seconds.count() << " s from archives ("
+                  << std::setprecision(1)
+                  << csv_seconds.count()
+                         / std::max(archive_seconds.count(), 1e-9)
+                  << "x)" << std::endl;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    argparse::ArgumentParser parser(
+        "tkarchive",
+        std::format(
+            "v{}.{}", Timekeeping_VERSION_MAJOR, Timekeeping_VERSION_MINOR),
+        argparse::default_arguments::all,
+        true);
+    parser.add_description(
+        "tkarchive - Convert the data files of a CSV group into compressed "
+        "columnar archives, one .tka file per data file.");
+    parser.add_argument("-p", "--path")
+        .nargs(1)
+        .required()
+        .help("Directory holding the data files.");
+    parser.add_argument("-t", "--template")
+        .nargs(1)
+        .required()
+        .help("Regex the data file paths below --path match.");
+    parser.add_argument("-o", "--output")
+        .nargs(1)
+        .required()
+        .help("Directory to write the archives to, mirroring --path.");
+    parser.add_argument("-f", "--time-format")
+        .nargs(1)
+        .default_value(std::string("oneColStandard"))
+        .help("Time format of the files, oneColStandard or twoColShort.");
+    parser.add_argument("-d", "--delimiter")
+        .nargs(1)
+        .default_value(std::string(","))
+        .help("Delimiter characters of the files.");
+    parser.add_argument("-m", "--multi-delimiter")
+        .default_value(false)
+        .implicit_value(true)
+        .help("Treat runs of delimiters as one.");
+    parser.add_argument("-H", "--header")
+        .default_value(false)
+        .implicit_value(true)
+        .help("The first line of each file names the columns.");
+    parser.add_argument("-c", "--columns")
+        .nargs(1)
+        .default_value(std::string(""))
+        .help("Comma separated column names, for files without a header.");
+    parser.add_argument("--comment")
+        .nargs(1)
+        .default_value(std::string("#"))
+        .help("Prefix of comment lines.");
+    parser.add_argument("-b", "--block-rows")
+        .nargs(1)
+        .default_value(std::string("4096"))
+        .help("Rows per archive block.");
+    parser.add_argument("--force")
+        .default_value(false)
+        .implicit_value(true)
+        .help("Rewrite archives that are newer than their data file.");
+    parser.add_argument("--verify")
+        .default_value(false)
+        .implicit_value(true)
+        .help("Check the archives against the CSV and compare scan speed.");
+
+    try
+    {
+        parser.parse_args(argc, argv);
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        CsvTimeFormat time_format
+            = parseTimeFormat(parser.get<std::string>("--time-format"));
+        std::string output = parser.get<std::string>("--output");
+        std::size_t block_rows
+            = std::stoul(parser.get<std::string>("--block-rows"));
+
+        CsvGroupMetadata metadata(
+            parser.get<std::string>("--path"),
+            parser.get<std::string>("--template"),
+            {},
+            "",
+            parser.get<std::string>("--comment"),
+            parser.get<std::string>("--delimiter"),
+            parser.get<bool>("--multi-delimiter"),
+            parser.get<bool>("--header"),
+            splitColumns(parser.get<std::string>("--columns")));
+        CsvGroup group(metadata);
+        CsvTimeCursor cursor(group.snapshot(), time_format);
+
+        std::vector<ArchivedFile> files
+            = planArchives(cursor.group(), output);
+        long written = 0;
+        for (const auto& file : files)
+        {
+            // A data file still being written is newer than its archive and
+            // is converted again on the next run
+            std::error_code error;
+            auto archive_time
+                = std::filesystem::last_write_time(file.archivePath, error);
+            if (!error && !parser.get<bool>("--force")
+                && archive_time
+                       >= std::filesystem::last_write_time(file.dataPath))
+            {
+                continue;
+            }
+
+            writeArchive(cursor, file, time_format, block_rows);
+            ++written;
+            std::cout << file.dataPath << " -> " << file.archivePath << " ("
+                      << file.last - file.first << " rows)" << std::endl;
+        }
+        std::cout << "Archived " << written << " of " << files.size()
+                  << " files" << std::endl;
+
+        if (parser.get<bool>("--verify") && !files.empty()
+            && !verifyArchives(cursor, files, time_format))
+        {
+            return 1;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,242 @@
+/*
+ * tkclient.cpp
+ * Command line client for the tkd query daemon, with a load test for checking
+ * a daemon locally.
+ *
+ * This file is part of the TimeKeeping project.
+ *
+ */
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CsvFileUtils/TimeParse.hpp"
+#include "Tkd/TkdClient.hpp"
+
+#include "TimekeepingConfig.h"
+#include <argparse/argparse.hpp>
+
+/* Prints a series as CSV.
+ */
+void printSeries(const TkdSeries& series)
+{
+    std::cout << "Time,Value" << std::endl;
+    for (size_t i = 0; i < series.times.size(); ++i)
+    {
+        std::cout << boost::posix_time::to_iso_extended_string(series.times[i])
+                  << "," << series.values[i] << "\n";
+    }
+}
+
+/* Parses a time argument in ISO extended format.
+ */
+date_time timeArgument(const std::string& text)
+{
+    return parseTime(TimeFormat::isoExtended, text);
+}
+
+/* Sends batches of lookups at random times from several connections at once
+ * and reports the throughput and request latency.
+ */
+void loadTest(
+    const std::string& socket_path,
+    const std::string& group,
+    const std::string& column,
+    long requests,
+    long batch,
+    int connections)
+{
+    TkdClient client(socket_path);
+    auto [group_index, column_index] = client.resolve(group, column);
+    TkdGroupInfo info = client.list()[group_index];
+    long span = (info.end - info.start).total_microseconds();
+
+    std::vector<std::vector<double>> latencies(connections);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int c = 0; c < connections; ++c)
+    {
+        threads.emplace_back(
+            [&, c]()
+            {
+                TkdClient connection(socket_path);
+                std::mt19937_64 random(c);
+                std::uniform_int_distribution<long> offset(0, span);
+                std::vector<date_time> times(batch);
+                for (long r = c; r < requests; r += connections)
+                {
+                    for (auto& time : times)
+                    {
+                        time = info.start
+                             + boost::posix_time::microseconds(offset(random));
+                    }
+                    auto sent = std::chrono::steady_clock::now();
+                    connection.valueAt(group_index, column_index, times);
+                    std::chrono::duration<double, std::micro> latency
+                        = std::chrono::steady_clock::now() - sent;
+                    latencies[c].push_back(latency.count());
+                }
+            });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    std::chrono::duration<double> elapsed
+        = std::chrono::steady_clock::now() - start;
+
+    std::vector<double> all;
+    for (const auto& latency : latencies)
+    {
+        all.insert(all.end(), latency.begin(), latency.end());
+    }
+    std::sort(all.begin(), all.end());
+    std::cout << std::fixed << std::setprecision(1) << requests
+              << " requests of " << batch << " lookups over " << connections
+              << " connections: "
+              << requests / elapsed.count() << " requests/s, "
+              << requests * batch / elapsed.count() << " lookups/s, "
+              << all[all.size() / 2] << " us p50, "
+              << all[size_t(0.99 * (all.size() - 1))] << " us p99" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    argparse::ArgumentParser parser(
+        "tkclient",
+        std::format(
+            "v{}.{}", Timekeeping_VERSION_MAJOR, Timekeeping_VERSION_MINOR),
+        argparse::default_arguments::all,
+        true);
+    parser.add_description(
+        "tkclient - Query a tkd daemon. Commands:\n"
+        "  list\n"
+        "  value GROUP COLUMN TIME...\n"
+        "  range GROUP COLUMN START END [MAX_ROWS]\n"
+        "  decimate GROUP COLUMN START END POINTS\n"
+        "  bench GROUP COLUMN REQUESTS BATCH CONNECTIONS\n"
+        "Times are ISO extended, e.g. 2025-07-11T00:00:00.5");
+    parser.add_argument("-s", "--socket")
+        .nargs(1)
+        .default_value("/tmp/tkd.sock")
+        .help("Path of the daemon's socket.");
+    parser.add_argument("command").help("The query to run.");
+    parser.add_argument("arguments")
+        .remaining()
+        .help("Arguments of the query.");
+
+    try
+    {
+        parser.parse_args(argc, argv);
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::string socket_path = parser.get<std::string>("--socket");
+    std::string command = parser.get<std::string>("command");
+    std::vector<std::string> args
+        = parser.present<std::vector<std::string>>("arguments")
+              .value_or(std::vector<std::string>());
+
+    auto require = [&](size_t count)
+    {
+        if (args.size() < count)
+        {
+            throw std::invalid_argument(
+                "Too few arguments for " + command + ", see --help");
+        }
+    };
+
+    try
+    {
+        TkdClient client(socket_path);
+        std::cout.precision(std::numeric_limits<double>::max_digits10);
+
+        if (command == "list")
+        {
+            for (const auto& group : client.list())
+            {
+                std::cout
+                    << group.name << ": " << group.rows << " rows from "
+                    << boost::posix_time::to_iso_extended_string(group.start)
+                    << " to "
+                    << boost::posix_time::to_iso_extended_string(group.end)
+                    << std::endl;
+                for (size_t c = 0; c < group.columns.size(); ++c)
+                {
+                    std::cout << "  " << c << " " << group.columns[c]
+                              << std::endl;
+                }
+            }
+        }
+        else if (command == "value")
+        {
+            require(3);
+            auto [group, column] = client.resolve(args[0], args[1]);
+            std::vector<date_time> times;
+            for (size_t i = 2; i < args.size(); ++i)
+            {
+                times.push_back(timeArgument(args[i]));
+            }
+            printSeries({times, client.valueAt(group, column, times)});
+        }
+        else if (command == "range")
+        {
+            require(4);
+            auto [group, column] = client.resolve(args[0], args[1]);
+            std::uint32_t max_rows = args.size() > 4 ? std::stoul(args[4]) : 0;
+            printSeries(client.range(
+                group,
+                column,
+                timeArgument(args[2]),
+                timeArgument(args[3]),
+                max_rows));
+        }
+        else if (command == "decimate")
+        {
+            require(5);
+            auto [group, column] = client.resolve(args[0], args[1]);
+            printSeries(client.decimate(
+                group,
+                column,
+                timeArgument(args[2]),
+                timeArgument(args[3]),
+                std::stoul(args[4])));
+        }
+        else if (command == "bench")
+        {
+            require(5);
+            loadTest(
+                socket_path,
+                args[0],
+                args[1],
+                std::max(1L, std::stol(args[2])),
+                std::max(1L, std::stol(args[3])),
+                std::max(1, std::stoi(args[4])));
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown command " + command);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
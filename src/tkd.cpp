@@ -0,0 +1,281 @@
+/*
+ * tkd.cpp
+ * Query daemon that keeps time groups open and answers value, range and
+ * decimated series queries over a Unix socket.
+ *
+ * This file is part of the TimeKeeping project.
+ *
+ */
+
+#include <boost/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CsvFileUtils/CsvGroupMetadata.hpp"
+#include "Tkd/TkdServer.hpp"
+
+#include "TimekeepingConfig.h"
+#include <argparse/argparse.hpp>
+
+/* The server stopped by SIGINT and SIGTERM.
+ */
+TkdServer* running_server = nullptr;
+
+void handleStopSignal(int)
+{
+    if (running_server)
+    {
+        running_server->stop();
+    }
+}
+
+/* Reads a JSON object from a file.
+ */
+boost::json::object readJsonObject(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        throw std::runtime_error("Could not open " + path);
+    }
+    boost::json::value value;
+    file >> value;
+    return value.as_object();
+}
+
+/* Gets a string setting, or a default if it is missing.
+ */
+std::string stringOr(
+    const boost::json::object& config,
+    const std::string& key,
+    const std::string& fallback)
+{
+    return config.contains(key) ? config.at(key).as_string().c_str() : fallback;
+}
+
+/* Gets a boolean setting, or a default if it is missing.
+ */
+bool boolOr(
+    const boost::json::object& config, const std::string& key, bool fallback)
+{
+    return config.contains(key) ? config.at(key).as_bool() : fallback;
+}
+
+/* Escapes a file name for use as a literal in a group template.
+ */
+std::string escapeRegex(const std::string& text)
+{
+    std::string escaped;
+    for (char c : text)
+    {
+        if (std::string("\\^$.|?*+()[]{}").find(c) != std::string::npos)
+        {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+/* Adds a group described in the "Groups" list of the config.
+ */
+void addConfigGroup(TkdServer& server, const boost::json::object& group)
+{
+    std::vector<std::string> columns;
+    if (group.contains("Columns"))
+    {
+        for (const auto& column : group.at("Columns").as_array())
+        {
+            columns.push_back(column.as_string().c_str());
+        }
+    }
+
+    std::string format = stringOr(group, "Time_Format", "oneColStandard");
+    CsvTimeFormat time_format;
+    if (format == "oneColStandard")
+    {
+        time_format = CsvTimeFormat::oneColStandard;
+    }
+    else if (format == "twoColShort")
+    {
+        time_format = CsvTimeFormat::twoColShort;
+    }
+    else
+    {
+        throw std::runtime_error("Unknown Time_Format " + format);
+    }
+
+    CsvGroupMetadata metadata(
+        group.at("Path").as_string().c_str(),
+        group.at("Template").as_string().c_str(),
+        {},
+        "",
+        stringOr(group, "Comment", "#"),
+        stringOr(group, "Delimiter", ","),
+        boolOr(group, "Multi_Delimiter", false),
+        boolOr(group, "Header", false),
+        columns);
+    server.addGroup(
+        group.at("Name").as_string().c_str(), metadata, time_format);
+}
+
+/* Adds the groups of an SrTime run: its Si3 and Maser inputs and the time
+ * scale it writes, with the same layouts SrTime reads them with.
+ */
+void addSrTimeGroups(TkdServer& server, const boost::json::object& config)
+{
+    server.addGroup(
+        "si3",
+        CsvGroupMetadata(
+            config.at("Si3_Data_Path").as_string().c_str(),
+            config.at("Si3_Data_Template").as_string().c_str(),
+            {},
+            "",
+            "#",
+            ",\r",
+            false,
+            true,
+            {"Time", "Si_Freq"}),
+        CsvTimeFormat::oneColStandard);
+
+    server.addGroup(
+        "maser",
+        CsvGroupMetadata(
+            config.at("Si3_Maser_Data_Path").as_string().c_str(),
+            config.at("Si3_Maser_Data_Template").as_string().c_str(),
+            {},
+            "",
+            "#",
+            " ",
+            true,
+            false,
+            {"Day",
+             "Time",
+             "S",
+             "Si_Phase",
+             "Rb_Phase",
+             "H_Phase",
+             "Z_Phase",
+             "Si_Freq",
+             "Rb_Freq",
+             "H_Freq",
+             "Z_Freq"}),
+        CsvTimeFormat::twoColShort);
+
+    // The output has a header row and ISO times, which the one column parser
+    // accepts
+    std::filesystem::path output = config.at("Output_File").as_string().c_str();
+    server.addGroup(
+        "deviation",
+        CsvGroupMetadata(
+            output.parent_path().empty() ? "." : output.parent_path().string(),
+            escapeRegex(output.filename().string()),
+            {},
+            "",
+            "#",
+            ",",
+            false,
+            true,
+            {}),
+        CsvTimeFormat::oneColStandard);
+}
+
+int main(int argc, char* argv[])
+{
+    argparse::ArgumentParser parser(
+        "tkd",
+        std::format(
+            "v{}.{}", Timekeeping_VERSION_MAJOR, Timekeeping_VERSION_MINOR),
+        argparse::default_arguments::all,
+        true);
+    parser.add_description(
+        "tkd - Keep time groups open and answer queries over a Unix socket.");
+    parser.add_argument("-c", "--config")
+        .nargs(1)
+        .default_value("{}")
+        .help(
+            "JSON configuration with Socket, Workers, Refresh_Seconds, Watch, "
+            "Groups and SrTime_Config.");
+    parser.add_argument("-s", "--socket")
+        .nargs(1)
+        .default_value("")
+        .help("Socket path, overriding the configuration.");
+    parser.add_epilog("Example usage: tkd -c \"tkd.json\" ");
+
+    try
+    {
+        parser.parse_args(argc, argv);
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        boost::json::object config
+            = readJsonObject(parser.get<std::string>("--config"));
+
+        std::string socket_path = parser.get<std::string>("--socket");
+        if (socket_path.empty())
+        {
+            socket_path = stringOr(config, "Socket", "/tmp/tkd.sock");
+        }
+        int workers = std::thread::hardware_concurrency();
+        if (config.contains("Workers"))
+        {
+            workers = int(config.at("Workers").as_int64());
+        }
+        long refresh_seconds = config.contains("Refresh_Seconds")
+                                 ? long(config.at("Refresh_Seconds").as_int64())
+                                 : 10;
+        bool watch = boolOr(config, "Watch", false);
+
+        TkdServer server(
+            socket_path,
+            workers,
+            std::chrono::seconds(refresh_seconds),
+            watch);
+
+        std::cout << "Loading groups" << std::endl;
+        if (config.contains("SrTime_Config"))
+        {
+            addSrTimeGroups(
+                server,
+                readJsonObject(config.at("SrTime_Config").as_string().c_str()));
+        }
+        if (config.contains("Groups"))
+        {
+            for (const auto& group : config.at("Groups").as_array())
+            {
+                addConfigGroup(server, group.as_object());
+            }
+        }
+
+        running_server = &server;
+        std::signal(SIGINT, handleStopSignal);
+        std::signal(SIGTERM, handleStopSignal);
+
+        std::cout << "Serving on " << socket_path << " with " << workers
+                  << " workers" << std::endl;
+        server.run();
+        running_server = nullptr;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,237 @@
+/*
+ * tkgen.cpp
+ * Writes synthetic PhaseFreq and Si3 groups in the exact layouts of the
+ * logged files, for benchmarks and scale tests without production data.
+ *
+ * Every file is a function of the options and its place in the group alone,
+ * so files are written in parallel, and a large corpus can be split across
+ * machines with --shard and still come out identical.
+ *
+ * This file is part of the TimeKeeping project.
+ *
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <format>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CsvFileUtils/SyntheticData.hpp"
+
+#include "TimekeepingConfig.h"
+#include <argparse/argparse.hpp>
+
+/* Parses a number of seconds into ticks.
+ */
+time_ticks parseSeconds(const std::string& seconds)
+{
+    return std::llround(std::stod(seconds) * 1e6);
+}
+
+int main(int argc, char* argv[])
+{
+    argparse::ArgumentParser parser(
+        "tkgen",
+        std::format(
+            "v{}.{}", Timekeeping_VERSION_MAJOR, Timekeeping_VERSION_MINOR),
+        argparse::default_arguments::all,
+        true);
+    parser.add_description(
+        "tkgen - Write a synthetic PhaseFreq or Si3 group in the layout of the "
+        "logged files.");
+    parser.add_argument("-o", "--output")
+        .nargs(1)
+        .required()
+        .help("Directory to write the files to.");
+    parser.add_argument("-l", "--layout")
+        .nargs(1)
+        .default_value(std::string("PhaseFreq"))
+        .help("Layout of the files, PhaseFreq or Si3.");
+    parser.add_argument("-p", "--prefix")
+        .nargs(1)
+        .default_value(std::string(""))
+        .help("Start of the file names, defaults to the layout name.");
+    parser.add_argument("-s", "--start")
+        .nargs(1)
+        .default_value(std::string("2025-07-11T00:00:00"))
+        .help("Time of the first row.");
+    parser.add_argument("-d", "--duration")
+        .nargs(1)
+        .default_value(std::string("86400"))
+        .help("Seconds of rows to write.");
+    parser.add_argument("-r", "--rate")
+        .nargs(1)
+        .default_value(std::string(""))
+        .help("Rows per second, defaults to 10 for PhaseFreq and 2 for Si3.");
+    parser.add_argument("-f", "--files")
+        .nargs(1)
+        .default_value(std::string("1"))
+        .help("Number of files to split the rows across.");
+    parser.add_argument("--jitter")
+        .nargs(1)
+        .default_value(std::string("0"))
+        .help("Largest shift of a row from its due time, in seconds.");
+    parser.add_argument("--gap-every")
+        .nargs(1)
+        .default_value(std::string("0"))
+        .help("Seconds between gaps in the rows, 0 for none.");
+    parser.add_argument("--gap-length")
+        .nargs(1)
+        .default_value(std::string("0"))
+        .help("Seconds of rows left out by each gap.");
+    parser.add_argument("-c", "--comment-every")
+        .nargs(1)
+        .default_value(std::string("0"))
+        .help("Rows between comment lines, 0 for none.");
+    parser.add_argument("--seed")
+        .nargs(1)
+        .default_value(std::string("1"))
+        .help("Seed of the values, gaps and jitter.");
+    parser.add_argument("-j", "--jobs")
+        .nargs(1)
+        .default_value(
+            std::to_string(std::max(1u, std::thread::hardware_concurrency())))
+        .help("Number of files written at once.");
+    parser.add_argument("--shard")
+        .nargs(1)
+        .default_value(std::string("0/1"))
+        .help("Write only shard k of n, as k/n, taking every nth file.");
+
+    try
+    {
+        parser.parse_args(argc, argv);
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        SyntheticGroup group;
+        std::string layout = parser.get<std::string>("--layout");
+        if (layout == "PhaseFreq")
+        {
+            group.layout = SyntheticLayout::phaseFreq;
+        }
+        else if (layout == "Si3")
+        {
+            group.layout = SyntheticLayout::si3;
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown layout " + layout);
+        }
+
+        std::string rate = parser.get<std::string>("--rate");
+        if (rate.empty())
+        {
+            rate = group.layout == SyntheticLayout::si3 ? "2" : "10";
+        }
+        std::string prefix = parser.get<std::string>("--prefix");
+
+        group.directory = parser.get<std::string>("--output");
+        group.prefix = prefix.empty() ? layout : prefix;
+        group.start = toTicks(parseTime(
+            TimeFormat::isoExtended, parser.get<std::string>("--start")));
+        group.duration = parseSeconds(parser.get<std::string>("--duration"));
+        group.interval = std::llround(1e6 / std::stod(rate));
+        group.files = std::stol(parser.get<std::string>("--files"));
+        group.jitter = parseSeconds(parser.get<std::string>("--jitter"));
+        group.gapEvery = parseSeconds(parser.get<std::string>("--gap-every"));
+        group.gapLength
+            = parseSeconds(parser.get<std::string>("--gap-length"));
+        group.commentEvery
+            = std::stol(parser.get<std::string>("--comment-every"));
+        group.seed = std::stoull(parser.get<std::string>("--seed"));
+
+        std::string shard = parser.get<std::string>("--shard");
+        std::size_t slash = shard.find('/');
+        if (slash == std::string::npos)
+        {
+            throw std::invalid_argument("Shard must be given as k/n");
+        }
+        long shard_index = std::stol(shard.substr(0, slash));
+        long shard_count = std::stol(shard.substr(slash + 1));
+        if (shard_count < 1 || shard_index < 0 || shard_index >= shard_count)
+        {
+            throw std::invalid_argument("Shard " + shard + " is out of range");
+        }
+        int jobs = std::max(1, std::stoi(parser.get<std::string>("--jobs")));
+
+        std::vector<SyntheticFile> files;
+        std::vector<SyntheticFile> all_files = planSyntheticFiles(group);
+        for (std::size_t k = shard_index; k < all_files.size();
+             k += shard_count)
+        {
+            files.push_back(all_files[k]);
+        }
+        std::filesystem::create_directories(group.directory);
+
+        std::cout << "Writing " << files.size() << " of " << all_files.size()
+                  << " " << layout << " files to " << group.directory
+                  << " with " << jobs << " jobs" << std::endl;
+
+        // Each job takes the next file until none are left
+        std::atomic<std::size_t> next = 0;
+        std::atomic<std::uintmax_t> bytes = 0;
+        std::mutex error_mutex;
+        std::exception_ptr error;
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (std::size_t j = 0; j < std::min<std::size_t>(jobs, files.size());
+             ++j)
+        {
+            threads.emplace_back(
+                [&]()
+                {
+                    for (std::size_t k = next++; k < files.size(); k = next++)
+                    {
+                        try
+                        {
+                            bytes += writeSyntheticFile(group, files[k]);
+                        }
+                        catch (...)
+                        {
+                            std::lock_guard<std::mutex> lock(error_mutex);
+                            error = std::current_exception();
+                            next = files.size();
+                        }
+                    }
+                });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+        std::chrono::duration<double> elapsed
+            = std::chrono::steady_clock::now() - start;
+
+        std::cout << std::fixed << std::setprecision(1) << "Wrote "
+                  << bytes / 1e6 << " MB in " << elapsed.count() << " s, "
+                  << bytes / 1e6 / std::max(elapsed.count(), 1e-9) << " MB/s"
+                  << std::endl;
+        std::cout << "Read back with template "
+                  << syntheticMetadata(group).dataTemplate() << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,253 @@
+/*
+ * AllocationTest.cpp
+ * Counts heap allocations in the steady state of the lookups made once per
+ * output row: CsvTimeGroup::colAtTime, CsvTimeCursor::colAtTime and the
+ * typed getRow, on groups laid out like the Si3 and PhaseFreq files. Once
+ * warm, none of them may allocate.
+ *
+ * This file is part of the TimeKeeping project.
+ *
+ */
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+
+#include <unistd.h>
+
+#include "CsvFileUtils/CsvTimeGroup.hpp"
+#include "CsvFileUtils/RowSchema.hpp"
+
+/* Number of heap allocations made by the program.
+ */
+std::atomic<long> allocations = 0;
+
+void* operator new(std::size_t size)
+{
+    ++allocations;
+    if (void* pointer = std::malloc(size > 0 ? size : 1))
+    {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+/* Row struct decoded by the typed reads.
+ */
+struct FreqRow
+{
+    quad Si_Freq;
+};
+
+using FreqSchema = RowSchema<FreqRow, Column<"Si_Freq", &FreqRow::Si_Freq>>;
+
+/* Writes a number zero padded to width digits.
+ */
+std::string padded(long value, int width)
+{
+    std::string text = std::to_string(value);
+    return std::string(std::max(0, width - int(text.size())), '0') + text;
+}
+
+/* Calls made in each measured run.
+ */
+constexpr long calls = 10000;
+
+/* Number of failed checks.
+ */
+int failures = 0;
+
+/* Runs a lookup once to warm it up, then again counting its allocations,
+ * which must be none.
+ */
+template <typename Lookup>
+void checkNoAllocations(const std::string& name, Lookup lookup)
+{
+    lookup();
+    long before = allocations;
+    lookup();
+    long made = allocations - before;
+    if (made != 0)
+    {
+        std::cerr << "FAILED: " << name << " made " << made
+                  << " allocations in " << calls << " calls" << std::endl;
+        ++failures;
+    }
+}
+
+/* Writes an hour of rows a second apart from midnight into three files, with
+ * a 20 s gap every 10 minutes: Si3 files with one time column, a header and
+ * CRLF line ends, or PhaseFreq files with a day and a time column and the long
+ * fields of the real ones.
+ */
+void writeFiles(const std::filesystem::path& directory, bool si3)
+{
+    std::filesystem::create_directories(directory);
+    for (int f = 0; f < 3; ++f)
+    {
+        std::ofstream out(directory
+                              / (si3 ? "Si3_" + padded(f + 1, 2) + ".csv"
+                                     : "PhaseFreq_250711_"
+                                           + std::to_string(f + 1) + ".txt"),
+                          std::ios::binary);
+        if (si3)
+        {
+            out << "Time,Si_Freq\r\n";
+        }
+        for (long second = f * 1200; second < (f + 1) * 1200; ++second)
+        {
+            if (second % 600 >= 580)
+            {
+                continue;
+            }
+            std::string clock = padded(second / 3600, 2) + ":"
+                              + padded(second / 60 % 60, 2) + ":"
+                              + padded(second % 60, 2) + ".000000";
+            std::string frequency
+                = "995532.689745" + padded(second * 7919 % 1000, 3);
+            if (si3)
+            {
+                out << "2025-07-11 " << clock << "," << frequency << "\r\n";
+            }
+            else
+            {
+                clock.erase(5, 1).erase(2, 1);
+                out << "250711 " << clock << " " << second << "  "
+                    << second * 995532 << "."
+                    << padded(second * 104729 % 1000000, 6) << " " << frequency
+                    << "\n";
+            }
+        }
+    }
+}
+
+/* Checks the lookups on a group of one layout.
+ */
+void checkLayout(const std::filesystem::path& directory, bool si3)
+{
+    writeFiles(directory, si3);
+    const std::string name = si3 ? "Si3" : "PhaseFreq";
+    CsvGroupMetadata metadata
+        = si3 ? CsvGroupMetadata(directory.string(),
+                                 "Si3_[0-9]{2}\\.csv",
+                                 {},
+                                 "",
+                                 "#",
+                                 ",\r",
+                                 false,
+                                 true,
+                                 {"Time", "Si_Freq"})
+              : CsvGroupMetadata(directory.string(),
+                                 "PhaseFreq_[0-9]{6}_[0-9]+\\.txt",
+                                 {},
+                                 "",
+                                 "#",
+                                 " ",
+                                 true,
+                                 false,
+                                 {"Day", "Time", "S", "Si_Phase", "Si_Freq"});
+
+    CsvTimeGroup time_group(metadata,
+                            si3 ? CsvTimeFormat::oneColStandard
+                                : CsvTimeFormat::twoColShort);
+    CsvTimeCursor cursor = time_group.snapshot().cursor();
+    CsvGroupSnapshot snapshot = time_group.snapshot().group();
+    date_time start = cursor.startTime();
+    long span = (cursor.endTime() - start).total_microseconds();
+    const std::string column = "Si_Freq";
+    quad sum = 0;
+
+    // Times spread over the group, and times before and after it
+    for (long offset : {0L, -span - 1, span + 1})
+    {
+        std::string where = offset == 0 ? " inside"
+                          : offset < 0  ? " before"
+                                        : " after";
+        auto times = [&](auto lookup)
+        {
+            return [&, lookup]()
+            {
+                for (long i = 0; i < calls; ++i)
+                {
+                    sum += lookup(start
+                                  + boost::posix_time::microseconds(
+                                      offset + (i * 7919L * 1000) % span));
+                }
+            };
+        };
+        checkNoAllocations(
+            name + " CsvTimeGroup::colAtTime" + where,
+            times([&](date_time time)
+                  { return time_group.colAtTime(time, column); }));
+        checkNoAllocations(
+            name + " CsvTimeCursor::colAtTime" + where,
+            times([&](date_time time)
+                  { return cursor.colAtTime(time, column); }));
+    }
+
+    RowDecoder<FreqSchema> decoder(snapshot.metadata());
+    checkNoAllocations(name + " typed getRow",
+                       [&]()
+                       {
+                           for (long i = 0; i < calls; ++i)
+                           {
+                               sum += snapshot
+                                          .getRow((i * 7919) % snapshot.size(),
+                                                  decoder)
+                                          .Si_Freq;
+                           }
+                       });
+}
+
+int main()
+{
+    std::filesystem::path directory
+        = std::filesystem::temp_directory_path()
+        / ("AllocationTest_" + std::to_string(::getpid()));
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    checkLayout(directory / "Si3", true);
+    checkLayout(directory / "PhaseFreq", false);
+    std::filesystem::remove_all(directory);
+
+    if (failures > 0)
+    {
+        std::cerr << failures << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "No allocations in steady state lookups" << std::endl;
+    return 0;
+}
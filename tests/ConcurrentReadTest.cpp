@@ -0,0 +1,247 @@
+/*
+ * ConcurrentReadTest.cpp
+ * Reads one CsvFile, CsvGroup and CsvGroupSnapshot from many threads at once
+ * with every read path, checking each result against a serial read. Build with
+ * ENABLE_TSAN to also have ThreadSanitizer check the reads for data races.
+ *
+ * This file is part of the TimeKeeping project.
+ *
+ */
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "CsvFileUtils/CsvFile.hpp"
+#include "CsvFileUtils/CsvGroup.hpp"
+#include "CsvFileUtils/RowSchema.hpp"
+
+/* Row struct decoded by the typed reads.
+ */
+struct PhaseRow
+{
+    std::string Time;
+    long S;
+    double H_Phase;
+};
+
+using PhaseSchema = RowSchema<PhaseRow,
+                              Column<"Day">,
+                              Column<"Time", &PhaseRow::Time>,
+                              Column<"S", &PhaseRow::S>,
+                              Column<"Si_Phase">,
+                              Column<"Rb_Phase">,
+                              Column<"H_Phase", &PhaseRow::H_Phase>>;
+
+/* Number of reading threads.
+ */
+constexpr int threadCount = 8;
+
+/* Reads made by each thread.
+ */
+constexpr long readsPerThread = 20000;
+
+/* Decodes a row into the row struct, with the typed getRow where the source
+ * has one.
+ */
+template <typename Source>
+PhaseRow readTyped(const Source& source,
+                   long row,
+                   RowDecoder<PhaseSchema>& decoder)
+{
+    if constexpr (requires { source.getRow(row, decoder); })
+    {
+        return source.getRow(row, decoder);
+    }
+    else
+    {
+        return decoder(source.getRawLine(row));
+    }
+}
+
+/* Reads the rows of a file, group or snapshot from many threads, counting
+ * the reads that differ from the serial read of the same row.
+ */
+template <typename Source>
+long countMismatches(const Source& source,
+                     const std::vector<std::string>& colNames)
+{
+    long rows = source.metadata().size();
+    Projection projection(colNames, {"H_Phase", "Time"});
+    std::vector<std::string> lines(rows);
+    std::vector<std::string> fields(rows);
+    std::vector<PhaseRow> typed_rows(rows);
+    std::vector<std::string_view> values;
+    RowDecoder<PhaseSchema> decoder(source.metadata());
+    for (long row = 0; row < rows; ++row)
+    {
+        lines[row] = source.getRawLine(row);
+        typed_rows[row] = decoder(lines[row]);
+        source.getFields(row, projection, values);
+        fields[row] = std::string(values[0]) + "|" + std::string(values[1]);
+    }
+
+    std::atomic<long> mismatches = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t)
+    {
+        threads.emplace_back(
+            [&, t]()
+            {
+                std::mt19937_64 random(t);
+                std::vector<std::string_view> values;
+                RowDecoder<PhaseSchema> decoder(source.metadata());
+                for (long k = 0; k < readsPerThread; ++k)
+                {
+                    long row = random() % rows;
+                    if (source.getRawLine(row) != lines[row])
+                    {
+                        ++mismatches;
+                    }
+
+                    source.getFields(row, projection, values);
+                    if (std::string(values[0]) + "|" + std::string(values[1])
+                        != fields[row])
+                    {
+                        ++mismatches;
+                    }
+
+                    PhaseRow typed = readTyped(source, row, decoder);
+                    if (typed.Time != typed_rows[row].Time
+                        || typed.S != typed_rows[row].S
+                        || typed.H_Phase != typed_rows[row].H_Phase)
+                    {
+                        ++mismatches;
+                    }
+
+                    if (k % 100 == 0)
+                    {
+                        long batch[] = {row, (row * 7919) % rows, 0, row};
+                        std::vector<std::string> read = source.readRows(batch);
+                        for (std::size_t i = 0; i < std::size(batch); ++i)
+                        {
+                            if (read[i] != lines[batch[i]])
+                            {
+                                ++mismatches;
+                            }
+                        }
+                    }
+                }
+            });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    return mismatches;
+}
+
+/* Columns of the test files.
+ */
+const std::vector<std::string> colNames
+    = {"Day", "Time", "S", "Si_Phase", "Rb_Phase", "H_Phase"};
+
+/* Writes a group of space delimited phase files, one a minute apart, with a
+ * comment line every 97 rows.
+ */
+std::vector<std::string> writeFiles(const std::filesystem::path& directory)
+{
+    std::vector<std::string> paths;
+    long row = 0;
+    for (int f = 0; f < 4; ++f)
+    {
+        paths.push_back(
+            (directory / ("Phase_250711_" + std::to_string(f + 1) + ".txt"))
+                .string());
+        std::ofstream out(paths.back());
+        for (int i = 0; i < 1500; ++i, ++row)
+        {
+            if (row % 97 == 0)
+            {
+                out << "# Row " << row << "\n";
+            }
+            out << "250711  " << 10 + f << std::setfill('0') << std::setw(2)
+                << i / 25 << std::setw(2) << i % 25 * 2 << "." << std::setw(6)
+                << row * 7 % 1000000 << std::setfill(' ') << " " << row
+                << "  " << row * 0.001 << "  " << -row * 0.25 << "  "
+                << 995532.689745958 + row << "\n";
+        }
+    }
+    return paths;
+}
+
+int main()
+{
+    std::filesystem::path directory
+        = std::filesystem::temp_directory_path()
+        / ("ConcurrentReadTest_" + std::to_string(::getpid()));
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    std::vector<std::string> paths = writeFiles(directory);
+
+    int failures = 0;
+    {
+        CsvFile file(CsvFileMetadata(paths[0],
+                                     (directory / "file.bin").string(),
+                                     (directory / "file.json").string(),
+                                     "#",
+                                     " ",
+                                     true,
+                                     false,
+                                     colNames));
+        long mismatches = countMismatches(file, colNames);
+        if (mismatches > 0)
+        {
+            std::cerr << "FAILED: " << mismatches
+                      << " concurrent CsvFile reads differ from serial reads"
+                      << std::endl;
+            ++failures;
+        }
+
+        CsvGroup group(CsvGroupMetadata(directory.string(),
+                                        "Phase_[0-9]{6}_[0-9]+\\.txt",
+                                        {},
+                                        "",
+                                        "#",
+                                        " ",
+                                        true,
+                                        false,
+                                        colNames));
+        mismatches = countMismatches(group, colNames);
+        if (mismatches > 0)
+        {
+            std::cerr << "FAILED: " << mismatches
+                      << " concurrent CsvGroup reads differ from serial reads"
+                      << std::endl;
+            ++failures;
+        }
+
+        CsvGroupSnapshot snapshot = group.snapshot();
+        mismatches = countMismatches(snapshot, colNames);
+        if (mismatches > 0)
+        {
+            std::cerr << "FAILED: " << mismatches
+                      << " concurrent CsvGroupSnapshot reads differ from "
+                         "serial reads"
+                      << std::endl;
+            ++failures;
+        }
+    }
+    std::filesystem::remove_all(directory);
+
+    if (failures > 0)
+    {
+        return 1;
+    }
+    std::cout << "All concurrent reads matched" << std::endl;
+    return 0;
+}
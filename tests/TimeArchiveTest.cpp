@@ -0,0 +1,176 @@
+/*
+ * TimeArchiveTest.cpp
+ * Writes rows into a TimeArchive and reads them back: every field must come
+ * back as the same text, every value as the quad its text parses to, and the
+ * block statistics must bound the values. Also checks that an unfinished
+ * archive leaves no file behind.
+ *
+ * This file is part of the TimeKeeping project.
+ *
+ */
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+#include "CsvFileUtils/TimeArchive.hpp"
+#include "Utils/FieldParse.hpp"
+
+/* Number of failed checks.
+ */
+int failures = 0;
+
+/* Records a failed check.
+ */
+void check(bool condition, const std::string& message)
+{
+    if (!condition)
+    {
+        std::cerr << "FAILED: " << message << std::endl;
+        ++failures;
+    }
+}
+
+/* Writes a number zero padded to width digits.
+ */
+std::string padded(long value, int width)
+{
+    std::string text = std::to_string(value);
+    return std::string(std::max(0, width - int(text.size())), '0') + text;
+}
+
+/* Columns of the test rows.
+ */
+const std::vector<std::string> colNames
+    = {"Day", "Time", "S", "Si_Freq", "Wide", "Padded", "Note"};
+
+/* Number of test rows.
+ */
+constexpr long rowCount = 10000;
+
+/* Makes the fields of a row: a counter, a noisy frequency, a decimal with
+ * more digits than a quad holds exactly, zero padded negatives and a column
+ * of text.
+ */
+std::vector<std::string> makeRow(long row)
+{
+    long second = row * 3;
+    long noise = (row * 7919) % 1000;
+    return {"250711",
+            padded(second / 3600, 2) + padded(second / 60 % 60, 2)
+                + padded(second % 60, 2) + "." + padded(row * 37 % 1000000, 6),
+            std::to_string(row),
+            "995532.689745" + padded(noise, 3),
+            "123456789012345678901234567" + padded(noise, 3) + "."
+                + padded(row * 104729 % 1000000, 6),
+            "-" + padded(row % 250, 4) + ".50",
+            row % 17 == 0 ? "nan" : "ok" + std::to_string(row % 5)};
+}
+
+/* Gets the time of a row from its time fields.
+ */
+time_ticks timeOf(const std::vector<std::string>& fields)
+{
+    std::string_view texts[] = {fields[0], fields[1]};
+    time_ticks ticks = 0;
+    TimeParser<CsvTimeFormat::twoColShort>::parse(texts, ticks);
+    return ticks;
+}
+
+/* Writes the test rows into an archive.
+ */
+void writeArchive(const std::string& path, bool close)
+{
+    TimeArchiveWriter writer(
+        path, colNames, CsvTimeFormat::twoColShort, " ", true, 1000);
+    for (long row = 0; row < rowCount; ++row)
+    {
+        std::vector<std::string> fields = makeRow(row);
+        std::vector<std::string_view> views(fields.begin(), fields.end());
+        writer.append(timeOf(fields), views);
+    }
+    if (close)
+    {
+        writer.close();
+    }
+}
+
+int main()
+{
+    std::filesystem::path directory
+        = std::filesystem::temp_directory_path()
+        / ("TimeArchiveTest_" + std::to_string(::getpid()));
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    std::string path = (directory / "Phase_250711.txt.tka").string();
+
+    writeArchive(path, false);
+    check(std::filesystem::is_empty(directory),
+          "an archive left unfinished left a file behind");
+
+    writeArchive(path, true);
+    check(std::distance(std::filesystem::directory_iterator(directory),
+                        std::filesystem::directory_iterator())
+              == 1,
+          "a finished archive left a temporary file behind");
+
+    TimeArchive archive({path});
+    check(archive.size() == rowCount, "archive has the wrong number of rows");
+    check(archive.blocks().size() == rowCount / 1000,
+          "archive has the wrong number of blocks");
+
+    // Every field comes back as the text it was written as
+    for (long row = 0; row < archive.size(); ++row)
+    {
+        std::vector<std::string> fields = makeRow(row);
+        std::map<std::string, std::string> read = archive[row];
+        for (std::size_t column = 0; column < colNames.size(); ++column)
+        {
+            check(read[colNames[column]] == fields[column],
+                  "row " + std::to_string(row) + " column " + colNames[column]
+                      + " reads back as '" + read[colNames[column]]
+                      + "' rather than '" + fields[column] + "'");
+        }
+        check(toTicks(archive.timeOfRow(row)) == timeOf(fields),
+              "row " + std::to_string(row) + " has the wrong time");
+    }
+
+    // Values are the quads their text parses to, and lie within the
+    // statistics of their block
+    for (std::size_t column = 2; column < colNames.size() - 1; ++column)
+    {
+        std::vector<date_time> times;
+        std::vector<quad> values;
+        archive.readRange(0, archive.size(), colNames[column], times, values);
+        for (long row = 0; row < archive.size(); ++row)
+        {
+            quad expected;
+            parseField(std::string_view(makeRow(row)[column]), expected);
+            check(values[row] == expected,
+                  "row " + std::to_string(row) + " column " + colNames[column]
+                      + " has a value other than its text");
+
+            const ArchiveBlock& block = archive.blocks()[row / 1000];
+            check(quad(block.min[column]) <= values[row]
+                      && values[row] <= quad(block.max[column]),
+                  "row " + std::to_string(row) + " column " + colNames[column]
+                      + " lies outside the statistics of its block");
+        }
+    }
+    std::filesystem::remove_all(directory);
+
+    if (failures > 0)
+    {
+        std::cerr << failures << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All archive checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,200 @@
+/*
+ * TimeJoinTest.cpp
+ * Joins a left group whose times step backwards, repeat, land on right rows
+ * and run past both ends of a right group with a gap, and checks every
+ * joined row against a per-row CsvTimeCursor lookup of the same time:
+ * colAtTime for linear alignment and the closest row for nearest.
+ *
+ * This file is part of the TimeKeeping project.
+ *
+ */
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+#include "CsvFileUtils/CsvGroup.hpp"
+#include "CsvFileUtils/CsvTimeSnapshot.hpp"
+#include "CsvFileUtils/RowSchema.hpp"
+#include "CsvFileUtils/TimeJoin.hpp"
+#include "Utils/FieldParse.hpp"
+
+/* Number of failed checks.
+ */
+int failures = 0;
+
+/* Records a failed check.
+ */
+void check(bool condition, const std::string& message)
+{
+    if (!condition)
+    {
+        std::cerr << "FAILED: " << message << std::endl;
+        ++failures;
+    }
+}
+
+/* Writes a number zero padded to width digits.
+ */
+std::string padded(long value, int width)
+{
+    std::string text = std::to_string(value);
+    return std::string(std::max(0, width - int(text.size())), '0') + text;
+}
+
+/* Row struct of the left group.
+ */
+struct LeftRow
+{
+    long N;
+};
+
+using LeftSchema = RowSchema<LeftRow,
+                             Column<"Day">,
+                             Column<"Time">,
+                             Column<"N", &LeftRow::N>>;
+
+/* Writes rows at times in microseconds since midnight, with a value column.
+ */
+void writeFile(const std::filesystem::path& path,
+               const std::vector<long>& times,
+               const std::vector<std::string>& values)
+{
+    std::ofstream out(path);
+    for (std::size_t row = 0; row < times.size(); ++row)
+    {
+        long seconds = times[row] / 1000000;
+        out << "250711 " << padded(seconds / 3600, 2)
+            << padded(seconds / 60 % 60, 2) << padded(seconds % 60, 2) << "."
+            << padded(times[row] % 1000000, 6) << " " << values[row] << "\n";
+    }
+}
+
+/* Opens the files of a directory as a time group.
+ */
+CsvGroup openGroup(const std::filesystem::path& directory,
+                   const std::string& column)
+{
+    return CsvGroup(CsvGroupMetadata(directory.string(),
+                                     "Data_[0-9]{6}\\.txt",
+                                     {},
+                                     "",
+                                     "#",
+                                     " ",
+                                     true,
+                                     false,
+                                     {"Day", "Time", column}));
+}
+
+int main()
+{
+    std::filesystem::path directory
+        = std::filesystem::temp_directory_path()
+        / ("TimeJoinTest_" + std::to_string(::getpid()));
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory / "left");
+    std::filesystem::create_directories(directory / "right");
+
+    // Right rows each second from 00:01:00, with a 20 s gap
+    std::vector<long> right_times;
+    std::vector<std::string> right_values;
+    for (long k = 0; k < 600; ++k)
+    {
+        right_times.push_back((60 + k + (k >= 300 ? 20 : 0)) * 1000000);
+        right_values.push_back(std::to_string(1000 + k / 8) + "."
+                               + padded(k * 7919 % 1000000, 6));
+    }
+    writeFile(directory / "right" / "Data_250711.txt",
+              right_times,
+              right_values);
+
+    // Left rows stepping around the first right row and back before it, then
+    // every half second from 00:00:30, stepping back 40 s every 250 rows, so
+    // times repeat and land on right rows, until past the end
+    std::vector<long> left_times
+        = {60500000, 59000000, 60500000, 60000000, 61000000, 60000000};
+    long time = 30000000;
+    for (long row = 0; row < 2000; ++row)
+    {
+        left_times.push_back(time);
+        time += row % 250 == 249 ? -40000000 : 500000;
+    }
+    std::vector<std::string> left_values;
+    for (std::size_t row = 0; row < left_times.size(); ++row)
+    {
+        left_values.push_back(std::to_string(row));
+    }
+    writeFile(directory / "left" / "Data_250711.txt", left_times, left_values);
+
+    {
+        CsvGroup left = openGroup(directory / "left", "N");
+        CsvGroup right = openGroup(directory / "right", "V");
+        CsvTimeSnapshot left_rows(left.snapshot(), CsvTimeFormat::twoColShort);
+        CsvTimeSnapshot right_rows(right.snapshot(),
+                                   CsvTimeFormat::twoColShort);
+        CsvTimeCursor lookup = right_rows.cursor();
+        const date_time right_start = lookup.startTime();
+        const date_time right_end = lookup.endTime();
+        const time_delt day = boost::posix_time::hours(24);
+        const time_ticks midnight = toTicks(right_start) - right_times[0];
+
+        // Small batches so the times cross batch boundaries both ways
+        TimeJoin<LeftSchema> join(left_rows,
+                                  right_rows,
+                                  {"V"},
+                                  ResampleMethod::linear,
+                                  day,
+                                  0,
+                                  -1,
+                                  7);
+        TimeAligner nearest(
+            right_rows, {"V"}, ResampleMethod::nearest, day, 7);
+        JoinedRow<LeftSchema> row;
+        long joined = 0;
+        while (join.next(row))
+        {
+            std::string at = "left row " + std::to_string(row.row) + ": ";
+            check(row.left.N == row.row, at + "decoded the wrong row");
+            check(toTicks(row.time) == midnight + left_times[row.row],
+                  at + "has the wrong time");
+            ++joined;
+
+            bool inside = row.time >= right_start && row.time <= right_end;
+            check(row.matched == inside,
+                  at + (inside ? "not matched" : "matched outside the rows"));
+            if (inside)
+            {
+                check(row.right[0] == lookup.colAtTime(row.time, "V"),
+                      at + "linear value differs from colAtTime");
+            }
+
+            quad value[1];
+            check(nearest.align(row.time, value),
+                  at + "not aligned to the nearest row");
+            quad expected;
+            parseField(std::string_view(
+                           right_values[lookup.closestIndex(row.time)]),
+                       expected);
+            check(value[0] == expected,
+                  at + "nearest value differs from the closest row");
+        }
+        check(joined == long(left_times.size()),
+              "joined " + std::to_string(joined) + " rows rather than "
+                  + std::to_string(left_times.size()));
+    }
+    std::filesystem::remove_all(directory);
+
+    if (failures > 0)
+    {
+        std::cerr << failures << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All time join checks passed" << std::endl;
+    return 0;
+}
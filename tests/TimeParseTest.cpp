@@ -0,0 +1,222 @@
+/*
+ * TimeParseTest.cpp
+ * Checks the fixed-width time parsers against the Boost parsers they replace:
+ * random rows in both formats, leap days, truncated fractions, invalid
+ * dates and separators Boost rejects.
+ *
+ * This file is part of the TimeKeeping project.
+ *
+ */
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "CsvFileUtils/TimeParse.hpp"
+
+/* Number of failed checks.
+ */
+int failures = 0;
+
+/* Records a failed check.
+ */
+void check(bool condition, const std::string& message)
+{
+    if (!condition)
+    {
+        std::cerr << "FAILED: " << message << std::endl;
+        ++failures;
+    }
+}
+
+/* Writes a number zero padded to width digits.
+ */
+std::string padded(long value, int width)
+{
+    std::string text = std::to_string(value);
+    return std::string(std::max(0, width - int(text.size())), '0') + text;
+}
+
+/* Parses the fields of one row with the fast parser, if it accepts them.
+ */
+template <CsvTimeFormat Format>
+std::optional<time_ticks> parseFast(const std::vector<std::string>& texts)
+{
+    std::vector<std::string_view> fields(texts.begin(), texts.end());
+    time_ticks ticks;
+    if (!TimeParser<Format>::parse(
+            std::span<const std::string_view, TimeParser<Format>::columns.size()>(
+                fields.data(), fields.size()),
+            ticks))
+    {
+        return std::nullopt;
+    }
+    return ticks;
+}
+
+/* Parses the fields of one row with Boost, if it accepts them.
+ */
+template <CsvTimeFormat Format>
+std::optional<time_ticks> parseReference(const std::vector<std::string>& texts)
+{
+    std::vector<std::string_view> fields(texts.begin(), texts.end());
+    try
+    {
+        return toTicks(parseTimeBoost<Format>(
+            std::span<const std::string_view, TimeParser<Format>::columns.size()>(
+                fields.data(), fields.size())));
+    }
+    catch (const std::exception&)
+    {
+        return std::nullopt;
+    }
+}
+
+/* Checks one row: the fast parser accepts it exactly when expected, and any
+ * time it gives is the time Boost gives.
+ */
+template <CsvTimeFormat Format>
+void checkRow(const std::vector<std::string>& texts, bool accepted)
+{
+    std::string row;
+    for (const auto& text : texts)
+    {
+        row += "'" + text + "' ";
+    }
+    std::optional<time_ticks> fast = parseFast<Format>(texts);
+    std::optional<time_ticks> reference = parseReference<Format>(texts);
+    check(fast.has_value() == accepted,
+          row + (accepted ? "rejected" : "accepted") + " by the fast parser");
+    if (fast)
+    {
+        check(reference && *reference == *fast,
+              row + "parsed differently from Boost");
+    }
+}
+
+/* Parses random rows of both formats in batches, with every row checked
+ * against Boost.
+ */
+void checkRandomRows(long rows)
+{
+    std::mt19937_64 random(20250711);
+    std::vector<std::string> standard;
+    std::vector<std::string> days;
+    std::vector<std::string> times;
+    for (long i = 0; i < rows; ++i)
+    {
+        int year = 1970 + random() % 130;
+        int month = 1 + random() % 12;
+        int day = 1 + random() % time_parse_detail::daysInMonth(year, month);
+        int hour = random() % 24;
+        int minute = random() % 60;
+        int second = random() % 60;
+        int digits = random() % 11;
+        std::string fraction;
+        for (int d = 0; d < digits; ++d)
+        {
+            fraction += char('0' + random() % 10);
+        }
+        std::string clock = padded(hour, 2) + ":" + padded(minute, 2) + ":"
+                          + padded(second, 2);
+        standard.push_back(
+            padded(year, 4) + "-" + padded(month, 2) + "-" + padded(day, 2)
+            + " " + clock + (digits > 0 ? "." + fraction : ""));
+
+        int short_year = 2000 + random() % 100;
+        day = 1 + random() % time_parse_detail::daysInMonth(short_year, month);
+        days.push_back(
+            padded(short_year % 100, 2) + padded(month, 2) + padded(day, 2));
+        times.push_back(
+            padded(hour, 2) + padded(minute, 2) + padded(second, 2) + "."
+            + (digits > 0 ? fraction : "0"));
+    }
+
+    std::vector<std::string_view> one_column;
+    std::vector<std::string_view> two_columns;
+    for (long i = 0; i < rows; ++i)
+    {
+        one_column.push_back(standard[i]);
+        two_columns.push_back(days[i]);
+        two_columns.push_back(times[i]);
+    }
+    std::vector<time_ticks> ticks(rows);
+    check(parseTimeBatch<CsvTimeFormat::oneColStandard>(
+              one_column, ticks, true)
+              == 0,
+          "random oneColStandard rows disagree with Boost");
+    check(parseTimeBatch<CsvTimeFormat::twoColShort>(
+              two_columns, ticks, true)
+              == 0,
+          "random twoColShort rows disagree with Boost");
+}
+
+int main()
+{
+    checkRandomRows(400000);
+
+    // Leap days, including the century rules
+    checkRow<CsvTimeFormat::oneColStandard>({"2024-02-29 23:59:59"}, true);
+    checkRow<CsvTimeFormat::oneColStandard>({"2000-02-29 00:00:00.5"}, true);
+    checkRow<CsvTimeFormat::oneColStandard>({"2023-02-29 00:00:00"}, false);
+    checkRow<CsvTimeFormat::oneColStandard>({"1900-02-29 00:00:00"}, false);
+    checkRow<CsvTimeFormat::twoColShort>({"240229", "120000.0"}, true);
+    checkRow<CsvTimeFormat::twoColShort>({"230229", "120000.0"}, false);
+
+    // Fractions past tick resolution are truncated, not rounded
+    checkRow<CsvTimeFormat::oneColStandard>(
+        {"1999-12-31 12:00:00.1234567899"}, true);
+    checkRow<CsvTimeFormat::twoColShort>({"991231", "120000.9999999"}, true);
+    std::optional<time_ticks> truncated
+        = parseFast<CsvTimeFormat::oneColStandard>(
+            {"1999-12-31 12:00:00.9999999"});
+    check(truncated && *truncated % 1000000 == 999999,
+          "fraction past tick resolution not truncated");
+    checkRow<CsvTimeFormat::oneColStandard>({"2025-07-11 00:00:00,25"}, true);
+
+    // Invalid dates and times, and layouts the fast parser leaves to Boost
+    checkRow<CsvTimeFormat::oneColStandard>({"2024-02-30 00:00:00"}, false);
+    checkRow<CsvTimeFormat::oneColStandard>({"2024-13-01 00:00:00"}, false);
+    checkRow<CsvTimeFormat::oneColStandard>({"2024-00-10 00:00:00"}, false);
+    checkRow<CsvTimeFormat::oneColStandard>({"2024-04-31 00:00:00"}, false);
+    checkRow<CsvTimeFormat::oneColStandard>({"2024-01-01 24:00:00"}, false);
+    checkRow<CsvTimeFormat::oneColStandard>({"2024-01-01 23:60:00"}, false);
+    checkRow<CsvTimeFormat::oneColStandard>({"2024-1-05 00:00:00"}, false);
+    checkRow<CsvTimeFormat::oneColStandard>({"2024-01-05 00:00:00."}, false);
+    checkRow<CsvTimeFormat::oneColStandard>({"2024-01-05 00:00:0a"}, false);
+    checkRow<CsvTimeFormat::twoColShort>({"241301", "000000.0"}, false);
+    checkRow<CsvTimeFormat::twoColShort>({"240101", "0000"}, false);
+    checkRow<CsvTimeFormat::twoColShort>({"24011", "000000.0"}, false);
+
+    // Boost rejects a 'T' separator, so the fast parser must too, but reads
+    // a Day/Time time with no fraction as whole seconds
+    check(!parseReference<CsvTimeFormat::oneColStandard>(
+              {"2024-01-05T00:00:00"}),
+          "Boost accepts a 'T' separator");
+    checkRow<CsvTimeFormat::oneColStandard>({"2024-01-05T00:00:00"}, false);
+    checkRow<CsvTimeFormat::twoColShort>({"240105", "120000"}, true);
+
+    // Rows the fast parser rejects still parse through the Boost fallback
+    std::vector<std::string_view> fallback = {"2024-1-05 00:00:00"};
+    std::vector<time_ticks> ticks(1);
+    std::optional<time_ticks> reference
+        = parseReference<CsvTimeFormat::oneColStandard>({"2024-1-05 00:00:00"});
+    check(reference
+              && parseTimeBatch<CsvTimeFormat::oneColStandard>(fallback, ticks)
+                     == 1
+              && ticks[0] == *reference,
+          "batch parse of a row left to Boost");
+
+    if (failures > 0)
+    {
+        std::cerr << failures << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All time parse checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,199 @@
+/*
+ * TimeSegmentsTest.cpp
+ * Checks the rows TimeSegments puts around a time against a binary search of
+ * the row times, on a group with jittered and exact segments, gaps, rate
+ * changes and irregular rows between segments, at every row time, between
+ * rows and at the edges of every segment.
+ *
+ * This file is part of the TimeKeeping project.
+ *
+ */
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "CsvFileUtils/CsvGroup.hpp"
+#include "CsvFileUtils/CsvTimeSnapshot.hpp"
+#include "CsvFileUtils/TimeSegments.hpp"
+
+/* Number of failed checks.
+ */
+int failures = 0;
+
+/* Records a failed check.
+ */
+void check(bool condition, const std::string& message)
+{
+    if (!condition)
+    {
+        std::cerr << "FAILED: " << message << std::endl;
+        ++failures;
+    }
+}
+
+/* Writes a number zero padded to width digits.
+ */
+std::string padded(long value, int width)
+{
+    std::string text = std::to_string(value);
+    return std::string(std::max(0, width - int(text.size())), '0') + text;
+}
+
+/* Makes row times in microseconds since midnight: runs at a fixed rate with
+ * and without jitter, a gap of missing rows, irregular rows, a run too short
+ * to be a segment and a change of rate with no gap.
+ */
+std::vector<long> makeTimes()
+{
+    std::mt19937_64 random(20250711);
+    std::vector<long> times;
+    long time = 1000000;
+    auto run = [&](long rows, long step, long jitter)
+    {
+        long start = time;
+        for (long k = 0; k < rows; ++k)
+        {
+            long offset
+                = jitter > 0 ? long(random() % (2 * jitter + 1)) - jitter : 0;
+            times.push_back(start + k * step + offset);
+        }
+        time = start + rows * step;
+    };
+
+    run(200, 1000000, 50000);
+    time += 30000000;
+    run(300, 1000000, 0);
+    for (int i = 0; i < 10; ++i)
+    {
+        time += 100000 + random() % 2900000;
+        times.push_back(time);
+    }
+    time += 1000000;
+    run(10, 500000, 0);
+    run(500, 250000, 20000);
+    run(400, 2000000, 0);
+    return times;
+}
+
+/* Writes the rows into two files of a group, split inside a segment.
+ */
+void writeFiles(const std::filesystem::path& directory,
+                const std::vector<long>& times)
+{
+    for (int f = 0; f < 2; ++f)
+    {
+        std::ofstream out(
+            directory / ("Freq_250711_" + std::to_string(f + 1) + ".txt"));
+        std::size_t first = f == 0 ? 0 : 600;
+        std::size_t last = f == 0 ? 600 : times.size();
+        for (std::size_t row = first; row < last; ++row)
+        {
+            long seconds = times[row] / 1000000;
+            out << "250711 " << padded(seconds / 3600, 2)
+                << padded(seconds / 60 % 60, 2) << padded(seconds % 60, 2)
+                << "." << padded(times[row] % 1000000, 6) << " " << row
+                << "\n";
+        }
+    }
+}
+
+int main()
+{
+    std::filesystem::path directory
+        = std::filesystem::temp_directory_path()
+        / ("TimeSegmentsTest_" + std::to_string(::getpid()));
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    writeFiles(directory, makeTimes());
+
+    {
+        CsvGroup group(CsvGroupMetadata(directory.string(),
+                                        "Freq_[0-9]{6}_[0-9]+\\.txt",
+                                        {},
+                                        "",
+                                        "#",
+                                        " ",
+                                        true,
+                                        false,
+                                        {"Day", "Time", "N"}));
+        CsvTimeSnapshot snapshot(group.snapshot(), CsvTimeFormat::twoColShort);
+        CsvTimeCursor searched = snapshot.cursor();
+        std::vector<time_ticks> times
+            = searched.timesOfRows(0, snapshot.size());
+
+        auto segments = TimeSegments::build(snapshot);
+        check(segments->uniformRows() >= 700,
+              "the exact runs are not found as segments, "
+                  + std::to_string(segments->uniformRows())
+                  + " rows are in segments");
+        CsvTimeCursor segmented = snapshot.cursor();
+        segmented.attachSegments(segments);
+
+        // Every row time, a tick either side, between rows, the edges of
+        // every segment and times outside the rows
+        std::vector<time_ticks> queries
+            = {times.front() - 1000000, times.back() + 1000000};
+        for (std::size_t row = 0; row < times.size(); ++row)
+        {
+            queries.insert(queries.end(),
+                           {times[row] - 1, times[row], times[row] + 1});
+            if (row + 1 < times.size())
+            {
+                queries.push_back((times[row] + times[row + 1]) / 2);
+            }
+        }
+        for (const auto& segment : segments->segments())
+        {
+            for (time_ticks edge :
+                 {segment.start - segment.jitter,
+                  segment.start + segment.jitter,
+                  segment.lastTime() - segment.jitter,
+                  segment.lastTime() + segment.jitter})
+            {
+                queries.insert(queries.end(), {edge - 1, edge, edge + 1});
+            }
+        }
+
+        for (time_ticks query : queries)
+        {
+            std::string at = "at " + std::to_string(query) + ": ";
+            if (query >= times.front() && query <= times.back())
+            {
+                long first_at = std::lower_bound(times.begin(), times.end(),
+                                                 query)
+                              - times.begin();
+                auto [first, last] = segments->window(query);
+                check(first >= 0 && last < long(times.size())
+                          && first_at <= last
+                          && (first == 0
+                              || (first < first_at && times[first] < query)),
+                      at + "window [" + std::to_string(first) + ", "
+                          + std::to_string(last)
+                          + "] misses the first row at or after it, "
+                          + std::to_string(first_at));
+            }
+
+            date_time time = fromTicks(query);
+            check(segmented.bounds(time) == searched.bounds(time),
+                  at + "bounds differ from a binary search");
+            check(segmented.closestIndex(time) == searched.closestIndex(time),
+                  at + "closest row differs from a binary search");
+        }
+    }
+    std::filesystem::remove_all(directory);
+
+    if (failures > 0)
+    {
+        std::cerr << failures << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All time segment checks passed" << std::endl;
+    return 0;
+}